@@ -0,0 +1,111 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Compares the flat and the hierarchical all to all algorithms. Every rank sends a number of small messages to every
+ * other rank, repeated for a number of iterations
+ *
+ * mpirun -np 16 ./all_to_all_benchmark [message size in bytes] [messages per target] [iterations]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include <glog/logging.h>
+#include <net/mpi/mpi_communicator.h>
+#include <ctx/twisterx_context.h>
+
+#include "net/ops/all_to_all.hpp"
+
+class BenchmarkCallback : public twisterx::ReceiveCallback {
+ public:
+  int64_t received = 0;
+
+  bool onReceive(int source, void *buffer, int length) override {
+    received += length;
+    delete[] static_cast<char *>(buffer);
+    return true;
+  }
+
+  bool onReceiveHeader(int source, int finished, int *buffer, int length) override {
+    return true;
+  }
+
+  bool onSendComplete(int target, void *buffer, int length) override {
+    return true;
+  }
+};
+
+double run(twisterx::TwisterXContext *ctx, const std::string &mode, int size, int messages, int iterations) {
+  ctx->AddConfig(TWISTERX_ALL_TO_ALL_MODE, mode);
+  std::vector<int> ranks;
+  for (int i = 0; i < ctx->GetWorldSize(); i++) {
+    ranks.push_back(i);
+  }
+  std::vector<char> buffer(size, 1);
+
+  ctx->Barrier();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    BenchmarkCallback callback;
+    auto all = twisterx::AllToAll::Create(ctx, ranks, ranks, ctx->GetNextSequence(), &callback);
+    for (int m = 0; m < messages; m++) {
+      for (int target : ranks) {
+        while (all->insert(buffer.data(), size, target) < 0) {
+          all->isComplete();
+        }
+      }
+    }
+    all->finish();
+    while (!all->isComplete()) {
+    }
+    all->close();
+    if (callback.received != static_cast<int64_t>(size) * messages * ctx->GetWorldSize()) {
+      LOG(FATAL) << "Expected " << static_cast<int64_t>(size) * messages * ctx->GetWorldSize()
+                 << " bytes, received " << callback.received;
+    }
+  }
+  ctx->Barrier();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  int size = argc > 1 ? std::stoi(argv[1]) : 64;
+  int messages = argc > 2 ? std::stoi(argv[2]) : 16;
+  int iterations = argc > 3 ? std::stoi(argv[3]) : 10;
+
+  auto mpi_config = new twisterx::net::MPIConfig();
+  auto ctx = twisterx::TwisterXContext::InitDistributed(mpi_config);
+
+  // warm up the channels and the node detection before measuring
+  run(ctx, TWISTERX_ALL_TO_ALL_FLAT, size, messages, 1);
+  run(ctx, TWISTERX_ALL_TO_ALL_HIERARCHICAL, size, messages, 1);
+
+  double flat = run(ctx, TWISTERX_ALL_TO_ALL_FLAT, size, messages, iterations);
+  double hierarchical = run(ctx, TWISTERX_ALL_TO_ALL_HIERARCHICAL, size, messages, iterations);
+
+  if (ctx->GetRank() == 0) {
+    LOG(INFO) << "World " << ctx->GetWorldSize() << " nodes "
+              << *std::max_element(ctx->GetCommunicator()->GetNodeIds().begin(),
+                                   ctx->GetCommunicator()->GetNodeIds().end()) + 1
+              << " message size " << size << " messages per target " << messages;
+    LOG(INFO) << "flat " << flat / iterations << " ms per all to all";
+    LOG(INFO) << "hierarchical " << hierarchical / iterations << " ms per all to all";
+  }
+  ctx->Finalize();
+  return 0;
+}
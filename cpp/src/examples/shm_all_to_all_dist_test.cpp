@@ -0,0 +1,140 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * All to all of tables between the ranks of a host, which go over the shared memory channel. Run on a single host
+ *
+ * mpirun -np 4 ./shm_all_to_all_dist_test [rows]
+ *
+ * Every rank sends each rank rows tagged with the source, the target and the row number, with a string column with
+ * nulls, and checks every row it receives. The tables are larger than the shared memory rings, so they are streamed
+ * through them. Set TWISTERX_SHM=0 to run the same exchange over MPI.
+ */
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+#include <glog/logging.h>
+#include <net/mpi/mpi_communicator.h>
+#include <ctx/twisterx_context.h>
+
+#include "arrow/arrow_all_to_all.hpp"
+
+static std::string RowString(int source, int target, int64_t row) {
+  return std::to_string(source) + "_" + std::to_string(target) + "_" + std::to_string(row);
+}
+
+/**
+ * Checks that the rows of each source arrive in order with the values they were sent with
+ */
+class CheckingCallback : public twisterx::ArrowCallback {
+ public:
+  CheckingCallback(int rank, int world_size) : rank(rank), next_rows(world_size, 0) {}
+
+  bool onReceive(int source, std::shared_ptr<arrow::Table> table) override {
+    std::shared_ptr<arrow::Table> combined;
+    if (!table->CombineChunks(arrow::default_memory_pool(), &combined).ok()) {
+      LOG(ERROR) << rank << " failed to combine the table from " << source;
+      errors++;
+      return true;
+    }
+    auto sources = std::static_pointer_cast<arrow::Int32Array>(combined->column(0)->chunk(0));
+    auto targets = std::static_pointer_cast<arrow::Int32Array>(combined->column(1)->chunk(0));
+    auto rows = std::static_pointer_cast<arrow::Int64Array>(combined->column(2)->chunk(0));
+    auto strings = std::static_pointer_cast<arrow::StringArray>(combined->column(3)->chunk(0));
+    for (int64_t i = 0; i < combined->num_rows(); i++) {
+      int64_t expected_row = next_rows[source]++;
+      bool null_string = expected_row % 10 == 0;
+      if (sources->Value(i) != source || targets->Value(i) != rank || rows->Value(i) != expected_row
+          || strings->IsNull(i) != null_string
+          || (!null_string && strings->GetString(i) != RowString(source, rank, expected_row))) {
+        if (errors++ < 10) {
+          LOG(ERROR) << rank << " received a wrong row from " << source << " at " << expected_row;
+        }
+      }
+    }
+    return true;
+  }
+
+  int rank;
+  std::vector<int64_t> next_rows;
+  int64_t errors = 0;
+};
+
+int main(int argc, char *argv[]) {
+  auto mpi_config = new twisterx::net::MPIConfig();
+  auto ctx = twisterx::TwisterXContext::InitDistributed(mpi_config);
+
+  int rank = ctx->GetRank();
+  int size = ctx->GetWorldSize();
+  int64_t rows = argc > 1 ? std::atoll(argv[1]) : 200000;
+
+  std::vector<int> all_ranks;
+  for (int i = 0; i < size; i++) {
+    all_ranks.push_back(i);
+  }
+
+  auto schema = arrow::schema({arrow::field("source", arrow::int32()), arrow::field("target", arrow::int32()),
+                               arrow::field("row", arrow::int64()), arrow::field("value", arrow::utf8())});
+  auto callback = std::make_shared<CheckingCallback>(rank, size);
+  twisterx::ArrowAllToAll all(ctx, all_ranks, all_ranks, 0, callback, schema, arrow::default_memory_pool());
+
+  for (int target = 0; target < size; target++) {
+    arrow::Int32Builder sources, targets;
+    arrow::Int64Builder row_numbers;
+    arrow::StringBuilder strings;
+    for (int64_t i = 0; i < rows; i++) {
+      sources.Append(rank);
+      targets.Append(target);
+      row_numbers.Append(i);
+      if (i % 10 == 0) {
+        strings.AppendNull();
+      } else {
+        strings.Append(RowString(rank, target, i));
+      }
+    }
+    std::vector<std::shared_ptr<arrow::Array>> columns(4);
+    sources.Finish(&columns[0]);
+    targets.Finish(&columns[1]);
+    row_numbers.Finish(&columns[2]);
+    strings.Finish(&columns[3]);
+    all.insert(arrow::Table::Make(schema, columns), target);
+  }
+
+  all.finish();
+  while (!all.isComplete()) {
+  }
+  all.close();
+
+  int64_t errors = callback->errors;
+  for (int source = 0; source < size; source++) {
+    if (callback->next_rows[source] != rows) {
+      LOG(ERROR) << rank << " received " << callback->next_rows[source] << " rows from " << source
+                 << ", expected " << rows;
+      errors++;
+    }
+  }
+
+  int64_t total_errors = 0;
+  ctx->GetCommunicator()->AllReduce(&errors, &total_errors, 1, twisterx::Type::INT64, twisterx::net::SUM);
+  if (rank == 0) {
+    LOG(INFO) << "Exchanged " << rows << " rows between each pair of " << size << " ranks, "
+              << (total_errors == 0 ? "all rows received" : std::to_string(total_errors) + " errors");
+  }
+
+  ctx->Finalize();
+  return total_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <net/mpi/mpi_communicator.h>
+#include <ctx/twisterx_context.h>
+#include <table.hpp>
+#include <status.hpp>
+#include <iostream>
+#include <io/csv_read_config.h>
+#include <chrono>
+
+using namespace twisterx;
+
+bool RunDistinct(int rank,
+                 twisterx::TwisterXContext *ctx,
+                 const std::shared_ptr<Table> &table,
+                 const std::vector<int> &columns,
+                 twisterx::DistinctKeep keep,
+                 std::shared_ptr<Table> &output) {
+  auto t1 = std::chrono::high_resolution_clock::now();
+  Status status = table->DistributedDistinct(columns, output, keep);
+  auto t2 = std::chrono::high_resolution_clock::now();
+  ctx->GetCommunicator()->Barrier();
+  auto t3 = std::chrono::high_resolution_clock::now();
+
+  if (!status.is_ok()) {
+    LOG(ERROR) << "Distinct failed! " << status.get_msg();
+    return false;
+  }
+  LOG(INFO) << rank << " distinct " << columns.size() << " columns keep " << keep
+            << " o_t " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count()
+            << " w_t " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2).count()
+            << " lines " << output->Rows();
+  output->Clear();
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+
+  std::shared_ptr<Table> table1, output;
+  Status status;
+
+  auto mpi_config = new twisterx::net::MPIConfig();
+  auto ctx = twisterx::TwisterXContext::InitDistributed(mpi_config);
+
+  int rank = ctx->GetRank();
+  std::string srank = std::to_string(rank);
+
+  if (argc != 3) {
+    LOG(ERROR) << "src_dir and base_dir not provided! ";
+    return 1;
+  }
+
+  std::string src_dir = argv[1];
+  std::string base_dir = argv[2];
+
+  system(("mkdir -p " + base_dir).c_str());
+
+  std::string csv1 = base_dir + "/csv1_" + srank + ".csv";
+
+  system(("cp " + src_dir + "/csv1_" + srank + ".csv " + csv1).c_str());
+
+  LOG(INFO) << rank << " Reading tables";
+  auto read_options = twisterx::io::config::CSVReadOptions().UseThreads(false).BlockSize(1 << 30);
+  if (!(status = Table::FromCSV(ctx, csv1, table1, read_options)).is_ok()) {
+    LOG(ERROR) << "File read failed! " << csv1;
+    return 1;
+  }
+  ctx->GetCommunicator()->Barrier();
+  LOG(INFO) << rank << " Done reading tables. rows " << table1->Rows();
+
+  LOG(INFO) << rank << " distinct start";
+  RunDistinct(rank, ctx, table1, {}, twisterx::KEEP_FIRST, output);
+  RunDistinct(rank, ctx, table1, {0}, twisterx::KEEP_FIRST, output);
+  RunDistinct(rank, ctx, table1, {0}, twisterx::KEEP_LAST, output);
+  RunDistinct(rank, ctx, table1, {0}, twisterx::KEEP_NONE, output);
+  LOG(INFO) << rank << " distinct end ----------------------------------";
+
+  ctx->Finalize();
+
+  system(("rm " + csv1).c_str());
+
+  return 0;
+}
+
+
@@ -0,0 +1,97 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <net/mpi/mpi_communicator.h>
+#include <ctx/twisterx_context.h>
+#include <table.hpp>
+#include <status.hpp>
+#include <io/csv_read_config.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+using namespace twisterx;
+
+bool RunTopK(int rank,
+             twisterx::TwisterXContext *ctx,
+             const std::shared_ptr<Table> &table,
+             int64_t k,
+             bool ascending,
+             std::shared_ptr<Table> &output) {
+  std::vector<twisterx::sort::config::SortKey> keys{twisterx::sort::config::SortKey(0, ascending)};
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+  Status status = table->DistributedTopK(keys, k, output);
+  auto t2 = std::chrono::high_resolution_clock::now();
+  ctx->GetCommunicator()->Barrier();
+  auto t3 = std::chrono::high_resolution_clock::now();
+
+  if (!status.is_ok()) {
+    LOG(ERROR) << "Top k failed! " << status.get_msg();
+    return false;
+  }
+  LOG(INFO) << rank << " t_t " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count()
+            << " w_t " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2).count()
+            << " lines " << output->Rows()
+            << " k " << k
+            << " asc " << ascending;
+  if (rank == 0) {
+    output->Print(0, static_cast<int>(std::min<int64_t>(output->Rows(), 10)), 0, output->Columns());
+  }
+  output->Clear();
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  std::shared_ptr<Table> table, top;
+  Status status;
+
+  auto mpi_config = new twisterx::net::MPIConfig();
+  auto ctx = twisterx::TwisterXContext::InitDistributed(mpi_config);
+
+  int rank = ctx->GetRank();
+  std::string srank = std::to_string(rank);
+
+  if (argc != 3) {
+    LOG(ERROR) << "src_dir and base_dir not provided! ";
+    return 1;
+  }
+
+  std::string src_dir = argv[1];
+  std::string base_dir = argv[2];
+
+  system(("mkdir -p " + base_dir + "; rm -f " + base_dir + "/*csv").c_str());
+
+  std::string csv1 = base_dir + "/csv1_" + srank + ".csv";
+  system(("cp " + src_dir + "/csv1_" + srank + ".csv " + csv1).c_str());
+
+  LOG(INFO) << rank << " Reading table";
+  auto read_options = twisterx::io::config::CSVReadOptions().UseThreads(false).BlockSize(1 << 30);
+  if (!(status = Table::FromCSV(ctx, csv1, table, read_options)).is_ok()) {
+    LOG(ERROR) << "File read failed! " << csv1;
+    return 1;
+  }
+  ctx->GetCommunicator()->Barrier();
+  LOG(INFO) << rank << " Done reading table. rows " << table->Rows();
+
+  LOG(INFO) << rank << " top k start";
+  RunTopK(rank, ctx, table, 100, true, top);
+  RunTopK(rank, ctx, table, 100, false, top);
+  LOG(INFO) << rank << " top k end ----------------------------------";
+
+  ctx->Finalize();
+  std::cout << "Removing File " << csv1 << std::endl;
+  system(("rm " + csv1).c_str());
+  return 0;
+}
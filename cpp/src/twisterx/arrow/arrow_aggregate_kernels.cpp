@@ -0,0 +1,447 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "arrow_aggregate_kernels.hpp"
+
+#include <cmath>
+#include <type_traits>
+
+namespace twisterx {
+
+using twisterx::groupby::config::AggregationOp;
+
+/**
+ * NaN values are skipped by the aggregates, the same as nulls
+ */
+template<typename T>
+static inline typename std::enable_if<std::is_floating_point<T>::value, bool>::type IsNaN(T value) {
+  return std::isnan(value);
+}
+
+template<typename T>
+static inline typename std::enable_if<!std::is_floating_point<T>::value, bool>::type IsNaN(T) {
+  return false;
+}
+
+/**
+ * Call the function with the row and the value of the non null, non NaN values of the array
+ */
+template<typename TYPE, typename FUNCTION>
+static inline void VisitValues(const arrow::Array &values, FUNCTION &&fn) {
+  const auto &array = static_cast<const arrow::NumericArray<TYPE> &>(values);
+  const typename TYPE::c_type *raw = array.raw_values();
+  const int64_t length = array.length();
+  if (array.null_count() == 0) {
+    for (int64_t i = 0; i < length; i++) {
+      if (!IsNaN(raw[i])) {
+        fn(i, raw[i]);
+      }
+    }
+  } else {
+    for (int64_t i = 0; i < length; i++) {
+      if (array.IsValid(i) && !IsNaN(raw[i])) {
+        fn(i, raw[i]);
+      }
+    }
+  }
+}
+
+/**
+ * Build an array with the value of each group, or null for the groups without values
+ */
+template<typename BUILDER_TYPE, typename T>
+static arrow::Status FinishValues(BUILDER_TYPE *builder,
+                                  const std::vector<T> &values,
+                                  const std::vector<int64_t> &counts,
+                                  int64_t min_count,
+                                  std::shared_ptr<arrow::Array> *out) {
+  arrow::Status status = builder->Reserve(values.size());
+  if (!status.ok()) {
+    return status;
+  }
+  for (size_t g = 0; g < values.size(); g++) {
+    if (counts[g] >= min_count) {
+      builder->UnsafeAppend(values[g]);
+    } else {
+      builder->UnsafeAppendNull();
+    }
+  }
+  return builder->Finish(out);
+}
+
+/**
+ * An array with the values, without nulls
+ */
+template<typename TYPE>
+static arrow::Status MakeStateArray(arrow::MemoryPool *pool,
+                                    const std::vector<typename TYPE::c_type> &values,
+                                    std::shared_ptr<arrow::Array> *out) {
+  arrow::NumericBuilder<TYPE> builder(pool);
+  arrow::Status status = builder.AppendValues(values);
+  if (!status.ok()) {
+    return status;
+  }
+  return builder.Finish(out);
+}
+
+template<typename TYPE>
+static inline const typename TYPE::c_type *StateValues(const std::shared_ptr<arrow::Array> &state) {
+  return static_cast<const arrow::NumericArray<TYPE> &>(*state).raw_values();
+}
+
+/**
+ * Counts the non null values of any type
+ */
+class CountKernel : public AggregateKernel {
+ public:
+  void Update(const arrow::Array &values, const int64_t *group_ids, int64_t num_groups) override {
+    counts_.resize(num_groups, 0);
+    const int64_t length = values.length();
+    if (values.null_count() == 0) {
+      for (int64_t i = 0; i < length; i++) {
+        counts_[group_ids[i]]++;
+      }
+    } else {
+      for (int64_t i = 0; i < length; i++) {
+        counts_[group_ids[i]] += values.IsValid(i);
+      }
+    }
+  }
+
+  void Merge(const std::vector<std::shared_ptr<arrow::Array>> &states,
+             const int64_t *group_ids,
+             int64_t num_groups) override {
+    counts_.resize(num_groups, 0);
+    const int64_t *counts = StateValues<arrow::Int64Type>(states[0]);
+    for (int64_t i = 0; i < states[0]->length(); i++) {
+      counts_[group_ids[i]] += counts[i];
+    }
+  }
+
+  int NumStates() const override {
+    return 1;
+  }
+
+  arrow::Status States(arrow::MemoryPool *pool, std::vector<std::shared_ptr<arrow::Array>> *out) override {
+    out->resize(1);
+    return Finish(pool, &(*out)[0]);
+  }
+
+  arrow::Status Finish(arrow::MemoryPool *pool, std::shared_ptr<arrow::Array> *out) override {
+    return MakeStateArray<arrow::Int64Type>(pool, counts_, out);
+  }
+
+  std::shared_ptr<arrow::DataType> OutputType() const override {
+    return arrow::int64();
+  }
+
+ protected:
+  std::vector<int64_t> counts_;
+};
+
+/**
+ * Counts the non null values of floating point values, skipping the NaNs
+ */
+template<typename TYPE>
+class FloatingCountKernel : public CountKernel {
+ public:
+  void Update(const arrow::Array &values, const int64_t *group_ids, int64_t num_groups) override {
+    counts_.resize(num_groups, 0);
+    VisitValues<TYPE>(values, [&](int64_t i, typename TYPE::c_type) {
+      counts_[group_ids[i]]++;
+    });
+  }
+};
+
+/**
+ * Sums the values into the c type of SUM_TYPE, the integers sum as 64 bit integers and the floating point values as
+ * doubles
+ */
+template<typename TYPE, typename SUM_TYPE>
+class SumKernel : public AggregateKernel {
+  using S = typename SUM_TYPE::c_type;
+
+ public:
+  void Update(const arrow::Array &values, const int64_t *group_ids, int64_t num_groups) override {
+    sums_.resize(num_groups, 0);
+    counts_.resize(num_groups, 0);
+    VisitValues<TYPE>(values, [&](int64_t i, typename TYPE::c_type value) {
+      sums_[group_ids[i]] += static_cast<S>(value);
+      counts_[group_ids[i]]++;
+    });
+  }
+
+  void Merge(const std::vector<std::shared_ptr<arrow::Array>> &states,
+             const int64_t *group_ids,
+             int64_t num_groups) override {
+    sums_.resize(num_groups, 0);
+    counts_.resize(num_groups, 0);
+    const S *sums = StateValues<SUM_TYPE>(states[0]);
+    const int64_t *counts = StateValues<arrow::Int64Type>(states[1]);
+    for (int64_t i = 0; i < states[0]->length(); i++) {
+      sums_[group_ids[i]] += sums[i];
+      counts_[group_ids[i]] += counts[i];
+    }
+  }
+
+  int NumStates() const override {
+    return 2;
+  }
+
+  arrow::Status States(arrow::MemoryPool *pool, std::vector<std::shared_ptr<arrow::Array>> *out) override {
+    out->resize(2);
+    arrow::Status status = MakeStateArray<SUM_TYPE>(pool, sums_, &(*out)[0]);
+    if (!status.ok()) {
+      return status;
+    }
+    return MakeStateArray<arrow::Int64Type>(pool, counts_, &(*out)[1]);
+  }
+
+  arrow::Status Finish(arrow::MemoryPool *pool, std::shared_ptr<arrow::Array> *out) override {
+    arrow::NumericBuilder<SUM_TYPE> builder(pool);
+    return FinishValues(&builder, sums_, counts_, 1, out);
+  }
+
+  std::shared_ptr<arrow::DataType> OutputType() const override {
+    return arrow::TypeTraits<SUM_TYPE>::type_singleton();
+  }
+
+ private:
+  std::vector<S> sums_;
+  std::vector<int64_t> counts_;
+};
+
+/**
+ * The minimum or the maximum of the values, in the type of the values
+ */
+template<typename TYPE, bool MIN>
+class MinMaxKernel : public AggregateKernel {
+  using T = typename TYPE::c_type;
+
+ public:
+  explicit MinMaxKernel(std::shared_ptr<arrow::DataType> type) : type_(std::move(type)) {}
+
+  void Update(const arrow::Array &values, const int64_t *group_ids, int64_t num_groups) override {
+    values_.resize(num_groups, T());
+    counts_.resize(num_groups, 0);
+    VisitValues<TYPE>(values, [&](int64_t i, T value) {
+      int64_t group = group_ids[i];
+      if (counts_[group] == 0 || (MIN ? value < values_[group] : values_[group] < value)) {
+        values_[group] = value;
+      }
+      counts_[group]++;
+    });
+  }
+
+  void Merge(const std::vector<std::shared_ptr<arrow::Array>> &states,
+             const int64_t *group_ids,
+             int64_t num_groups) override {
+    // the groups without values have null states, which are skipped
+    Update(*states[0], group_ids, num_groups);
+  }
+
+  int NumStates() const override {
+    return 1;
+  }
+
+  arrow::Status States(arrow::MemoryPool *pool, std::vector<std::shared_ptr<arrow::Array>> *out) override {
+    out->resize(1);
+    return Finish(pool, &(*out)[0]);
+  }
+
+  arrow::Status Finish(arrow::MemoryPool *pool, std::shared_ptr<arrow::Array> *out) override {
+    // the builder takes the type, the date and time types have parameters
+    arrow::NumericBuilder<TYPE> builder(type_, pool);
+    return FinishValues(&builder, values_, counts_, 1, out);
+  }
+
+  std::shared_ptr<arrow::DataType> OutputType() const override {
+    return type_;
+  }
+
+ private:
+  std::shared_ptr<arrow::DataType> type_;
+  std::vector<T> values_;
+  std::vector<int64_t> counts_;
+};
+
+/**
+ * The mean or the sample variance of the values as doubles. The mean and the sum of the squared differences from
+ * the mean are updated a value at a time with Welford's method, which doesn't lose the precision of a sum of squares,
+ * and partial states are merged with the pairwise formula of Chan et al.
+ */
+template<typename TYPE>
+class MomentsKernel : public AggregateKernel {
+ public:
+  explicit MomentsKernel(bool variance) : variance_(variance) {}
+
+  void Update(const arrow::Array &values, const int64_t *group_ids, int64_t num_groups) override {
+    counts_.resize(num_groups, 0);
+    means_.resize(num_groups, 0);
+    m2s_.resize(num_groups, 0);
+    VisitValues<TYPE>(values, [&](int64_t i, typename TYPE::c_type value) {
+      int64_t group = group_ids[i];
+      double x = static_cast<double>(value);
+      double delta = x - means_[group];
+      means_[group] += delta / static_cast<double>(++counts_[group]);
+      m2s_[group] += delta * (x - means_[group]);
+    });
+  }
+
+  void Merge(const std::vector<std::shared_ptr<arrow::Array>> &states,
+             const int64_t *group_ids,
+             int64_t num_groups) override {
+    counts_.resize(num_groups, 0);
+    means_.resize(num_groups, 0);
+    m2s_.resize(num_groups, 0);
+    const int64_t *counts = StateValues<arrow::Int64Type>(states[0]);
+    const double *means = StateValues<arrow::DoubleType>(states[1]);
+    const double *m2s = variance_ ? StateValues<arrow::DoubleType>(states[2]) : nullptr;
+    for (int64_t i = 0; i < states[0]->length(); i++) {
+      if (counts[i] == 0) {
+        continue;
+      }
+      int64_t group = group_ids[i];
+      double count = static_cast<double>(counts_[group]);
+      double other_count = static_cast<double>(counts[i]);
+      double total = count + other_count;
+      double delta = means[i] - means_[group];
+      means_[group] += delta * other_count / total;
+      if (variance_) {
+        m2s_[group] += m2s[i] + delta * delta * count * other_count / total;
+      }
+      counts_[group] += counts[i];
+    }
+  }
+
+  int NumStates() const override {
+    // the mean doesn't need the squared differences
+    return variance_ ? 3 : 2;
+  }
+
+  arrow::Status States(arrow::MemoryPool *pool, std::vector<std::shared_ptr<arrow::Array>> *out) override {
+    out->resize(NumStates());
+    arrow::Status status = MakeStateArray<arrow::Int64Type>(pool, counts_, &(*out)[0]);
+    if (!status.ok()) {
+      return status;
+    }
+    status = MakeStateArray<arrow::DoubleType>(pool, means_, &(*out)[1]);
+    if (!status.ok() || !variance_) {
+      return status;
+    }
+    return MakeStateArray<arrow::DoubleType>(pool, m2s_, &(*out)[2]);
+  }
+
+  arrow::Status Finish(arrow::MemoryPool *pool, std::shared_ptr<arrow::Array> *out) override {
+    arrow::DoubleBuilder builder(pool);
+    if (!variance_) {
+      return FinishValues(&builder, means_, counts_, 1, out);
+    }
+    std::vector<double> variances(counts_.size(), 0);
+    for (size_t g = 0; g < counts_.size(); g++) {
+      if (counts_[g] > 1) {
+        variances[g] = m2s_[g] / static_cast<double>(counts_[g] - 1);
+      }
+    }
+    return FinishValues(&builder, variances, counts_, 2, out);
+  }
+
+  std::shared_ptr<arrow::DataType> OutputType() const override {
+    return arrow::float64();
+  }
+
+ private:
+  bool variance_;
+  std::vector<int64_t> counts_;
+  std::vector<double> means_;
+  std::vector<double> m2s_;
+};
+
+template<typename T>
+using SumArrowType = typename std::conditional<std::is_floating_point<T>::value, arrow::DoubleType,
+                                               typename std::conditional<std::is_signed<T>::value,
+                                                                         arrow::Int64Type,
+                                                                         arrow::UInt64Type>::type>::type;
+
+template<typename TYPE>
+static AggregateKernel *CreateNumericKernel(const std::shared_ptr<arrow::DataType> &type, AggregationOp op) {
+  using T = typename TYPE::c_type;
+  switch (op) {
+    case twisterx::groupby::config::COUNT:
+      return std::is_floating_point<T>::value ? new FloatingCountKernel<TYPE>() : new CountKernel();
+    case twisterx::groupby::config::SUM:return new SumKernel<TYPE, SumArrowType<T>>();
+    case twisterx::groupby::config::MIN:return new MinMaxKernel<TYPE, true>(type);
+    case twisterx::groupby::config::MAX:return new MinMaxKernel<TYPE, false>(type);
+    case twisterx::groupby::config::MEAN:return new MomentsKernel<TYPE>(false);
+    case twisterx::groupby::config::VAR:return new MomentsKernel<TYPE>(true);
+  }
+  return nullptr;
+}
+
+template<typename TYPE>
+static AggregateKernel *CreateTemporalKernel(const std::shared_ptr<arrow::DataType> &type, AggregationOp op) {
+  switch (op) {
+    case twisterx::groupby::config::COUNT:return new CountKernel();
+    case twisterx::groupby::config::MIN:return new MinMaxKernel<TYPE, true>(type);
+    case twisterx::groupby::config::MAX:return new MinMaxKernel<TYPE, false>(type);
+    default:return nullptr;
+  }
+}
+
+arrow::Status CreateAggregateKernel(const std::shared_ptr<arrow::DataType> &type,
+                                    AggregationOp op,
+                                    std::unique_ptr<AggregateKernel> *out) {
+  AggregateKernel *kernel;
+  switch (type->id()) {
+    case arrow::Type::UINT8:kernel = CreateNumericKernel<arrow::UInt8Type>(type, op);
+      break;
+    case arrow::Type::INT8:kernel = CreateNumericKernel<arrow::Int8Type>(type, op);
+      break;
+    case arrow::Type::UINT16:kernel = CreateNumericKernel<arrow::UInt16Type>(type, op);
+      break;
+    case arrow::Type::INT16:kernel = CreateNumericKernel<arrow::Int16Type>(type, op);
+      break;
+    case arrow::Type::UINT32:kernel = CreateNumericKernel<arrow::UInt32Type>(type, op);
+      break;
+    case arrow::Type::INT32:kernel = CreateNumericKernel<arrow::Int32Type>(type, op);
+      break;
+    case arrow::Type::UINT64:kernel = CreateNumericKernel<arrow::UInt64Type>(type, op);
+      break;
+    case arrow::Type::INT64:kernel = CreateNumericKernel<arrow::Int64Type>(type, op);
+      break;
+    case arrow::Type::FLOAT:kernel = CreateNumericKernel<arrow::FloatType>(type, op);
+      break;
+    case arrow::Type::DOUBLE:kernel = CreateNumericKernel<arrow::DoubleType>(type, op);
+      break;
+    case arrow::Type::DATE32:kernel = CreateTemporalKernel<arrow::Date32Type>(type, op);
+      break;
+    case arrow::Type::DATE64:kernel = CreateTemporalKernel<arrow::Date64Type>(type, op);
+      break;
+    case arrow::Type::TIMESTAMP:kernel = CreateTemporalKernel<arrow::TimestampType>(type, op);
+      break;
+    case arrow::Type::TIME32:kernel = CreateTemporalKernel<arrow::Time32Type>(type, op);
+      break;
+    case arrow::Type::TIME64:kernel = CreateTemporalKernel<arrow::Time64Type>(type, op);
+      break;
+    default:kernel = op == twisterx::groupby::config::COUNT ? new CountKernel() : nullptr;
+  }
+  if (kernel == nullptr) {
+    return arrow::Status::NotImplemented("Aggregate " + twisterx::groupby::config::AggregationOpName(op)
+                                             + " of type " + type->ToString());
+  }
+  out->reset(kernel);
+  return arrow::Status::OK();
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_ARROW_AGGREGATE_KERNELS_H
+#define TWISTERX_ARROW_AGGREGATE_KERNELS_H
+
+#include <memory>
+#include <vector>
+#include <arrow/api.h>
+
+#include "../groupby/groupby_config.h"
+
+namespace twisterx {
+
+/**
+ * The state of an aggregate for each group of a group by, kept in typed arrays indexed by the dense group ids. The
+ * states are updated a column at a time, the null values are skipped. The states can be taken as partial states and
+ * merged into the kernel of another rank, so a distributed group by shuffles the states instead of the rows.
+ */
+class AggregateKernel {
+ public:
+  virtual ~AggregateKernel() = default;
+
+  /**
+   * Add the values to the states of their groups
+   * @param values the values, a chunk of the column
+   * @param group_ids the group of each value
+   * @param num_groups the number of groups, the states grow to it
+   */
+  virtual void Update(const arrow::Array &values, const int64_t *group_ids, int64_t num_groups) = 0;
+
+  /**
+   * Merge partial states into the states of their groups
+   * @param states the arrays of the partial states, in the layout of States
+   * @param group_ids the group of each partial state
+   * @param num_groups the number of groups, the states grow to it
+   */
+  virtual void Merge(const std::vector<std::shared_ptr<arrow::Array>> &states,
+                     const int64_t *group_ids,
+                     int64_t num_groups) = 0;
+
+  /**
+   * The number of arrays of the partial states
+   */
+  virtual int NumStates() const = 0;
+
+  /**
+   * The partial states of the groups. A count is a count, a sum is a sum and a count, min and max are the values,
+   * null for the groups without values, a mean is a count and a mean, and a variance is a count, a mean and the sum
+   * of the squared differences from the mean.
+   * @param pool the memory pool
+   * @param out NumStates arrays with the states of each group id
+   */
+  virtual arrow::Status States(arrow::MemoryPool *pool, std::vector<std::shared_ptr<arrow::Array>> *out) = 0;
+
+  /**
+   * The aggregate of each group, null for the groups without values. The variance is null for the groups with less
+   * than two values.
+   * @param pool the memory pool
+   * @param out an array with the aggregate of each group id
+   */
+  virtual arrow::Status Finish(arrow::MemoryPool *pool, std::shared_ptr<arrow::Array> *out) = 0;
+
+  /**
+   * The type of the aggregates
+   */
+  virtual std::shared_ptr<arrow::DataType> OutputType() const = 0;
+};
+
+/**
+ * Create the kernel of an aggregate of a column. Count takes any type, min and max take numeric, date and time
+ * values, and sum, mean and variance take numeric values.
+ * @param type the type of the column
+ * @param op the aggregate
+ * @param out the kernel
+ * @return the status, NotImplemented if the aggregate doesn't take the type
+ */
+arrow::Status CreateAggregateKernel(const std::shared_ptr<arrow::DataType> &type,
+                                    twisterx::groupby::config::AggregationOp op,
+                                    std::unique_ptr<AggregateKernel> *out);
+
+}
+
+#endif //TWISTERX_ARROW_AGGREGATE_KERNELS_H
@@ -14,9 +14,145 @@
 
 #include "arrow_all_to_all.hpp"
 
+#include <arrow/util/bit_util.h>
 #include <glog/logging.h>
 
 namespace twisterx {
+
+/**
+ * The way the buffers of an array are laid out, we use this to figure out which part of a buffer
+ * belongs to a sliced array
+ */
+enum ArrowBufferLayout {
+  // validity bitmap followed by a fixed width value buffer
+  ARROW_LAYOUT_FIXED_WIDTH,
+  // validity bitmap, 32 bit offsets and the data
+  ARROW_LAYOUT_BINARY,
+  // validity bitmap, 64 bit offsets and the data
+  ARROW_LAYOUT_LARGE_BINARY,
+  // we don't know how to trim these buffers, so we send them as they are
+  ARROW_LAYOUT_OTHER
+};
+
+static ArrowBufferLayout GetBufferLayout(const arrow::DataType &type) {
+  switch (type.id()) {
+    case arrow::Type::NA:
+    case arrow::Type::DICTIONARY:return ARROW_LAYOUT_OTHER;
+    case arrow::Type::STRING:
+    case arrow::Type::BINARY:return ARROW_LAYOUT_BINARY;
+    case arrow::Type::LARGE_STRING:
+    case arrow::Type::LARGE_BINARY:return ARROW_LAYOUT_LARGE_BINARY;
+    default:
+      if (dynamic_cast<const arrow::FixedWidthType *>(&type) != nullptr) {
+        return ARROW_LAYOUT_FIXED_WIDTH;
+      }
+      return ARROW_LAYOUT_OTHER;
+  }
+}
+
+/**
+ * The offset the receiver should use for the array. For the layouts we understand, we only send the
+ * buffer ranges covered by the array starting from a byte boundary, so the offset is below 8
+ */
+static int64_t GetWireOffset(const std::shared_ptr<arrow::ArrayData> &data) {
+  if (GetBufferLayout(*data->type) == ARROW_LAYOUT_OTHER) {
+    return data->offset;
+  }
+  return data->offset % 8;
+}
+
+/**
+ * Get the part of the buffer that needs to be sent for this array, this doesn't copy the buffer
+ * @param data the array data
+ * @param index index of the buffer
+ * @param start start of the memory to send
+ * @param size number of bytes to send
+ */
+static void GetWireBuffer(const std::shared_ptr<arrow::ArrayData> &data, size_t index,
+                          const uint8_t **start, int64_t *size) {
+  const std::shared_ptr<arrow::Buffer> &buf = data->buffers[index];
+  if (buf == nullptr) {
+    *start = nullptr;
+    *size = 0;
+    return;
+  }
+
+  ArrowBufferLayout layout = GetBufferLayout(*data->type);
+  if (layout == ARROW_LAYOUT_OTHER) {
+    *start = buf->data();
+    *size = buf->size();
+    return;
+  }
+
+  // we start at the byte boundary before the offset, so that bitmaps doesn't need shifting
+  int64_t first = data->offset - GetWireOffset(data);
+  int64_t count = GetWireOffset(data) + data->length;
+  if (index == 0) {
+    *start = buf->data() + first / 8;
+    *size = arrow::BitUtil::BytesForBits(count);
+    return;
+  }
+
+  switch (layout) {
+    case ARROW_LAYOUT_FIXED_WIDTH: {
+      int bit_width = static_cast<const arrow::FixedWidthType &>(*data->type).bit_width();
+      if (bit_width == 1) {
+        *start = buf->data() + first / 8;
+        *size = arrow::BitUtil::BytesForBits(count);
+      } else {
+        *start = buf->data() + first * (bit_width / 8);
+        *size = count * (bit_width / 8);
+      }
+      return;
+    }
+    case ARROW_LAYOUT_BINARY: {
+      if (index == 1) {
+        *start = buf->data() + first * sizeof(int32_t);
+        *size = (count + 1) * sizeof(int32_t);
+      } else {
+        auto offsets = reinterpret_cast<const int32_t *>(data->buffers[1]->data());
+        *start = buf->data() + offsets[first];
+        *size = offsets[first + count] - offsets[first];
+      }
+      return;
+    }
+    case ARROW_LAYOUT_LARGE_BINARY: {
+      if (index == 1) {
+        *start = buf->data() + first * sizeof(int64_t);
+        *size = (count + 1) * sizeof(int64_t);
+      } else {
+        auto offsets = reinterpret_cast<const int64_t *>(data->buffers[1]->data());
+        *start = buf->data() + offsets[first];
+        *size = offsets[first + count] - offsets[first];
+      }
+      return;
+    }
+    default:*start = buf->data();
+      *size = buf->size();
+  }
+}
+
+/**
+ * The value offsets we receive for binary arrays start from the first value we sent, so we need
+ * to re-base them to start from 0 as the data buffer is trimmed
+ */
+template<typename OFFSET_TYPE>
+static arrow::Status RebaseOffsets(std::shared_ptr<arrow::Buffer> *offsets_buf, arrow::MemoryPool *pool) {
+  auto offsets = reinterpret_cast<const OFFSET_TYPE *>((*offsets_buf)->data());
+  int64_t no_offsets = (*offsets_buf)->size() / sizeof(OFFSET_TYPE);
+  if (no_offsets == 0 || offsets[0] == 0) {
+    return arrow::Status::OK();
+  }
+  std::shared_ptr<arrow::Buffer> rebased;
+  RETURN_NOT_OK(arrow::AllocateBuffer(pool, (*offsets_buf)->size(), &rebased));
+  auto rebased_offsets = reinterpret_cast<OFFSET_TYPE *>(rebased->mutable_data());
+  OFFSET_TYPE base = offsets[0];
+  for (int64_t i = 0; i < no_offsets; i++) {
+    rebased_offsets[i] = offsets[i] - base;
+  }
+  *offsets_buf = rebased;
+  return arrow::Status::OK();
+}
 ArrowAllToAll::ArrowAllToAll(twisterx::TwisterXContext *ctx,
                              const std::vector<int> &source,
                              const std::vector<int> &targets,
@@ -32,8 +168,15 @@ ArrowAllToAll::ArrowAllToAll(twisterx::TwisterXContext *ctx,
   workerId_ = ctx->GetRank();
   pool_ = pool;
 
+  // open the metrics before the all to all, so that it records into ours
+  metrics_registry_ = ctx->GetMetrics();
+  metrics_ = metrics_registry_->Open(edgeId, "ArrowAllToAll");
+  if (metrics_ != nullptr) {
+    metrics_->BeginPhase("insert");
+  }
+
   // we need to pass the correct arguments
-  all_ = std::make_shared<AllToAll>(ctx, source, targets, edgeId, this);
+  all_ = AllToAll::Create(ctx, source, targets, edgeId, this);
 
   // add the trackers for sending
   for (auto t : targets) {
@@ -50,6 +193,9 @@ int ArrowAllToAll::insert(const std::shared_ptr<arrow::Table> &arrow, int target
   // lets save the table into pending and move on
   std::shared_ptr<PendingSendTable> st = inputs_[target];
   st->pending.push(arrow);
+  if (metrics_ != nullptr) {
+    metrics_->Peer(target).tables_sent++;
+  }
   return 1;
 }
 
@@ -77,17 +223,22 @@ bool ArrowAllToAll::isComplete() {
 
           std::shared_ptr<arrow::ArrayData> data = arr->data();
           while (static_cast<size_t>(t.second->bufferIndex) < data->buffers.size()) {
-            std::shared_ptr<arrow::Buffer> buf = data->buffers[t.second->bufferIndex];
-            int hdr[5];
+            // we only send the part of the buffer used by this array, so slices go without a copy
+            const uint8_t *buf = nullptr;
+            int64_t buf_size = 0;
+            GetWireBuffer(data, t.second->bufferIndex, &buf, &buf_size);
+            int hdr[7];
             hdr[0] = t.second->columnIndex;
             hdr[1] = t.second->bufferIndex;
             hdr[2] = data->buffers.size();
             hdr[3] = cArr->chunks().size();
             hdr[4] = data->length;
+            hdr[5] = GetWireOffset(data);
+            hdr[6] = arr->null_count();
             // lets send this buffer, we need to send the length at this point
-            // const uint8_t *b = buf->data();
-            // LOG(INFO) << workerId_ <<  " Sent length " << (int) buf->size() << " last: " << (int) b[(int) buf->size() / 2 - 1];
-            bool accept = all_->insert((void *) buf->data(), (int) buf->size(), t.first, hdr, 5);
+            // the arrow buffer owns the memory, so channels in the same process can share it
+            bool accept = all_->insert((void *) buf, (int) buf_size, t.first, hdr, 7,
+                                       data->buffers[t.second->bufferIndex]);
             if (!accept) {
               canContinue = false;
               break;
@@ -126,10 +277,19 @@ bool ArrowAllToAll::isComplete() {
     all_->finish();
   }
 
-  return isAllEmpty && all_->isComplete() && finishedSources_.size() == srcs_.size();
+  bool complete = isAllEmpty && all_->isComplete() && finishedSources_.size() == srcs_.size();
+  if (complete && !completed_ && metrics_ != nullptr) {
+    metrics_->EndPhase("complete");
+  }
+  completed_ = complete;
+  return complete;
 }
 
 void ArrowAllToAll::finish() {
+  if (!finished && metrics_ != nullptr) {
+    metrics_->EndPhase("insert");
+    metrics_->BeginPhase("complete");
+  }
   finished = true;
 }
 
@@ -138,6 +298,13 @@ void ArrowAllToAll::close() {
   inputs_.clear();
   // call close on the underlying allto all
   all_->close();
+  if (metrics_ != nullptr) {
+    metrics_registry_->Close(metrics_);
+  }
+}
+
+std::shared_ptr<EdgeMetrics> ArrowAllToAll::GetMetrics() {
+  return metrics_;
 }
 
 void debug(int thisWorker, std::string msg) {
@@ -147,18 +314,46 @@ void debug(int thisWorker, std::string msg) {
 }
 
 bool ArrowAllToAll::onReceive(int source, void *buffer, int length) {
-  std::shared_ptr<PendingReceiveTable> table = receives_[source];
-  receivedBuffers_++;
   // create the buffer hosting the value
   std::shared_ptr<arrow::Buffer> buf = std::make_shared<arrow::Buffer>((uint8_t *) buffer, length);
+  return onReceiveBuffer(source, buf);
+}
+
+bool ArrowAllToAll::onReceiveShared(int source, void *buffer, int length, const std::shared_ptr<void> &owner) {
+  if (owner == nullptr) {
+    return ReceiveCallback::onReceiveShared(source, buffer, length, owner);
+  }
+  // we only pass arrow buffers as owners, so we can slice the part we sent
+  std::shared_ptr<arrow::Buffer> parent = std::static_pointer_cast<arrow::Buffer>(owner);
+  int64_t offset = static_cast<const uint8_t *>(buffer) - parent->data();
+  return onReceiveBuffer(source, arrow::SliceBuffer(parent, offset, length));
+}
+
+bool ArrowAllToAll::onReceiveBuffer(int source, const std::shared_ptr<arrow::Buffer> &buf) {
+  std::shared_ptr<PendingReceiveTable> table = receives_[source];
+  receivedBuffers_++;
   debug(this->workerId_, "before push");
   table->buffers.push_back(buf);
   debug(this->workerId_, "after push");
   // now check weather we have the expected number of buffers received
   if (table->noBuffers == table->bufferIndex + 1) {
+    const std::shared_ptr<arrow::DataType> &type = schema_->field(table->columnIndex)->type();
+    // an empty validity buffer means there are no nulls in the array
+    if (!table->buffers.empty() && table->buffers[0]->size() == 0) {
+      table->buffers[0] = nullptr;
+    }
+    ArrowBufferLayout layout = GetBufferLayout(*type);
+    if (table->buffers.size() > 1 && (layout == ARROW_LAYOUT_BINARY || layout == ARROW_LAYOUT_LARGE_BINARY)) {
+      arrow::Status status = layout == ARROW_LAYOUT_BINARY ? RebaseOffsets<int32_t>(&table->buffers[1], pool_)
+                                                           : RebaseOffsets<int64_t>(&table->buffers[1], pool_);
+      if (!status.ok()) {
+        LOG(FATAL) << "Failed to re-base the value offsets " << status.ToString();
+        return false;
+      }
+    }
     // okay we are done with this array
     std::shared_ptr<arrow::ArrayData> data = arrow::ArrayData::Make(
-        schema_->field(table->columnIndex)->type(), table->length, table->buffers);
+        type, table->length, table->buffers, table->nullCount, table->offset);
     // clears the buffers
     debug(this->workerId_, "before clear buffers");
     table->buffers.clear();
@@ -193,6 +388,9 @@ bool ArrowAllToAll::onReceive(int source, void *buffer, int length) {
         debug(this->workerId_, "after clear chunk arrays");
 
         debug(this->workerId_, "before call on recv");
+        if (metrics_ != nullptr) {
+          metrics_->Peer(source).tables_received++;
+        }
         recv_callback_->onReceive(source, tablePtr);
         debug(this->workerId_, "after call on recv");
       }
@@ -206,8 +404,8 @@ bool ArrowAllToAll::onReceive(int source, void *buffer, int length) {
 
 bool ArrowAllToAll::onReceiveHeader(int source, int finished, int *buffer, int length) {
   if (!finished) {
-    if (length != 5) {
-      LOG(FATAL) << "Incorrect length on header, expected 5 ints got " << length;
+    if (length != 7) {
+      LOG(FATAL) << "Incorrect length on header, expected 7 ints got " << length;
       return false;
     }
 
@@ -217,6 +415,8 @@ bool ArrowAllToAll::onReceiveHeader(int source, int finished, int *buffer, int l
     table->noBuffers = buffer[2];
     table->noArray = buffer[3];
     table->length = buffer[4];
+    table->offset = buffer[5];
+    table->nullCount = buffer[6];
   } else {
     finishedSources_.push_back(source);
   }
@@ -63,6 +63,10 @@ struct PendingReceiveTable {
   int noArray{};
   // the length of the current array data
   int length{};
+  // the offset of the current array data
+  int offset{};
+  // the null count of the current array data
+  int nullCount{};
   // keep the current columns
   std::vector<std::shared_ptr<arrow::ChunkedArray>> currentArrays;
   // keep the current buffers
@@ -137,6 +141,11 @@ class ArrowAllToAll : public ReceiveCallback {
    */
   bool onReceive(int source, void *buffer, int length) override;
 
+  /**
+   * A buffer is received without a copy, the owner is the arrow buffer we passed at the sender
+   */
+  bool onReceiveShared(int source, void *buffer, int length, const std::shared_ptr<void> &owner) override;
+
   /**
    * We implement the receive callback
    * @param request the original request, we can free it now
@@ -145,7 +154,18 @@ class ArrowAllToAll : public ReceiveCallback {
 
   bool onSendComplete(int target, void *buffer, int length) override;
 
+  /**
+   * The communication metrics of this operation
+   * @return the metrics, nullptr if the metrics are not enabled
+   */
+  std::shared_ptr<EdgeMetrics> GetMetrics();
+
  private:
+  /**
+   * Add a received buffer to the array being built for the source
+   */
+  bool onReceiveBuffer(int source, const std::shared_ptr<arrow::Buffer> &buf);
+
   /**
    * The targets
    */
@@ -205,6 +225,21 @@ class ArrowAllToAll : public ReceiveCallback {
    * The memory pool
    */
   arrow::MemoryPool *pool_;
+
+  /**
+   * The metrics registry of the context
+   */
+  CommMetrics *metrics_registry_;
+
+  /**
+   * The metrics of this operation, shared with the underlying all to all
+   */
+  std::shared_ptr<EdgeMetrics> metrics_;
+
+  /**
+   * We have seen the completion
+   */
+  bool completed_ = false;
 };
 }
 #endif //TWISTERX_ARROW_H
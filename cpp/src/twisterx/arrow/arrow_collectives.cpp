@@ -0,0 +1,129 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "arrow_collectives.hpp"
+
+#include <arrow/io/memory.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
+#include <utility>
+
+namespace twisterx {
+
+/**
+ * An arrow buffer owning the memory of a vector
+ */
+class VectorBuffer : public arrow::Buffer {
+ public:
+  explicit VectorBuffer(std::vector<uint8_t> &&data) : arrow::Buffer(nullptr, 0), vector_(std::move(data)) {
+    data_ = vector_.data();
+    size_ = vector_.size();
+    capacity_ = size_;
+  }
+
+ private:
+  std::vector<uint8_t> vector_;
+};
+
+arrow::Status SerializeTable(const std::shared_ptr<arrow::Table> &table, std::vector<uint8_t> *out) {
+  std::shared_ptr<arrow::io::BufferOutputStream> stream;
+  RETURN_NOT_OK(arrow::io::BufferOutputStream::Create(0, arrow::default_memory_pool(), &stream));
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+  RETURN_NOT_OK(arrow::ipc::RecordBatchStreamWriter::Open(stream.get(), table->schema(), &writer));
+  RETURN_NOT_OK(writer->WriteTable(*table));
+  RETURN_NOT_OK(writer->Close());
+  std::shared_ptr<arrow::Buffer> buf;
+  RETURN_NOT_OK(stream->Finish(&buf));
+  out->assign(buf->data(), buf->data() + buf->size());
+  return arrow::Status::OK();
+}
+
+arrow::Status DeserializeTable(std::vector<uint8_t> &&data, std::shared_ptr<arrow::Table> *table) {
+  std::shared_ptr<arrow::Buffer> buf = std::make_shared<VectorBuffer>(std::move(data));
+  auto input = std::make_shared<arrow::io::BufferReader>(buf);
+  std::shared_ptr<arrow::RecordBatchReader> reader;
+  RETURN_NOT_OK(arrow::ipc::RecordBatchStreamReader::Open(input, &reader));
+  return reader->ReadAll(table);
+}
+
+/**
+ * Serialize the table of a rank taking part in a collective. A rank that fails still takes part with an empty
+ * buffer, which no table serializes to, so the other ranks don't wait for it and see the failure.
+ */
+static arrow::Status SerializeForCollective(const std::shared_ptr<arrow::Table> &table, std::vector<uint8_t> *out) {
+  arrow::Status status = SerializeTable(table, out);
+  if (!status.ok()) {
+    out->clear();
+  }
+  return status;
+}
+
+static arrow::Status DeserializeFromCollective(std::vector<uint8_t> &&data, std::shared_ptr<arrow::Table> *table) {
+  if (data.empty()) {
+    return arrow::Status::Invalid("A rank failed to serialize its table");
+  }
+  return DeserializeTable(std::move(data), table);
+}
+
+arrow::Status BroadcastTable(twisterx::TwisterXContext *ctx, std::shared_ptr<arrow::Table> *table, int root) {
+  std::vector<uint8_t> data;
+  arrow::Status status;
+  if (ctx->GetRank() == root) {
+    status = SerializeForCollective(*table, &data);
+  }
+  ctx->GetCommunicator()->Broadcast(&data, root);
+  if (ctx->GetRank() != root) {
+    status = DeserializeFromCollective(std::move(data), table);
+  }
+  return status;
+}
+
+static arrow::Status DeserializeTables(std::vector<std::vector<uint8_t>> &&data,
+                                       std::vector<std::shared_ptr<arrow::Table>> *tables) {
+  tables->clear();
+  for (auto &d : data) {
+    std::shared_ptr<arrow::Table> t;
+    RETURN_NOT_OK(DeserializeFromCollective(std::move(d), &t));
+    tables->push_back(t);
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status GatherTables(twisterx::TwisterXContext *ctx,
+                           const std::shared_ptr<arrow::Table> &table,
+                           int root,
+                           std::vector<std::shared_ptr<arrow::Table>> *tables) {
+  std::vector<uint8_t> data;
+  arrow::Status status = SerializeForCollective(table, &data);
+  std::vector<std::vector<uint8_t>> gathered;
+  ctx->GetCommunicator()->Gather(data, root, &gathered);
+  if (ctx->GetRank() == root && status.ok()) {
+    return DeserializeTables(std::move(gathered), tables);
+  }
+  return status;
+}
+
+arrow::Status AllGatherTables(twisterx::TwisterXContext *ctx,
+                              const std::shared_ptr<arrow::Table> &table,
+                              std::vector<std::shared_ptr<arrow::Table>> *tables) {
+  std::vector<uint8_t> data;
+  arrow::Status status = SerializeForCollective(table, &data);
+  std::vector<std::vector<uint8_t>> gathered;
+  ctx->GetCommunicator()->AllGather(data, &gathered);
+  if (!status.ok()) {
+    return status;
+  }
+  return DeserializeTables(std::move(gathered), tables);
+}
+}
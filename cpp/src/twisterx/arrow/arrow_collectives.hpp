@@ -0,0 +1,72 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_ARROW_ARROW_COLLECTIVES_HPP_
+#define TWISTERX_SRC_TWISTERX_ARROW_ARROW_COLLECTIVES_HPP_
+
+#include <arrow/api.h>
+#include <vector>
+#include "../ctx/twisterx_context.h"
+
+namespace twisterx {
+
+/**
+ * Serialize a table with the arrow IPC stream format
+ * @param table the table
+ * @param out the serialized bytes
+ */
+arrow::Status SerializeTable(const std::shared_ptr<arrow::Table> &table, std::vector<uint8_t> *out);
+
+/**
+ * Read a table serialized with SerializeTable, the table takes the ownership of the bytes without a copy
+ * @param data the serialized bytes
+ * @param table the table
+ */
+arrow::Status DeserializeTable(std::vector<uint8_t> &&data, std::shared_ptr<arrow::Table> *table);
+
+/**
+ * Broadcast a table from the root to all the ranks. If the root fails to serialize the table, every rank still
+ * returns and the other ranks return an error
+ * @param ctx the context
+ * @param table the table at the root, the received table at the other ranks
+ * @param root the rank broadcasting
+ */
+arrow::Status BroadcastTable(twisterx::TwisterXContext *ctx, std::shared_ptr<arrow::Table> *table, int root);
+
+/**
+ * Gather the tables of all the ranks at the root. A rank failing to serialize its table still takes part, and the
+ * root returns an error
+ * @param ctx the context
+ * @param table the table of this rank
+ * @param root the rank gathering
+ * @param tables the tables indexed by the rank, only set at the root
+ */
+arrow::Status GatherTables(twisterx::TwisterXContext *ctx,
+                           const std::shared_ptr<arrow::Table> &table,
+                           int root,
+                           std::vector<std::shared_ptr<arrow::Table>> *tables);
+
+/**
+ * Gather the tables of all the ranks at every rank. A rank failing to serialize its table still takes part, and
+ * every rank returns an error
+ * @param ctx the context
+ * @param table the table of this rank
+ * @param tables the tables indexed by the rank
+ */
+arrow::Status AllGatherTables(twisterx::TwisterXContext *ctx,
+                              const std::shared_ptr<arrow::Table> &table,
+                              std::vector<std::shared_ptr<arrow::Table>> *tables);
+}
+
+#endif //TWISTERX_SRC_TWISTERX_ARROW_ARROW_COLLECTIVES_HPP_
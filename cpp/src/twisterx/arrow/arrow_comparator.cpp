@@ -13,6 +13,11 @@
  */
 
 #include "arrow_comparator.h"
+
+#include <cstring>
+#include <arrow/util/decimal.h>
+#include "../util/arrow_utils.hpp"
+
 namespace twisterx {
 
 template<typename ARROW_TYPE>
@@ -36,31 +41,87 @@ class NumericArrowComparator : public ArrowComparator {
   }
 };
 
+class BooleanArrowComparator : public ArrowComparator {
+  int compare(std::shared_ptr<arrow::Array> array1,
+              int64_t index1,
+              std::shared_ptr<arrow::Array> array2,
+              int64_t index2) override {
+    auto reader1 = std::static_pointer_cast<arrow::BooleanArray>(array1);
+    auto reader2 = std::static_pointer_cast<arrow::BooleanArray>(array2);
+    return static_cast<int>(reader1->Value(index1)) - static_cast<int>(reader2->Value(index2));
+  }
+};
+
+/**
+ * Compare the binary and string values by their bytes
+ */
+template<typename ARROW_TYPE>
+class BinaryArrowComparator : public ArrowComparator {
+  int compare(std::shared_ptr<arrow::Array> array1,
+              int64_t index1,
+              std::shared_ptr<arrow::Array> array2,
+              int64_t index2) override {
+    using ARRAY_TYPE = typename arrow::TypeTraits<ARROW_TYPE>::ArrayType;
+    auto reader1 = std::static_pointer_cast<ARRAY_TYPE>(array1);
+    auto reader2 = std::static_pointer_cast<ARRAY_TYPE>(array2);
+    return reader1->GetView(index1).compare(reader2->GetView(index2));
+  }
+};
+
+class FixedSizeBinaryArrowComparator : public ArrowComparator {
+  int compare(std::shared_ptr<arrow::Array> array1,
+              int64_t index1,
+              std::shared_ptr<arrow::Array> array2,
+              int64_t index2) override {
+    auto reader1 = std::static_pointer_cast<arrow::FixedSizeBinaryArray>(array1);
+    auto reader2 = std::static_pointer_cast<arrow::FixedSizeBinaryArray>(array2);
+    return std::memcmp(reader1->GetValue(index1), reader2->GetValue(index2), reader1->byte_width());
+  }
+};
+
+class DecimalArrowComparator : public ArrowComparator {
+  int compare(std::shared_ptr<arrow::Array> array1,
+              int64_t index1,
+              std::shared_ptr<arrow::Array> array2,
+              int64_t index2) override {
+    auto reader1 = std::static_pointer_cast<arrow::Decimal128Array>(array1);
+    auto reader2 = std::static_pointer_cast<arrow::Decimal128Array>(array2);
+    arrow::Decimal128 value1(reader1->GetValue(index1));
+    arrow::Decimal128 value2(reader2->GetValue(index2));
+    if (value1 < value2) {
+      return -1;
+    } else if (value1 > value2) {
+      return 1;
+    }
+    return 0;
+  }
+};
+
 ArrowComparator *GetComparator(const std::shared_ptr<arrow::DataType> &type) {
   switch (type->id()) {
     case arrow::Type::NA:break;
-    case arrow::Type::BOOL:break;
+    case arrow::Type::BOOL:return new BooleanArrowComparator();
     case arrow::Type::UINT8:return new NumericArrowComparator<arrow::UInt8Type>();
     case arrow::Type::INT8:return new NumericArrowComparator<arrow::Int8Type>();
     case arrow::Type::UINT16:return new NumericArrowComparator<arrow::UInt16Type>();
     case arrow::Type::INT16:return new NumericArrowComparator<arrow::Int16Type>();
     case arrow::Type::UINT32:return new NumericArrowComparator<arrow::UInt32Type>();
-    case arrow::Type::INT32:return new NumericArrowComparator<arrow::Int16Type>();
+    case arrow::Type::INT32:return new NumericArrowComparator<arrow::Int32Type>();
     case arrow::Type::UINT64:return new NumericArrowComparator<arrow::UInt64Type>();
     case arrow::Type::INT64:return new NumericArrowComparator<arrow::Int64Type>();
     case arrow::Type::HALF_FLOAT:return new NumericArrowComparator<arrow::HalfFloatType>();
     case arrow::Type::FLOAT:return new NumericArrowComparator<arrow::FloatType>();
     case arrow::Type::DOUBLE:return new NumericArrowComparator<arrow::DoubleType>();
-    case arrow::Type::STRING:break;
-    case arrow::Type::BINARY:break;
-    case arrow::Type::FIXED_SIZE_BINARY:break;
-    case arrow::Type::DATE32:break;
-    case arrow::Type::DATE64:break;
-    case arrow::Type::TIMESTAMP:break;
-    case arrow::Type::TIME32:break;
-    case arrow::Type::TIME64:break;
+    case arrow::Type::STRING:return new BinaryArrowComparator<arrow::StringType>();
+    case arrow::Type::BINARY:return new BinaryArrowComparator<arrow::BinaryType>();
+    case arrow::Type::FIXED_SIZE_BINARY:return new FixedSizeBinaryArrowComparator();
+    case arrow::Type::DATE32:return new NumericArrowComparator<arrow::Date32Type>();
+    case arrow::Type::DATE64:return new NumericArrowComparator<arrow::Date64Type>();
+    case arrow::Type::TIMESTAMP:return new NumericArrowComparator<arrow::TimestampType>();
+    case arrow::Type::TIME32:return new NumericArrowComparator<arrow::Time32Type>();
+    case arrow::Type::TIME64:return new NumericArrowComparator<arrow::Time64Type>();
     case arrow::Type::INTERVAL:break;
-    case arrow::Type::DECIMAL:break;
+    case arrow::Type::DECIMAL:return new DecimalArrowComparator();
     case arrow::Type::LIST:break;
     case arrow::Type::STRUCT:break;
     case arrow::Type::UNION:break;
@@ -69,10 +130,11 @@ ArrowComparator *GetComparator(const std::shared_ptr<arrow::DataType> &type) {
     case arrow::Type::EXTENSION:break;
     case arrow::Type::FIXED_SIZE_LIST:break;
     case arrow::Type::DURATION:break;
-    case arrow::Type::LARGE_STRING:break;
-    case arrow::Type::LARGE_BINARY:break;
+    case arrow::Type::LARGE_STRING:return new BinaryArrowComparator<arrow::LargeStringType>();
+    case arrow::Type::LARGE_BINARY:return new BinaryArrowComparator<arrow::LargeBinaryType>();
     case arrow::Type::LARGE_LIST:break;
   }
+  return nullptr;
 }
 
 TableRowComparator::TableRowComparator(const std::vector<std::shared_ptr<arrow::Field>> fields) {
@@ -89,9 +151,10 @@ int TableRowComparator::compare(const std::shared_ptr<arrow::Table> &table1,
   // before calling this function from an internal twisterx function, schema validation should be done to make sure
   // table1 and table2 has the same schema.
   for (int c = 0; c < table1->num_columns(); ++c) {
-    int comparision =
-        this->comparators[c]->compare(table1->column(c)->chunk(0), index1,
-                                      table2->column(c)->chunk(0), index2) != 0;
+    int64_t row1 = index1, row2 = index2;
+    std::shared_ptr<arrow::Array> chunk1 = util::GetChunk(table1->column(c), &row1);
+    std::shared_ptr<arrow::Array> chunk2 = util::GetChunk(table2->column(c), &row2);
+    int comparision = this->comparators[c]->compare(chunk1, row1, chunk2, row2);
     if (comparision != 0) {
       return comparision;
     }
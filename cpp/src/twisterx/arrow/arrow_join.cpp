@@ -14,6 +14,7 @@
 
 #include "arrow_join.hpp"
 #include "../join/join.hpp"
+#include "../join/join_utils.hpp"
 #include "arrow_partition_kernels.hpp"
 #include "arrow_kernels.hpp"
 #include <chrono>
@@ -83,97 +84,53 @@ ArrowJoinWithPartition::ArrowJoinWithPartition(twisterx::TwisterXContext *ctx, c
   join_ = std::make_shared<ArrowJoin>(ctx, source, targets, leftEdgeId, rightEdgeId, callback, schema, pool);
 }
 
+bool ArrowJoinWithPartition::partitionTable(const std::shared_ptr<arrow::Table> &table,
+											int hashColumn,
+											std::unordered_map<int, std::shared_ptr<arrow::Table>> *out) {
+  PartitionIds partitions;
+  // only the hash column is combined if the table has more than one chunk
+  std::shared_ptr<arrow::Array> array;
+  arrow::Status combine_status = twisterx::join::util::CombineColumn(table, hashColumn, &array, pool_);
+  if (!combine_status.ok()) {
+	LOG(FATAL) << "Failed to combine the hash column " << combine_status.message();
+	return false;
+  }
+  // first we partition the table
+  twisterx::Status status = HashPartitionArray(pool_, array, targets_, &partitions);
+  if (!status.is_ok()) {
+	LOG(FATAL) << "Failed to create the hash partition";
+	return false;
+  }
+  // then we split all the columns to the targets
+  status = SplitTable(table, partitions, targets_, pool_, out);
+  if (!status.is_ok()) {
+	LOG(FATAL) << "Failed to split the table";
+	return false;
+  }
+  return true;
+}
+
 bool ArrowJoinWithPartition::isComplete() {
   if (!leftUnPartitionedTables_.empty()) {
 	std::shared_ptr<arrow::Table> left_tab = leftUnPartitionedTables_.front();
-	// keep arrays for each target, these arrays are used for creating the table
-	std::unordered_map<int, std::shared_ptr<std::vector<std::shared_ptr<arrow::Array>>>> data_arrays;
-
-	for (int t : targets_) {
-	  data_arrays.insert(std::pair<int, std::shared_ptr<std::vector<std::shared_ptr<arrow::Array>>>>(t,
-																									 std::make_shared<
-																										 std::vector<std::shared_ptr<
-																											 arrow::Array>>>()));
-	}
-
-	auto column = left_tab->column(leftColumnIndex_);
-	std::vector<int64_t> outPartitions;
-	std::shared_ptr<arrow::Array> array = column->chunk(0);
-	// first we partition the table
-	twisterx::Status status = HashPartitionArray(pool_, array, targets_, &outPartitions);
-	if (!status.is_ok()) {
-	  LOG(FATAL) << "Failed to create the hash partition";
+	std::unordered_map<int, std::shared_ptr<arrow::Table>> tables;
+	if (!partitionTable(left_tab, leftColumnIndex_, &tables)) {
 	  return true;
 	}
-
-	for (int i = 0; i < left_tab->num_columns(); i++) {
-	  std::shared_ptr<arrow::DataType> type = array->type();
-	  std::shared_ptr<ArrowArraySplitKernel> splitKernel;
-	  status = CreateSplitter(type, pool_, &splitKernel);
-	  if (!status.is_ok()) {
-		LOG(FATAL) << "Failed to create the splitter";
-		return true;
-	  }
-
-	  // this one outputs arrays for each target as a map
-	  std::unordered_map<int, std::shared_ptr<arrow::Array>> arrays;
-	  splitKernel->Split(array, outPartitions, targets_, arrays);
-
-	  for (const auto &x : arrays) {
-		std::shared_ptr<std::vector<std::shared_ptr<arrow::Array>>> cols = data_arrays[x.first];
-		cols->push_back(x.second);
-	  }
-	}
-	// now insert these array to
-	for (const auto &x : data_arrays) {
-	  std::shared_ptr<arrow::Table> table = arrow::Table::Make(left_tab->schema(), *x.second);
-	  join_->leftInsert(table, x.first);
+	for (const auto &x : tables) {
+	  join_->leftInsert(x.second, x.first);
 	}
 	leftUnPartitionedTables_.pop();
   }
 
   if (!rightUnPartitionedTables_.empty()) {
-	std::shared_ptr<arrow::Table> left_tab = rightUnPartitionedTables_.front();
-	// keep arrays for each target, these arrays are used for creating the table
-	std::unordered_map<int, std::shared_ptr<std::vector<std::shared_ptr<arrow::Array>>>> data_arrays;
-	for (int t : targets_) {
-	  data_arrays.insert(
-		  std::pair<int, std::shared_ptr<std::vector<std::shared_ptr<arrow::Array>>>>(
-			  t, std::make_shared<std::vector<std::shared_ptr<arrow::Array>>>()));
-	}
-
-	auto column = left_tab->column(rightColumnIndex_);
-	std::vector<int64_t> outPartitions;
-	std::shared_ptr<arrow::Array> array = column->chunk(0);
-	// first we partition the table
-	twisterx::Status status = HashPartitionArray(pool_, array, targets_, &outPartitions);
-	if (!status.is_ok()) {
-	  LOG(FATAL) << "Failed to create the hash partition";
+	std::shared_ptr<arrow::Table> right_tab = rightUnPartitionedTables_.front();
+	std::unordered_map<int, std::shared_ptr<arrow::Table>> tables;
+	if (!partitionTable(right_tab, rightColumnIndex_, &tables)) {
 	  return true;
 	}
-
-	for (int i = 0; i < left_tab->num_columns(); i++) {
-	  std::shared_ptr<arrow::DataType> type = array->type();
-	  std::shared_ptr<ArrowArraySplitKernel> splitKernel;
-	  status = CreateSplitter(type, pool_, &splitKernel);
-	  if (!status.is_ok()) {
-		LOG(FATAL) << "Failed to create the splitter";
-		return true;
-	  }
-
-	  // this one outputs arrays for each target as a map
-	  std::unordered_map<int, std::shared_ptr<arrow::Array>> arrays;
-	  splitKernel->Split(array, outPartitions, targets_, arrays);
-
-	  for (const auto &x : arrays) {
-		std::shared_ptr<std::vector<std::shared_ptr<arrow::Array>>> cols = data_arrays[x.first];
-		cols->push_back(x.second);
-	  }
-	}
-	// now insert these array to
-	for (const auto &x : data_arrays) {
-	  std::shared_ptr<arrow::Table> table = arrow::Table::Make(left_tab->schema(), *x.second);
-	  join_->rightInsert(table, x.first);
+	for (const auto &x : tables) {
+	  join_->rightInsert(x.second, x.first);
 	}
 	rightUnPartitionedTables_.pop();
   }
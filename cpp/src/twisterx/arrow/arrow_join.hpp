@@ -194,6 +194,14 @@ class ArrowJoinWithPartition {
   std::vector<int32_t> targets_;
   int leftColumnIndex_;
   int rightColumnIndex_;
+
+  /**
+   * Partition the table to the targets by hashing the column
+   * @return false if the partitioning failed
+   */
+  bool partitionTable(const std::shared_ptr<arrow::Table> &table,
+					  int hashColumn,
+					  std::unordered_map<int, std::shared_ptr<arrow::Table>> *out);
 };
 
 }
@@ -14,6 +14,12 @@
 
 #include "arrow_kernels.hpp"
 
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <arrow/util/bit_util.h>
+#include "../util/arrow_utils.hpp"
+
 namespace twisterx {
 twisterx::Status CreateSplitter(std::shared_ptr<arrow::DataType> &type,
 								arrow::MemoryPool *pool,
@@ -40,9 +46,30 @@ twisterx::Status CreateSplitter(std::shared_ptr<arrow::DataType> &type,
 	  break;
 	case arrow::Type::DOUBLE:kernel = new DoubleArraySplitter(type, pool);
 	  break;
-	case arrow::Type::FIXED_SIZE_BINARY:kernel = new FixedBinaryArraySplitKernel(type, pool);
+	case arrow::Type::HALF_FLOAT:kernel = new HalfFloatArraySplitter(type, pool);
+	  break;
+	case arrow::Type::BOOL:kernel = new BooleanArraySplitKernel(type, pool);
+	  break;
+	case arrow::Type::DATE32:kernel = new Date32ArraySplitter(type, pool);
+	  break;
+	case arrow::Type::DATE64:kernel = new Date64ArraySplitter(type, pool);
+	  break;
+	case arrow::Type::TIMESTAMP:kernel = new TimestampArraySplitter(type, pool);
+	  break;
+	case arrow::Type::TIME32:kernel = new Time32ArraySplitter(type, pool);
+	  break;
+	case arrow::Type::TIME64:kernel = new Time64ArraySplitter(type, pool);
 	  break;
-	case arrow::Type::BINARY:kernel = new BinaryArraySplitKernel(type, pool);
+	case arrow::Type::FIXED_SIZE_BINARY:
+	case arrow::Type::DECIMAL:kernel = new FixedBinaryArraySplitKernel(type, pool);
+	  break;
+	case arrow::Type::BINARY:kernel = new BinaryArraySplitter(type, pool);
+	  break;
+	case arrow::Type::STRING:kernel = new StringArraySplitter(type, pool);
+	  break;
+	case arrow::Type::LARGE_BINARY:kernel = new LargeBinaryArraySplitter(type, pool);
+	  break;
+	case arrow::Type::LARGE_STRING:kernel = new LargeStringArraySplitter(type, pool);
 	  break;
 	default:LOG(FATAL) << "Un-known type";
 	  return twisterx::Status(twisterx::NotImplemented, "This type not implemented");
@@ -51,176 +78,484 @@ twisterx::Status CreateSplitter(std::shared_ptr<arrow::DataType> &type,
   return twisterx::Status::OK();
 }
 
+arrow::Status ArrowArraySplitKernel::SplitValidity(const std::shared_ptr<arrow::Array> &values,
+												   const PartitionIds &partitions,
+												   std::vector<std::shared_ptr<arrow::Buffer>> *bitmaps,
+												   std::vector<int64_t> *null_counts) {
+  const std::vector<int64_t> &counts = partitions.Counts();
+  bitmaps->assign(counts.size(), nullptr);
+  null_counts->assign(counts.size(), 0);
+  if (values->null_count() == 0) {
+	return arrow::Status::OK();
+  }
+
+  std::vector<uint8_t *> dest;
+  for (size_t p = 0; p < counts.size(); p++) {
+	RETURN_NOT_OK(arrow::AllocateEmptyBitmap(pool_, counts[p], &(*bitmaps)[p]));
+	dest.push_back((*bitmaps)[p]->mutable_data());
+  }
+  std::vector<int64_t> positions(counts.size(), 0);
+  const uint8_t *valid = values->null_bitmap_data();
+  const int64_t offset = values->offset();
+  const int64_t length = values->length();
+  partitions.Visit([&](const auto *ids) {
+	for (int64_t i = 0; i < length; i++) {
+	  auto p = ids[i];
+	  if (arrow::BitUtil::GetBit(valid, offset + i)) {
+		arrow::BitUtil::SetBit(dest[p], positions[p]);
+	  } else {
+		(*null_counts)[p]++;
+	  }
+	  positions[p]++;
+	}
+  });
+  return arrow::Status::OK();
+}
+
+arrow::Status ArrowArraySplitKernel::AllocateBuffers(const std::vector<int64_t> &sizes,
+													 std::vector<std::shared_ptr<arrow::Buffer>> *buffers) {
+  buffers->clear();
+  for (int64_t size : sizes) {
+	std::shared_ptr<arrow::Buffer> buf;
+	RETURN_NOT_OK(arrow::AllocateBuffer(pool_, size, &buf));
+	buffers->push_back(buf);
+  }
+  return arrow::Status::OK();
+}
+
+void ArrowArraySplitKernel::MakeArrays(const PartitionIds &partitions,
+									   const std::vector<int32_t> &targets,
+									   const std::vector<std::vector<std::shared_ptr<arrow::Buffer>>> &buffers,
+									   const std::vector<int64_t> &null_counts,
+									   std::unordered_map<int, std::shared_ptr<arrow::Array>> &out) {
+  for (size_t p = 0; p < targets.size(); p++) {
+	std::shared_ptr<arrow::ArrayData> data = arrow::ArrayData::Make(
+		type_, partitions.Counts()[p], buffers[p], null_counts[p]);
+	out.insert(std::pair<int, std::shared_ptr<arrow::Array>>(targets[p], arrow::MakeArray(data)));
+  }
+}
+
 int FixedBinaryArraySplitKernel::Split(std::shared_ptr<arrow::Array> &values,
-									   const std::vector<int64_t> &partitions,
+									   const PartitionIds &partitions,
 									   const std::vector<int32_t> &targets,
 									   std::unordered_map<int, std::shared_ptr<arrow::Array> > &out) {
   auto reader =
 	  std::static_pointer_cast<arrow::FixedSizeBinaryArray>(values);
-  std::unordered_map<int, std::shared_ptr<arrow::FixedSizeBinaryBuilder>> builders;
-
-  for (int it : targets) {
-	std::shared_ptr<arrow::FixedSizeBinaryBuilder> b = std::make_shared<arrow::FixedSizeBinaryBuilder>(type_, pool_);
-	builders.insert(std::pair<int, std::shared_ptr<arrow::FixedSizeBinaryBuilder>>(it, b));
+  const int32_t width = reader->byte_width();
+  std::vector<std::shared_ptr<arrow::Buffer>> bitmaps;
+  std::vector<int64_t> null_counts;
+  std::vector<std::shared_ptr<arrow::Buffer>> data;
+  std::vector<int64_t> sizes;
+  for (int64_t count : partitions.Counts()) {
+	sizes.push_back(count * width);
+  }
+  arrow::Status status = SplitValidity(values, partitions, &bitmaps, &null_counts);
+  if (status.ok()) {
+	status = AllocateBuffers(sizes, &data);
+  }
+  if (!status.ok()) {
+	LOG(FATAL) << "Failed to split " << status.message();
+	return -1;
   }
 
-  for (size_t i = 0; i < partitions.size(); i++) {
-	std::shared_ptr<arrow::FixedSizeBinaryBuilder> b = builders[partitions.at(i)];
-	if (b->Append(reader->Value(i)) != arrow::Status::OK()) {
-	  LOG(FATAL) << "Failed to merge";
-	  return -1;
+  std::vector<uint8_t *> dest;
+  for (const auto &buf : data) {
+	dest.push_back(buf->mutable_data());
+  }
+  const uint8_t *src = reader->raw_values();
+  const int64_t length = values->length();
+  partitions.Visit([&](const auto *ids) {
+	for (int64_t i = 0; i < length; i++) {
+	  auto p = ids[i];
+	  std::memcpy(dest[p], src + i * width, width);
+	  dest[p] += width;
 	}
+  });
+
+  std::vector<std::vector<std::shared_ptr<arrow::Buffer>>> buffers;
+  for (size_t p = 0; p < data.size(); p++) {
+	buffers.push_back({bitmaps[p], data[p]});
+  }
+  MakeArrays(partitions, targets, buffers, null_counts, out);
+  return 0;
+}
+
+int BooleanArraySplitKernel::Split(std::shared_ptr<arrow::Array> &values,
+								   const PartitionIds &partitions,
+								   const std::vector<int32_t> &targets,
+								   std::unordered_map<int, std::shared_ptr<arrow::Array> > &out) {
+  const std::vector<int64_t> &counts = partitions.Counts();
+  std::vector<std::shared_ptr<arrow::Buffer>> bitmaps;
+  std::vector<int64_t> null_counts;
+  std::vector<std::shared_ptr<arrow::Buffer>> data(counts.size());
+  arrow::Status status = SplitValidity(values, partitions, &bitmaps, &null_counts);
+  for (size_t p = 0; status.ok() && p < counts.size(); p++) {
+	status = arrow::AllocateEmptyBitmap(pool_, counts[p], &data[p]);
+  }
+  if (!status.ok()) {
+	LOG(FATAL) << "Failed to split " << status.message();
+	return -1;
   }
 
-  for (int it : targets) {
-	std::shared_ptr<arrow::FixedSizeBinaryBuilder> b = builders[it];
-	std::shared_ptr<arrow::Array> array;
-	if (b->Finish(&array) != arrow::Status::OK()) {
-	  LOG(FATAL) << "Failed to merge";
-	  return -1;
+  std::vector<uint8_t *> dest;
+  for (const auto &buf : data) {
+	dest.push_back(buf->mutable_data());
+  }
+  std::vector<int64_t> positions(counts.size(), 0);
+  const uint8_t *src = values->data()->buffers[1]->data();
+  const int64_t offset = values->offset();
+  const int64_t length = values->length();
+  partitions.Visit([&](const auto *ids) {
+	for (int64_t i = 0; i < length; i++) {
+	  auto p = ids[i];
+	  // the bitmaps are zeroed, so only the set bits are written
+	  if (arrow::BitUtil::GetBit(src, offset + i)) {
+		arrow::BitUtil::SetBit(dest[p], positions[p]);
+	  }
+	  positions[p]++;
 	}
-	out.insert(std::pair<int, std::shared_ptr<arrow::Array>>(it, array));
+  });
+
+  std::vector<std::vector<std::shared_ptr<arrow::Buffer>>> buffers;
+  for (size_t p = 0; p < counts.size(); p++) {
+	buffers.push_back({bitmaps[p], data[p]});
   }
+  MakeArrays(partitions, targets, buffers, null_counts, out);
   return 0;
 }
 
-int BinaryArraySplitKernel::Split(std::shared_ptr<arrow::Array> &values,
-								  const std::vector<int64_t> &partitions,
-								  const std::vector<int32_t> &targets,
-								  std::unordered_map<int, std::shared_ptr<arrow::Array> > &out) {
-  auto reader =
-	  std::static_pointer_cast<arrow::BinaryArray>(values);
-  std::unordered_map<int, std::shared_ptr<arrow::BinaryBuilder>> builders;
+twisterx::Status SplitTable(const std::shared_ptr<arrow::Table> &table,
+							const PartitionIds &partitions,
+							const std::vector<int32_t> &targets,
+							arrow::MemoryPool *pool,
+							std::unordered_map<int, std::shared_ptr<arrow::Table>> *out,
+							int num_threads) {
+  const int num_columns = table->num_columns();
+  // the chunks of each column for each target
+  std::vector<std::unordered_map<int, std::vector<std::shared_ptr<arrow::Array>>>> split_columns(num_columns);
+  std::vector<twisterx::Status> statuses(num_columns, twisterx::Status::OK());
 
-  for (int it : targets) {
-	std::shared_ptr<arrow::BinaryBuilder> b = std::make_shared<arrow::BinaryBuilder>(type_, pool_);
-	builders.insert(std::pair<int, std::shared_ptr<arrow::BinaryBuilder>>(it, b));
+  // a chunked table, such as a concatenation of tables, is split chunk by chunk with the partitions of the rows of
+  // each chunk, so the columns chunked as the first column are not combined
+  std::vector<int64_t> chunk_lengths;
+  std::vector<PartitionIds> chunk_partitions;
+  if (num_columns > 0 && table->column(0)->num_chunks() > 1) {
+	int64_t offset = 0;
+	for (const auto &chunk : table->column(0)->chunks()) {
+	  chunk_lengths.push_back(chunk->length());
+	  chunk_partitions.emplace_back();
+	  partitions.Slice(offset, chunk->length(), &chunk_partitions.back());
+	  offset += chunk->length();
+	}
   }
 
-  for (size_t i = 0; i < partitions.size(); i++) {
-	std::shared_ptr<arrow::BinaryBuilder> b = builders[partitions.at(i)];
-	int length = 0;
-	const uint8_t *value = reader->GetValue(i, &length);
-	if (b->Append(value, length) != arrow::Status::OK()) {
-	  LOG(FATAL) << "Failed to merge";
-	  return -1;
+  auto split_column = [&](int c) {
+	const std::shared_ptr<arrow::ChunkedArray> &column = table->column(c);
+	std::shared_ptr<arrow::DataType> type = column->type();
+	std::shared_ptr<ArrowArraySplitKernel> splitKernel;
+	twisterx::Status status = CreateSplitter(type, pool, &splitKernel);
+	if (!status.is_ok()) {
+	  statuses[c] = status;
+	  return;
+	}
+	bool chunked_as_first = !chunk_lengths.empty() && column->num_chunks() == static_cast<int>(chunk_lengths.size());
+	for (int k = 0; chunked_as_first && k < column->num_chunks(); k++) {
+	  chunked_as_first = column->chunk(k)->length() == chunk_lengths[k];
 	}
-  }
 
-  for (int it : targets) {
-	std::shared_ptr<arrow::BinaryBuilder> b = builders[it];
-	std::shared_ptr<arrow::Array> array;
-	if (b->Finish(&array) != arrow::Status::OK()) {
-	  LOG(FATAL) << "Failed to merge";
-	  return -1;
+	std::vector<std::shared_ptr<arrow::Array>> arrays;
+	if (column->num_chunks() == 1 || chunked_as_first) {
+	  arrays = column->chunks();
+	} else {
+	  // the partitions are given for the rows of the table, so we need a single array
+	  std::shared_ptr<arrow::Array> array;
+	  arrow::Status arrow_status = twisterx::util::CombineChunks(column, &array, pool);
+	  if (!arrow_status.ok()) {
+		statuses[c] = twisterx::Status((int) arrow_status.code(), arrow_status.message());
+		return;
+	  }
+	  arrays.push_back(array);
 	}
-	out.insert(std::pair<int, std::shared_ptr<arrow::Array>>(it, array));
-  }
-  return 0;
-}
+	for (size_t k = 0; k < arrays.size(); k++) {
+	  std::unordered_map<int, std::shared_ptr<arrow::Array>> split_chunk;
+	  if (splitKernel->Split(arrays[k], arrays.size() == 1 ? partitions : chunk_partitions[k], targets,
+							 split_chunk) != 0) {
+		statuses[c] = twisterx::Status(twisterx::ExecutionError, "Failed to split column " + std::to_string(c));
+		return;
+	  }
+	  for (auto &target : split_chunk) {
+		split_columns[c][target.first].push_back(target.second);
+	  }
+	}
+  };
 
-class ArrowStringSortKernel : public ArrowArraySortKernel {
- public:
-  explicit ArrowStringSortKernel(std::shared_ptr<arrow::DataType> type,
-								 arrow::MemoryPool *pool) :
-	  ArrowArraySortKernel(type, pool) {}
+  int threads = std::max(1, std::min(num_threads, num_columns));
+  if (threads == 1) {
+	for (int c = 0; c < num_columns; c++) {
+	  split_column(c);
+	}
+  } else {
+	// the threads take the next column to split until all are done
+	std::atomic<int> next_column(0);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++) {
+	  workers.emplace_back([&]() {
+		for (int c = next_column++; c < num_columns; c = next_column++) {
+		  split_column(c);
+		}
+	  });
+	}
+	for (auto &worker : workers) {
+	  worker.join();
+	}
+  }
 
-  int Sort(std::shared_ptr<arrow::Array> values,
-		   std::shared_ptr<arrow::Array> *offsets) override {
-	auto array = std::static_pointer_cast<arrow::StringArray>(values);
-	std::shared_ptr<arrow::Buffer> indices_buf;
-	int64_t buf_size = values->length() * sizeof(uint64_t);
-	arrow::Status status = AllocateBuffer(arrow::default_memory_pool(), buf_size + 1, &indices_buf);
-	if (status != arrow::Status::OK()) {
-	  LOG(FATAL) << "Failed to allocate sort indices - " << status.message();
-	  return -1;
+  for (auto &status : statuses) {
+	if (!status.is_ok()) {
+	  return status;
 	}
-	auto *indices_begin = reinterpret_cast<int64_t *>(indices_buf->mutable_data());
-	for (int64_t i = 0; i < values->length(); i++) {
-	  indices_begin[i] = i;
+  }
+  for (int32_t target : targets) {
+	std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+	for (int c = 0; c < num_columns; c++) {
+	  columns.push_back(std::make_shared<arrow::ChunkedArray>(split_columns[c][target], table->field(c)->type()));
 	}
-	int64_t *indices_end = indices_begin + values->length();
-	std::sort(indices_begin, indices_end, [array](uint64_t left, uint64_t right) {
-	  return array->GetView(left).compare(array->GetView(right));
-	});
-	*offsets = std::make_shared<arrow::UInt64Array>(values->length(), indices_buf);
-	return 0;
+	out->insert(std::pair<int, std::shared_ptr<arrow::Table>>(target, arrow::Table::Make(table->schema(), columns)));
   }
-};
+  return twisterx::Status::OK();
+}
 
+/**
+ * Sorts string and binary values in byte order on cached prefixes, see SortBinaryIndices
+ */
 class ArrowBinarySortKernel : public ArrowArraySortKernel {
  public:
   explicit ArrowBinarySortKernel(std::shared_ptr<arrow::DataType> type,
-								 arrow::MemoryPool *pool) :
-	  ArrowArraySortKernel(type, pool) {}
+								 arrow::MemoryPool *pool,
+								 int num_threads = 1) :
+	  ArrowArraySortKernel(type, pool, num_threads) {}
 
   int Sort(std::shared_ptr<arrow::Array> values,
 		   std::shared_ptr<arrow::Array> *offsets) override {
-	auto array = std::static_pointer_cast<arrow::BinaryArray>(values);
 	std::shared_ptr<arrow::Buffer> indices_buf;
 	int64_t buf_size = values->length() * sizeof(uint64_t);
 	arrow::Status status = AllocateBuffer(arrow::default_memory_pool(), buf_size + 1, &indices_buf);
 	if (status != arrow::Status::OK()) {
-	  LOG(FATAL) << "Failed to allocate sort indices - " << status.message();
+	  LOG(ERROR) << "Failed to allocate sort indices - " << status.message();
 	  return -1;
 	}
 	auto *indices_begin = reinterpret_cast<int64_t *>(indices_buf->mutable_data());
-	for (int64_t i = 0; i < values->length(); i++) {
-	  indices_begin[i] = i;
+	status = SortBinaryIndices(values, indices_begin, num_threads_);
+	if (status != arrow::Status::OK()) {
+	  LOG(ERROR) << "Failed to sort - " << status.message();
+	  return -1;
 	}
-	int64_t *indices_end = indices_begin + values->length();
-	std::sort(indices_begin, indices_end, [array](uint64_t left, uint64_t right) {
-	  return array->GetView(left).compare(array->GetView(right));
-	});
 	*offsets = std::make_shared<arrow::UInt64Array>(values->length(), indices_buf);
 	return 0;
   }
 };
 
-int CreateSorter(std::shared_ptr<arrow::DataType> type,
-				 arrow::MemoryPool *pool,
-				 std::shared_ptr<ArrowArraySortKernel> *out) {
+static arrow::Status CreateSorter(std::shared_ptr<arrow::DataType> type,
+								  arrow::MemoryPool *pool,
+								  std::shared_ptr<ArrowArraySortKernel> *out,
+								  int num_threads) {
   ArrowArraySortKernel *kernel;
   switch (type->id()) {
-	case arrow::Type::UINT8:kernel = new UInt8ArraySorter(type, pool);
+	case arrow::Type::UINT8:kernel = new UInt8ArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::INT8:kernel = new Int8ArraySorter(type, pool);
+	case arrow::Type::INT8:kernel = new Int8ArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::UINT16:kernel = new UInt16ArraySorter(type, pool);
+	case arrow::Type::UINT16:kernel = new UInt16ArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::INT16:kernel = new Int16ArraySorter(type, pool);
+	case arrow::Type::INT16:kernel = new Int16ArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::UINT32:kernel = new UInt32ArraySorter(type, pool);
+	case arrow::Type::UINT32:kernel = new UInt32ArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::INT32:kernel = new Int32ArraySorter(type, pool);
+	case arrow::Type::INT32:kernel = new Int32ArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::UINT64:kernel = new UInt64ArraySorter(type, pool);
+	case arrow::Type::UINT64:kernel = new UInt64ArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::INT64:kernel = new Int64ArraySorter(type, pool);
+	case arrow::Type::INT64:kernel = new Int64ArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::FLOAT:kernel = new FloatArraySorter(type, pool);
+	case arrow::Type::FLOAT:kernel = new FloatArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::DOUBLE:kernel = new DoubleArraySorter(type, pool);
+	case arrow::Type::DOUBLE:kernel = new DoubleArraySorter(type, pool, num_threads);
 	  break;
-	case arrow::Type::STRING:kernel = new ArrowStringSortKernel(type, pool);
+	case arrow::Type::DATE32:kernel = new ArrowArrayNumericSortKernel<arrow::Date32Type>(type, pool, num_threads);
 	  break;
-	case arrow::Type::BINARY:kernel = new ArrowBinarySortKernel(type, pool);
+	case arrow::Type::DATE64:kernel = new ArrowArrayNumericSortKernel<arrow::Date64Type>(type, pool, num_threads);
 	  break;
-	case arrow::Type::FIXED_SIZE_BINARY:kernel = new ArrowBinarySortKernel(type, pool);
+	case arrow::Type::TIME32:kernel = new ArrowArrayNumericSortKernel<arrow::Time32Type>(type, pool, num_threads);
 	  break;
-	default:LOG(FATAL) << "Un-known type";
-	  return -1;
+	case arrow::Type::TIME64:kernel = new ArrowArrayNumericSortKernel<arrow::Time64Type>(type, pool, num_threads);
+	  break;
+	case arrow::Type::TIMESTAMP:
+	  kernel = new ArrowArrayNumericSortKernel<arrow::TimestampType>(type, pool, num_threads);
+	  break;
+	case arrow::Type::STRING:
+	case arrow::Type::BINARY:
+	case arrow::Type::LARGE_STRING:
+	case arrow::Type::LARGE_BINARY:
+	case arrow::Type::FIXED_SIZE_BINARY:kernel = new ArrowBinarySortKernel(type, pool, num_threads);
+	  break;
+	default:return arrow::Status::NotImplemented("Sorting on type " + type->ToString());
   }
   out->reset(kernel);
-  return 0;
+  return arrow::Status::OK();
 }
 
 arrow::Status SortIndices(arrow::MemoryPool *memory_pool, std::shared_ptr<arrow::Array> values,
-						  std::shared_ptr<arrow::Array> *offsets) {
+						  std::shared_ptr<arrow::Array> *offsets, int num_threads) {
   std::shared_ptr<ArrowArraySortKernel> out;
-  CreateSorter(values->type(), memory_pool, &out);
-  out->Sort(values, offsets);
+  RETURN_NOT_OK(CreateSorter(values->type(), memory_pool, &out, num_threads));
+  if (out->Sort(values, offsets) != 0) {
+	return arrow::Status::UnknownError("Failed to sort the values of type " + values->type()->ToString());
+  }
   return arrow::Status::OK();
 }
 
-}
\ No newline at end of file
+/**
+ * Merge the runs with a heap of the runs ordered by their next value. KEY gives the value of a row of a run.
+ */
+template<typename KEY>
+static arrow::Status MergeRuns(arrow::MemoryPool *memory_pool,
+							   const std::vector<std::shared_ptr<arrow::Array>> &runs,
+							   bool ascending,
+							   KEY &&key,
+							   std::shared_ptr<arrow::Array> *indices) {
+  const size_t num_runs = runs.size();
+  std::vector<int64_t> positions(num_runs, 0);
+  std::vector<int64_t> run_offsets(num_runs, 0);
+  int64_t length = 0;
+  for (size_t r = 0; r < num_runs; r++) {
+	run_offsets[r] = length;
+	length += runs[r]->length();
+  }
+
+  // whether the next value of run a goes before the next value of run b
+  auto before = [&](size_t a, size_t b) {
+	bool a_null = runs[a]->IsNull(positions[a]);
+	bool b_null = runs[b]->IsNull(positions[b]);
+	if (a_null || b_null) {
+	  return !a_null || (b_null && a < b);
+	}
+	// NaNs order as the largest values, as in the local sort, and equal values by their runs
+	auto a_value = key(a, positions[a]);
+	auto b_value = key(b, positions[b]);
+	if (ascending ? ValueLess(a_value, b_value) : ValueLess(b_value, a_value)) {
+	  return true;
+	}
+	if (ascending ? ValueLess(b_value, a_value) : ValueLess(a_value, b_value)) {
+	  return false;
+	}
+	return a < b;
+  };
+  // the top of the heap is the run with the next value
+  auto heap_order = [&](size_t a, size_t b) {
+	return before(b, a);
+  };
+  std::vector<size_t> heap;
+  for (size_t r = 0; r < num_runs; r++) {
+	if (runs[r]->length() > 0) {
+	  heap.push_back(r);
+	}
+  }
+  std::make_heap(heap.begin(), heap.end(), heap_order);
+
+  arrow::Int64Builder builder(memory_pool);
+  RETURN_NOT_OK(builder.Reserve(length));
+  while (!heap.empty()) {
+	std::pop_heap(heap.begin(), heap.end(), heap_order);
+	size_t r = heap.back();
+	builder.UnsafeAppend(run_offsets[r] + positions[r]);
+	if (++positions[r] < runs[r]->length()) {
+	  std::push_heap(heap.begin(), heap.end(), heap_order);
+	} else {
+	  heap.pop_back();
+	}
+  }
+  return builder.Finish(indices);
+}
+
+template<typename TYPE>
+static arrow::Status MergeNumericRuns(arrow::MemoryPool *memory_pool,
+									  const std::vector<std::shared_ptr<arrow::Array>> &runs,
+									  bool ascending,
+									  std::shared_ptr<arrow::Array> *indices) {
+  using T = typename TYPE::c_type;
+  std::vector<const T *> values;
+  for (const auto &run : runs) {
+	values.push_back(std::static_pointer_cast<arrow::NumericArray<TYPE>>(run)->raw_values());
+  }
+  return MergeRuns(memory_pool, runs, ascending, [&values](size_t run, int64_t row) {
+	return values[run][row];
+  }, indices);
+}
+
+template<typename TYPE>
+static arrow::Status MergeBinaryRuns(arrow::MemoryPool *memory_pool,
+									 const std::vector<std::shared_ptr<arrow::Array>> &runs,
+									 bool ascending,
+									 std::shared_ptr<arrow::Array> *indices) {
+  using ARRAY_TYPE = typename arrow::TypeTraits<TYPE>::ArrayType;
+  std::vector<const ARRAY_TYPE *> values;
+  for (const auto &run : runs) {
+	values.push_back(static_cast<const ARRAY_TYPE *>(run.get()));
+  }
+  return MergeRuns(memory_pool, runs, ascending, [&values](size_t run, int64_t row) {
+	return values[run]->GetView(row);
+  }, indices);
+}
+
+static arrow::Status MergeBooleanRuns(arrow::MemoryPool *memory_pool,
+									  const std::vector<std::shared_ptr<arrow::Array>> &runs,
+									  bool ascending,
+									  std::shared_ptr<arrow::Array> *indices) {
+  std::vector<const arrow::BooleanArray *> values;
+  for (const auto &run : runs) {
+	values.push_back(static_cast<const arrow::BooleanArray *>(run.get()));
+  }
+  return MergeRuns(memory_pool, runs, ascending, [&values](size_t run, int64_t row) {
+	return values[run]->Value(row);
+  }, indices);
+}
+
+arrow::Status MergeSortedRuns(arrow::MemoryPool *memory_pool,
+							  const std::vector<std::shared_ptr<arrow::Array>> &runs,
+							  bool ascending,
+							  std::shared_ptr<arrow::Array> *indices) {
+  if (runs.empty()) {
+	return arrow::Status::Invalid("No runs to merge");
+  }
+  switch (runs[0]->type_id()) {
+	case arrow::Type::UINT8:return MergeNumericRuns<arrow::UInt8Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::INT8:return MergeNumericRuns<arrow::Int8Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::UINT16:return MergeNumericRuns<arrow::UInt16Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::INT16:return MergeNumericRuns<arrow::Int16Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::UINT32:return MergeNumericRuns<arrow::UInt32Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::INT32:return MergeNumericRuns<arrow::Int32Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::UINT64:return MergeNumericRuns<arrow::UInt64Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::INT64:return MergeNumericRuns<arrow::Int64Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::FLOAT:return MergeNumericRuns<arrow::FloatType>(memory_pool, runs, ascending, indices);
+	case arrow::Type::DOUBLE:return MergeNumericRuns<arrow::DoubleType>(memory_pool, runs, ascending, indices);
+	case arrow::Type::DATE32:return MergeNumericRuns<arrow::Date32Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::DATE64:return MergeNumericRuns<arrow::Date64Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::TIME32:return MergeNumericRuns<arrow::Time32Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::TIME64:return MergeNumericRuns<arrow::Time64Type>(memory_pool, runs, ascending, indices);
+	case arrow::Type::TIMESTAMP:
+	  return MergeNumericRuns<arrow::TimestampType>(memory_pool, runs, ascending, indices);
+	case arrow::Type::BOOL:return MergeBooleanRuns(memory_pool, runs, ascending, indices);
+	case arrow::Type::STRING:return MergeBinaryRuns<arrow::StringType>(memory_pool, runs, ascending, indices);
+	case arrow::Type::BINARY:return MergeBinaryRuns<arrow::BinaryType>(memory_pool, runs, ascending, indices);
+	case arrow::Type::LARGE_STRING:
+	  return MergeBinaryRuns<arrow::LargeStringType>(memory_pool, runs, ascending, indices);
+	case arrow::Type::LARGE_BINARY:
+	  return MergeBinaryRuns<arrow::LargeBinaryType>(memory_pool, runs, ascending, indices);
+	case arrow::Type::FIXED_SIZE_BINARY:
+	  return MergeBinaryRuns<arrow::FixedSizeBinaryType>(memory_pool, runs, ascending, indices);
+	default:
+	  return arrow::Status::NotImplemented("Merging runs of type " + runs[0]->type()->ToString());
+  }
+}
+
+}
@@ -15,32 +15,165 @@
 #ifndef TWISTERX_ARROW_KERNELS_H
 #define TWISTERX_ARROW_KERNELS_H
 
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
 #include <arrow/api.h>
 #include <arrow/compute/kernel.h>
 #include <glog/logging.h>
 #include "../status.hpp"
+#include "arrow_sort_kernels.hpp"
+
+// number of threads used to split the columns of a table when partitioning
+#define TWISTERX_SPLIT_THREADS "twisterx.split.threads"
+// number of threads used by the radix sort of the sort indices
+#define TWISTERX_SORT_THREADS "twisterx.sort.threads"
 
 namespace twisterx {
 
+/**
+ * The partition of each row of a table, given as an index to the targets, and the number of rows of each partition.
+ * The indices are 16 bits wide when there are at most 65536 partitions, otherwise 32 bits wide. The rows are counted
+ * once and every column of the table is split using the counts.
+ */
+class PartitionIds {
+ public:
+  /**
+   * Make space for the partitions of length rows
+   */
+  void Reset(int64_t length, uint32_t num_partitions) {
+	length_ = length;
+	num_partitions_ = num_partitions;
+	wide_ = num_partitions > (1u << 16);
+	if (wide_) {
+	  narrow_ids_.clear();
+	  wide_ids_.resize(length);
+	} else {
+	  wide_ids_.clear();
+	  narrow_ids_.resize(length);
+	}
+	counts_.assign(num_partitions, 0);
+  }
+
+  /**
+   * Count the rows of each partition, call after setting the partitions of all the rows
+   */
+  void Count() {
+	std::fill(counts_.begin(), counts_.end(), 0);
+	Visit([this](const auto *ids) {
+	  for (int64_t i = 0; i < length_; i++) {
+		counts_[ids[i]]++;
+	  }
+	});
+  }
+
+  /**
+   * Call the function with the indices, either a const uint16_t * or a const uint32_t *
+   */
+  template<typename FUNCTION>
+  void Visit(FUNCTION &&fn) const {
+	if (wide_) {
+	  fn(wide_ids_.data());
+	} else {
+	  fn(narrow_ids_.data());
+	}
+  }
+
+  /**
+   * Call the function with the indices to set them, either a uint16_t * or a uint32_t *
+   */
+  template<typename FUNCTION>
+  void VisitMutable(FUNCTION &&fn) {
+	if (wide_) {
+	  fn(wide_ids_.data());
+	} else {
+	  fn(narrow_ids_.data());
+	}
+  }
+
+  uint32_t Get(int64_t row) const {
+	return wide_ ? wide_ids_[row] : narrow_ids_[row];
+  }
+
+  /**
+   * The partitions of the rows from offset to offset + length, counted
+   */
+  void Slice(int64_t offset, int64_t length, PartitionIds *out) const {
+	out->Reset(length, num_partitions_);
+	if (wide_) {
+	  std::copy(wide_ids_.begin() + offset, wide_ids_.begin() + offset + length, out->wide_ids_.begin());
+	} else {
+	  std::copy(narrow_ids_.begin() + offset, narrow_ids_.begin() + offset + length, out->narrow_ids_.begin());
+	}
+	out->Count();
+  }
+
+  int64_t Length() const {
+	return length_;
+  }
+
+  uint32_t NumPartitions() const {
+	return num_partitions_;
+  }
+
+  const std::vector<int64_t> &Counts() const {
+	return counts_;
+  }
+
+ private:
+  int64_t length_ = 0;
+  uint32_t num_partitions_ = 0;
+  bool wide_ = false;
+  std::vector<uint16_t> narrow_ids_;
+  std::vector<uint32_t> wide_ids_;
+  std::vector<int64_t> counts_;
+};
+
 class ArrowArraySplitKernel {
  public:
   explicit ArrowArraySplitKernel(std::shared_ptr<arrow::DataType> type,
 								 arrow::MemoryPool *pool) : type_(type), pool_(pool) {}
 
+  virtual ~ArrowArraySplitKernel() = default;
+
   /**
-   * Merge the values in the column and return an array
-   * @param ctx
-   * @param values
-   * @param targets
-   * @param out_length
-   * @param out
-   * @return
+   * Split the values to the targets. The buffers of each target are allocated to the exact size using the counts
+   * of the partitions, and the values are written to them in a single pass.
+   * @param values the values
+   * @param partitions the partition of each value, an index to the targets
+   * @param targets the targets
+   * @param out an array for each target
+   * @return 0 if success
    */
   virtual int Split(std::shared_ptr<arrow::Array> &values,
-					const std::vector<int64_t> &partitions,
+					const PartitionIds &partitions,
 					const std::vector<int32_t> &targets,
 					std::unordered_map<int, std::shared_ptr<arrow::Array>> &out) = 0;
  protected:
+  /**
+   * Split the validity bitmap of the values, the bitmaps are nullptr if the values don't have nulls
+   */
+  arrow::Status SplitValidity(const std::shared_ptr<arrow::Array> &values,
+							  const PartitionIds &partitions,
+							  std::vector<std::shared_ptr<arrow::Buffer>> *bitmaps,
+							  std::vector<int64_t> *null_counts);
+
+  /**
+   * Allocate a buffer for each partition, the size is given for each partition
+   */
+  arrow::Status AllocateBuffers(const std::vector<int64_t> &sizes,
+								std::vector<std::shared_ptr<arrow::Buffer>> *buffers);
+
+  /**
+   * Make an array for each target from the buffers of its partition
+   */
+  void MakeArrays(const PartitionIds &partitions,
+				  const std::vector<int32_t> &targets,
+				  const std::vector<std::vector<std::shared_ptr<arrow::Buffer>>> &buffers,
+				  const std::vector<int64_t> &null_counts,
+				  std::unordered_map<int, std::shared_ptr<arrow::Array>> &out);
+
   std::shared_ptr<arrow::DataType> type_;
   arrow::MemoryPool *pool_;
 };
@@ -48,34 +181,51 @@ class ArrowArraySplitKernel {
 template<typename TYPE>
 class ArrowArrayNumericSplitKernel : public ArrowArraySplitKernel {
  public:
+  using T = typename TYPE::c_type;
+
   explicit ArrowArrayNumericSplitKernel(std::shared_ptr<arrow::DataType> type,
 										arrow::MemoryPool *pool) :
 	  ArrowArraySplitKernel(type, pool) {}
 
   int Split(std::shared_ptr<arrow::Array> &values,
-			const std::vector<int64_t> &partitions,
+			const PartitionIds &partitions,
 			const std::vector<int32_t> &targets,
 			std::unordered_map<int, std::shared_ptr<arrow::Array>> &out) override {
-	auto reader =
-		std::static_pointer_cast<arrow::NumericArray<TYPE>>(values);
-	std::unordered_map<int, std::shared_ptr<arrow::NumericBuilder<TYPE>>> builders;
-
-	for (long target : targets) {
-	  std::shared_ptr<arrow::NumericBuilder<TYPE>> b = std::make_shared<arrow::NumericBuilder<TYPE>>(type_, pool_);
-	  builders.insert(std::pair<int, std::shared_ptr<arrow::NumericBuilder<TYPE>>>(target, b));
+	auto reader = std::static_pointer_cast<arrow::NumericArray<TYPE>>(values);
+	std::vector<std::shared_ptr<arrow::Buffer>> bitmaps;
+	std::vector<int64_t> null_counts;
+	std::vector<std::shared_ptr<arrow::Buffer>> data;
+	std::vector<int64_t> sizes;
+	for (int64_t count : partitions.Counts()) {
+	  sizes.push_back(count * sizeof(T));
+	}
+	arrow::Status status = SplitValidity(values, partitions, &bitmaps, &null_counts);
+	if (status.ok()) {
+	  status = AllocateBuffers(sizes, &data);
+	}
+	if (!status.ok()) {
+	  LOG(FATAL) << "Failed to split " << status.message();
+	  return -1;
 	}
 
-	for (size_t i = 0; i < partitions.size(); i++) {
-	  std::shared_ptr<arrow::NumericBuilder<TYPE>> b = builders[partitions.at(i)];
-	  b->Append(reader->Value(i));
+	// write each value to the next free slot of its partition
+	std::vector<T *> dest;
+	for (const auto &buf : data) {
+	  dest.push_back(reinterpret_cast<T *>(buf->mutable_data()));
 	}
+	const T *src = reader->raw_values();
+	const int64_t length = values->length();
+	partitions.Visit([&](const auto *ids) {
+	  for (int64_t i = 0; i < length; i++) {
+		*(dest[ids[i]]++) = src[i];
+	  }
+	});
 
-	for (long target : targets) {
-	  std::shared_ptr<arrow::NumericBuilder<TYPE>> b = builders[target];
-	  std::shared_ptr<arrow::Array> array;
-	  b->Finish(&array);
-	  out.insert(std::pair<int, std::shared_ptr<arrow::Array>>(target, array));
+	std::vector<std::vector<std::shared_ptr<arrow::Buffer>>> buffers;
+	for (size_t p = 0; p < data.size(); p++) {
+	  buffers.push_back({bitmaps[p], data[p]});
 	}
+	MakeArrays(partitions, targets, buffers, null_counts, out);
 	return 0;
   }
 };
@@ -87,19 +237,101 @@ class FixedBinaryArraySplitKernel : public ArrowArraySplitKernel {
 	  ArrowArraySplitKernel(type, pool) {}
 
   int Split(std::shared_ptr<arrow::Array> &values,
-			const std::vector<int64_t> &partitions,
+			const PartitionIds &partitions,
 			const std::vector<int32_t> &targets,
 			std::unordered_map<int, std::shared_ptr<arrow::Array>> &out) override;
 };
 
+/**
+ * Split the binary and string arrays, the offsets are 32 bits wide for the binary and string types and 64 bits
+ * wide for the large types
+ */
+template<typename TYPE>
 class BinaryArraySplitKernel : public ArrowArraySplitKernel {
  public:
+  using ARRAY_TYPE = typename arrow::TypeTraits<TYPE>::ArrayType;
+  using offset_type = typename TYPE::offset_type;
+
   explicit BinaryArraySplitKernel(std::shared_ptr<arrow::DataType> type,
 								  arrow::MemoryPool *pool) :
 	  ArrowArraySplitKernel(type, pool) {}
 
   int Split(std::shared_ptr<arrow::Array> &values,
-			const std::vector<int64_t> &partitions,
+			const PartitionIds &partitions,
+			const std::vector<int32_t> &targets,
+			std::unordered_map<int, std::shared_ptr<arrow::Array>> &out) override {
+	auto reader = std::static_pointer_cast<ARRAY_TYPE>(values);
+	const offset_type *offsets = reader->raw_value_offsets();
+	const uint8_t *src = reader->value_data()->data();
+	const int64_t length = values->length();
+	const std::vector<int64_t> &counts = partitions.Counts();
+
+	// first we find the size of the data of each partition
+	std::vector<int64_t> data_sizes(counts.size(), 0);
+	partitions.Visit([&](const auto *ids) {
+	  for (int64_t i = 0; i < length; i++) {
+		data_sizes[ids[i]] += offsets[i + 1] - offsets[i];
+	  }
+	});
+
+	std::vector<int64_t> offset_sizes;
+	for (int64_t count : counts) {
+	  offset_sizes.push_back((count + 1) * sizeof(offset_type));
+	}
+	std::vector<std::shared_ptr<arrow::Buffer>> bitmaps;
+	std::vector<int64_t> null_counts;
+	std::vector<std::shared_ptr<arrow::Buffer>> offset_bufs;
+	std::vector<std::shared_ptr<arrow::Buffer>> data_bufs;
+	arrow::Status status = SplitValidity(values, partitions, &bitmaps, &null_counts);
+	if (status.ok()) {
+	  status = AllocateBuffers(offset_sizes, &offset_bufs);
+	}
+	if (status.ok()) {
+	  status = AllocateBuffers(data_sizes, &data_bufs);
+	}
+	if (!status.ok()) {
+	  LOG(FATAL) << "Failed to split " << status.message();
+	  return -1;
+	}
+
+	std::vector<offset_type *> dest_offsets;
+	std::vector<uint8_t *> dest_data;
+	for (size_t p = 0; p < counts.size(); p++) {
+	  dest_offsets.push_back(reinterpret_cast<offset_type *>(offset_bufs[p]->mutable_data()));
+	  dest_offsets[p][0] = 0;
+	  dest_data.push_back(data_bufs[p]->mutable_data());
+	}
+	std::vector<offset_type> data_positions(counts.size(), 0);
+	partitions.Visit([&](const auto *ids) {
+	  for (int64_t i = 0; i < length; i++) {
+		auto p = ids[i];
+		offset_type value_length = offsets[i + 1] - offsets[i];
+		std::memcpy(dest_data[p] + data_positions[p], src + offsets[i], value_length);
+		data_positions[p] += value_length;
+		*(++dest_offsets[p]) = data_positions[p];
+	  }
+	});
+
+	std::vector<std::vector<std::shared_ptr<arrow::Buffer>>> buffers;
+	for (size_t p = 0; p < counts.size(); p++) {
+	  buffers.push_back({bitmaps[p], offset_bufs[p], data_bufs[p]});
+	}
+	MakeArrays(partitions, targets, buffers, null_counts, out);
+	return 0;
+  }
+};
+
+/**
+ * Split the boolean arrays, the values are bits so we set the bits of each partition
+ */
+class BooleanArraySplitKernel : public ArrowArraySplitKernel {
+ public:
+  explicit BooleanArraySplitKernel(std::shared_ptr<arrow::DataType> type,
+								   arrow::MemoryPool *pool) :
+	  ArrowArraySplitKernel(type, pool) {}
+
+  int Split(std::shared_ptr<arrow::Array> &values,
+			const PartitionIds &partitions,
 			const std::vector<int32_t> &targets,
 			std::unordered_map<int, std::shared_ptr<arrow::Array>> &out) override;
 };
@@ -118,14 +350,44 @@ using HalfFloatArraySplitter = ArrowArrayNumericSplitKernel<arrow::HalfFloatType
 using FloatArraySplitter = ArrowArrayNumericSplitKernel<arrow::FloatType>;
 using DoubleArraySplitter = ArrowArrayNumericSplitKernel<arrow::DoubleType>;
 
+using Date32ArraySplitter = ArrowArrayNumericSplitKernel<arrow::Date32Type>;
+using Date64ArraySplitter = ArrowArrayNumericSplitKernel<arrow::Date64Type>;
+using TimestampArraySplitter = ArrowArrayNumericSplitKernel<arrow::TimestampType>;
+using Time32ArraySplitter = ArrowArrayNumericSplitKernel<arrow::Time32Type>;
+using Time64ArraySplitter = ArrowArrayNumericSplitKernel<arrow::Time64Type>;
+
+using BinaryArraySplitter = BinaryArraySplitKernel<arrow::BinaryType>;
+using StringArraySplitter = BinaryArraySplitKernel<arrow::StringType>;
+using LargeBinaryArraySplitter = BinaryArraySplitKernel<arrow::LargeBinaryType>;
+using LargeStringArraySplitter = BinaryArraySplitKernel<arrow::LargeStringType>;
+
 twisterx::Status CreateSplitter(std::shared_ptr<arrow::DataType> &type,
 								arrow::MemoryPool *pool,
 								std::shared_ptr<ArrowArraySplitKernel> *out);
 
+/**
+ * Split the rows of the table to the targets, a column at a time. The columns of a table with more than one chunk
+ * are split chunk by chunk without combining them, and the tables of the targets have a chunk for each chunk.
+ * @param table the table
+ * @param partitions the partition of each row, an index to the targets
+ * @param targets the targets
+ * @param pool the memory pool
+ * @param out a table for each target
+ * @param num_threads split up to this many columns in parallel
+ * @return the status of the split
+ */
+twisterx::Status SplitTable(const std::shared_ptr<arrow::Table> &table,
+							const PartitionIds &partitions,
+							const std::vector<int32_t> &targets,
+							arrow::MemoryPool *pool,
+							std::unordered_map<int, std::shared_ptr<arrow::Table>> *out,
+							int num_threads = 1);
+
 class ArrowArraySortKernel {
  public:
   explicit ArrowArraySortKernel(std::shared_ptr<arrow::DataType> type,
-								arrow::MemoryPool *pool) : type_(type), pool_(pool) {}
+								arrow::MemoryPool *pool,
+								int num_threads = 1) : type_(type), pool_(pool), num_threads_(num_threads) {}
 
   /**
    * Sort the values in the column and return an array with the indices
@@ -141,16 +403,21 @@ class ArrowArraySortKernel {
  protected:
   std::shared_ptr<arrow::DataType> type_;
   arrow::MemoryPool *pool_;
+  int num_threads_;
 };
 
+/**
+ * Sorts integers and floating point values with a radix sort, see SortValueIndices
+ */
 template<typename TYPE>
 class ArrowArrayNumericSortKernel : public ArrowArraySortKernel {
  public:
   using T = typename TYPE::c_type;
 
   explicit ArrowArrayNumericSortKernel(std::shared_ptr<arrow::DataType> type,
-									   arrow::MemoryPool *pool) :
-	  ArrowArraySortKernel(type, pool) {}
+									   arrow::MemoryPool *pool,
+									   int num_threads = 1) :
+	  ArrowArraySortKernel(type, pool, num_threads) {}
 
   int Sort(std::shared_ptr<arrow::Array> values,
 		   std::shared_ptr<arrow::Array> *offsets) override {
@@ -164,14 +431,7 @@ class ArrowArrayNumericSortKernel : public ArrowArraySortKernel {
 	  return -1;
 	}
 	auto *indices_begin = reinterpret_cast<int64_t *>(indices_buf->mutable_data());
-	for (int64_t i = 0; i < values->length(); i++) {
-	  indices_begin[i] = i;
-	}
-	int64_t *indices_end = indices_begin + values->length();
-	// LOG(INFO) << "Length " << values->length() << " ind " << indices_begin << "nd " << indices_begin + values->length();
-	std::sort(indices_begin, indices_end, [left_data](uint64_t left, uint64_t right) {
-	  return left_data[left] < left_data[right];
-	});
+	SortValueIndices<T>(left_data, values->length(), indices_begin, num_threads_);
 	*offsets = std::make_shared<arrow::UInt64Array>(values->length(), indices_buf);
 	return 0;
   }
@@ -189,8 +449,31 @@ using HalfFloatArraySorter = ArrowArrayNumericSortKernel<arrow::HalfFloatType>;
 using FloatArraySorter = ArrowArrayNumericSortKernel<arrow::FloatType>;
 using DoubleArraySorter = ArrowArrayNumericSortKernel<arrow::DoubleType>;
 
+/**
+ * Sort the values to indices, the nulls are not ordered
+ * @param memory_pool the memory pool
+ * @param values the values
+ * @param offsets the sorted indices
+ * @param num_threads the threads of the radix sort of integer and floating point values
+ * @return the status of the sort
+ */
 arrow::Status SortIndices(arrow::MemoryPool *memory_pool, std::shared_ptr<arrow::Array> values,
-						  std::shared_ptr<arrow::Array> *offsets);
+						  std::shared_ptr<arrow::Array> *offsets, int num_threads = 1);
+
+/**
+ * Merge runs of sorted values with a k-way merge, the nulls are at the end of each run and go to the end of the
+ * merged order. NaNs order after the largest values, as in the local sort, and equal values are taken from the runs
+ * in the order of the runs.
+ * @param memory_pool the memory pool
+ * @param runs the sorted runs
+ * @param ascending the order of the runs
+ * @param indices the merged order, as int64 indices to the concatenation of the runs
+ * @return the status of the merge
+ */
+arrow::Status MergeSortedRuns(arrow::MemoryPool *memory_pool,
+							  const std::vector<std::shared_ptr<arrow::Array>> &runs,
+							  bool ascending,
+							  std::shared_ptr<arrow::Array> *indices);
 
 }
 
@@ -14,31 +14,81 @@
 
 #include "arrow_partition_kernels.hpp"
 
+#include <random>
+#include <arrow/compute/context.h>
+#include <arrow/compute/kernels/take.h>
+#include "../util/arrow_utils.hpp"
+
 namespace twisterx {
 
+void HashesToPartitions(const std::vector<uint32_t> &hashes, uint32_t num_partitions,
+                        PartitionIds *partitions) {
+  partitions->Reset(hashes.size(), num_partitions);
+  partitions->VisitMutable([&](auto *ids) {
+    for (size_t i = 0; i < hashes.size(); i++) {
+      ids[i] = hashes[i] % num_partitions;
+    }
+  });
+  partitions->Count();
+}
+
+int ArrowPartitionKernel::Partition(const std::shared_ptr<arrow::Array> &values, const std::vector<int> &targets,
+                                    PartitionIds *partitions) {
+  std::vector<uint32_t> hashes(values->length());
+  HashArray(values, hashes.data());
+  HashesToPartitions(hashes, targets.size(), partitions);
+  return 0;
+}
+
 ArrowPartitionKernel *GetPartitionKernel(arrow::MemoryPool *pool,
-                                         const std::shared_ptr<arrow::DataType> &data_type) {
+                                         const std::shared_ptr<arrow::DataType> &data_type,
+                                         util::HashAlgorithm algorithm) {
   ArrowPartitionKernel *kernel;
   switch (data_type->id()) {
-    case arrow::Type::UINT8:kernel = new UInt8ArrayHashPartitioner(pool);
+    case arrow::Type::UINT8:kernel = new UInt8ArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::INT8:kernel = new Int8ArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::UINT16:kernel = new UInt16ArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::INT16:kernel = new Int16ArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::UINT32:kernel = new UInt32ArrayHashPartitioner(pool, algorithm);
       break;
-    case arrow::Type::INT8:kernel = new Int8ArrayHashPartitioner(pool);
+    case arrow::Type::INT32:kernel = new Int32ArrayHashPartitioner(pool, algorithm);
       break;
-    case arrow::Type::UINT16:kernel = new UInt16ArrayHashPartitioner(pool);
+    case arrow::Type::UINT64:kernel = new UInt64ArrayHashPartitioner(pool, algorithm);
       break;
-    case arrow::Type::INT16:kernel = new Int16ArrayHashPartitioner(pool);
+    case arrow::Type::INT64:kernel = new Int64ArrayHashPartitioner(pool, algorithm);
       break;
-    case arrow::Type::UINT32:kernel = new UInt32ArrayHashPartitioner(pool);
+    case arrow::Type::FLOAT:kernel = new FloatArrayHashPartitioner(pool, algorithm);
       break;
-    case arrow::Type::INT32:kernel = new Int32ArrayHashPartitioner(pool);
+    case arrow::Type::DOUBLE:kernel = new DoubleArrayHashPartitioner(pool, algorithm);
       break;
-    case arrow::Type::UINT64:kernel = new UInt64ArrayHashPartitioner(pool);
+    case arrow::Type::HALF_FLOAT:kernel = new HalfFloatArrayHashPartitioner(pool, algorithm);
       break;
-    case arrow::Type::INT64:kernel = new Int64ArrayHashPartitioner(pool);
+    case arrow::Type::BOOL:kernel = new BooleanHashPartitionKernel(pool, algorithm);
       break;
-    case arrow::Type::FLOAT:kernel = new FloatArrayHashPartitioner(pool);
+    case arrow::Type::DATE32:kernel = new Date32ArrayHashPartitioner(pool, algorithm);
       break;
-    case arrow::Type::DOUBLE:kernel = new DoubleArrayHashPartitioner(pool);
+    case arrow::Type::DATE64:kernel = new Date64ArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::TIMESTAMP:kernel = new TimestampArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::TIME32:kernel = new Time32ArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::TIME64:kernel = new Time64ArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::STRING:kernel = new StringArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::BINARY:kernel = new BinaryArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::LARGE_STRING:kernel = new LargeStringArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::LARGE_BINARY:kernel = new LargeBinaryArrayHashPartitioner(pool, algorithm);
+      break;
+    case arrow::Type::FIXED_SIZE_BINARY:
+    case arrow::Type::DECIMAL:kernel = new FixedSizeBinaryHashPartitionKernel(pool, algorithm);
       break;
     default:LOG(FATAL) << "Un-known type";
       return NULLPTR;
@@ -47,57 +97,205 @@ ArrowPartitionKernel *GetPartitionKernel(arrow::MemoryPool *pool,
 }
 
 ArrowPartitionKernel *GetPartitionKernel(arrow::MemoryPool *pool,
-                                         std::shared_ptr<arrow::Array> values) {
-  return GetPartitionKernel(pool, values->type());
+                                         std::shared_ptr<arrow::Array> values,
+                                         util::HashAlgorithm algorithm) {
+  return GetPartitionKernel(pool, values->type(), algorithm);
 }
 
 twisterx::Status HashPartitionArray(arrow::MemoryPool *pool,
                                     std::shared_ptr<arrow::Array> values,
                                     const std::vector<int> &targets,
-                                    std::vector<int64_t> *outPartitions) {
-  ArrowPartitionKernel *kernel = GetPartitionKernel(pool, values);
+                                    PartitionIds *outPartitions,
+                                    util::HashAlgorithm algorithm) {
+  std::unique_ptr<ArrowPartitionKernel> kernel(GetPartitionKernel(pool, values, algorithm));
   kernel->Partition(values, targets, outPartitions);
   return twisterx::Status::OK();
 }
 
-twisterx::Status HashPartitionArrays(arrow::MemoryPool *pool,
-                                     const std::vector<std::shared_ptr<arrow::Array>> &values,
-                                     int64_t length,
-                                     const std::vector<int> &targets,
-                                     std::vector<int64_t> *outPartitions) {
-  std::vector<ArrowPartitionKernel *> hash_kernels;
+twisterx::Status HashRows(arrow::MemoryPool *pool,
+                          const std::vector<std::shared_ptr<arrow::Array>> &values,
+                          int64_t length,
+                          std::vector<uint32_t> *hashes,
+                          util::HashAlgorithm algorithm) {
+  std::vector<std::unique_ptr<ArrowPartitionKernel>> hash_kernels;
   for (const auto &array: values) {
-    auto hash_kernel = GetPartitionKernel(pool, array);
+    auto hash_kernel = GetPartitionKernel(pool, array, algorithm);
     if (hash_kernel == NULLPTR) {
       LOG(FATAL) << "Un-known type";
       return twisterx::Status(twisterx::NotImplemented, "Not implemented or unsupported data type.");
     }
-    hash_kernels.push_back(hash_kernel);
+    hash_kernels.emplace_back(hash_kernel);
   }
 
-  for (int64_t index = 0; index < length; index++) {
-    int64_t hash_code = 1;
-    int64_t array_index = 0;
-    for (const auto &array: values) {
-      hash_code = 31 * hash_code + hash_kernels[array_index++]->ToHash(array, index);
-    }
-    outPartitions->push_back(targets[hash_code % targets.size()]);
+  // hash a column at a time, combining into the hashes of the rows
+  hashes->assign(length, 1);
+  for (size_t c = 0; c < values.size(); c++) {
+    hash_kernels[c]->UpdateHash(values[c], hashes->data());
   }
   return twisterx::Status::OK();
 }
 
+twisterx::Status HashPartitionArrays(arrow::MemoryPool *pool,
+                                     const std::vector<std::shared_ptr<arrow::Array>> &values,
+                                     int64_t length,
+                                     const std::vector<int> &targets,
+                                     PartitionIds *outPartitions,
+                                     util::HashAlgorithm algorithm) {
+  std::vector<uint32_t> hashes;
+  twisterx::Status status = HashRows(pool, values, length, &hashes, algorithm);
+  if (!status.is_ok()) {
+    return status;
+  }
+  HashesToPartitions(hashes, targets.size(), outPartitions);
+  return twisterx::Status::OK();
+}
+
 RowHashingKernel::RowHashingKernel(const std::vector<std::shared_ptr<arrow::Field>> &fields,
-                                   arrow::MemoryPool *memory_pool) {
+                                   arrow::MemoryPool *memory_pool,
+                                   util::HashAlgorithm algorithm) {
   for (auto const &field: fields) {
-    this->hash_kernels.push_back(std::shared_ptr<ArrowPartitionKernel>(GetPartitionKernel(memory_pool, field->type())));
+    this->hash_kernels.push_back(std::shared_ptr<ArrowPartitionKernel>(
+        GetPartitionKernel(memory_pool, field->type(), algorithm)));
   }
 }
 
 int32_t RowHashingKernel::Hash(const std::shared_ptr<arrow::Table> &table, int64_t row) {
-  int64_t hash_code = 1;
+  uint32_t hash_code = 1;
   for (int c = 0; c < table->num_columns(); ++c) {
-    hash_code = 31 * hash_code + this->hash_kernels[c]->ToHash(table->column(c)->chunk(0), row);
+    // the columns of a table with more than one chunk may be chunked differently
+    int64_t chunk_row = row;
+    std::shared_ptr<arrow::Array> chunk = util::GetChunk(table->column(c), &chunk_row);
+    hash_code = util::CombineHash(hash_code, this->hash_kernels[c]->ToHash(chunk, chunk_row));
   }
   return hash_code;
 }
+
+void RowHashingKernel::Hash(const std::shared_ptr<arrow::Table> &table, std::vector<uint32_t> *hashes) {
+  hashes->assign(table->num_rows(), 1);
+  for (int c = 0; c < table->num_columns(); ++c) {
+    int64_t offset = 0;
+    for (const auto &chunk : table->column(c)->chunks()) {
+      this->hash_kernels[c]->UpdateHash(chunk, hashes->data() + offset);
+      offset += chunk->length();
+    }
+  }
+}
+
+twisterx::Status CreateRangePartitionKernel(const std::shared_ptr<arrow::DataType> &type,
+                                            bool ascending,
+                                            std::shared_ptr<RangePartitionKernel> *out) {
+  RangePartitionKernel *kernel;
+  switch (type->id()) {
+    case arrow::Type::UINT8:kernel = new NumericRangePartitionKernel<arrow::UInt8Type>(ascending);
+      break;
+    case arrow::Type::INT8:kernel = new NumericRangePartitionKernel<arrow::Int8Type>(ascending);
+      break;
+    case arrow::Type::UINT16:kernel = new NumericRangePartitionKernel<arrow::UInt16Type>(ascending);
+      break;
+    case arrow::Type::INT16:kernel = new NumericRangePartitionKernel<arrow::Int16Type>(ascending);
+      break;
+    case arrow::Type::UINT32:kernel = new NumericRangePartitionKernel<arrow::UInt32Type>(ascending);
+      break;
+    case arrow::Type::INT32:kernel = new NumericRangePartitionKernel<arrow::Int32Type>(ascending);
+      break;
+    case arrow::Type::UINT64:kernel = new NumericRangePartitionKernel<arrow::UInt64Type>(ascending);
+      break;
+    case arrow::Type::INT64:kernel = new NumericRangePartitionKernel<arrow::Int64Type>(ascending);
+      break;
+    case arrow::Type::FLOAT:kernel = new NumericRangePartitionKernel<arrow::FloatType>(ascending);
+      break;
+    case arrow::Type::DOUBLE:kernel = new NumericRangePartitionKernel<arrow::DoubleType>(ascending);
+      break;
+    case arrow::Type::DATE32:kernel = new NumericRangePartitionKernel<arrow::Date32Type>(ascending);
+      break;
+    case arrow::Type::DATE64:kernel = new NumericRangePartitionKernel<arrow::Date64Type>(ascending);
+      break;
+    case arrow::Type::TIMESTAMP:kernel = new NumericRangePartitionKernel<arrow::TimestampType>(ascending);
+      break;
+    case arrow::Type::TIME32:kernel = new NumericRangePartitionKernel<arrow::Time32Type>(ascending);
+      break;
+    case arrow::Type::TIME64:kernel = new NumericRangePartitionKernel<arrow::Time64Type>(ascending);
+      break;
+    case arrow::Type::STRING:kernel = new BinaryRangePartitionKernel<arrow::StringType>(ascending);
+      break;
+    case arrow::Type::BINARY:kernel = new BinaryRangePartitionKernel<arrow::BinaryType>(ascending);
+      break;
+    case arrow::Type::LARGE_STRING:kernel = new BinaryRangePartitionKernel<arrow::LargeStringType>(ascending);
+      break;
+    case arrow::Type::LARGE_BINARY:kernel = new BinaryRangePartitionKernel<arrow::LargeBinaryType>(ascending);
+      break;
+    case arrow::Type::FIXED_SIZE_BINARY:
+      kernel = new BinaryRangePartitionKernel<arrow::FixedSizeBinaryType>(ascending);
+      break;
+    default:
+      return twisterx::Status(twisterx::NotImplemented,
+                              "Range partitioning is not implemented for " + type->ToString());
+  }
+  out->reset(kernel);
+  return twisterx::Status::OK();
+}
+
+/**
+ * Take the values at the sample indices
+ */
+static twisterx::Status TakeSamples(arrow::MemoryPool *pool,
+                                    const std::shared_ptr<arrow::Array> &values,
+                                    arrow::Int64Builder *indices_builder,
+                                    std::shared_ptr<arrow::Array> *out) {
+  std::shared_ptr<arrow::Array> indices;
+  arrow::Status status = indices_builder->Finish(&indices);
+  if (status.ok()) {
+    arrow::compute::FunctionContext ctx(pool);
+    status = arrow::compute::Take(&ctx, *values, *indices, arrow::compute::TakeOptions(), out);
+  }
+  if (!status.ok()) {
+    return twisterx::Status((int) status.code(), status.message());
+  }
+  return twisterx::Status::OK();
+}
+
+twisterx::Status SampleArray(arrow::MemoryPool *pool,
+                             const std::shared_ptr<arrow::Array> &values,
+                             int64_t num_samples,
+                             uint32_t seed,
+                             std::shared_ptr<arrow::Array> *out) {
+  const int64_t length = values->length();
+  if (length <= num_samples) {
+    *out = values;
+    return twisterx::Status::OK();
+  }
+
+  arrow::Int64Builder builder(pool);
+  arrow::Status status = builder.Reserve(num_samples);
+  if (!status.ok()) {
+    return twisterx::Status((int) status.code(), status.message());
+  }
+  std::mt19937_64 generator(seed);
+  std::uniform_int_distribution<int64_t> distribution(0, length - 1);
+  for (int64_t i = 0; i < num_samples; i++) {
+    builder.UnsafeAppend(distribution(generator));
+  }
+  return TakeSamples(pool, values, &builder, out);
+}
+
+twisterx::Status SampleSortedArray(arrow::MemoryPool *pool,
+                                   const std::shared_ptr<arrow::Array> &values,
+                                   int64_t num_samples,
+                                   std::shared_ptr<arrow::Array> *out) {
+  const int64_t length = values->length();
+  if (length <= num_samples) {
+    *out = values;
+    return twisterx::Status::OK();
+  }
+
+  arrow::Int64Builder builder(pool);
+  arrow::Status status = builder.Reserve(num_samples);
+  if (!status.ok()) {
+    return twisterx::Status((int) status.code(), status.message());
+  }
+  for (int64_t i = 0; i < num_samples; i++) {
+    builder.UnsafeAppend((i + 1) * length / (num_samples + 1));
+  }
+  return TakeSamples(pool, values, &builder, out);
+}
 }
@@ -15,78 +15,195 @@
 #ifndef TWISTERX_ARROW_PARTITION_KERNELS_H
 #define TWISTERX_ARROW_PARTITION_KERNELS_H
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <string>
+#include <type_traits>
 #include <vector>
 #include <arrow/api.h>
+#include <arrow/util/bit_util.h>
 #include <glog/logging.h>
 
-#include "../util/murmur3.hpp"
+#include "../util/hash.hpp"
 #include "../status.hpp"
+#include "arrow_kernels.hpp"
+
+// the hash algorithm used for partitioning, murmur3 (default), xxhash or crc32
+#define TWISTERX_HASH_ALGORITHM "twisterx.hash"
+// the number of values sampled for each partition when choosing the splitters of a range partition
+#define TWISTERX_RANGE_SAMPLES "twisterx.range.samples"
 
 namespace twisterx {
 
 class ArrowPartitionKernel {
  public:
   explicit ArrowPartitionKernel(
-      arrow::MemoryPool *pool) : pool_(pool) {}
+      arrow::MemoryPool *pool,
+      util::HashAlgorithm algorithm = util::MURMUR3_HASH) : pool_(pool), algorithm_(algorithm) {}
+
+  virtual ~ArrowPartitionKernel() = default;
 
   /**
-   * We partition the table and return the indexes as an array
-   * @param ctx
-   * @param values
-   * @param out
-   * @return
+   * We partition the values and return the partition of each value as an index to the targets
+   * @param values the values
+   * @param targets the targets
+   * @param partitions the partitions, counted
+   * @return 0 if success
    */
   virtual int Partition(const std::shared_ptr<arrow::Array> &values, const std::vector<int> &targets,
-                        std::vector<int64_t> *partitions) = 0;
+                        PartitionIds *partitions);
 
   virtual uint32_t ToHash(const std::shared_ptr<arrow::Array> &values,
                           int64_t index) = 0;
+
+  /**
+   * Hash all the values of the array, a null value hashes to 0
+   * @param values the array
+   * @param hashes output, space for the length of the array
+   */
+  virtual void HashArray(const std::shared_ptr<arrow::Array> &values, uint32_t *hashes) = 0;
+
+  /**
+   * Combine the hashes of the values into the hashes of the rows using util::CombineHash
+   * @param values the array
+   * @param hashes the hashes of the rows, space for the length of the array
+   */
+  virtual void UpdateHash(const std::shared_ptr<arrow::Array> &values, uint32_t *hashes) = 0;
  protected:
   arrow::MemoryPool *pool_;
+  util::HashAlgorithm algorithm_;
 };
 
-template<typename TYPE, typename CTYPE>
-class NumericHashPartitionKernel : public ArrowPartitionKernel {
+/**
+ * The hashing of a kernel for an array type, the kernel gives the hash of a single value with
+ * template<typename HASHER> static uint32_t HashValue(const ARRAY_TYPE &array, int64_t index)
+ * and this hashes whole arrays with it
+ */
+template<typename KERNEL, typename ARRAY_TYPE>
+class TypedHashPartitionKernel : public ArrowPartitionKernel {
  public:
-  explicit NumericHashPartitionKernel(arrow::MemoryPool *pool) : ArrowPartitionKernel(pool) {}
+  explicit TypedHashPartitionKernel(arrow::MemoryPool *pool,
+                                    util::HashAlgorithm algorithm = util::MURMUR3_HASH)
+      : ArrowPartitionKernel(pool, algorithm) {}
 
   uint32_t ToHash(const std::shared_ptr<arrow::Array> &values,
-                  int64_t index) {
-    auto reader = std::static_pointer_cast<arrow::NumericArray<TYPE>>(values);
-    auto type = std::static_pointer_cast<arrow::FixedWidthType>(values->type());
-    int bitWidth = type->bit_width();
+                  int64_t index) override {
     if (values->IsNull(index)) {
       return 0;
-    } else {
-      CTYPE lValue = reader->Value(index);
-
-      uint32_t hash = 0;
-      uint32_t seed = 0;
-      void *val = (void *) &(lValue);
-      // do the hash as we know the bit width
-      twisterx::util::MurmurHash3_x86_32(val, bitWidth / 8, seed, &hash);
-      return hash;
     }
+    const auto &array = static_cast<const ARRAY_TYPE &>(*values);
+    uint32_t hash = 0;
+    util::WithHasher(algorithm_, [&](auto hasher) {
+      hash = KERNEL::template HashValue<decltype(hasher)>(array, index);
+    });
+    return hash;
+  }
 
+  void HashArray(const std::shared_ptr<arrow::Array> &values, uint32_t *hashes) override {
+    util::WithHasher(algorithm_, [&](auto hasher) {
+      HashValues<decltype(hasher), false>(values, hashes);
+    });
   }
 
-  int Partition(const std::shared_ptr<arrow::Array> &values, const std::vector<int> &targets,
-                std::vector<int64_t> *partitions) override {
-    auto reader = std::static_pointer_cast<arrow::NumericArray<TYPE>>(values);
-    auto type = std::static_pointer_cast<arrow::FixedWidthType>(values->type());
-    int bitWidth = type->bit_width();
-    for (int64_t i = 0; i < reader->length(); i++) {
-      auto lValue = reader->Value(i);
-      void *val = (void *) &(lValue);
-      uint32_t hash = 0;
-      uint32_t seed = 0;
-      // do the hash as we know the bit width
-      twisterx::util::MurmurHash3_x86_32(val, bitWidth / 8, seed, &hash);
-      partitions->push_back(targets.at(hash % targets.size()));
+  void UpdateHash(const std::shared_ptr<arrow::Array> &values, uint32_t *hashes) override {
+    util::WithHasher(algorithm_, [&](auto hasher) {
+      HashValues<decltype(hasher), true>(values, hashes);
+    });
+  }
+
+ private:
+  template<typename HASHER, bool COMBINE>
+  static void HashValues(const std::shared_ptr<arrow::Array> &values, uint32_t *hashes) {
+    const auto &array = static_cast<const ARRAY_TYPE &>(*values);
+    const int64_t length = values->length();
+    if (values->null_count() == 0) {
+      for (int64_t i = 0; i < length; i++) {
+        uint32_t hash = KERNEL::template HashValue<HASHER>(array, i);
+        hashes[i] = COMBINE ? util::CombineHash(hashes[i], hash) : hash;
+      }
+    } else {
+      // the nulls hash to 0, we mask the hash with the validity bit instead of branching
+      const uint8_t *valid = values->null_bitmap_data();
+      const int64_t offset = values->offset();
+      for (int64_t i = 0; i < length; i++) {
+        uint32_t mask = 0u - static_cast<uint32_t>(arrow::BitUtil::GetBit(valid, offset + i));
+        uint32_t hash = KERNEL::template HashValue<HASHER>(array, i) & mask;
+        hashes[i] = COMBINE ? util::CombineHash(hashes[i], hash) : hash;
+      }
     }
-    // now build the
-    return 0;
+  }
+};
+
+/**
+ * Hash the fixed width values, the dates and times are hashed as their integer values
+ */
+template<typename TYPE, typename CTYPE>
+class NumericHashPartitionKernel
+    : public TypedHashPartitionKernel<NumericHashPartitionKernel<TYPE, CTYPE>, arrow::NumericArray<TYPE>> {
+ public:
+  explicit NumericHashPartitionKernel(arrow::MemoryPool *pool,
+                                      util::HashAlgorithm algorithm = util::MURMUR3_HASH)
+      : TypedHashPartitionKernel<NumericHashPartitionKernel<TYPE, CTYPE>, arrow::NumericArray<TYPE>>(pool,
+                                                                                                      algorithm) {}
+
+  template<typename HASHER>
+  static inline uint32_t HashValue(const arrow::NumericArray<TYPE> &array, int64_t index) {
+    return HASHER::template Hash<sizeof(CTYPE)>(reinterpret_cast<const uint8_t *>(array.raw_values() + index));
+  }
+};
+
+/**
+ * Hash the bytes of the values of binary and string arrays
+ */
+template<typename TYPE>
+class BinaryHashPartitionKernel
+    : public TypedHashPartitionKernel<BinaryHashPartitionKernel<TYPE>, typename arrow::TypeTraits<TYPE>::ArrayType> {
+ public:
+  using ARRAY_TYPE = typename arrow::TypeTraits<TYPE>::ArrayType;
+
+  explicit BinaryHashPartitionKernel(arrow::MemoryPool *pool,
+                                     util::HashAlgorithm algorithm = util::MURMUR3_HASH)
+      : TypedHashPartitionKernel<BinaryHashPartitionKernel<TYPE>, ARRAY_TYPE>(pool, algorithm) {}
+
+  template<typename HASHER>
+  static inline uint32_t HashValue(const ARRAY_TYPE &array, int64_t index) {
+    typename TYPE::offset_type length = 0;
+    const uint8_t *value = array.GetValue(index, &length);
+    return HASHER::Hash(value, length);
+  }
+};
+
+/**
+ * Hash the bytes of fixed size binary values, decimals are fixed size binary arrays as well
+ */
+class FixedSizeBinaryHashPartitionKernel
+    : public TypedHashPartitionKernel<FixedSizeBinaryHashPartitionKernel, arrow::FixedSizeBinaryArray> {
+ public:
+  explicit FixedSizeBinaryHashPartitionKernel(arrow::MemoryPool *pool,
+                                              util::HashAlgorithm algorithm = util::MURMUR3_HASH)
+      : TypedHashPartitionKernel<FixedSizeBinaryHashPartitionKernel, arrow::FixedSizeBinaryArray>(pool, algorithm) {}
+
+  template<typename HASHER>
+  static inline uint32_t HashValue(const arrow::FixedSizeBinaryArray &array, int64_t index) {
+    return HASHER::Hash(array.GetValue(index), array.byte_width());
+  }
+};
+
+/**
+ * Hash the booleans as a byte of 0 or 1
+ */
+class BooleanHashPartitionKernel
+    : public TypedHashPartitionKernel<BooleanHashPartitionKernel, arrow::BooleanArray> {
+ public:
+  explicit BooleanHashPartitionKernel(arrow::MemoryPool *pool,
+                                      util::HashAlgorithm algorithm = util::MURMUR3_HASH)
+      : TypedHashPartitionKernel<BooleanHashPartitionKernel, arrow::BooleanArray>(pool, algorithm) {}
+
+  template<typename HASHER>
+  static inline uint32_t HashValue(const arrow::BooleanArray &array, int64_t index) {
+    uint8_t value = array.Value(index) ? 1 : 0;
+    return HASHER::template Hash<1>(&value);
   }
 };
 
@@ -98,34 +215,293 @@ using Int8ArrayHashPartitioner = NumericHashPartitionKernel<arrow::Int8Type, int
 using Int16ArrayHashPartitioner = NumericHashPartitionKernel<arrow::Int16Type, int16_t>;
 using Int32ArrayHashPartitioner = NumericHashPartitionKernel<arrow::Int32Type, int32_t>;
 using Int64ArrayHashPartitioner = NumericHashPartitionKernel<arrow::Int64Type, int64_t>;
-using HalfFloatArrayHashPartitioner = NumericHashPartitionKernel<arrow::HalfFloatType, float_t>;
-using FloatArrayHashPartitioner = NumericHashPartitionKernel<arrow::FloatType, float_t>;
-using DoubleArrayHashPartitioner = NumericHashPartitionKernel<arrow::DoubleType, double_t>;
+using HalfFloatArrayHashPartitioner = NumericHashPartitionKernel<arrow::HalfFloatType, uint16_t>;
+using FloatArrayHashPartitioner = NumericHashPartitionKernel<arrow::FloatType, float>;
+using DoubleArrayHashPartitioner = NumericHashPartitionKernel<arrow::DoubleType, double>;
+using Date32ArrayHashPartitioner = NumericHashPartitionKernel<arrow::Date32Type, int32_t>;
+using Date64ArrayHashPartitioner = NumericHashPartitionKernel<arrow::Date64Type, int64_t>;
+using TimestampArrayHashPartitioner = NumericHashPartitionKernel<arrow::TimestampType, int64_t>;
+using Time32ArrayHashPartitioner = NumericHashPartitionKernel<arrow::Time32Type, int32_t>;
+using Time64ArrayHashPartitioner = NumericHashPartitionKernel<arrow::Time64Type, int64_t>;
+using StringArrayHashPartitioner = BinaryHashPartitionKernel<arrow::StringType>;
+using BinaryArrayHashPartitioner = BinaryHashPartitionKernel<arrow::BinaryType>;
+using LargeStringArrayHashPartitioner = BinaryHashPartitionKernel<arrow::LargeStringType>;
+using LargeBinaryArrayHashPartitioner = BinaryHashPartitionKernel<arrow::LargeBinaryType>;
 
 ArrowPartitionKernel *GetPartitionKernel(arrow::MemoryPool *pool,
-                                         std::shared_ptr<arrow::Array> values);
+                                         std::shared_ptr<arrow::Array> values,
+                                         util::HashAlgorithm algorithm = util::MURMUR3_HASH);
 
 ArrowPartitionKernel *GetPartitionKernel(arrow::MemoryPool *pool,
-                                         const std::shared_ptr<arrow::DataType> &data_type);
+                                         const std::shared_ptr<arrow::DataType> &data_type,
+                                         util::HashAlgorithm algorithm = util::MURMUR3_HASH);
 
+/**
+ * Partition the values using their hash, the partitions are indices to the targets
+ */
 twisterx::Status HashPartitionArray(arrow::MemoryPool *pool,
                                     std::shared_ptr<arrow::Array> values,
                                     const std::vector<int> &targets,
-                                    std::vector<int64_t> *outPartitions);
+                                    PartitionIds *outPartitions,
+                                    util::HashAlgorithm algorithm = util::MURMUR3_HASH);
 
+/**
+ * Hash the rows of the arrays, the arrays are hashed one at a time and combined with util::CombineHash. Equal rows
+ * have equal hashes, and a null value hashes to 0.
+ * @param values the columns of the rows, of the same length
+ * @param length the number of rows
+ * @param hashes the hash of each row
+ */
+twisterx::Status HashRows(arrow::MemoryPool *pool,
+                          const std::vector<std::shared_ptr<arrow::Array>> &values,
+                          int64_t length,
+                          std::vector<uint32_t> *hashes,
+                          util::HashAlgorithm algorithm = util::MURMUR3_HASH);
+
+/**
+ * Set the partitions from the hashes of the rows and count them, the partition of a row is its hash modulo the
+ * number of partitions
+ */
+void HashesToPartitions(const std::vector<uint32_t> &hashes, uint32_t num_partitions, PartitionIds *partitions);
+
+/**
+ * Partition the rows using the combined hash of the values of the arrays, the arrays are hashed one at a time.
+ * The partitions are indices to the targets.
+ */
 twisterx::Status HashPartitionArrays(arrow::MemoryPool *pool,
                                      const std::vector<std::shared_ptr<arrow::Array>> &values,
                                      int64_t length,
                                      const std::vector<int> &targets,
-                                     std::vector<int64_t> *outPartitions);
+                                     PartitionIds *outPartitions,
+                                     util::HashAlgorithm algorithm = util::MURMUR3_HASH);
 
 class RowHashingKernel {
  private:
   std::vector<std::shared_ptr<ArrowPartitionKernel>> hash_kernels;
  public:
-  RowHashingKernel(const std::vector<std::shared_ptr<arrow::Field>> &vector, arrow::MemoryPool *memory_pool);
+  RowHashingKernel(const std::vector<std::shared_ptr<arrow::Field>> &vector,
+                   arrow::MemoryPool *memory_pool,
+                   util::HashAlgorithm algorithm = util::MURMUR3_HASH);
   int32_t Hash(const std::shared_ptr<arrow::Table> &table, int64_t row);
+
+  /**
+   * Hash all the rows of the table, the hash of a row is the same as the one given by Hash(table, row)
+   * @param table the table
+   * @param hashes output, the hash of each row
+   */
+  void Hash(const std::shared_ptr<arrow::Table> &table, std::vector<uint32_t> *hashes);
+};
+
+/**
+ * Partition the values to ranges of their order. The ranges are bounded by P-1 splitters chosen from a sample of
+ * the values, and a value goes to the partition given by the number of splitters less than or equal to it, so equal
+ * values always go to the same partition. In descending order the partitions are reversed. The nulls go to the
+ * last partition, and NaNs order after the largest values as in the local sort, so they go to the last partition
+ * in ascending order and to the first in descending order.
+ */
+class RangePartitionKernel {
+ public:
+  explicit RangePartitionKernel(bool ascending) : ascending_(ascending) {}
+
+  virtual ~RangePartitionKernel() = default;
+
+  /**
+   * Choose the splitters of the partitions from the samples, the samples can be in any order and have nulls
+   * @param samples the samples, from one or more ranks
+   * @param num_partitions the number of partitions
+   */
+  virtual void SetSplitters(const std::vector<std::shared_ptr<arrow::Array>> &samples, uint32_t num_partitions) = 0;
+
+  /**
+   * Partition the values using the splitters
+   * @param values the values
+   * @param partitions the partition of each value, counted
+   */
+  virtual void Partition(const std::shared_ptr<arrow::Array> &values, PartitionIds *partitions) = 0;
+
+  uint32_t NumPartitions() const {
+    return num_partitions_;
+  }
+
+ protected:
+  /**
+   * The number of splitters less than or equal to the value, the splitters are sorted. The search doesn't branch
+   * on the comparisons so it doesn't suffer from mispredictions.
+   */
+  template<typename T, typename V>
+  static inline uint32_t UpperBound(const T *splitters, size_t n, const V &value) {
+    const T *base = splitters;
+    while (n > 1) {
+      size_t half = n / 2;
+      base = (base[half] <= value) ? base + half : base;
+      n -= half;
+    }
+    return static_cast<uint32_t>((base - splitters) + (n == 1 && *base <= value));
+  }
+
+  /**
+   * Pick the splitters at the quantiles of the sorted samples
+   */
+  template<typename T>
+  void ChooseSplitters(std::vector<T> *sorted_samples, uint32_t num_partitions, std::vector<T> *splitters) {
+    num_partitions_ = num_partitions;
+    splitters->clear();
+    const size_t n = sorted_samples->size();
+    if (n == 0) {
+      return;
+    }
+    for (uint32_t p = 1; p < num_partitions; p++) {
+      splitters->push_back((*sorted_samples)[std::min(n - 1, (p * n) / num_partitions)]);
+    }
+  }
+
+  /**
+   * Set the partition of every value from its range, given by the function
+   */
+  template<typename RANGE>
+  void AssignPartitions(const std::shared_ptr<arrow::Array> &values, PartitionIds *partitions, RANGE &&range) {
+    const int64_t length = values->length();
+    const uint32_t last = num_partitions_ - 1;
+    const bool has_nulls = values->null_count() > 0;
+    partitions->Reset(length, num_partitions_);
+    partitions->VisitMutable([&](auto *ids) {
+      for (int64_t i = 0; i < length; i++) {
+        uint32_t p = range(i);
+        p = ascending_ ? p : last - p;
+        ids[i] = (has_nulls && values->IsNull(i)) ? last : p;
+      }
+    });
+    partitions->Count();
+  }
+
+  bool ascending_;
+  uint32_t num_partitions_ = 1;
 };
+
+/**
+ * Range partition the fixed width values, the dates and times are ordered by their integer values
+ */
+template<typename TYPE>
+class NumericRangePartitionKernel : public RangePartitionKernel {
+ public:
+  using T = typename TYPE::c_type;
+  using ARRAY_TYPE = arrow::NumericArray<TYPE>;
+
+  explicit NumericRangePartitionKernel(bool ascending) : RangePartitionKernel(ascending) {}
+
+  void SetSplitters(const std::vector<std::shared_ptr<arrow::Array>> &samples, uint32_t num_partitions) override {
+    std::vector<T> values;
+    for (const auto &sample : samples) {
+      auto array = std::static_pointer_cast<ARRAY_TYPE>(sample);
+      for (int64_t i = 0; i < array->length(); i++) {
+        // NaNs are not ordered by <, so they are not splitters
+        if (!array->IsNull(i) && !IsNaN(array->Value(i))) {
+          values.push_back(array->Value(i));
+        }
+      }
+    }
+    std::sort(values.begin(), values.end());
+    ChooseSplitters(&values, num_partitions, &splitters_);
+  }
+
+  void Partition(const std::shared_ptr<arrow::Array> &values, PartitionIds *partitions) override {
+    const T *data = std::static_pointer_cast<ARRAY_TYPE>(values)->raw_values();
+    const T *splitters = splitters_.data();
+    const size_t n = splitters_.size();
+    AssignPartitions(values, partitions, [&](int64_t i) {
+      return IsNaN(data[i]) ? static_cast<uint32_t>(n) : UpperBound(splitters, n, data[i]);
+    });
+  }
+
+ private:
+  static inline bool IsNaN(T value) {
+    return std::is_floating_point<T>::value && std::isnan(value);
+  }
+
+  std::vector<T> splitters_;
+};
+
+/**
+ * Range partition the binary and string values by the order of their bytes, fixed size binary values as well
+ */
+template<typename TYPE>
+class BinaryRangePartitionKernel : public RangePartitionKernel {
+ public:
+  using ARRAY_TYPE = typename arrow::TypeTraits<TYPE>::ArrayType;
+
+  explicit BinaryRangePartitionKernel(bool ascending) : RangePartitionKernel(ascending) {}
+
+  void SetSplitters(const std::vector<std::shared_ptr<arrow::Array>> &samples, uint32_t num_partitions) override {
+    std::vector<std::string> values;
+    for (const auto &sample : samples) {
+      auto array = std::static_pointer_cast<ARRAY_TYPE>(sample);
+      for (int64_t i = 0; i < array->length(); i++) {
+        if (!array->IsNull(i)) {
+          arrow::util::string_view view = array->GetView(i);
+          values.emplace_back(view.data(), view.size());
+        }
+      }
+    }
+    std::sort(values.begin(), values.end());
+    ChooseSplitters(&values, num_partitions, &splitter_values_);
+    // the search compares views, so it doesn't construct strings
+    splitters_.clear();
+    for (const auto &splitter : splitter_values_) {
+      splitters_.emplace_back(splitter.data(), splitter.size());
+    }
+  }
+
+  void Partition(const std::shared_ptr<arrow::Array> &values, PartitionIds *partitions) override {
+    auto array = std::static_pointer_cast<ARRAY_TYPE>(values);
+    const arrow::util::string_view *splitters = splitters_.data();
+    const size_t n = splitters_.size();
+    AssignPartitions(values, partitions, [&](int64_t i) {
+      return UpperBound(splitters, n, array->GetView(i));
+    });
+  }
+
+ private:
+  std::vector<std::string> splitter_values_;
+  std::vector<arrow::util::string_view> splitters_;
+};
+
+/**
+ * Create a range partition kernel for the type
+ * @param type the type of the values
+ * @param ascending the order of the partitions
+ * @param out the kernel
+ * @return NotImplemented if the type can't be range partitioned
+ */
+twisterx::Status CreateRangePartitionKernel(const std::shared_ptr<arrow::DataType> &type,
+                                            bool ascending,
+                                            std::shared_ptr<RangePartitionKernel> *out);
+
+/**
+ * Sample values of the array uniformly at random, all the values are taken if the array isn't larger than the
+ * number of samples
+ * @param pool the memory pool
+ * @param values the values
+ * @param num_samples the number of samples
+ * @param seed seed of the random sampling
+ * @param out the samples
+ */
+twisterx::Status SampleArray(arrow::MemoryPool *pool,
+                             const std::shared_ptr<arrow::Array> &values,
+                             int64_t num_samples,
+                             uint32_t seed,
+                             std::shared_ptr<arrow::Array> *out);
+
+/**
+ * Sample values of a sorted array at regular intervals, so the samples divide the array into equal parts
+ * @param pool the memory pool
+ * @param values the sorted values
+ * @param num_samples the number of samples
+ * @param out the samples
+ */
+twisterx::Status SampleSortedArray(arrow::MemoryPool *pool,
+                                   const std::shared_ptr<arrow::Array> &values,
+                                   int64_t num_samples,
+                                   std::shared_ptr<arrow::Array> *out);
 }
 
 #endif //TWISTERX_ARROW_PARTITION_KERNELS_H
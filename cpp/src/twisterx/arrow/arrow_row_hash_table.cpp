@@ -0,0 +1,185 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "arrow_row_hash_table.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace twisterx {
+
+/**
+ * The comparison of a column of a type, VALUE_EQUAL compares two non null values
+ */
+template<typename ARRAY_TYPE, typename VALUE_EQUAL>
+class TypedColumnEqualityKernel : public ColumnEqualityKernel {
+ public:
+  explicit TypedColumnEqualityKernel(std::vector<std::shared_ptr<arrow::Array>> arrays) : arrays_(std::move(arrays)) {
+    for (const auto &array : arrays_) {
+      typed_arrays_.push_back(static_cast<const ARRAY_TYPE *>(array.get()));
+      has_nulls_ = has_nulls_ || array->null_count() > 0;
+    }
+  }
+
+  bool Equal(int32_t table1, int64_t row1, int32_t table2, int64_t row2) const override {
+    const ARRAY_TYPE &array1 = *typed_arrays_[table1];
+    const ARRAY_TYPE &array2 = *typed_arrays_[table2];
+    if (has_nulls_) {
+      bool null1 = array1.IsNull(row1);
+      bool null2 = array2.IsNull(row2);
+      if (null1 || null2) {
+        return null1 == null2;
+      }
+    }
+    return VALUE_EQUAL::Equal(array1, row1, array2, row2);
+  }
+
+ private:
+  std::vector<std::shared_ptr<arrow::Array>> arrays_;
+  std::vector<const ARRAY_TYPE *> typed_arrays_;
+  bool has_nulls_ = false;
+};
+
+/**
+ * Fixed width values compare their bytes, so a NaN equals itself as it does when hashed
+ */
+template<typename TYPE>
+struct NumericValueEqual {
+  using T = typename TYPE::c_type;
+
+  static inline bool Equal(const arrow::NumericArray<TYPE> &array1, int64_t row1,
+                           const arrow::NumericArray<TYPE> &array2, int64_t row2) {
+    return std::memcmp(array1.raw_values() + row1, array2.raw_values() + row2, sizeof(T)) == 0;
+  }
+};
+
+struct BooleanValueEqual {
+  static inline bool Equal(const arrow::BooleanArray &array1, int64_t row1,
+                           const arrow::BooleanArray &array2, int64_t row2) {
+    return array1.Value(row1) == array2.Value(row2);
+  }
+};
+
+template<typename ARRAY_TYPE>
+struct BinaryValueEqual {
+  static inline bool Equal(const ARRAY_TYPE &array1, int64_t row1, const ARRAY_TYPE &array2, int64_t row2) {
+    return array1.GetView(row1) == array2.GetView(row2);
+  }
+};
+
+template<typename TYPE>
+static std::unique_ptr<ColumnEqualityKernel> MakeNumericEquality(std::vector<std::shared_ptr<arrow::Array>> arrays) {
+  return std::unique_ptr<ColumnEqualityKernel>(
+      new TypedColumnEqualityKernel<arrow::NumericArray<TYPE>, NumericValueEqual<TYPE>>(std::move(arrays)));
+}
+
+template<typename ARRAY_TYPE>
+static std::unique_ptr<ColumnEqualityKernel> MakeBinaryEquality(std::vector<std::shared_ptr<arrow::Array>> arrays) {
+  return std::unique_ptr<ColumnEqualityKernel>(
+      new TypedColumnEqualityKernel<ARRAY_TYPE, BinaryValueEqual<ARRAY_TYPE>>(std::move(arrays)));
+}
+
+static std::unique_ptr<ColumnEqualityKernel> CreateColumnEqualityKernel(
+    const std::shared_ptr<arrow::DataType> &type,
+    std::vector<std::shared_ptr<arrow::Array>> arrays) {
+  switch (type->id()) {
+    case arrow::Type::BOOL:
+      return std::unique_ptr<ColumnEqualityKernel>(
+          new TypedColumnEqualityKernel<arrow::BooleanArray, BooleanValueEqual>(std::move(arrays)));
+    case arrow::Type::UINT8:return MakeNumericEquality<arrow::UInt8Type>(std::move(arrays));
+    case arrow::Type::INT8:return MakeNumericEquality<arrow::Int8Type>(std::move(arrays));
+    case arrow::Type::UINT16:return MakeNumericEquality<arrow::UInt16Type>(std::move(arrays));
+    case arrow::Type::INT16:return MakeNumericEquality<arrow::Int16Type>(std::move(arrays));
+    case arrow::Type::UINT32:return MakeNumericEquality<arrow::UInt32Type>(std::move(arrays));
+    case arrow::Type::INT32:return MakeNumericEquality<arrow::Int32Type>(std::move(arrays));
+    case arrow::Type::UINT64:return MakeNumericEquality<arrow::UInt64Type>(std::move(arrays));
+    case arrow::Type::INT64:return MakeNumericEquality<arrow::Int64Type>(std::move(arrays));
+    case arrow::Type::HALF_FLOAT:return MakeNumericEquality<arrow::HalfFloatType>(std::move(arrays));
+    case arrow::Type::FLOAT:return MakeNumericEquality<arrow::FloatType>(std::move(arrays));
+    case arrow::Type::DOUBLE:return MakeNumericEquality<arrow::DoubleType>(std::move(arrays));
+    case arrow::Type::DATE32:return MakeNumericEquality<arrow::Date32Type>(std::move(arrays));
+    case arrow::Type::DATE64:return MakeNumericEquality<arrow::Date64Type>(std::move(arrays));
+    case arrow::Type::TIMESTAMP:return MakeNumericEquality<arrow::TimestampType>(std::move(arrays));
+    case arrow::Type::TIME32:return MakeNumericEquality<arrow::Time32Type>(std::move(arrays));
+    case arrow::Type::TIME64:return MakeNumericEquality<arrow::Time64Type>(std::move(arrays));
+    case arrow::Type::STRING:return MakeBinaryEquality<arrow::StringArray>(std::move(arrays));
+    case arrow::Type::BINARY:return MakeBinaryEquality<arrow::BinaryArray>(std::move(arrays));
+    case arrow::Type::LARGE_STRING:return MakeBinaryEquality<arrow::LargeStringArray>(std::move(arrays));
+    case arrow::Type::LARGE_BINARY:return MakeBinaryEquality<arrow::LargeBinaryArray>(std::move(arrays));
+    case arrow::Type::FIXED_SIZE_BINARY:
+    case arrow::Type::DECIMAL:return MakeBinaryEquality<arrow::FixedSizeBinaryArray>(std::move(arrays));
+    default:return nullptr;
+  }
+}
+
+arrow::Status RowEquality::Make(const std::vector<std::vector<std::shared_ptr<arrow::Array>>> &tables,
+                                std::unique_ptr<RowEquality> *out) {
+  std::unique_ptr<RowEquality> equality(new RowEquality());
+  const size_t num_columns = tables.empty() ? 0 : tables[0].size();
+  for (size_t c = 0; c < num_columns; c++) {
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    for (const auto &table : tables) {
+      if (table.size() != num_columns) {
+        return arrow::Status::Invalid("The tables have different numbers of columns");
+      }
+      arrays.push_back(table[c]);
+    }
+    auto type = arrays[0]->type();
+    auto kernel = CreateColumnEqualityKernel(type, std::move(arrays));
+    if (kernel == nullptr) {
+      return arrow::Status::NotImplemented("Comparing rows of type " + type->ToString());
+    }
+    equality->columns_.push_back(std::move(kernel));
+  }
+  *out = std::move(equality);
+  return arrow::Status::OK();
+}
+
+RowHashTable::RowHashTable(const RowEquality *equality, int64_t expected_rows) : equality_(equality) {
+  // at most half the slots are used
+  size_t capacity = 16;
+  while (capacity < static_cast<size_t>(expected_rows) * 2) {
+    capacity *= 2;
+  }
+  slots_.assign(capacity, Slot{0, -1});
+  SetCapacity(capacity);
+  tables_.reserve(expected_rows);
+  rows_.reserve(expected_rows);
+}
+
+void RowHashTable::SetCapacity(size_t capacity) {
+  mask_ = capacity - 1;
+  shift_ = 64;
+  while (capacity > 1) {
+    capacity >>= 1;
+    shift_--;
+  }
+}
+
+void RowHashTable::Grow() {
+  std::vector<Slot> old_slots(slots_.size() * 2, Slot{0, -1});
+  old_slots.swap(slots_);
+  SetCapacity(slots_.size());
+  for (const auto &slot : old_slots) {
+    if (slot.id >= 0) {
+      size_t index = HomeSlot(slot.hash);
+      while (slots_[index].id >= 0) {
+        index = (index + 1) & mask_;
+      }
+      slots_[index] = slot;
+    }
+  }
+}
+
+}
@@ -0,0 +1,176 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_ARROW_ROW_HASH_TABLE_H
+#define TWISTERX_ARROW_ROW_HASH_TABLE_H
+
+#include <memory>
+#include <vector>
+#include <arrow/api.h>
+
+namespace twisterx {
+
+/**
+ * Compares the values of a column at the rows of one or more tables
+ */
+class ColumnEqualityKernel {
+ public:
+  virtual ~ColumnEqualityKernel() = default;
+
+  virtual bool Equal(int32_t table1, int64_t row1, int32_t table2, int64_t row2) const = 0;
+};
+
+/**
+ * Compares the rows of one or more tables with the same column types. Two nulls are equal, and fixed width values
+ * are equal if their bytes are equal, the same as their hashes.
+ */
+class RowEquality {
+ public:
+  /**
+   * Create the comparison of the rows of the tables
+   * @param tables the columns of the tables, tables[t][c] is the column c of the table t as a single array
+   * @param out the comparison
+   * @return the status, NotImplemented if a column type can't be compared
+   */
+  static arrow::Status Make(const std::vector<std::vector<std::shared_ptr<arrow::Array>>> &tables,
+                            std::unique_ptr<RowEquality> *out);
+
+  inline bool Equal(int32_t table1, int64_t row1, int32_t table2, int64_t row2) const {
+    for (const auto &column : columns_) {
+      if (!column->Equal(table1, row1, table2, row2)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::vector<std::unique_ptr<ColumnEqualityKernel>> columns_;
+};
+
+/**
+ * A hash table of the distinct rows of one or more tables, with open addressing and linear probing. A slot holds
+ * the hash of a row and the id of the row. The ids are dense and given in the order the distinct rows are added,
+ * and the table and the row of each id are kept by the id. The rows are compared only when the hashes are equal.
+ */
+class RowHashTable {
+ public:
+  /**
+   * @param equality the comparison of the rows, it should outlive the table
+   * @param expected_rows the number of distinct rows expected, the table grows past it
+   */
+  RowHashTable(const RowEquality *equality, int64_t expected_rows);
+
+  /**
+   * Find the id of a row equal to the row, or add the row with the next id
+   * @param hash the hash of the row
+   * @param table the table of the row
+   * @param row the row
+   * @param inserted if not null, set to true if the row was added
+   * @return the id of the row
+   */
+  inline int64_t FindOrInsert(uint32_t hash, int32_t table, int64_t row, bool *inserted = nullptr) {
+    if ((size_ + 1) * 2 > static_cast<int64_t>(slots_.size())) {
+      Grow();
+    }
+    size_t index = HomeSlot(hash);
+    while (slots_[index].id >= 0) {
+      const Slot &slot = slots_[index];
+      if (slot.hash == hash && equality_->Equal(tables_[slot.id], rows_[slot.id], table, row)) {
+        if (inserted != nullptr) {
+          *inserted = false;
+        }
+        return slot.id;
+      }
+      index = (index + 1) & mask_;
+    }
+    slots_[index].hash = hash;
+    slots_[index].id = size_;
+    tables_.push_back(table);
+    rows_.push_back(row);
+    if (inserted != nullptr) {
+      *inserted = true;
+    }
+    return size_++;
+  }
+
+  /**
+   * Find the id of a row equal to the row
+   * @return the id, or -1 if there is no equal row
+   */
+  inline int64_t Find(uint32_t hash, int32_t table, int64_t row) const {
+    size_t index = HomeSlot(hash);
+    while (slots_[index].id >= 0) {
+      const Slot &slot = slots_[index];
+      if (slot.hash == hash && equality_->Equal(tables_[slot.id], rows_[slot.id], table, row)) {
+        return slot.id;
+      }
+      index = (index + 1) & mask_;
+    }
+    return -1;
+  }
+
+  /**
+   * The number of distinct rows
+   */
+  int64_t Size() const {
+    return size_;
+  }
+
+  /**
+   * The table of the first row added with the id
+   */
+  int32_t Table(int64_t id) const {
+    return tables_[id];
+  }
+
+  /**
+   * The row of the first row added with the id
+   */
+  int64_t Row(int64_t id) const {
+    return rows_[id];
+  }
+
+ private:
+  struct Slot {
+    uint32_t hash;
+    int64_t id;
+  };
+
+  /**
+   * The first slot of a hash, from the high bits of a Fibonacci hash. The rows a rank receives from a hash shuffle
+   * have equal hashes modulo the number of ranks, so the low bits of their hashes are not spread over the slots.
+   */
+  inline size_t HomeSlot(uint32_t hash) const {
+    return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> shift_);
+  }
+
+  // double the slots, the slots keep the hashes so the rows are not hashed again
+  void Grow();
+
+  // set the mask and the shift of the home slots for the number of slots
+  void SetCapacity(size_t capacity);
+
+  const RowEquality *equality_;
+  std::vector<Slot> slots_;
+  size_t mask_ = 0;
+  int shift_ = 64;
+  int64_t size_ = 0;
+  std::vector<int32_t> tables_;
+  std::vector<int64_t> rows_;
+};
+
+}
+
+#endif //TWISTERX_ARROW_ROW_HASH_TABLE_H
@@ -0,0 +1,818 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "arrow_sort_kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "../util/arrow_utils.hpp"
+
+namespace twisterx {
+
+using twisterx::sort::config::SortKey;
+
+// a range of the sorted indices with equal keys, [first, second)
+using SortRange = std::pair<int64_t, int64_t>;
+
+/**
+ * The bits of a value ordered as an unsigned integer, signed integers flip the sign bit
+ */
+template<typename T>
+static inline typename std::make_unsigned<T>::type OrderedBits(T value) {
+  using U = typename std::make_unsigned<T>::type;
+  U bits = static_cast<U>(value);
+  if (std::is_signed<T>::value) {
+    bits ^= static_cast<U>(U(1) << (sizeof(T) * 8 - 1));
+  }
+  return bits;
+}
+
+/**
+ * Floating point values flip all the bits of negatives and the sign bit of positives. The NaNs go after the
+ * largest values and the zeros are equal.
+ */
+static inline uint32_t OrderedBits(float value) {
+  if (std::isnan(value)) {
+    value = std::numeric_limits<float>::quiet_NaN();
+  } else if (value == 0) {
+    value = 0;
+  }
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+static inline uint64_t OrderedBits(double value) {
+  if (std::isnan(value)) {
+    value = std::numeric_limits<double>::quiet_NaN();
+  } else if (value == 0) {
+    value = 0;
+  }
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+}
+
+// shorter arrays are sorted with a comparison sort
+static constexpr int64_t kRadixSortMinLength = 1024;
+// the rows a thread sorts at least in a radix pass
+static constexpr int64_t kRadixSortMinThreadRows = 1 << 16;
+static constexpr int kRadixBits = 8;
+static constexpr int kRadixBuckets = 1 << kRadixBits;
+
+/**
+ * Run fn(t) for t in [0, num_threads), the calling thread runs the first
+ */
+template<typename FUNCTION>
+static void ParallelFor(int num_threads, FUNCTION &&fn) {
+  std::vector<std::thread> workers;
+  for (int t = 1; t < num_threads; t++) {
+    workers.emplace_back(fn, t);
+  }
+  fn(0);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+/**
+ * Sort the keys and the indices along with them with a LSD radix sort. The keys are made relative to the minimum
+ * first, so we only make passes over the digits that differ, and a pass is skipped if all the keys have the same
+ * digit. Each thread counts and scatters a contiguous block of the keys, so the sort is stable.
+ * @param keys the keys, they are relative to the minimum key after the sort
+ * @param indices the indices moved with the keys
+ */
+template<typename U>
+static void RadixSortPairs(U *keys, int64_t *indices, int64_t length, int num_threads) {
+  if (length < kRadixSortMinLength) {
+    std::vector<std::pair<U, int64_t>> pairs(length);
+    for (int64_t i = 0; i < length; i++) {
+      pairs[i] = std::make_pair(keys[i], indices[i]);
+    }
+    std::stable_sort(pairs.begin(), pairs.end(), [](const std::pair<U, int64_t> &a, const std::pair<U, int64_t> &b) {
+      return a.first < b.first;
+    });
+    for (int64_t i = 0; i < length; i++) {
+      keys[i] = pairs[i].first;
+      indices[i] = pairs[i].second;
+    }
+    return;
+  }
+
+  const U min = *std::min_element(keys, keys + length);
+  U range = 0;
+  for (int64_t i = 0; i < length; i++) {
+    keys[i] -= min;
+    range |= keys[i];
+  }
+  int passes = 0;
+  while (passes * kRadixBits < static_cast<int>(sizeof(U) * 8) && (range >> (passes * kRadixBits)) != 0) {
+    passes++;
+  }
+
+  const int threads = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(num_threads,
+                                                                             length / kRadixSortMinThreadRows)));
+  std::vector<int64_t> bounds(threads + 1);
+  for (int t = 0; t <= threads; t++) {
+    bounds[t] = length * t / threads;
+  }
+  std::vector<U> keys_buf(length);
+  std::vector<int64_t> indices_buf(length);
+  U *src_keys = keys, *dst_keys = keys_buf.data();
+  int64_t *src_indices = indices, *dst_indices = indices_buf.data();
+  std::vector<std::array<int64_t, kRadixBuckets>> counts(threads);
+
+  for (int pass = 0; pass < passes; pass++) {
+    const int shift = pass * kRadixBits;
+    ParallelFor(threads, [&](int t) {
+      auto &count = counts[t];
+      count.fill(0);
+      for (int64_t i = bounds[t]; i < bounds[t + 1]; i++) {
+        count[(src_keys[i] >> shift) & (kRadixBuckets - 1)]++;
+      }
+    });
+
+    // the offset of each digit for each thread, the threads write their digits in the order of their blocks
+    bool same_digit = false;
+    int64_t offset = 0;
+    for (int d = 0; d < kRadixBuckets; d++) {
+      int64_t digit_start = offset;
+      for (int t = 0; t < threads; t++) {
+        int64_t count = counts[t][d];
+        counts[t][d] = offset;
+        offset += count;
+      }
+      same_digit = same_digit || offset - digit_start == length;
+    }
+    if (same_digit) {
+      continue;
+    }
+
+    ParallelFor(threads, [&](int t) {
+      auto &position = counts[t];
+      for (int64_t i = bounds[t]; i < bounds[t + 1]; i++) {
+        int64_t pos = position[(src_keys[i] >> shift) & (kRadixBuckets - 1)]++;
+        dst_keys[pos] = src_keys[i];
+        dst_indices[pos] = src_indices[i];
+      }
+    });
+    std::swap(src_keys, dst_keys);
+    std::swap(src_indices, dst_indices);
+  }
+
+  if (src_keys != keys) {
+    std::copy(src_keys, src_keys + length, keys);
+    std::copy(src_indices, src_indices + length, indices);
+  }
+}
+
+template<typename T>
+void SortValueIndices(const T *values, int64_t length, int64_t *indices, int num_threads) {
+  using U = decltype(OrderedBits(T()));
+  std::vector<U> keys(length);
+  for (int64_t i = 0; i < length; i++) {
+    keys[i] = OrderedBits(values[i]);
+    indices[i] = i;
+  }
+  RadixSortPairs<U>(keys.data(), indices, length, num_threads);
+}
+
+template void SortValueIndices<int8_t>(const int8_t *, int64_t, int64_t *, int);
+template void SortValueIndices<uint8_t>(const uint8_t *, int64_t, int64_t *, int);
+template void SortValueIndices<int16_t>(const int16_t *, int64_t, int64_t *, int);
+template void SortValueIndices<uint16_t>(const uint16_t *, int64_t, int64_t *, int);
+template void SortValueIndices<int32_t>(const int32_t *, int64_t, int64_t *, int);
+template void SortValueIndices<uint32_t>(const uint32_t *, int64_t, int64_t *, int);
+template void SortValueIndices<int64_t>(const int64_t *, int64_t, int64_t *, int);
+template void SortValueIndices<uint64_t>(const uint64_t *, int64_t, int64_t *, int);
+template void SortValueIndices<float>(const float *, int64_t, int64_t *, int);
+template void SortValueIndices<double>(const double *, int64_t, int64_t *, int);
+
+/**
+ * Sorts binary values on 8 byte big-endian prefixes. The indices are radix sorted on the first 8 bytes, and each run
+ * of equal prefixes is sorted on the next 8 bytes, until the values of a run end. The prefixes are zero padded, so
+ * values that end within a run are a prefix of the longer values of the run and go first, ordered by length. Each
+ * comparison is an integer compare of a prefix cached next to the index instead of a read of two values.
+ */
+template<typename ARRAY_TYPE>
+class BinaryPrefixSorter {
+ public:
+  explicit BinaryPrefixSorter(const ARRAY_TYPE &array) : array_(array) {}
+
+  void Sort(int64_t *indices, int64_t length, int num_threads) {
+    std::iota(indices, indices + length, 0);
+    // the runs to sort, with the depth of their prefix
+    std::vector<std::tuple<int64_t, int64_t, int64_t>> runs;
+    runs.emplace_back(0, length, 0);
+    std::vector<uint64_t> prefixes;
+    while (!runs.empty()) {
+      int64_t begin, end, depth;
+      std::tie(begin, end, depth) = runs.back();
+      runs.pop_back();
+
+      const int64_t run_length = end - begin;
+      prefixes.resize(run_length);
+      for (int64_t i = 0; i < run_length; i++) {
+        prefixes[i] = Prefix(indices[begin + i], depth);
+      }
+      RadixSortPairs<uint64_t>(prefixes.data(), indices + begin, run_length, begin == 0 ? num_threads : 1);
+
+      int64_t start = 0;
+      for (int64_t i = 1; i <= run_length; i++) {
+        if (i < run_length && prefixes[i] == prefixes[start]) {
+          continue;
+        }
+        if (i - start > 1) {
+          // the values that end in this prefix go first, the rest are sorted on the next prefix
+          int64_t *run_begin = indices + begin + start;
+          int64_t *run_end = indices + begin + i;
+          const int64_t next_depth = depth + 8;
+          int64_t *rest = std::stable_partition(run_begin, run_end, [this, next_depth](int64_t index) {
+            return Length(index) <= next_depth;
+          });
+          std::stable_sort(run_begin, rest, [this](int64_t a, int64_t b) {
+            return Length(a) < Length(b);
+          });
+          if (run_end - rest > 1) {
+            runs.emplace_back(rest - indices, run_end - indices, next_depth);
+          }
+        }
+        start = i;
+      }
+    }
+  }
+
+ private:
+  inline int64_t Length(int64_t index) const {
+    return static_cast<int64_t>(array_.GetView(index).size());
+  }
+
+  inline uint64_t Prefix(int64_t index, int64_t depth) const {
+    auto value = array_.GetView(index);
+    const auto *data = reinterpret_cast<const uint8_t *>(value.data());
+    int64_t remaining = static_cast<int64_t>(value.size()) - depth;
+    int64_t bytes = std::max<int64_t>(0, std::min<int64_t>(8, remaining));
+    uint64_t prefix = 0;
+    for (int64_t b = 0; b < bytes; b++) {
+      prefix |= static_cast<uint64_t>(data[depth + b]) << (56 - 8 * b);
+    }
+    return prefix;
+  }
+
+  const ARRAY_TYPE &array_;
+};
+
+template<typename ARRAY_TYPE>
+static void SortBinaryArrayIndices(const arrow::Array &values, int64_t *indices, int num_threads) {
+  BinaryPrefixSorter<ARRAY_TYPE> sorter(static_cast<const ARRAY_TYPE &>(values));
+  sorter.Sort(indices, values.length(), num_threads);
+}
+
+arrow::Status SortBinaryIndices(const std::shared_ptr<arrow::Array> &values, int64_t *indices, int num_threads) {
+  switch (values->type_id()) {
+    case arrow::Type::STRING:SortBinaryArrayIndices<arrow::StringArray>(*values, indices, num_threads);
+      break;
+    case arrow::Type::BINARY:SortBinaryArrayIndices<arrow::BinaryArray>(*values, indices, num_threads);
+      break;
+    case arrow::Type::LARGE_STRING:SortBinaryArrayIndices<arrow::LargeStringArray>(*values, indices, num_threads);
+      break;
+    case arrow::Type::LARGE_BINARY:SortBinaryArrayIndices<arrow::LargeBinaryArray>(*values, indices, num_threads);
+      break;
+    case arrow::Type::FIXED_SIZE_BINARY:
+      SortBinaryArrayIndices<arrow::FixedSizeBinaryArray>(*values, indices, num_threads);
+      break;
+    default:return arrow::Status::NotImplemented("Binary sort of type " + values->type()->ToString());
+  }
+  return arrow::Status::OK();
+}
+
+template<typename U>
+static inline void PutBigEndian(U bits, uint8_t *out) {
+  for (int b = sizeof(U) - 1; b >= 0; b--) {
+    *out++ = static_cast<uint8_t>(bits >> (b * 8));
+  }
+}
+
+template<typename TYPE>
+static void EncodeNumericKey(const arrow::Array &array, bool ascending, uint8_t *out, int32_t stride) {
+  using T = typename TYPE::c_type;
+  using U = decltype(OrderedBits(T()));
+  const T *values = static_cast<const arrow::NumericArray<TYPE> &>(array).raw_values();
+  const U mask = ascending ? U(0) : static_cast<U>(~U(0));
+  for (int64_t i = 0; i < array.length(); i++) {
+    PutBigEndian<U>(static_cast<U>(OrderedBits(values[i]) ^ mask), out + i * stride);
+  }
+}
+
+static void EncodeBooleanKey(const arrow::Array &array, bool ascending, uint8_t *out, int32_t stride) {
+  const auto &values = static_cast<const arrow::BooleanArray &>(array);
+  for (int64_t i = 0; i < array.length(); i++) {
+    out[i * stride] = static_cast<uint8_t>(values.Value(i) == ascending);
+  }
+}
+
+/**
+ * The bytes of a value of the type in the normalized key, 0 if the type can't be normalized
+ */
+static int32_t NormalizedValueWidth(const arrow::DataType &type) {
+  switch (type.id()) {
+    case arrow::Type::BOOL:
+    case arrow::Type::UINT8:
+    case arrow::Type::INT8:return 1;
+    case arrow::Type::UINT16:
+    case arrow::Type::INT16:return 2;
+    case arrow::Type::UINT32:
+    case arrow::Type::INT32:
+    case arrow::Type::FLOAT:
+    case arrow::Type::DATE32:
+    case arrow::Type::TIME32:return 4;
+    case arrow::Type::UINT64:
+    case arrow::Type::INT64:
+    case arrow::Type::DOUBLE:
+    case arrow::Type::DATE64:
+    case arrow::Type::TIME64:
+    case arrow::Type::TIMESTAMP:return 8;
+    default:return 0;
+  }
+}
+
+static void EncodeKey(const arrow::Array &array, bool ascending, uint8_t *out, int32_t stride) {
+  switch (array.type_id()) {
+    case arrow::Type::BOOL:return EncodeBooleanKey(array, ascending, out, stride);
+    case arrow::Type::UINT8:return EncodeNumericKey<arrow::UInt8Type>(array, ascending, out, stride);
+    case arrow::Type::INT8:return EncodeNumericKey<arrow::Int8Type>(array, ascending, out, stride);
+    case arrow::Type::UINT16:return EncodeNumericKey<arrow::UInt16Type>(array, ascending, out, stride);
+    case arrow::Type::INT16:return EncodeNumericKey<arrow::Int16Type>(array, ascending, out, stride);
+    case arrow::Type::UINT32:return EncodeNumericKey<arrow::UInt32Type>(array, ascending, out, stride);
+    case arrow::Type::INT32:return EncodeNumericKey<arrow::Int32Type>(array, ascending, out, stride);
+    case arrow::Type::UINT64:return EncodeNumericKey<arrow::UInt64Type>(array, ascending, out, stride);
+    case arrow::Type::INT64:return EncodeNumericKey<arrow::Int64Type>(array, ascending, out, stride);
+    case arrow::Type::FLOAT:return EncodeNumericKey<arrow::FloatType>(array, ascending, out, stride);
+    case arrow::Type::DOUBLE:return EncodeNumericKey<arrow::DoubleType>(array, ascending, out, stride);
+    case arrow::Type::DATE32:return EncodeNumericKey<arrow::Date32Type>(array, ascending, out, stride);
+    case arrow::Type::DATE64:return EncodeNumericKey<arrow::Date64Type>(array, ascending, out, stride);
+    case arrow::Type::TIME32:return EncodeNumericKey<arrow::Time32Type>(array, ascending, out, stride);
+    case arrow::Type::TIME64:return EncodeNumericKey<arrow::Time64Type>(array, ascending, out, stride);
+    case arrow::Type::TIMESTAMP:return EncodeNumericKey<arrow::TimestampType>(array, ascending, out, stride);
+    default:return;
+  }
+}
+
+/**
+ * The leading keys encoded so that the byte order of the rows is the order of the keys. A key with nulls gets a
+ * byte before the value that puts the nulls first or last, the values of the nulls are zero.
+ */
+class NormalizedKeys {
+ public:
+  NormalizedKeys(const std::vector<std::shared_ptr<arrow::Array>> &columns, const std::vector<SortKey> &keys) {
+    for (size_t k = 0; k < keys.size(); k++) {
+      int32_t value_width = NormalizedValueWidth(*columns[k]->type());
+      int32_t key_width = value_width + (columns[k]->null_count() > 0 ? 1 : 0);
+      if (value_width == 0 || width_ + key_width > TWISTERX_SORT_NORMALIZED_KEY_WIDTH) {
+        break;
+      }
+      width_ += key_width;
+      num_keys_++;
+    }
+    if (num_keys_ == 0) {
+      return;
+    }
+
+    const int64_t length = columns[0]->length();
+    bytes_.assign(length * width_, 0);
+    int32_t offset = 0;
+    for (size_t k = 0; k < num_keys_; k++) {
+      const auto &array = columns[k];
+      const bool has_nulls = array->null_count() > 0;
+      int32_t value_offset = offset + (has_nulls ? 1 : 0);
+      int32_t value_width = NormalizedValueWidth(*array->type());
+      EncodeKey(*array, keys[k].IsAscending(), bytes_.data() + value_offset, width_);
+      if (has_nulls) {
+        const uint8_t null_byte = keys[k].NullsFirst() ? 0 : 1;
+        for (int64_t i = 0; i < length; i++) {
+          uint8_t *row = bytes_.data() + i * width_;
+          if (array->IsNull(i)) {
+            row[offset] = null_byte;
+            std::memset(row + value_offset, 0, value_width);
+          } else {
+            row[offset] = static_cast<uint8_t>(1 - null_byte);
+          }
+        }
+      }
+      offset = value_offset + value_width;
+    }
+  }
+
+  /**
+   * The number of leading keys in the normalized key
+   */
+  size_t NumKeys() const {
+    return num_keys_;
+  }
+
+  /**
+   * Sort the indices by the normalized key, equal keys keep the order of the rows. The ranges of equal keys are
+   * added to the ties if there are more keys to sort on.
+   */
+  void Sort(int64_t *indices, int64_t length, bool find_ties, std::vector<SortRange> *ties, int num_threads) const {
+    if (width_ <= 8) {
+      SortPacked(indices, length, find_ties, ties, num_threads);
+      return;
+    }
+    const uint8_t *bytes = bytes_.data();
+    const int32_t width = width_;
+    std::iota(indices, indices + length, 0);
+    std::sort(indices, indices + length, [bytes, width](int64_t a, int64_t b) {
+      int c = std::memcmp(bytes + a * width, bytes + b * width, width);
+      return c < 0 || (c == 0 && a < b);
+    });
+    if (find_ties) {
+      FindTies(indices, length, [bytes, width](int64_t a, int64_t b) {
+        return std::memcmp(bytes + a * width, bytes + b * width, width) == 0;
+      }, ties);
+    }
+  }
+
+  /**
+   * Compare two rows by the normalized key
+   * @return negative, zero or positive as row a goes before, with or after row b
+   */
+  inline int Compare(int64_t a, int64_t b) const {
+    if (width_ == 0) {
+      return 0;
+    }
+    return std::memcmp(bytes_.data() + a * width_, bytes_.data() + b * width_, width_);
+  }
+
+ private:
+  /**
+   * Keys of up to 8 bytes are packed into an integer and radix sorted
+   */
+  void SortPacked(int64_t *indices, int64_t length, bool find_ties, std::vector<SortRange> *ties,
+                  int num_threads) const {
+    std::vector<uint64_t> packed(length);
+    for (int64_t i = 0; i < length; i++) {
+      const uint8_t *row = bytes_.data() + i * width_;
+      uint64_t key = 0;
+      for (int32_t b = 0; b < width_; b++) {
+        key = (key << 8) | row[b];
+      }
+      packed[i] = key;
+      indices[i] = i;
+    }
+    RadixSortPairs<uint64_t>(packed.data(), indices, length, num_threads);
+    if (find_ties) {
+      int64_t start = 0;
+      for (int64_t i = 1; i <= length; i++) {
+        if (i == length || packed[i] != packed[start]) {
+          if (i - start > 1) {
+            ties->emplace_back(start, i);
+          }
+          start = i;
+        }
+      }
+    }
+  }
+
+  template<typename EQUAL>
+  static void FindTies(const int64_t *indices, int64_t length, EQUAL &&equal, std::vector<SortRange> *ties) {
+    int64_t start = 0;
+    for (int64_t i = 1; i <= length; i++) {
+      if (i == length || !equal(indices[start], indices[i])) {
+        if (i - start > 1) {
+          ties->emplace_back(start, i);
+        }
+        start = i;
+      }
+    }
+  }
+
+  int32_t width_ = 0;
+  size_t num_keys_ = 0;
+  std::vector<uint8_t> bytes_;
+};
+
+/**
+ * Sorts the ranges of equal keys of the indices by a column
+ */
+class ColumnSortKernel {
+ public:
+  virtual ~ColumnSortKernel() = default;
+
+  /**
+   * Sort each range of the indices by the column, and replace the ranges with the ranges that are still equal
+   * @param indices the indices
+   * @param ties the ranges of equal keys
+   */
+  virtual void SortTies(int64_t *indices, std::vector<SortRange> *ties) = 0;
+
+  /**
+   * Compare two rows by the column, with the order and the null placement of the key
+   * @return negative, zero or positive as row a goes before, with or after row b
+   */
+  virtual int Compare(int64_t a, int64_t b) const = 0;
+};
+
+/**
+ * The sort of a column of a type, VALUES gives the value of a row
+ */
+template<typename VALUES>
+class TypedColumnSortKernel : public ColumnSortKernel {
+ public:
+  TypedColumnSortKernel(std::shared_ptr<arrow::Array> array, const SortKey &key)
+      : array_(std::move(array)), values_(*array_), ascending_(key.IsAscending()), nulls_first_(key.NullsFirst()) {}
+
+  void SortTies(int64_t *indices, std::vector<SortRange> *ties) override {
+    std::vector<SortRange> remaining;
+    const VALUES &values = values_;
+    auto less = [&values](int64_t a, int64_t b) {
+      return ValueLess(values.Get(a), values.Get(b));
+    };
+    auto greater = [&values](int64_t a, int64_t b) {
+      return ValueLess(values.Get(b), values.Get(a));
+    };
+    for (const auto &tie : *ties) {
+      int64_t *begin = indices + tie.first;
+      int64_t *end = indices + tie.second;
+      if (array_->null_count() > 0) {
+        // the nulls are equal, so they stay a range of their own
+        int64_t *nulls_begin, *nulls_end;
+        if (nulls_first_) {
+          nulls_begin = begin;
+          nulls_end = begin = std::stable_partition(begin, end, [this](int64_t i) {
+            return array_->IsNull(i);
+          });
+        } else {
+          nulls_begin = end = std::stable_partition(begin, end, [this](int64_t i) {
+            return array_->IsValid(i);
+          });
+          nulls_end = indices + tie.second;
+        }
+        AddTie(indices, nulls_begin, nulls_end, &remaining);
+      }
+      if (ascending_) {
+        std::stable_sort(begin, end, less);
+      } else {
+        std::stable_sort(begin, end, greater);
+      }
+      int64_t *start = begin;
+      for (int64_t *it = begin + 1; it <= end; it++) {
+        if (it == end || less(*start, *it) || less(*it, *start)) {
+          AddTie(indices, start, it, &remaining);
+          start = it;
+        }
+      }
+    }
+    ties->swap(remaining);
+  }
+
+  int Compare(int64_t a, int64_t b) const override {
+    if (array_->null_count() > 0) {
+      bool a_null = array_->IsNull(a);
+      bool b_null = array_->IsNull(b);
+      if (a_null || b_null) {
+        if (a_null == b_null) {
+          return 0;
+        }
+        return a_null == nulls_first_ ? -1 : 1;
+      }
+    }
+    const auto a_value = values_.Get(a);
+    const auto b_value = values_.Get(b);
+    int c = ValueLess(a_value, b_value) ? -1 : (ValueLess(b_value, a_value) ? 1 : 0);
+    return ascending_ ? c : -c;
+  }
+
+ private:
+  static void AddTie(const int64_t *indices, const int64_t *begin, const int64_t *end, std::vector<SortRange> *ties) {
+    if (end - begin > 1) {
+      ties->emplace_back(begin - indices, end - indices);
+    }
+  }
+
+  std::shared_ptr<arrow::Array> array_;
+  VALUES values_;
+  bool ascending_;
+  bool nulls_first_;
+};
+
+template<typename TYPE>
+class NumericSortValues {
+ public:
+  using T = typename TYPE::c_type;
+
+  explicit NumericSortValues(const arrow::Array &array)
+      : values_(static_cast<const arrow::NumericArray<TYPE> &>(array).raw_values()) {}
+
+  inline T Get(int64_t i) const {
+    return values_[i];
+  }
+
+ private:
+  const T *values_;
+};
+
+class BooleanSortValues {
+ public:
+  explicit BooleanSortValues(const arrow::Array &array) : array_(static_cast<const arrow::BooleanArray &>(array)) {}
+
+  inline bool Get(int64_t i) const {
+    return array_.Value(i);
+  }
+
+ private:
+  const arrow::BooleanArray &array_;
+};
+
+template<typename ARRAY_TYPE>
+class BinarySortValues {
+ public:
+  explicit BinarySortValues(const arrow::Array &array) : array_(static_cast<const ARRAY_TYPE &>(array)) {}
+
+  inline arrow::util::string_view Get(int64_t i) const {
+    return array_.GetView(i);
+  }
+
+ private:
+  const ARRAY_TYPE &array_;
+};
+
+template<typename VALUES>
+static std::unique_ptr<ColumnSortKernel> MakeColumnSortKernel(const std::shared_ptr<arrow::Array> &array,
+                                                              const SortKey &key) {
+  return std::unique_ptr<ColumnSortKernel>(new TypedColumnSortKernel<VALUES>(array, key));
+}
+
+static std::unique_ptr<ColumnSortKernel> CreateColumnSortKernel(const std::shared_ptr<arrow::Array> &array,
+                                                                const SortKey &key) {
+  switch (array->type_id()) {
+    case arrow::Type::BOOL:return MakeColumnSortKernel<BooleanSortValues>(array, key);
+    case arrow::Type::UINT8:return MakeColumnSortKernel<NumericSortValues<arrow::UInt8Type>>(array, key);
+    case arrow::Type::INT8:return MakeColumnSortKernel<NumericSortValues<arrow::Int8Type>>(array, key);
+    case arrow::Type::UINT16:return MakeColumnSortKernel<NumericSortValues<arrow::UInt16Type>>(array, key);
+    case arrow::Type::INT16:return MakeColumnSortKernel<NumericSortValues<arrow::Int16Type>>(array, key);
+    case arrow::Type::UINT32:return MakeColumnSortKernel<NumericSortValues<arrow::UInt32Type>>(array, key);
+    case arrow::Type::INT32:return MakeColumnSortKernel<NumericSortValues<arrow::Int32Type>>(array, key);
+    case arrow::Type::UINT64:return MakeColumnSortKernel<NumericSortValues<arrow::UInt64Type>>(array, key);
+    case arrow::Type::INT64:return MakeColumnSortKernel<NumericSortValues<arrow::Int64Type>>(array, key);
+    case arrow::Type::FLOAT:return MakeColumnSortKernel<NumericSortValues<arrow::FloatType>>(array, key);
+    case arrow::Type::DOUBLE:return MakeColumnSortKernel<NumericSortValues<arrow::DoubleType>>(array, key);
+    case arrow::Type::DATE32:return MakeColumnSortKernel<NumericSortValues<arrow::Date32Type>>(array, key);
+    case arrow::Type::DATE64:return MakeColumnSortKernel<NumericSortValues<arrow::Date64Type>>(array, key);
+    case arrow::Type::TIME32:return MakeColumnSortKernel<NumericSortValues<arrow::Time32Type>>(array, key);
+    case arrow::Type::TIME64:return MakeColumnSortKernel<NumericSortValues<arrow::Time64Type>>(array, key);
+    case arrow::Type::TIMESTAMP:return MakeColumnSortKernel<NumericSortValues<arrow::TimestampType>>(array, key);
+    case arrow::Type::STRING:return MakeColumnSortKernel<BinarySortValues<arrow::StringArray>>(array, key);
+    case arrow::Type::BINARY:return MakeColumnSortKernel<BinarySortValues<arrow::BinaryArray>>(array, key);
+    case arrow::Type::LARGE_STRING:
+      return MakeColumnSortKernel<BinarySortValues<arrow::LargeStringArray>>(array, key);
+    case arrow::Type::LARGE_BINARY:
+      return MakeColumnSortKernel<BinarySortValues<arrow::LargeBinaryArray>>(array, key);
+    case arrow::Type::FIXED_SIZE_BINARY:
+      return MakeColumnSortKernel<BinarySortValues<arrow::FixedSizeBinaryArray>>(array, key);
+    default:return nullptr;
+  }
+}
+
+/**
+ * The sort columns of the keys as single arrays
+ */
+static arrow::Status SortColumns(arrow::MemoryPool *pool,
+                                 const std::shared_ptr<arrow::Table> &table,
+                                 const std::vector<SortKey> &keys,
+                                 std::vector<std::shared_ptr<arrow::Array>> *columns) {
+  if (keys.empty()) {
+    return arrow::Status::Invalid("No columns to sort on");
+  }
+  for (const auto &key : keys) {
+    if (key.GetColumnIdx() < 0 || key.GetColumnIdx() >= table->num_columns()) {
+      return arrow::Status::IndexError("Invalid sort column " + std::to_string(key.GetColumnIdx()));
+    }
+    std::shared_ptr<arrow::Array> array;
+    RETURN_NOT_OK(twisterx::util::CombineChunks(table->column(key.GetColumnIdx()), &array, pool));
+    columns->push_back(array);
+  }
+  return arrow::Status::OK();
+}
+
+/**
+ * The kernels of the keys after the ones in the normalized key
+ */
+static arrow::Status CreateColumnSortKernels(const std::vector<std::shared_ptr<arrow::Array>> &columns,
+                                             const std::vector<SortKey> &keys,
+                                             size_t first_key,
+                                             std::vector<std::unique_ptr<ColumnSortKernel>> *kernels) {
+  for (size_t k = first_key; k < keys.size(); k++) {
+    kernels->push_back(CreateColumnSortKernel(columns[k], keys[k]));
+    if (kernels->back() == nullptr) {
+      return arrow::Status::NotImplemented("Sorting on type " + columns[k]->type()->ToString());
+    }
+  }
+  return arrow::Status::OK();
+}
+
+arrow::Status SortIndicesMultiColumns(arrow::MemoryPool *pool,
+                                      const std::shared_ptr<arrow::Table> &table,
+                                      const std::vector<SortKey> &keys,
+                                      std::shared_ptr<arrow::Array> *indices,
+                                      int num_threads) {
+  std::vector<std::shared_ptr<arrow::Array>> columns;
+  RETURN_NOT_OK(SortColumns(pool, table, keys, &columns));
+
+  const int64_t length = table->num_rows();
+  std::shared_ptr<arrow::Buffer> indices_buf;
+  RETURN_NOT_OK(arrow::AllocateBuffer(pool, length * sizeof(int64_t), &indices_buf));
+  auto *sorted = reinterpret_cast<int64_t *>(indices_buf->mutable_data());
+
+  // sort on the normalized key, then sort the ties one column at a time
+  NormalizedKeys normalized(columns, keys);
+  std::vector<std::unique_ptr<ColumnSortKernel>> kernels;
+  RETURN_NOT_OK(CreateColumnSortKernels(columns, keys, normalized.NumKeys(), &kernels));
+  std::vector<SortRange> ties;
+  if (normalized.NumKeys() > 0) {
+    normalized.Sort(sorted, length, normalized.NumKeys() < keys.size(), &ties, num_threads);
+  } else {
+    std::iota(sorted, sorted + length, 0);
+    if (length > 1) {
+      ties.emplace_back(0, length);
+    }
+  }
+  for (size_t k = 0; k < kernels.size() && !ties.empty(); k++) {
+    kernels[k]->SortTies(sorted, &ties);
+  }
+
+  *indices = std::make_shared<arrow::Int64Array>(length, indices_buf);
+  return arrow::Status::OK();
+}
+
+arrow::Status TopKIndices(arrow::MemoryPool *pool,
+                          const std::shared_ptr<arrow::Table> &table,
+                          const std::vector<SortKey> &keys,
+                          int64_t k,
+                          std::shared_ptr<arrow::Array> *indices,
+                          int num_threads) {
+  if (k < 0) {
+    return arrow::Status::Invalid("Negative number of rows " + std::to_string(k));
+  }
+  const int64_t length = table->num_rows();
+  if (k >= length) {
+    return SortIndicesMultiColumns(pool, table, keys, indices, num_threads);
+  }
+  std::vector<std::shared_ptr<arrow::Array>> columns;
+  RETURN_NOT_OK(SortColumns(pool, table, keys, &columns));
+  NormalizedKeys normalized(columns, keys);
+  std::vector<std::unique_ptr<ColumnSortKernel>> kernels;
+  RETURN_NOT_OK(CreateColumnSortKernels(columns, keys, normalized.NumKeys(), &kernels));
+
+  // the rows compare on all the keys, then on the row index so the selection is the prefix of the stable sort
+  auto less = [&normalized, &kernels](int64_t a, int64_t b) {
+    int c = normalized.Compare(a, b);
+    for (size_t i = 0; c == 0 && i < kernels.size(); i++) {
+      c = kernels[i]->Compare(a, b);
+    }
+    return c < 0 || (c == 0 && a < b);
+  };
+
+  // a max heap of the k smallest rows seen so far, most rows are rejected with a single compare against the top
+  std::vector<int64_t> heap;
+  heap.reserve(k);
+  for (int64_t i = 0; i < length && k > 0; i++) {
+    if (static_cast<int64_t>(heap.size()) < k) {
+      heap.push_back(i);
+      std::push_heap(heap.begin(), heap.end(), less);
+    } else if (less(i, heap.front())) {
+      std::pop_heap(heap.begin(), heap.end(), less);
+      heap.back() = i;
+      std::push_heap(heap.begin(), heap.end(), less);
+    }
+  }
+  std::sort_heap(heap.begin(), heap.end(), less);
+
+  std::shared_ptr<arrow::Buffer> indices_buf;
+  RETURN_NOT_OK(arrow::AllocateBuffer(pool, k * sizeof(int64_t), &indices_buf));
+  std::copy(heap.begin(), heap.end(), reinterpret_cast<int64_t *>(indices_buf->mutable_data()));
+  *indices = std::make_shared<arrow::Int64Array>(k, indices_buf);
+  return arrow::Status::OK();
+}
+
+}
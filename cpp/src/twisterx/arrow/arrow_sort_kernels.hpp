@@ -0,0 +1,110 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_ARROW_SORT_KERNELS_H
+#define TWISTERX_ARROW_SORT_KERNELS_H
+
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <arrow/api.h>
+
+#include "../sort/sort_config.h"
+
+// the maximum bytes of the normalized key of the leading fixed width sort columns
+#define TWISTERX_SORT_NORMALIZED_KEY_WIDTH 32
+
+namespace twisterx {
+
+/**
+ * The order of two values of a sort, a strict weak order for every type
+ */
+template<typename T>
+inline bool ValueLess(const T &a, const T &b) {
+  return a < b;
+}
+
+// the NaNs go after the largest values, as in the normalized keys
+inline bool ValueLess(float a, float b) {
+  return a < b || (std::isnan(b) && !std::isnan(a));
+}
+
+inline bool ValueLess(double a, double b) {
+  return a < b || (std::isnan(b) && !std::isnan(a));
+}
+
+/**
+ * Sort the rows of a table by multiple columns. The leading fixed width columns are encoded into a normalized key,
+ * a byte string that orders the rows with a single integer compare or memcmp. The rows with equal normalized keys
+ * are then sorted by the remaining columns one column at a time, with comparisons specialized to the column type.
+ * The sort is stable.
+ * @param pool the memory pool
+ * @param table the table
+ * @param keys the sort columns, the first key is the most significant
+ * @param indices the int64 indices of the rows in the sorted order
+ * @param num_threads the threads of the radix sort of the normalized keys
+ * @return the status of the sort
+ */
+arrow::Status SortIndicesMultiColumns(arrow::MemoryPool *pool,
+                                      const std::shared_ptr<arrow::Table> &table,
+                                      const std::vector<twisterx::sort::config::SortKey> &keys,
+                                      std::shared_ptr<arrow::Array> *indices,
+                                      int num_threads = 1);
+
+/**
+ * The indices of the first k rows of the table in the order of the sort columns, without sorting the other rows.
+ * The rows are selected with a bounded heap of k rows that compares on the normalized key and then on the remaining
+ * columns, and the k rows are sorted. The result is the prefix of the stable sort of the table.
+ * @param pool the memory pool
+ * @param table the table
+ * @param keys the sort columns, the first key is the most significant
+ * @param k the number of rows, all the rows are sorted if the table has at most k rows
+ * @param indices the int64 indices of the first k rows in the sorted order
+ * @param num_threads the threads of the sort when all the rows are sorted
+ * @return the status of the selection
+ */
+arrow::Status TopKIndices(arrow::MemoryPool *pool,
+                          const std::shared_ptr<arrow::Table> &table,
+                          const std::vector<twisterx::sort::config::SortKey> &keys,
+                          int64_t k,
+                          std::shared_ptr<arrow::Array> *indices,
+                          int num_threads = 1);
+
+/**
+ * Sort the indices of integer or floating point values. Short arrays use a comparison sort, longer ones a LSD radix
+ * sort of (key, index) pairs, where the key is the bits of the value relative to the minimum, so a narrow range of
+ * values takes fewer passes. Floating point values flip their bits so they order as unsigned integers, with the
+ * NaNs last. The sort is stable. It is instantiated for the integer types, float and double.
+ * @param values the values
+ * @param length the number of values
+ * @param indices the sorted indices
+ * @param num_threads the threads of the radix sort, large arrays split the passes over the threads
+ */
+template<typename T>
+void SortValueIndices(const T *values, int64_t length, int64_t *indices, int num_threads = 1);
+
+/**
+ * Sort the indices of string or binary values in byte order. An 8 byte big-endian prefix of each value is cached with
+ * its index, the indices are radix sorted on the prefixes, and the runs of equal prefixes are sorted on the next 8
+ * bytes. The sort is stable.
+ * @param values string, binary, large string, large binary or fixed size binary values
+ * @param indices the sorted indices
+ * @param num_threads the threads of the radix sort of the first prefixes
+ * @return the status of the sort
+ */
+arrow::Status SortBinaryIndices(const std::shared_ptr<arrow::Array> &values, int64_t *indices, int num_threads = 1);
+
+}
+
+#endif //TWISTERX_ARROW_SORT_KERNELS_H
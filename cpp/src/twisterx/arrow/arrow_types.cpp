@@ -28,8 +28,8 @@ bool validateArrowTableTypes(const std::shared_ptr<arrow::Table> &table) {
   std::shared_ptr<arrow::Schema> schema = table->schema();
   for (const auto &t : schema->fields()) {
 	switch (t->type()->id()) {
-	  case arrow::Type::NA:break;
-	  case arrow::Type::BOOL:break;
+	  case arrow::Type::NA:return false;
+	  case arrow::Type::BOOL:
 	  case arrow::Type::UINT8:
 	  case arrow::Type::INT8:
 	  case arrow::Type::UINT16:
@@ -42,15 +42,17 @@ bool validateArrowTableTypes(const std::shared_ptr<arrow::Table> &table) {
 	  case arrow::Type::FLOAT:
 	  case arrow::Type::DOUBLE:
 	  case arrow::Type::BINARY:
-	  case arrow::Type::FIXED_SIZE_BINARY:return true;
-	  case arrow::Type::STRING:break;
-	  case arrow::Type::DATE32:break;
-	  case arrow::Type::DATE64:break;
-	  case arrow::Type::TIMESTAMP:break;
-	  case arrow::Type::TIME32:break;
-	  case arrow::Type::TIME64:break;
-	  case arrow::Type::INTERVAL:break;
-	  case arrow::Type::DECIMAL:break;
+	  case arrow::Type::FIXED_SIZE_BINARY:
+	  case arrow::Type::STRING:
+	  case arrow::Type::DATE32:
+	  case arrow::Type::DATE64:
+	  case arrow::Type::TIMESTAMP:
+	  case arrow::Type::TIME32:
+	  case arrow::Type::TIME64:
+	  case arrow::Type::DECIMAL:
+	  case arrow::Type::LARGE_STRING:
+	  case arrow::Type::LARGE_BINARY:break;
+	  case arrow::Type::INTERVAL:return false;
 	  case arrow::Type::LIST: {
 		auto t_value = std::static_pointer_cast<arrow::ListType>(t->type());
 		switch (t_value->value_type()->id()) {
@@ -64,9 +66,10 @@ bool validateArrowTableTypes(const std::shared_ptr<arrow::Table> &table) {
 		  case arrow::Type::INT64:
 		  case arrow::Type::HALF_FLOAT:
 		  case arrow::Type::FLOAT:
-		  case arrow::Type::DOUBLE:return true;
+		  case arrow::Type::DOUBLE:break;
 		  default:return false;
 		}
+		break;
 	  }
 	  case arrow::Type::STRUCT:
 	  case arrow::Type::UNION:
@@ -75,11 +78,10 @@ bool validateArrowTableTypes(const std::shared_ptr<arrow::Table> &table) {
 	  case arrow::Type::EXTENSION:
 	  case arrow::Type::FIXED_SIZE_LIST:
 	  case arrow::Type::DURATION:
-	  case arrow::Type::LARGE_STRING:
-	  case arrow::Type::LARGE_BINARY:
 	  case arrow::Type::LARGE_LIST:return false;
 	}
   }
+  return true;
 }
 
 }
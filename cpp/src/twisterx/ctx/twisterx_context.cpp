@@ -14,7 +14,12 @@
 
 #include "twisterx_context.h"
 #include "arrow/memory_pool.h"
+#include <glog/logging.h>
 #include "../net/mpi/mpi_communicator.h"
+#include "../net/tcp/tcp_communicator.h"
+#include "../net/local/local_communicator.h"
+#include "../net/channel_pool.hpp"
+#include "../net/comm_metrics.hpp"
 
 namespace twisterx {
 
@@ -32,11 +37,38 @@ TwisterXContext *TwisterXContext::InitDistributed(net::CommConfig *config) {
     ctx->communicator->Init(config);
     ctx->distributed = true;
     return ctx;
+  } else if (config->Type() == net::CommType::TCP) {
+    auto ctx = new TwisterXContext(true);
+    ctx->communicator = new net::TCPCommunicator();
+    ctx->communicator->Init(config);
+    ctx->distributed = true;
+    return ctx;
+  } else if (config->Type() == net::CommType::LOCAL) {
+    auto ctx = new TwisterXContext(true);
+    ctx->communicator = new net::LocalCommunicator();
+    ctx->communicator->Init(config);
+    ctx->distributed = true;
+    return ctx;
   } else {
     throw "Unsupported communication type";
   }
   return nullptr;
 }
+TwisterXContext *TwisterXContext::Split(int color, int key) {
+  if (!this->distributed) {
+    LOG(FATAL) << "Only a distributed context can be split";
+  }
+  net::Communicator *sub = this->communicator->Split(color, key);
+  if (sub == nullptr) {
+    return nullptr;
+  }
+  auto ctx = new TwisterXContext(true);
+  ctx->communicator = sub;
+  ctx->config = this->config;
+  ctx->memory_pool = this->memory_pool;
+  return ctx;
+}
+
 net::Communicator *TwisterXContext::GetCommunicator() const {
   return this->communicator;
 }
@@ -72,6 +104,11 @@ int TwisterXContext::GetWorldSize() {
   return 1;
 }
 void TwisterXContext::Finalize() {
+  // the pooled channels have to be closed before the communicator
+  delete this->channel_pool;
+  this->channel_pool = nullptr;
+  delete this->metrics;
+  this->metrics = nullptr;
   if (this->distributed) {
     this->communicator->Finalize();
     delete this->communicator;
@@ -97,6 +134,28 @@ void TwisterXContext::SetMemoryPool(twisterx::MemoryPool *mem_pool) {
   this->memory_pool = mem_pool;
 }
 int32_t TwisterXContext::GetNextSequence() {
-  return this->sequence_no++;
+  // the sequence stays below the reusable edges
+  return this->sequence_no++ % TWISTERX_REUSABLE_EDGE_FLAG;
+}
+
+int32_t TwisterXContext::GetReusableEdge(int32_t slot) {
+  if (!GetChannelPool()->IsEnabled()) {
+    return GetNextSequence();
+  }
+  return TWISTERX_REUSABLE_EDGE_FLAG | slot;
+}
+
+twisterx::ChannelPool *TwisterXContext::GetChannelPool() {
+  if (this->channel_pool == nullptr) {
+    this->channel_pool = new ChannelPool(this->communicator, GetConfig(TWISTERX_CHANNEL_POOL, "true") != "false");
+  }
+  return this->channel_pool;
+}
+
+twisterx::CommMetrics *TwisterXContext::GetMetrics() {
+  if (this->metrics == nullptr) {
+    this->metrics = new CommMetrics(GetRank(), GetConfig(TWISTERX_METRICS, "false") == "true");
+  }
+  return this->metrics;
 }
 }
\ No newline at end of file
@@ -22,6 +22,9 @@
 #include "memory_pool.h"
 
 namespace twisterx {
+class ChannelPool;
+class CommMetrics;
+
 class TwisterXContext {
  private:
   std::unordered_map<std::string, std::string> config{};
@@ -29,12 +32,26 @@ class TwisterXContext {
   twisterx::net::Communicator *communicator{};
   twisterx::MemoryPool *memory_pool{};
   int32_t sequence_no = 0;
+  twisterx::ChannelPool *channel_pool{};
+  twisterx::CommMetrics *metrics{};
 
  public:
   static TwisterXContext *Init();
   void Finalize();
 
   static TwisterXContext *InitDistributed(net::CommConfig *config);
+
+  /**
+   * Split the ranks of this context into groups, see net::Communicator::Split. The operations given the new
+   * context run only on the ranks of its group, with the ranks numbered within the group, and don't interfere with
+   * the operations of the other groups. The new context shares the configs and the memory pool of this context.
+   * This is a collective call. Finalize the new context before this one.
+   *
+   * @param color the group of this rank, TWISTERX_SPLIT_UNDEFINED to not take part in any
+   * @param key orders the ranks within the group
+   * @return the context of the group, nullptr if the color is TWISTERX_SPLIT_UNDEFINED
+   */
+  TwisterXContext *Split(int color, int key = 0);
   void AddConfig(const std::string &key, const std::string &value);
   std::string GetConfig(const std::string &key, const std::string &def = "");
   net::Communicator *GetCommunicator() const;
@@ -47,6 +64,25 @@ class TwisterXContext {
   twisterx::MemoryPool *GetMemoryPool();
   void SetMemoryPool(twisterx::MemoryPool *mem_pool);
   int32_t GetNextSequence();
+
+  /**
+   * Get the edge of an operation that runs repeatedly, one run at a time. With the channel pool enabled this is the
+   * same edge for every run, so the runs reuse the channels, otherwise it is a new edge from the sequence.
+   *
+   * @param slot identifies the operation, less than TWISTERX_REUSABLE_EDGE_FLAG
+   */
+  int32_t GetReusableEdge(int32_t slot);
+
+  /**
+   * The pool of the channels of this context, created on the first call
+   */
+  twisterx::ChannelPool *GetChannelPool();
+
+  /**
+   * The communication metrics of the operations of this context, created on the first call. The metrics are
+   * recorded only when the config TWISTERX_METRICS is set to true.
+   */
+  twisterx::CommMetrics *GetMetrics();
   void Barrier() {
     this->GetCommunicator()->Barrier();
   }
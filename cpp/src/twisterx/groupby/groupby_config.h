@@ -0,0 +1,124 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_GROUPBY_GROUPBY_CONFIG_H_
+#define TWISTERX_SRC_TWISTERX_GROUPBY_GROUPBY_CONFIG_H_
+
+#include <string>
+
+// a distributed group by shuffles the rows instead of partial aggregates if the groups of the rows sampled on the
+// ranks are more than this fraction of the rows
+#define TWISTERX_GROUPBY_PARTIAL_RATIO "twisterx.groupby.partial.ratio"
+// the number of rows of each rank grouped before choosing to aggregate them before the shuffle
+#define TWISTERX_GROUPBY_PARTIAL_SAMPLE "twisterx.groupby.partial.sample"
+
+namespace twisterx {
+namespace groupby {
+namespace config {
+
+/**
+ * The aggregate of the values of a group, the null values and the NaN floating point values are skipped
+ */
+enum AggregationOp {
+  // the number of non null, non NaN values
+  COUNT,
+  // the sum, as int64 for signed integers, uint64 for unsigned integers and double for floating point
+  SUM,
+  MIN,
+  MAX,
+  // the mean as a double
+  MEAN,
+  // the sample variance as a double
+  VAR
+};
+
+/**
+ * The name of the aggregate, used in the names of the result columns
+ */
+inline std::string AggregationOpName(AggregationOp op) {
+  switch (op) {
+    case COUNT:return "count";
+    case SUM:return "sum";
+    case MIN:return "min";
+    case MAX:return "max";
+    case MEAN:return "mean";
+    case VAR:return "var";
+  }
+  return "";
+}
+
+/**
+ * Parse the name of an aggregate
+ * @return false if the name is not an aggregate
+ */
+inline bool ParseAggregationOp(const std::string &name, AggregationOp *op) {
+  for (AggregationOp candidate : {COUNT, SUM, MIN, MAX, MEAN, VAR}) {
+    if (name == AggregationOpName(candidate)) {
+      *op = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * An aggregate of a column of a group by
+ */
+class Aggregation {
+ private:
+  int column_idx;
+  AggregationOp op;
+
+ public:
+  Aggregation() = delete;
+
+  Aggregation(int column_idx, AggregationOp op) : column_idx(column_idx), op(op) {}
+
+  static Aggregation Count(int column_idx) {
+    return {column_idx, COUNT};
+  }
+
+  static Aggregation Sum(int column_idx) {
+    return {column_idx, SUM};
+  }
+
+  static Aggregation Min(int column_idx) {
+    return {column_idx, MIN};
+  }
+
+  static Aggregation Max(int column_idx) {
+    return {column_idx, MAX};
+  }
+
+  static Aggregation Mean(int column_idx) {
+    return {column_idx, MEAN};
+  }
+
+  static Aggregation Var(int column_idx) {
+    return {column_idx, VAR};
+  }
+
+  int GetColumnIdx() const {
+    return column_idx;
+  }
+
+  AggregationOp GetOp() const {
+    return op;
+  }
+};
+}
+}
+}
+
+#endif //TWISTERX_SRC_TWISTERX_GROUPBY_GROUPBY_CONFIG_H_
@@ -23,20 +23,25 @@
 namespace twisterx {
 namespace join {
 
+/**
+ * Collect the indices of the next run of equal keys. CPP_KEY_TYPE is the value type of the array, or a string view
+ * for string and binary arrays.
+ */
 template<typename ARROW_KEY_TYPE, typename CPP_KEY_TYPE>
-void advance(std::vector<CPP_KEY_TYPE> *subset,
+void advance(std::vector<int64_t> *subset,
              const std::shared_ptr<arrow::Int64Array> &sorted_indices, // this is always Int64Array
              int64_t *current_index, //always int64_t
              std::shared_ptr<arrow::Array> data_column,
              CPP_KEY_TYPE *key) {
+  using ARRAY_TYPE = typename arrow::TypeTraits<ARROW_KEY_TYPE>::ArrayType;
   subset->clear();
   if (*current_index == sorted_indices->length()) {
     return;
   }
-  auto data_column_casted = std::static_pointer_cast<arrow::NumericArray<ARROW_KEY_TYPE>>(data_column);
+  auto data_column_casted = std::static_pointer_cast<ARRAY_TYPE>(data_column);
   int64_t data_index = sorted_indices->Value(*current_index);
-  *key = data_column_casted->Value(data_index);
-  while (*current_index < sorted_indices->length() && data_column_casted->Value(data_index) == *key) {
+  *key = data_column_casted->GetView(data_index);
+  while (*current_index < sorted_indices->length() && data_column_casted->GetView(data_index) == *key) {
     subset->push_back(data_index);
     (*current_index)++;
     if (*current_index == sorted_indices->length()) {
@@ -53,14 +58,15 @@ arrow::Status do_sorted_join(const std::shared_ptr<arrow::Table> &left_tab,
                              int64_t right_join_column_idx,
                              twisterx::join::config::JoinType join_type,
                              std::shared_ptr<arrow::Table> *joined_table,
-                             arrow::MemoryPool *memory_pool) {
-  // combine chunks if multiple chunks are available
-  std::shared_ptr<arrow::Table> left_tab_comb, right_tab_comb;
+                             arrow::MemoryPool *memory_pool,
+                             int sort_threads) {
+  // combine the chunks of the join columns, the other columns are copied chunk by chunk
+  std::shared_ptr<arrow::Array> left_join_column, right_join_column;
   arrow::Status lstatus, rstatus;
   auto t11 = std::chrono::high_resolution_clock::now();
 
-  lstatus = twisterx::join::util::CombineChunks(left_tab, left_join_column_idx, left_tab_comb, memory_pool);
-  rstatus = twisterx::join::util::CombineChunks(right_tab, right_join_column_idx, right_tab_comb, memory_pool);
+  lstatus = twisterx::join::util::CombineColumn(left_tab, left_join_column_idx, &left_join_column, memory_pool);
+  rstatus = twisterx::join::util::CombineColumn(right_tab, right_join_column_idx, &right_join_column, memory_pool);
 
   auto t22 = std::chrono::high_resolution_clock::now();
 
@@ -72,12 +78,10 @@ arrow::Status do_sorted_join(const std::shared_ptr<arrow::Table> &left_tab,
   LOG(INFO) << "Combine chunks time : " << std::chrono::duration_cast<std::chrono::milliseconds>(t22 - t11).count();
 
   //sort columns
-  auto left_join_column = left_tab_comb->column(left_join_column_idx)->chunk(0);
-  auto right_join_column = right_tab_comb->column(right_join_column_idx)->chunk(0);
 
   auto t1 = std::chrono::high_resolution_clock::now();
   std::shared_ptr<arrow::Array> left_index_sorted_column;
-  auto status = SortIndices(memory_pool, left_join_column, &left_index_sorted_column);
+  auto status = SortIndices(memory_pool, left_join_column, &left_index_sorted_column, sort_threads);
   if (status != arrow::Status::OK()) {
     LOG(FATAL) << "Failed when sorting left table to indices. " << status.ToString();
     return status;
@@ -87,7 +91,7 @@ arrow::Status do_sorted_join(const std::shared_ptr<arrow::Table> &left_tab,
 
   t1 = std::chrono::high_resolution_clock::now();
   std::shared_ptr<arrow::Array> right_index_sorted_column;
-  status = SortIndices(memory_pool, right_join_column, &right_index_sorted_column);
+  status = SortIndices(memory_pool, right_join_column, &right_index_sorted_column, sort_threads);
   if (status != arrow::Status::OK()) {
     LOG(FATAL) << "Failed when sorting right table to indices. " << status.ToString();
     return status;
@@ -96,7 +100,7 @@ arrow::Status do_sorted_join(const std::shared_ptr<arrow::Table> &left_tab,
   LOG(INFO) << "right sorting time : " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
 
   CPP_KEY_TYPE left_key, right_key;
-  std::vector<CPP_KEY_TYPE> left_subset, right_subset;
+  std::vector<int64_t> left_subset, right_subset;
   int64_t left_current_index = 0;
   int64_t right_current_index = 0;
 
@@ -214,8 +218,8 @@ arrow::Status do_sorted_join(const std::shared_ptr<arrow::Table> &left_tab,
   // build final table
   status = twisterx::join::util::build_final_table(
       left_indices, right_indices,
-      left_tab_comb,
-      right_tab_comb,
+      left_tab,
+      right_tab,
       joined_table,
       memory_pool
   );
@@ -246,13 +250,13 @@ arrow::Status do_hash_join(const std::shared_ptr<arrow::Table> &left_tab,
 						   std::shared_ptr<arrow::Table> *joined_table,
 						   arrow::MemoryPool *memory_pool) {
 
-  // combine chunks if multiple chunks are available
-  std::shared_ptr<arrow::Table> left_tab_comb, right_tab_comb;
+  // combine the chunks of the join columns, the other columns are copied chunk by chunk
+  std::shared_ptr<arrow::Array> left_idx_column, right_idx_column;
   arrow::Status lstatus, rstatus;
   auto t11 = std::chrono::high_resolution_clock::now();
 
-  lstatus = twisterx::join::util::CombineChunks(left_tab, left_join_column_idx, left_tab_comb, memory_pool);
-  rstatus = twisterx::join::util::CombineChunks(right_tab, right_join_column_idx, right_tab_comb, memory_pool);
+  lstatus = twisterx::join::util::CombineColumn(left_tab, left_join_column_idx, &left_idx_column, memory_pool);
+  rstatus = twisterx::join::util::CombineColumn(right_tab, right_join_column_idx, &right_idx_column, memory_pool);
 
   auto t22 = std::chrono::high_resolution_clock::now();
 
@@ -263,10 +267,6 @@ arrow::Status do_hash_join(const std::shared_ptr<arrow::Table> &left_tab,
 
   LOG(INFO) << "Combine chunks time : " << std::chrono::duration_cast<std::chrono::milliseconds>(t22 - t11).count();
 
-  //sort columns
-  std::shared_ptr<arrow::Array> left_idx_column = left_tab_comb->column(left_join_column_idx)->chunk(0);
-  std::shared_ptr<arrow::Array> right_idx_column = right_tab_comb->column(right_join_column_idx)->chunk(0);
-
   std::shared_ptr<std::vector<int64_t>> left_indices = std::make_shared<std::vector<int64_t>>();
   std::shared_ptr<std::vector<int64_t>> right_indices = std::make_shared<std::vector<int64_t>>();
 
@@ -294,8 +294,8 @@ arrow::Status do_hash_join(const std::shared_ptr<arrow::Table> &left_tab,
 
   auto status = twisterx::join::util::build_final_table(
 	  left_indices, right_indices,
-      left_tab_comb,
-	  right_tab_comb,
+      left_tab,
+	  right_tab,
 	  joined_table,
 	  memory_pool
   );
@@ -319,7 +319,8 @@ arrow::Status do_join(const std::shared_ptr<arrow::Table> &left_tab,
 					  twisterx::join::config::JoinType join_type,
 					  twisterx::join::config::JoinAlgorithm join_algorithm,
 					  std::shared_ptr<arrow::Table> *joined_table,
-					  arrow::MemoryPool *memory_pool) {
+					  arrow::MemoryPool *memory_pool,
+					  int sort_threads) {
   using ARROW_KEY_TYPE = typename ARROW_ARRAY_TYPE::TypeClass;
   using CPP_KEY_TYPE = typename ARROW_KEY_TYPE::c_type;
 
@@ -330,7 +331,7 @@ arrow::Status do_join(const std::shared_ptr<arrow::Table> &left_tab,
 														  left_join_column_idx,
 														  right_join_column_idx,
 														  join_type,
-														  joined_table, memory_pool);
+														  joined_table, memory_pool, sort_threads);
 	case twisterx::join::config::HASH:
 	  return do_hash_join<ARROW_ARRAY_TYPE>(left_tab,
 											right_tab,
@@ -342,6 +343,30 @@ arrow::Status do_join(const std::shared_ptr<arrow::Table> &left_tab,
   return arrow::Status::OK();
 }
 
+/**
+ * Join on string or binary keys, only the sort join is supported
+ */
+template<typename ARROW_KEY_TYPE>
+arrow::Status do_binary_join(const std::shared_ptr<arrow::Table> &left_tab,
+							 const std::shared_ptr<arrow::Table> &right_tab,
+							 int64_t left_join_column_idx,
+							 int64_t right_join_column_idx,
+							 twisterx::join::config::JoinType join_type,
+							 twisterx::join::config::JoinAlgorithm join_algorithm,
+							 std::shared_ptr<arrow::Table> *joined_table,
+							 arrow::MemoryPool *memory_pool,
+							 int sort_threads) {
+  if (join_algorithm != twisterx::join::config::SORT) {
+	return arrow::Status::NotImplemented("Only the sort join is supported on string and binary keys");
+  }
+  return do_sorted_join<ARROW_KEY_TYPE, arrow::util::string_view>(left_tab,
+																  right_tab,
+																  left_join_column_idx,
+																  right_join_column_idx,
+																  join_type,
+																  joined_table, memory_pool, sort_threads);
+}
+
 arrow::Status joinTables(const std::vector<std::shared_ptr<arrow::Table>> &left_tabs,
 						 const std::vector<std::shared_ptr<arrow::Table>> &right_tabs,
 						 twisterx::join::config::JoinConfig join_config,
@@ -353,42 +378,9 @@ arrow::Status joinTables(const std::vector<std::shared_ptr<arrow::Table>> &left_
   std::shared_ptr<arrow::Table> right_tab = arrow::ConcatenateTables(right_tabs,
 																	 arrow::ConcatenateTablesOptions::Defaults(),
 																	 memory_pool).ValueOrDie();
-  std::shared_ptr<arrow::Table> left_tab_combined;
-  std::shared_ptr<arrow::Table> right_tab_combined;
-
-  arrow::Status left_combine_stat = left_tab->CombineChunks(memory_pool, &left_tab_combined);
-  if (left_combine_stat != arrow::Status::OK()) {
-	LOG(FATAL) << "Error in combining table chunks of left table." << left_combine_stat.ToString();
-	return left_combine_stat;
-  }
-  if (left_tabs.size() > 1) {
-	for (const auto &t : left_tabs) {
-	  arrow::Status status = twisterx::util::free_table(t);
-	  if (status != arrow::Status::OK()) {
-		LOG(FATAL) << "Failed to free table" << status.ToString();
-		return status;
-	  }
-	}
-  }
-
-  arrow::Status right_combine_stat = right_tab->CombineChunks(memory_pool, &right_tab_combined);
-  if (right_combine_stat != arrow::Status::OK()) {
-	LOG(FATAL) << "Error in combining table chunks of right table." << left_combine_stat.ToString();
-	return right_combine_stat;
-  }
-
-  if (right_tabs.size() > 1) {
-	for (auto t : right_tabs) {
-	  arrow::Status status = twisterx::util::free_table(t);
-	  if (status != arrow::Status::OK()) {
-		LOG(FATAL) << "Failed to free table" << status.ToString();
-		return status;
-	  }
-	}
-  }
-
-  return twisterx::join::joinTables(left_tab_combined,
-									right_tab_combined,
+  // the concatenated tables share the buffers of the tables, the join combines only the chunks of the join columns
+  return twisterx::join::joinTables(left_tab,
+									right_tab,
 									join_config,
 									joined_table,
 									memory_pool);
@@ -419,7 +411,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 															join_config.GetType(),
 															join_config.GetAlgorithm(),
 															joined_table,
-															memory_pool);
+															memory_pool,
+															join_config.GetSortThreads());
 	case arrow::Type::INT8:
 	  return do_join<arrow::NumericArray<arrow::Int8Type>>(left_tab,
 														   right_tab,
@@ -428,7 +421,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 														   join_config.GetType(),
 														   join_config.GetAlgorithm(),
 														   joined_table,
-														   memory_pool);
+														   memory_pool,
+														   join_config.GetSortThreads());
 	case arrow::Type::UINT16:
 	  return do_join<arrow::NumericArray<arrow::UInt16Type>>(left_tab,
 															 right_tab,
@@ -437,7 +431,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 															 join_config.GetType(),
 															 join_config.GetAlgorithm(),
 															 joined_table,
-															 memory_pool);
+															 memory_pool,
+															 join_config.GetSortThreads());
 	case arrow::Type::INT16:
 	  return do_join<arrow::NumericArray<arrow::Int16Type>>(left_tab,
 															right_tab,
@@ -446,7 +441,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 															join_config.GetType(),
 															join_config.GetAlgorithm(),
 															joined_table,
-															memory_pool);
+															memory_pool,
+															join_config.GetSortThreads());
 	case arrow::Type::UINT32:
 	  return do_join<arrow::NumericArray<arrow::UInt32Type>>(left_tab,
 															 right_tab,
@@ -455,7 +451,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 															 join_config.GetType(),
 															 join_config.GetAlgorithm(),
 															 joined_table,
-															 memory_pool);
+															 memory_pool,
+															 join_config.GetSortThreads());
 	case arrow::Type::INT32:
 	  return do_join<arrow::NumericArray<arrow::Int32Type>>(left_tab,
 															right_tab,
@@ -464,7 +461,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 															join_config.GetType(),
 															join_config.GetAlgorithm(),
 															joined_table,
-															memory_pool);
+															memory_pool,
+															join_config.GetSortThreads());
 	case arrow::Type::UINT64:
 	  return do_join<arrow::NumericArray<arrow::UInt64Type>>(left_tab,
 															 right_tab,
@@ -473,7 +471,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 															 join_config.GetType(),
 															 join_config.GetAlgorithm(),
 															 joined_table,
-															 memory_pool);
+															 memory_pool,
+															 join_config.GetSortThreads());
 	case arrow::Type::INT64:
 	  return do_join<arrow::NumericArray<arrow::Int64Type>>(left_tab,
 															right_tab,
@@ -482,7 +481,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 															join_config.GetType(),
 															join_config.GetAlgorithm(),
 															joined_table,
-															memory_pool);;
+															memory_pool,
+															join_config.GetSortThreads());;
 	case arrow::Type::HALF_FLOAT:
 	  return do_join<arrow::NumericArray<arrow::HalfFloatType>>(left_tab,
 																right_tab,
@@ -491,7 +491,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 																join_config.GetType(),
 																join_config.GetAlgorithm(),
 																joined_table,
-																memory_pool);
+																memory_pool,
+																join_config.GetSortThreads());
 	case arrow::Type::FLOAT:
 	  return do_join<arrow::NumericArray<arrow::FloatType>>(left_tab,
 															right_tab,
@@ -500,7 +501,8 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 															join_config.GetType(),
 															join_config.GetAlgorithm(),
 															joined_table,
-															memory_pool);
+															memory_pool,
+															join_config.GetSortThreads());
 	case arrow::Type::DOUBLE:
 	  return do_join<arrow::NumericArray<arrow::DoubleType>>(left_tab,
 															 right_tab,
@@ -509,10 +511,38 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 															 join_config.GetType(),
 															 join_config.GetAlgorithm(),
 															 joined_table,
-															 memory_pool);
-	case arrow::Type::STRING:break;
-	case arrow::Type::BINARY:break;
-	case arrow::Type::FIXED_SIZE_BINARY:break;
+															 memory_pool,
+															 join_config.GetSortThreads());
+	case arrow::Type::STRING:
+	  return do_binary_join<arrow::StringType>(left_tab,
+											   right_tab,
+											   join_config.GetLeftColumnIdx(),
+											   join_config.GetRightColumnIdx(),
+											   join_config.GetType(),
+											   join_config.GetAlgorithm(),
+											   joined_table,
+											   memory_pool,
+											   join_config.GetSortThreads());
+	case arrow::Type::BINARY:
+	  return do_binary_join<arrow::BinaryType>(left_tab,
+											   right_tab,
+											   join_config.GetLeftColumnIdx(),
+											   join_config.GetRightColumnIdx(),
+											   join_config.GetType(),
+											   join_config.GetAlgorithm(),
+											   joined_table,
+											   memory_pool,
+											   join_config.GetSortThreads());
+	case arrow::Type::FIXED_SIZE_BINARY:
+	  return do_binary_join<arrow::FixedSizeBinaryType>(left_tab,
+														right_tab,
+														join_config.GetLeftColumnIdx(),
+														join_config.GetRightColumnIdx(),
+														join_config.GetType(),
+														join_config.GetAlgorithm(),
+														joined_table,
+														memory_pool,
+														join_config.GetSortThreads());
 	case arrow::Type::DATE32:break;
 	case arrow::Type::DATE64:break;
 	case arrow::Type::TIMESTAMP:break;
@@ -528,8 +558,26 @@ arrow::Status joinTables(const std::shared_ptr<arrow::Table> &left_tab,
 	case arrow::Type::EXTENSION:break;
 	case arrow::Type::FIXED_SIZE_LIST:break;
 	case arrow::Type::DURATION:break;
-	case arrow::Type::LARGE_STRING:break;
-	case arrow::Type::LARGE_BINARY:break;
+	case arrow::Type::LARGE_STRING:
+	  return do_binary_join<arrow::LargeStringType>(left_tab,
+													right_tab,
+													join_config.GetLeftColumnIdx(),
+													join_config.GetRightColumnIdx(),
+													join_config.GetType(),
+													join_config.GetAlgorithm(),
+													joined_table,
+													memory_pool,
+													join_config.GetSortThreads());
+	case arrow::Type::LARGE_BINARY:
+	  return do_binary_join<arrow::LargeBinaryType>(left_tab,
+													right_tab,
+													join_config.GetLeftColumnIdx(),
+													join_config.GetRightColumnIdx(),
+													join_config.GetType(),
+													join_config.GetAlgorithm(),
+													joined_table,
+													memory_pool,
+													join_config.GetSortThreads());
 	case arrow::Type::LARGE_LIST:break;
   }
   return arrow::Status::OK();
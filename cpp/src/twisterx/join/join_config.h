@@ -31,6 +31,7 @@ class JoinConfig {
   JoinType type;
   JoinAlgorithm algorithm;
   int left_column_idx, right_column_idx;
+  int sort_threads = 1;
 
  public:
   JoinConfig() = delete;
@@ -86,6 +87,16 @@ class JoinConfig {
   int GetRightColumnIdx() const {
 	return right_column_idx;
   }
+
+  /**
+   * The threads used to sort the join columns of a sort join
+   */
+  int GetSortThreads() const {
+	return sort_threads;
+  }
+  void SetSortThreads(int threads) {
+	sort_threads = threads;
+  }
 };
 }
 }
@@ -52,10 +52,10 @@ arrow::Status build_final_table(const std::shared_ptr<std::vector<int64_t>> &lef
   for (auto &column :left_tab->columns()) {
 	std::shared_ptr<arrow::Array> destination_col_array;
 	arrow::Status
-		status = twisterx::util::copy_array_by_indices(left_indices,
-													   column->chunk(0),
-													   &destination_col_array,
-													   memory_pool);
+		status = twisterx::util::copy_chunked_array_by_indices(left_indices,
+															   column,
+															   &destination_col_array,
+															   memory_pool);
 	if (status != arrow::Status::OK()) {
 	  LOG(FATAL) << "Failed while copying a column to the final table from left table. " << status.ToString();
 	  return status;
@@ -67,10 +67,10 @@ arrow::Status build_final_table(const std::shared_ptr<std::vector<int64_t>> &lef
   for (auto &column :right_tab->columns()) {
 	std::shared_ptr<arrow::Array> destination_col_array;
 	arrow::Status
-		status = twisterx::util::copy_array_by_indices(right_indices,
-													   column->chunk(0),
-													   &destination_col_array,
-													   memory_pool);
+		status = twisterx::util::copy_chunked_array_by_indices(right_indices,
+															   column,
+															   &destination_col_array,
+															   memory_pool);
     if (status != arrow::Status::OK()) {
       LOG(FATAL) << "Failed while copying a column to the final table from right table. " << status.ToString();
       return status;
@@ -81,17 +81,11 @@ arrow::Status build_final_table(const std::shared_ptr<std::vector<int64_t>> &lef
   return arrow::Status::OK();
 }
 
-arrow::Status CombineChunks(const std::shared_ptr<arrow::Table> &table,
+arrow::Status CombineColumn(const std::shared_ptr<arrow::Table> &table,
                             int64_t col_index,
-                            std::shared_ptr<arrow::Table> &output_table,
+                            std::shared_ptr<arrow::Array> *output_array,
                             arrow::MemoryPool *memory_pool) {
-  if (table->column(col_index)->num_chunks() > 1) {
-    LOG(INFO) << "Combining chunks " << table->column(col_index)->num_chunks();
-    return table->CombineChunks(memory_pool, &output_table);
-  } else {
-    output_table = table;
-    return arrow::Status::OK();
-  }
+  return twisterx::util::CombineChunks(table->column(col_index), output_array, memory_pool);
 }
 
 }
@@ -29,9 +29,13 @@ arrow::Status build_final_table(const std::shared_ptr<std::vector<int64_t>> &lef
                                 std::shared_ptr<arrow::Table> *final_table,
                                 arrow::MemoryPool *memory_pool);
 
-arrow::Status CombineChunks(const std::shared_ptr<arrow::Table> &table,
+/**
+ * The join column as a single array, only this column is concatenated if it has more than one chunk. The other
+ * columns are copied to the joined table chunk by chunk.
+ */
+arrow::Status CombineColumn(const std::shared_ptr<arrow::Table> &table,
                             int64_t col_index,
-                            std::shared_ptr<arrow::Table> &output_table,
+                            std::shared_ptr<arrow::Array> *output_array,
                             arrow::MemoryPool *memory_pool);
 }
 }
@@ -16,6 +16,7 @@
 #define TWISTERX_TXREQUEST_H
 
 #include "iostream"
+#include <memory>
 using namespace std;
 
 namespace twisterx {
@@ -25,8 +26,10 @@ class TxRequest {
   void *buffer{};
   int length{};
   int target;
-  int header[6] = {};
+  int header[8] = {};
   int headerLength{};
+  // keeps the memory of the buffer alive, when set a channel may hand the buffer to the receiver without a copy
+  std::shared_ptr<void> owner{};
 
   TxRequest(int tgt, void *buf, int len);
 
@@ -22,6 +22,8 @@
 
 namespace twisterx {
 
+struct EdgeMetrics;
+
 /**
  * When a send is complete, this callback is called by the channel, it is the responsibility
  * of the operations to register this callback
@@ -41,6 +43,18 @@ class ChannelReceiveCallback {
   virtual void receivedData(int receiveId, void *buffer, int length) = 0;
 
   virtual void receivedHeader(int receiveId, int finished, int *header, int headerLength) = 0;
+
+  /**
+   * A buffer is received without a copy, the memory belongs to the sender and is kept alive by the owner.
+   * By default we copy the buffer and call receivedData
+   */
+  virtual void receivedSharedData(int receiveId, void *buffer, int length, const std::shared_ptr<void> &owner) {
+    char *data = new char[length];
+    if (length > 0) {
+      memcpy(data, buffer, length);
+    }
+    receivedData(receiveId, data, length);
+  }
 };
 
 /**
@@ -85,6 +99,24 @@ class Channel {
    */
   virtual void close() = 0;
 
+  /**
+   * Get the channel ready for another operation with the same edge and peers, after the finish of the previous
+   * operation is exchanged with every peer. Messages of the next operation arriving before this call are kept
+   * and given to the new callbacks.
+   *
+   * @return false if the channel can't be reused, it has to be closed then
+   */
+  virtual bool reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send) {
+    return false;
+  }
+
+  /**
+   * Set the metrics of the operation using the channel, nullptr to stop recording. Channels without
+   * instrumentation ignore this.
+   */
+  virtual void setMetrics(const std::shared_ptr<EdgeMetrics> &metrics) {
+  }
+
   virtual ~Channel() = default;
 };
 }
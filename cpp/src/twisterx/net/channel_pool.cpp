@@ -0,0 +1,70 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "channel_pool.hpp"
+
+namespace twisterx {
+
+ChannelPool::ChannelPool(net::Communicator *communicator, bool enabled)
+    : communicator(communicator), enabled(enabled) {}
+
+Channel *ChannelPool::Acquire(int edge, const std::vector<int> &receives, const std::vector<int> &sends,
+                              ChannelReceiveCallback *rcv, ChannelSendCallback *send) {
+  auto it = idle.find(edge);
+  if (it != idle.end()) {
+    PooledChannel pooled = it->second;
+    idle.erase(it);
+    if (pooled.receives == receives && pooled.sends == sends && pooled.channel->reuse(rcv, send)) {
+      active[pooled.channel] = pooled;
+      return pooled.channel;
+    }
+    pooled.channel->close();
+    delete pooled.channel;
+  }
+
+  Channel *channel = communicator->CreateChannel();
+  channel->init(edge, receives, sends, rcv, send);
+  active[channel] = PooledChannel{channel, receives, sends};
+  return channel;
+}
+
+void ChannelPool::Release(int edge, Channel *channel) {
+  auto it = active.find(channel);
+  PooledChannel pooled = it->second;
+  active.erase(it);
+  // we keep one channel for an edge
+  if (enabled && (edge & TWISTERX_REUSABLE_EDGE_FLAG) != 0 && idle.find(edge) == idle.end()) {
+    idle[edge] = pooled;
+    return;
+  }
+  channel->close();
+  delete channel;
+}
+
+bool ChannelPool::IsEnabled() const {
+  return enabled;
+}
+
+void ChannelPool::Clear() {
+  for (auto &p : idle) {
+    p.second.channel->close();
+    delete p.second.channel;
+  }
+  idle.clear();
+}
+
+ChannelPool::~ChannelPool() {
+  Clear();
+}
+}
@@ -0,0 +1,83 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_NET_CHANNEL_POOL_HPP_
+#define TWISTERX_SRC_TWISTERX_NET_CHANNEL_POOL_HPP_
+
+#include <unordered_map>
+#include <vector>
+#include "channel.hpp"
+#include "communicator.h"
+
+// edges with this bit are reused by the operations, the channels of these edges are kept in the pool
+#define TWISTERX_REUSABLE_EDGE_FLAG (1 << 17)
+// set to false in the context to close the channels after every operation
+#define TWISTERX_CHANNEL_POOL "twisterx.channel_pool"
+
+namespace twisterx {
+
+/**
+ * Keeps the channels of the reusable edges after the operations using them are done, so the next operation on
+ * the same edge gets the channel with its buffers and its requests already set up instead of creating one.
+ *
+ * An operation on a reusable edge has to finish before the next operation on the same edge starts at this rank,
+ * the other ranks may already be running the next one. The channels of the other edges are created and closed
+ * as before.
+ */
+class ChannelPool {
+ public:
+  /**
+   * Create the pool
+   * @param communicator creates the channels
+   * @param enabled keep the channels, otherwise every channel is closed when released
+   */
+  ChannelPool(net::Communicator *communicator, bool enabled);
+
+  /**
+   * Get a channel initialized for the edge and the peers, reusing the channel of the edge if there is one
+   */
+  Channel *Acquire(int edge, const std::vector<int> &receives, const std::vector<int> &sends,
+                   ChannelReceiveCallback *rcv, ChannelSendCallback *send);
+
+  /**
+   * Give back a channel after the operation using it is complete
+   */
+  void Release(int edge, Channel *channel);
+
+  bool IsEnabled() const;
+
+  /**
+   * Close all the channels in the pool
+   */
+  void Clear();
+
+  virtual ~ChannelPool();
+
+ private:
+  struct PooledChannel {
+    Channel *channel;
+    std::vector<int> receives;
+    std::vector<int> sends;
+  };
+
+  net::Communicator *communicator;
+  bool enabled;
+  // the channels given out, with their peers
+  std::unordered_map<Channel *, PooledChannel> active;
+  // channels waiting for the next operation of their edge
+  std::unordered_map<int, PooledChannel> idle;
+};
+}
+
+#endif //TWISTERX_SRC_TWISTERX_NET_CHANNEL_POOL_HPP_
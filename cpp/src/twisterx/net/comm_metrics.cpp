@@ -0,0 +1,204 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "comm_metrics.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace twisterx {
+
+EdgeMetrics::EdgeMetrics(int rank, int edge, std::string operation)
+    : rank(rank), edge(edge), operation(std::move(operation)), start_us(Now()) {}
+
+int64_t EdgeMetrics::Now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void EdgeMetrics::BeginPhase(const std::string &name) {
+  phases.push_back(PhaseMetrics{name, Now(), 0});
+}
+
+void EdgeMetrics::EndPhase(const std::string &name) {
+  for (auto it = phases.rbegin(); it != phases.rend(); ++it) {
+    if (it->name == name && it->end_us == 0) {
+      it->end_us = Now();
+      return;
+    }
+  }
+}
+
+void EdgeMetrics::AddPhase(const std::string &name, int64_t start, int64_t end) {
+  phases.push_back(PhaseMetrics{name, start, end});
+}
+
+void EdgeMetrics::ToJson(std::ostream &out) const {
+  out << "{\"rank\":" << rank << ",\"edge\":" << edge << ",\"operation\":\"" << operation << "\""
+      << ",\"start_us\":" << start_us << ",\"end_us\":" << end_us
+      << ",\"progress_ns\":" << progress_ns << ",\"channel_progress_ns\":" << channel_progress_ns
+      << ",\"phases\":[";
+  for (size_t i = 0; i < phases.size(); i++) {
+    out << (i > 0 ? "," : "") << "{\"name\":\"" << phases[i].name << "\",\"start_us\":" << phases[i].start_us
+        << ",\"end_us\":" << phases[i].end_us << "}";
+  }
+  out << "],\"peers\":{";
+  bool first = true;
+  for (auto &p : peers) {
+    const PeerMetrics &m = p.second;
+    out << (first ? "" : ",") << "\"" << p.first << "\":{"
+        << "\"messages_sent\":" << m.messages_sent
+        << ",\"bytes_sent\":" << m.bytes_sent
+        << ",\"messages_received\":" << m.messages_received
+        << ",\"bytes_received\":" << m.bytes_received
+        << ",\"header_only_sent\":" << m.header_only_sent
+        << ",\"header_only_received\":" << m.header_only_received
+        << ",\"max_queue_depth\":" << m.max_queue_depth
+        << ",\"channel_messages_sent\":" << m.channel_messages_sent
+        << ",\"channel_messages_received\":" << m.channel_messages_received
+        << ",\"channel_max_queue_depth\":" << m.channel_max_queue_depth
+        << ",\"tables_sent\":" << m.tables_sent
+        << ",\"tables_received\":" << m.tables_received << "}";
+    first = false;
+  }
+  out << "}}";
+}
+
+CommMetrics::CommMetrics(int rank, bool enabled) : rank(rank), enabled(enabled) {}
+
+bool CommMetrics::IsEnabled() const {
+  return enabled;
+}
+
+std::shared_ptr<EdgeMetrics> CommMetrics::Open(int edge, const std::string &operation) {
+  if (!enabled) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  auto metrics = std::make_shared<EdgeMetrics>(rank, edge, operation);
+  records.push_back(metrics);
+  current[edge] = metrics;
+  return metrics;
+}
+
+std::shared_ptr<EdgeMetrics> CommMetrics::Current(int edge) {
+  if (!enabled) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  auto it = current.find(edge);
+  return it == current.end() ? nullptr : it->second;
+}
+
+void CommMetrics::Close(const std::shared_ptr<EdgeMetrics> &metrics) {
+  if (metrics == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  metrics->end_us = EdgeMetrics::Now();
+  auto it = current.find(metrics->edge);
+  if (it != current.end() && it->second == metrics) {
+    current.erase(it);
+  }
+}
+
+std::vector<std::shared_ptr<EdgeMetrics>> CommMetrics::Records() {
+  std::lock_guard<std::mutex> guard(lock);
+  return records;
+}
+
+void CommMetrics::Clear() {
+  std::lock_guard<std::mutex> guard(lock);
+  records.clear();
+}
+
+std::string CommMetrics::ToJson() {
+  std::ostringstream out;
+  out << "[";
+  auto all = Records();
+  for (size_t i = 0; i < all.size(); i++) {
+    if (i > 0) {
+      out << ",\n";
+    }
+    all[i]->ToJson(out);
+  }
+  out << "]";
+  return out.str();
+}
+
+/**
+ * Write a complete event of the chrome trace format
+ */
+static void TraceEvent(std::ostream &out, bool *first, const std::string &name, int rank, int edge,
+                       int64_t start, int64_t end) {
+  if (end < start) {
+    end = start;
+  }
+  out << (*first ? "" : ",\n") << "{\"name\":\"" << name << "\",\"cat\":\"comm\",\"ph\":\"X\",\"ts\":" << start
+      << ",\"dur\":" << end - start << ",\"pid\":" << rank << ",\"tid\":" << edge;
+  *first = false;
+}
+
+std::string CommMetrics::ToChromeTrace() {
+  std::ostringstream out;
+  out << "{\"traceEvents\":[";
+  bool first = true;
+  for (auto &m : Records()) {
+    int64_t end = m->end_us > 0 ? m->end_us : EdgeMetrics::Now();
+    TraceEvent(out, &first, m->operation, m->rank, m->edge, m->start_us, end);
+    // the totals of the peers go to the arguments of the operation
+    PeerMetrics total;
+    for (auto &p : m->peers) {
+      total.messages_sent += p.second.messages_sent;
+      total.bytes_sent += p.second.bytes_sent;
+      total.messages_received += p.second.messages_received;
+      total.bytes_received += p.second.bytes_received;
+    }
+    out << ",\"args\":{\"messages_sent\":" << total.messages_sent << ",\"bytes_sent\":" << total.bytes_sent
+        << ",\"messages_received\":" << total.messages_received << ",\"bytes_received\":" << total.bytes_received
+        << ",\"progress_us\":" << m->progress_ns / 1000 << ",\"channel_progress_us\":"
+        << m->channel_progress_ns / 1000 << "}}";
+    for (auto &phase : m->phases) {
+      TraceEvent(out, &first, m->operation + "." + phase.name, m->rank, m->edge, phase.start_us,
+                 phase.end_us > 0 ? phase.end_us : end);
+      out << "}";
+    }
+  }
+  out << "],\"displayTimeUnit\":\"ms\"}";
+  return out.str();
+}
+
+static Status WriteFile(const std::string &path, const std::string &content) {
+  std::ofstream out(path);
+  if (!out) {
+    return Status(Code::IOError, "Failed to open " + path);
+  }
+  out << content;
+  out.close();
+  if (!out) {
+    return Status(Code::IOError, "Failed to write " + path);
+  }
+  return Status::OK();
+}
+
+Status CommMetrics::WriteJson(const std::string &path) {
+  return WriteFile(path, ToJson());
+}
+
+Status CommMetrics::WriteChromeTrace(const std::string &path) {
+  return WriteFile(path, ToChromeTrace());
+}
+}
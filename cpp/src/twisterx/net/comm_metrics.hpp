@@ -0,0 +1,158 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_NET_COMM_METRICS_HPP_
+#define TWISTERX_SRC_TWISTERX_NET_COMM_METRICS_HPP_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../status.hpp"
+
+// set to true in the context to record the metrics of the communication operations
+#define TWISTERX_METRICS "twisterx.metrics"
+
+namespace twisterx {
+
+/**
+ * Counters of the communication with a single peer over an edge
+ */
+struct PeerMetrics {
+  // messages given to the operation for the peer and received from the peer
+  int64_t messages_sent = 0;
+  int64_t bytes_sent = 0;
+  int64_t messages_received = 0;
+  int64_t bytes_received = 0;
+  // messages without any data, only a header
+  int64_t header_only_sent = 0;
+  int64_t header_only_received = 0;
+  // the most messages waiting in the operation to be sent to the peer
+  int64_t max_queue_depth = 0;
+  // messages on the wire, the channel may send the header and the data as separate messages
+  int64_t channel_messages_sent = 0;
+  int64_t channel_messages_received = 0;
+  // the most messages waiting in the channel to be sent to the peer
+  int64_t channel_max_queue_depth = 0;
+  // tables of the arrow all to all
+  int64_t tables_sent = 0;
+  int64_t tables_received = 0;
+};
+
+/**
+ * A named interval of an operation, times are in microseconds since the epoch
+ */
+struct PhaseMetrics {
+  std::string name;
+  int64_t start_us;
+  int64_t end_us;
+};
+
+/**
+ * The metrics of one run of an operation on an edge. The operation and its channel update the metrics from the
+ * thread progressing the operation.
+ */
+struct EdgeMetrics {
+  EdgeMetrics(int rank, int edge, std::string operation);
+
+  int rank;
+  int edge;
+  std::string operation;
+  // when the operation was created and closed
+  int64_t start_us;
+  int64_t end_us = 0;
+  // time spent progressing the operation and its channel
+  int64_t progress_ns = 0;
+  int64_t channel_progress_ns = 0;
+  std::map<int, PeerMetrics> peers;
+  std::vector<PhaseMetrics> phases;
+
+  PeerMetrics &Peer(int peer) {
+    return peers[peer];
+  }
+
+  /**
+   * Start a phase, the phase ends with EndPhase of the same name
+   */
+  void BeginPhase(const std::string &name);
+
+  void EndPhase(const std::string &name);
+
+  void AddPhase(const std::string &name, int64_t start_us, int64_t end_us);
+
+  void ToJson(std::ostream &out) const;
+
+  /**
+   * Current time in microseconds since the epoch, the ranks on different hosts are as close as their clocks
+   */
+  static int64_t Now();
+};
+
+/**
+ * The metrics of the communication operations of a context. Disabled unless TWISTERX_METRICS is set to true in the
+ * context, then the operations record their metrics here and they can be queried or dumped for analysis.
+ */
+class CommMetrics {
+ public:
+  CommMetrics(int rank, bool enabled);
+
+  bool IsEnabled() const;
+
+  /**
+   * Start recording an operation on the edge, the operations on the same edge started before Close record to it
+   *
+   * @return the metrics to update, nullptr if the metrics are disabled
+   */
+  std::shared_ptr<EdgeMetrics> Open(int edge, const std::string &operation);
+
+  /**
+   * The metrics opened for the edge and not closed yet, nullptr if there are none
+   */
+  std::shared_ptr<EdgeMetrics> Current(int edge);
+
+  void Close(const std::shared_ptr<EdgeMetrics> &metrics);
+
+  /**
+   * All the recorded operations, in the order they were opened
+   */
+  std::vector<std::shared_ptr<EdgeMetrics>> Records();
+
+  void Clear();
+
+  std::string ToJson();
+
+  /**
+   * The operations and their phases as complete events of the chrome trace format, one process per rank and one
+   * thread per edge. The traceEvents of the ranks can be merged to view them together.
+   */
+  std::string ToChromeTrace();
+
+  Status WriteJson(const std::string &path);
+
+  Status WriteChromeTrace(const std::string &path);
+
+ private:
+  int rank;
+  bool enabled;
+  std::mutex lock;
+  std::vector<std::shared_ptr<EdgeMetrics>> records;
+  std::unordered_map<int, std::shared_ptr<EdgeMetrics>> current;
+};
+}
+
+#endif //TWISTERX_SRC_TWISTERX_NET_COMM_METRICS_HPP_
@@ -18,7 +18,7 @@
 namespace twisterx {
 namespace net {
 enum CommType {
-  MPI, TCP, UCX
+  MPI, TCP, UCX, LOCAL
 };
 }
 }
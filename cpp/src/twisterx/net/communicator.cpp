@@ -0,0 +1,390 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "communicator.h"
+#include "sub_communicator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <queue>
+#include <glog/logging.h>
+
+namespace twisterx {
+namespace net {
+
+/**
+ * Blocking point to point messages over a channel, used to build the collectives
+ */
+class CollectiveExchange : public ChannelReceiveCallback, public ChannelSendCallback {
+ public:
+  CollectiveExchange(Communicator *comm, int edge, const std::vector<int> &peers) {
+    channel = comm->CreateChannel();
+    channel->init(edge, peers, peers, this, this);
+  }
+
+  /**
+   * Send the data to the target, the data is kept until the send completes
+   */
+  void Send(int target, std::vector<uint8_t> &&data) {
+    auto buf = std::make_shared<std::vector<uint8_t>>(std::move(data));
+    auto request = std::make_shared<TxRequest>(target, buf->data(), static_cast<int>(buf->size()));
+    request->owner = buf;
+    while (channel->send(request) < 0) {
+      Progress();
+    }
+    pendingSends++;
+  }
+
+  /**
+   * Wait for the next message from the source
+   */
+  std::vector<uint8_t> Receive(int source) {
+    std::queue<std::vector<uint8_t>> &q = received[source];
+    while (q.empty()) {
+      Progress();
+    }
+    std::vector<uint8_t> data = std::move(q.front());
+    q.pop();
+    return data;
+  }
+
+  ~CollectiveExchange() {
+    while (pendingSends > 0) {
+      Progress();
+    }
+    channel->close();
+    delete channel;
+  }
+
+  void receivedData(int receiveId, void *buffer, int length) override {
+    auto *data = static_cast<uint8_t *>(buffer);
+    received[receiveId].push(std::vector<uint8_t>(data, data + length));
+    delete[] static_cast<char *>(buffer);
+  }
+
+  void receivedHeader(int receiveId, int finished, int *header, int headerLength) override {
+    delete[] header;
+  }
+
+  void sendComplete(std::shared_ptr<TxRequest> request) override {
+    pendingSends--;
+  }
+
+  void sendFinishComplete(std::shared_ptr<TxRequest> request) override {}
+
+ private:
+  Channel *channel;
+  int pendingSends = 0;
+  std::unordered_map<int, std::queue<std::vector<uint8_t>>> received;
+
+  void Progress() {
+    channel->progressSends();
+    channel->progressReceives();
+  }
+};
+
+/**
+ * The parent and the children of a rank in a binomial tree rooted at the root
+ */
+static void BinomialTree(int rank, int world_size, int root, int *parent, std::vector<int> *children) {
+  int relative = (rank - root + world_size) % world_size;
+  int lowbit = 1;
+  if (relative == 0) {
+    while (lowbit < world_size) {
+      lowbit <<= 1;
+    }
+    *parent = -1;
+  } else {
+    lowbit = relative & -relative;
+    *parent = (relative - lowbit + root) % world_size;
+  }
+  for (int mask = 1; mask < lowbit && relative + mask < world_size; mask <<= 1) {
+    children->push_back((relative + mask + root) % world_size);
+  }
+}
+
+static std::vector<int> TreePeers(int parent, const std::vector<int> &children) {
+  std::vector<int> peers(children);
+  if (parent >= 0) {
+    peers.push_back(parent);
+  }
+  return peers;
+}
+
+template<typename T>
+static void Append(std::vector<uint8_t> *out, const T &value) {
+  const auto *p = reinterpret_cast<const uint8_t *>(&value);
+  out->insert(out->end(), p, p + sizeof(T));
+}
+
+/**
+ * Pack the buffers of a set of ranks as [rank, length, data]...
+ */
+static void PackBlock(std::vector<uint8_t> *out, int32_t rank, const uint8_t *data, int64_t length) {
+  Append(out, rank);
+  Append(out, length);
+  out->insert(out->end(), data, data + length);
+}
+
+static void UnpackBlocks(const std::vector<uint8_t> &packed, std::vector<std::vector<uint8_t>> *blocks) {
+  size_t pos = 0;
+  while (pos < packed.size()) {
+    int32_t rank;
+    int64_t length;
+    memcpy(&rank, packed.data() + pos, sizeof(rank));
+    pos += sizeof(rank);
+    memcpy(&length, packed.data() + pos, sizeof(length));
+    pos += sizeof(length);
+    (*blocks)[rank].assign(packed.data() + pos, packed.data() + pos + length);
+    pos += length;
+  }
+}
+
+template<typename T>
+static void ReduceValues(const void *in, void *inout, int count, ReduceOp op) {
+  const T *a = static_cast<const T *>(in);
+  T *b = static_cast<T *>(inout);
+  for (int i = 0; i < count; i++) {
+    switch (op) {
+      case SUM:b[i] = b[i] + a[i];
+        break;
+      case MIN:b[i] = a[i] < b[i] ? a[i] : b[i];
+        break;
+      case MAX:b[i] = a[i] > b[i] ? a[i] : b[i];
+        break;
+      case PROD:b[i] = b[i] * a[i];
+        break;
+    }
+  }
+}
+
+static int TypeSize(Type::type type) {
+  switch (type) {
+    case Type::UINT8:
+    case Type::INT8:return 1;
+    case Type::UINT16:
+    case Type::INT16:return 2;
+    case Type::UINT32:
+    case Type::INT32:
+    case Type::FLOAT:return 4;
+    case Type::UINT64:
+    case Type::INT64:
+    case Type::DOUBLE:return 8;
+    default:LOG(FATAL) << "Un-supported type for reduce " << type;
+      return -1;
+  }
+}
+
+static void ReduceValues(const void *in, void *inout, int count, Type::type type, ReduceOp op) {
+  switch (type) {
+    case Type::UINT8:return ReduceValues<uint8_t>(in, inout, count, op);
+    case Type::INT8:return ReduceValues<int8_t>(in, inout, count, op);
+    case Type::UINT16:return ReduceValues<uint16_t>(in, inout, count, op);
+    case Type::INT16:return ReduceValues<int16_t>(in, inout, count, op);
+    case Type::UINT32:return ReduceValues<uint32_t>(in, inout, count, op);
+    case Type::INT32:return ReduceValues<int32_t>(in, inout, count, op);
+    case Type::UINT64:return ReduceValues<uint64_t>(in, inout, count, op);
+    case Type::INT64:return ReduceValues<int64_t>(in, inout, count, op);
+    case Type::FLOAT:return ReduceValues<float>(in, inout, count, op);
+    case Type::DOUBLE:return ReduceValues<double>(in, inout, count, op);
+    default:LOG(FATAL) << "Un-supported type for reduce " << type;
+  }
+}
+
+int Communicator::NextCollectiveEdge() {
+  int edge = TWISTERX_COLLECTIVE_EDGE_BASE + collective_sequence;
+  collective_sequence = (collective_sequence + 1) % collective_edges;
+  return edge;
+}
+
+void Communicator::Broadcast(std::vector<uint8_t> *buffer, int root) {
+  int edge = NextCollectiveEdge();
+  int size = GetWorldSize();
+  if (size == 1) {
+    return;
+  }
+  int parent;
+  std::vector<int> children;
+  BinomialTree(GetRank(), size, root, &parent, &children);
+  CollectiveExchange exchange(this, edge, TreePeers(parent, children));
+  if (parent >= 0) {
+    *buffer = exchange.Receive(parent);
+  }
+  // send to the largest sub tree first
+  for (auto it = children.rbegin(); it != children.rend(); ++it) {
+    exchange.Send(*it, std::vector<uint8_t>(*buffer));
+  }
+}
+
+void Communicator::Gather(const std::vector<uint8_t> &send, int root, std::vector<std::vector<uint8_t>> *recv) {
+  int edge = NextCollectiveEdge();
+  int size = GetWorldSize();
+  int parent;
+  std::vector<int> children;
+  BinomialTree(GetRank(), size, root, &parent, &children);
+
+  std::vector<uint8_t> packed;
+  PackBlock(&packed, GetRank(), send.data(), send.size());
+  {
+    CollectiveExchange exchange(this, edge, TreePeers(parent, children));
+    for (int child : children) {
+      std::vector<uint8_t> sub_tree = exchange.Receive(child);
+      packed.insert(packed.end(), sub_tree.begin(), sub_tree.end());
+    }
+    if (parent >= 0) {
+      exchange.Send(parent, std::move(packed));
+      return;
+    }
+  }
+  recv->clear();
+  recv->resize(size);
+  UnpackBlocks(packed, recv);
+}
+
+void Communicator::AllGather(const std::vector<uint8_t> &send, std::vector<std::vector<uint8_t>> *recv) {
+  // gather to 0 and broadcast the packed buffers, both are logarithmic
+  std::vector<std::vector<uint8_t>> gathered;
+  Gather(send, 0, &gathered);
+  std::vector<uint8_t> packed;
+  if (GetRank() == 0) {
+    for (size_t i = 0; i < gathered.size(); i++) {
+      PackBlock(&packed, i, gathered[i].data(), gathered[i].size());
+    }
+  }
+  Broadcast(&packed, 0);
+  recv->clear();
+  recv->resize(GetWorldSize());
+  UnpackBlocks(packed, recv);
+}
+
+void Communicator::Reduce(const void *send, void *recv, int count, Type::type type, ReduceOp op, int root) {
+  int edge = NextCollectiveEdge();
+  int size = GetWorldSize();
+  int parent;
+  std::vector<int> children;
+  BinomialTree(GetRank(), size, root, &parent, &children);
+
+  size_t bytes = static_cast<size_t>(count) * TypeSize(type);
+  std::vector<uint8_t> values(static_cast<const uint8_t *>(send), static_cast<const uint8_t *>(send) + bytes);
+  CollectiveExchange exchange(this, edge, TreePeers(parent, children));
+  for (int child : children) {
+    std::vector<uint8_t> child_values = exchange.Receive(child);
+    ReduceValues(child_values.data(), values.data(), count, type, op);
+  }
+  if (parent >= 0) {
+    exchange.Send(parent, std::move(values));
+  } else {
+    memcpy(recv, values.data(), bytes);
+  }
+}
+
+const std::vector<int> &Communicator::GetNodeIds() {
+  if (!node_ids.empty()) {
+    return node_ids;
+  }
+  int size = GetWorldSize();
+  const char *rpn_env = std::getenv("TWISTERX_RANKS_PER_NODE");
+  if (rpn_env != nullptr && std::atoi(rpn_env) > 0) {
+    int ranks_per_node = std::atoi(rpn_env);
+    for (int i = 0; i < size; i++) {
+      node_ids.push_back(i / ranks_per_node);
+    }
+    return node_ids;
+  }
+
+  char host[256] = {};
+  gethostname(host, sizeof(host) - 1);
+  std::vector<uint8_t> send(host, host + strlen(host));
+  std::vector<std::vector<uint8_t>> hosts;
+  AllGather(send, &hosts);
+  // number the nodes in the order of their first rank
+  std::unordered_map<std::string, int> ids;
+  for (int i = 0; i < size; i++) {
+    std::string name(hosts[i].begin(), hosts[i].end());
+    auto it = ids.find(name);
+    if (it == ids.end()) {
+      it = ids.insert(std::make_pair(name, static_cast<int>(ids.size()))).first;
+    }
+    node_ids.push_back(it->second);
+  }
+  return node_ids;
+}
+
+void Communicator::AllReduce(const void *send, void *recv, int count, Type::type type, ReduceOp op) {
+  std::vector<uint8_t> values(static_cast<size_t>(count) * TypeSize(type));
+  Reduce(send, values.data(), count, type, op, 0);
+  Broadcast(&values, 0);
+  memcpy(recv, values.data(), values.size());
+}
+int Communicator::SplitGroup(int color, int key, int32_t *sequence, std::vector<int> *members) {
+  // the sub communicators take their node ids from this one, every rank has to ask before leaving
+  GetNodeIds();
+
+  int32_t values[3] = {color, key, *sequence};
+  std::vector<uint8_t> send(reinterpret_cast<uint8_t *>(values), reinterpret_cast<uint8_t *>(values) + sizeof(values));
+  std::vector<std::vector<uint8_t>> all;
+  AllGather(send, &all);
+
+  // a fresh id larger than any id known to the ranks of this communicator
+  int32_t id = 0;
+  std::vector<std::pair<int32_t, int>> group;
+  for (int i = 0; i < GetWorldSize(); i++) {
+    int32_t other[3];
+    memcpy(other, all[i].data(), sizeof(other));
+    id = std::max(id, other[2]);
+    if (color != TWISTERX_SPLIT_UNDEFINED && other[0] == color) {
+      group.emplace_back(other[1], i);
+    }
+  }
+  id++;
+  *sequence = id;
+
+  std::sort(group.begin(), group.end());
+  members->clear();
+  for (auto &g : group) {
+    members->push_back(g.second);
+  }
+  return id;
+}
+
+void Communicator::InheritNodeIds(Communicator *sub, const std::vector<int> &members) {
+  const std::vector<int> &ids = GetNodeIds();
+  std::unordered_map<int, int> renumbered;
+  sub->node_ids.clear();
+  for (int m : members) {
+    auto it = renumbered.find(ids[m]);
+    if (it == renumbered.end()) {
+      it = renumbered.insert(std::make_pair(ids[m], static_cast<int>(renumbered.size()))).first;
+    }
+    sub->node_ids.push_back(it->second);
+  }
+}
+
+Communicator *Communicator::Split(int color, int key) {
+  std::vector<int> members;
+  int id = SplitGroup(color, key, &split_sequence, &members);
+  if (members.empty()) {
+    return nullptr;
+  }
+  auto sub = new SubCommunicator(this, members, id);
+  InheritNodeIds(sub, members);
+  return sub;
+}
+}
+}
@@ -15,16 +15,64 @@
 #ifndef TWISTERX_SRC_TWISTERX_COMM_COMMUNICATOR_H_
 #define TWISTERX_SRC_TWISTERX_COMM_COMMUNICATOR_H_
 
+#include <cstdint>
+#include <vector>
 #include "comm_config.h"
 #include "channel.hpp"
+#include "../data_types.hpp"
+
+// edges from this value are used by the collectives, the operations use edges from the context sequence
+#define TWISTERX_COLLECTIVE_EDGE_BASE (1 << 30)
+
+// pass as the color to Split to leave a rank out of the sub communicators
+#define TWISTERX_SPLIT_UNDEFINED (-1)
+
 namespace twisterx {
 namespace net {
 
+enum ReduceOp {
+  SUM, MIN, MAX, PROD
+};
+
 class Communicator {
+  friend class SubCommunicator;
 
  protected:
   int rank = -1;
   int world_size = -1;
+  // every rank calls the collectives in the same order, so this gives the same edge at every rank
+  int32_t collective_sequence = 0;
+  // number of edges the collectives cycle through, smaller for a sub communicator which has to fit its edges in a split
+  int32_t collective_edges = TWISTERX_COLLECTIVE_EDGE_BASE;
+  // the node of each rank, computed on the first request
+  std::vector<int> node_ids;
+  // number of sub communicators known to this rank, used to give the sub communicators unique ids
+  int32_t split_sequence = 0;
+
+  /**
+   * Get a fresh edge for a collective built on the channels
+   */
+  int NextCollectiveEdge();
+
+  /**
+   * Find the ranks of the group of this rank for a split. This is a collective call.
+   *
+   * @param color the group of this rank
+   * @param key orders the ranks within the group, ties are broken by the rank
+   * @param sequence the split sequence of the process, updated with the id of the split
+   * @param members ranks of the group, empty if the color is TWISTERX_SPLIT_UNDEFINED
+   * @return an id for the split, unique among the communicators sharing a rank with this communicator
+   */
+  int SplitGroup(int color, int key, int32_t *sequence, std::vector<int> *members);
+
+  /**
+   * Set the node ids of a sub communicator from the node ids of this communicator
+   *
+   * @param sub the sub communicator
+   * @param members the ranks of this communicator in the sub communicator, in the order of their new ranks
+   */
+  void InheritNodeIds(Communicator *sub, const std::vector<int> &members);
+
  public:
   virtual void Init(CommConfig *config) = 0;
   virtual Channel *CreateChannel() = 0;
@@ -32,6 +80,71 @@ class Communicator {
   virtual int GetWorldSize() = 0;
   virtual void Finalize() = 0;
   virtual void Barrier() = 0;
+
+  /**
+   * Broadcast a buffer from the root to all the ranks. The buffer is resized at the receivers.
+   * The default implementation uses a binomial tree over the channels.
+   *
+   * @param buffer the data at the root, the received data at the other ranks
+   * @param root the rank broadcasting
+   */
+  virtual void Broadcast(std::vector<uint8_t> *buffer, int root);
+
+  /**
+   * Gather a buffer from every rank to the root, the buffers can have different sizes
+   *
+   * @param send the buffer of this rank
+   * @param root the rank gathering
+   * @param recv the buffers indexed by rank, only filled at the root
+   */
+  virtual void Gather(const std::vector<uint8_t> &send, int root, std::vector<std::vector<uint8_t>> *recv);
+
+  /**
+   * Gather a buffer from every rank to every rank
+   *
+   * @param send the buffer of this rank
+   * @param recv the buffers indexed by rank
+   */
+  virtual void AllGather(const std::vector<uint8_t> &send, std::vector<std::vector<uint8_t>> *recv);
+
+  /**
+   * Reduce the values element wise to the root
+   *
+   * @param send the values of this rank
+   * @param recv the reduced values, only set at the root
+   * @param count number of values
+   * @param type type of the values, only the numeric types are supported
+   * @param op the reduce operation
+   * @param root the rank receiving the result
+   */
+  virtual void Reduce(const void *send, void *recv, int count, Type::type type, ReduceOp op, int root);
+
+  /**
+   * Reduce the values element wise, every rank gets the result
+   */
+  virtual void AllReduce(const void *send, void *recv, int count, Type::type type, ReduceOp op);
+
+  /**
+   * Get the node of every rank, ranks on the same host share a node id. Node ids are numbered from 0.
+   * This is a collective call the first time. TWISTERX_RANKS_PER_NODE can be set to group consecutive ranks
+   * into nodes instead, which is useful for testing on a single host.
+   *
+   * @return node ids indexed by the rank
+   */
+  const std::vector<int> &GetNodeIds();
+
+  /**
+   * Split the communicator into disjoint sub communicators like MPI_Comm_split. Ranks with the same color form
+   * a sub communicator with its own rank numbering, ordered by the key, and with its own edges, so operations
+   * on different sub communicators can run at the same time. This is a collective call.
+   *
+   * @param color the sub communicator of this rank, TWISTERX_SPLIT_UNDEFINED to not take part in any
+   * @param key orders the ranks in the sub communicator
+   * @return the sub communicator owned by the caller, nullptr if the color is TWISTERX_SPLIT_UNDEFINED
+   */
+  virtual Communicator *Split(int color, int key);
+
+  virtual ~Communicator() = default;
 };
 }
 }
@@ -0,0 +1,88 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "composite_channel.hpp"
+
+#include <utility>
+
+namespace twisterx {
+
+CompositeChannel::CompositeChannel(Channel *local, Channel *remote, std::unordered_set<int> local_ranks)
+    : local(local), remote(remote), local_ranks(std::move(local_ranks)) {}
+
+Channel *CompositeChannel::ChannelFor(int peer) const {
+  return local_ranks.find(peer) != local_ranks.end() ? local : remote;
+}
+
+void CompositeChannel::init(int edge, const std::vector<int> &receives, const std::vector<int> &sendIds,
+                            ChannelReceiveCallback *rcv, ChannelSendCallback *send) {
+  std::vector<int> local_receives, remote_receives, local_sends, remote_sends;
+  for (int r : receives) {
+    if (local_ranks.find(r) != local_ranks.end()) {
+      local_receives.push_back(r);
+    } else {
+      remote_receives.push_back(r);
+    }
+  }
+  for (int s : sendIds) {
+    if (local_ranks.find(s) != local_ranks.end()) {
+      local_sends.push_back(s);
+    } else {
+      remote_sends.push_back(s);
+    }
+  }
+  local->init(edge, local_receives, local_sends, rcv, send);
+  remote->init(edge, remote_receives, remote_sends, rcv, send);
+}
+
+int CompositeChannel::send(std::shared_ptr<TxRequest> request) {
+  return ChannelFor(request->target)->send(request);
+}
+
+int CompositeChannel::sendFin(std::shared_ptr<TxRequest> request) {
+  return ChannelFor(request->target)->sendFin(request);
+}
+
+void CompositeChannel::progressSends() {
+  local->progressSends();
+  remote->progressSends();
+}
+
+void CompositeChannel::progressReceives() {
+  local->progressReceives();
+  remote->progressReceives();
+}
+
+void CompositeChannel::close() {
+  local->close();
+  remote->close();
+}
+
+bool CompositeChannel::reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send) {
+  // both have to be asked, each of them resets its own state
+  bool local_reused = local->reuse(rcv, send);
+  bool remote_reused = remote->reuse(rcv, send);
+  return local_reused && remote_reused;
+}
+
+void CompositeChannel::setMetrics(const std::shared_ptr<EdgeMetrics> &metrics) {
+  local->setMetrics(metrics);
+  remote->setMetrics(metrics);
+}
+
+CompositeChannel::~CompositeChannel() {
+  delete local;
+  delete remote;
+}
+}
@@ -0,0 +1,68 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_COMPOSITE_CHANNEL_H
+#define TWISTERX_COMPOSITE_CHANNEL_H
+
+#include "channel.hpp"
+
+#include <vector>
+#include <unordered_set>
+
+namespace twisterx {
+
+/**
+ * A channel that routes the messages to one of two channels depending on the peer. Ranks in the local set
+ * use the local channel (i.e. shared memory) and the rest use the remote channel (i.e. MPI).
+ * The composite channel owns both channels.
+ */
+class CompositeChannel : public Channel {
+ public:
+  /**
+   * Create the channel
+   * @param local channel used for the local ranks
+   * @param remote channel used for the rest of the ranks
+   * @param local_ranks the ranks reachable through the local channel
+   */
+  CompositeChannel(Channel *local, Channel *remote, std::unordered_set<int> local_ranks);
+
+  void init(int edge, const std::vector<int> &receives, const std::vector<int> &sendIds,
+            ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+  int send(std::shared_ptr<TxRequest> request) override;
+
+  int sendFin(std::shared_ptr<TxRequest> request) override;
+
+  void progressSends() override;
+
+  void progressReceives() override;
+
+  void close() override;
+
+  bool reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+  void setMetrics(const std::shared_ptr<EdgeMetrics> &metrics) override;
+
+  ~CompositeChannel() override;
+
+ private:
+  Channel *local;
+  Channel *remote;
+  std::unordered_set<int> local_ranks;
+
+  Channel *ChannelFor(int peer) const;
+};
+}
+
+#endif //TWISTERX_COMPOSITE_CHANNEL_H
@@ -0,0 +1,157 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "local_channel.hpp"
+
+#include <cstring>
+
+namespace twisterx {
+
+LocalChannel::LocalChannel(net::LocalCommGroup *group, int rank) : group(group), rank(rank) {}
+
+void LocalChannel::init(int ed, const std::vector<int> &receiveIds, const std::vector<int> &sendIds,
+                        ChannelReceiveCallback *rcv, ChannelSendCallback *send_fn) {
+  edge = ed;
+  rcv_fn = rcv;
+  send_comp_fn = send_fn;
+  for (int source : receiveIds) {
+    receives[source] = group->AcquireMailbox(edge, source, rank);
+  }
+  for (int target : sendIds) {
+    auto *ps = new LocalPendingSend();
+    ps->mailbox = group->AcquireMailbox(edge, rank, target);
+    sends[target] = ps;
+  }
+}
+
+int LocalChannel::send(std::shared_ptr<TxRequest> request) {
+  LocalPendingSend *ps = sends[request->target];
+  if (ps->pendingData.size() > 1000) {
+    return -1;
+  }
+  ps->pendingData.push(request);
+  return 1;
+}
+
+int LocalChannel::sendFin(std::shared_ptr<TxRequest> request) {
+  if (finishRequests.find(request->target) != finishRequests.end()) {
+    return -1;
+  }
+  finishRequests.insert(std::pair<int, std::shared_ptr<TxRequest>>(request->target, request));
+  return 1;
+}
+
+void LocalChannel::progressSends() {
+  for (auto x : sends) {
+    LocalPendingSend *ps = x.second;
+    while (!ps->pendingData.empty()) {
+      std::shared_ptr<TxRequest> r = ps->pendingData.front();
+      net::LocalMessage msg;
+      msg.headerLength = r->headerLength;
+      if (r->headerLength > 0) {
+        memcpy(msg.header, r->header, r->headerLength * sizeof(int));
+      }
+      msg.length = r->length;
+      if (r->owner != nullptr) {
+        // the receiver shares the buffer with us
+        msg.buffer = r->buffer;
+        msg.owner = r->owner;
+      } else {
+        // the receiver owns what it receives, so we have to give it a copy
+        char *data = new char[r->length];
+        if (r->length > 0) {
+          memcpy(data, r->buffer, r->length);
+        }
+        msg.buffer = data;
+      }
+      if (!ps->mailbox->queue.Push(std::move(msg))) {
+        if (r->owner == nullptr) {
+          delete[] static_cast<char *>(msg.buffer);
+        }
+        break;
+      }
+      ps->pendingData.pop();
+      send_comp_fn->sendComplete(r);
+    }
+
+    if (ps->pendingData.empty() && !ps->finSent) {
+      auto fin = finishRequests.find(x.first);
+      if (fin != finishRequests.end()) {
+        net::LocalMessage msg;
+        msg.fin = 1;
+        if (ps->mailbox->queue.Push(std::move(msg))) {
+          ps->finSent = true;
+          send_comp_fn->sendFinishComplete(fin->second);
+        }
+      }
+    }
+  }
+}
+
+void LocalChannel::progressReceives() {
+  for (auto x : receives) {
+    net::LocalMessage msg;
+    while (finishedSources.find(x.first) == finishedSources.end() && x.second->queue.Pop(&msg)) {
+      if (msg.fin) {
+        finishedSources.insert(x.first);
+        rcv_fn->receivedHeader(x.first, msg.fin, nullptr, 0);
+        continue;
+      }
+      int *header = nullptr;
+      if (msg.headerLength > 0) {
+        header = new int[msg.headerLength];
+        memcpy(header, msg.header, msg.headerLength * sizeof(int));
+      }
+      rcv_fn->receivedHeader(x.first, msg.fin, header, msg.headerLength);
+      if (msg.owner != nullptr) {
+        rcv_fn->receivedSharedData(x.first, msg.buffer, msg.length, msg.owner);
+      } else {
+        rcv_fn->receivedData(x.first, msg.buffer, msg.length);
+      }
+      msg = net::LocalMessage();
+    }
+  }
+}
+
+bool LocalChannel::reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send_fn) {
+  for (auto &s : sends) {
+    if (!s.second->finSent || !s.second->pendingData.empty()) {
+      return false;
+    }
+  }
+  if (finishedSources.size() != receives.size()) {
+    return false;
+  }
+  rcv_fn = rcv;
+  send_comp_fn = send_fn;
+  finishRequests.clear();
+  finishedSources.clear();
+  for (auto &s : sends) {
+    s.second->finSent = false;
+  }
+  return true;
+}
+
+void LocalChannel::close() {
+  for (auto &r : receives) {
+    group->ReleaseMailbox(edge, r.first, rank);
+  }
+  receives.clear();
+  for (auto &s : sends) {
+    group->ReleaseMailbox(edge, rank, s.first);
+    delete s.second;
+  }
+  sends.clear();
+}
+}
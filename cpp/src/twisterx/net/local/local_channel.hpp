@@ -0,0 +1,77 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_LOCAL_CHANNEL_H
+#define TWISTERX_LOCAL_CHANNEL_H
+
+#include "../channel.hpp"
+#include "local_communicator.h"
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <queue>
+
+namespace twisterx {
+
+struct LocalPendingSend {
+  net::LocalMailbox *mailbox{};
+  std::queue<std::shared_ptr<TxRequest>> pendingData;
+  bool finSent = false;
+};
+
+/**
+ * A channel between ranks running as threads of the same process. Messages are passed through
+ * lock free queues. A buffer with an owner is handed to the receiver without a copy, other buffers
+ * are copied once as the receiver owns the received memory.
+ */
+class LocalChannel : public Channel {
+ public:
+  LocalChannel(net::LocalCommGroup *group, int rank);
+
+  void init(int edge, const std::vector<int> &receives, const std::vector<int> &sendIds,
+            ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+  int send(std::shared_ptr<TxRequest> request) override;
+
+  int sendFin(std::shared_ptr<TxRequest> request) override;
+
+  void progressSends() override;
+
+  void progressReceives() override;
+
+  void close() override;
+
+  bool reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+ private:
+  net::LocalCommGroup *group;
+  int rank;
+  int edge{};
+  // keep track of the sends for each target
+  std::unordered_map<int, LocalPendingSend *> sends;
+  // the mailboxes we receive from, for each source
+  std::unordered_map<int, net::LocalMailbox *> receives;
+  // we got finish requests
+  std::unordered_map<int, std::shared_ptr<TxRequest>> finishRequests;
+  // sources that sent the finish, what comes after belongs to the next operation on the edge
+  std::unordered_set<int> finishedSources;
+  // receive callback function
+  ChannelReceiveCallback *rcv_fn{};
+  // send complete callback function
+  ChannelSendCallback *send_comp_fn{};
+};
+}
+
+#endif //TWISTERX_LOCAL_CHANNEL_H
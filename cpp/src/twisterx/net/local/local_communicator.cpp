@@ -0,0 +1,112 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "local_communicator.h"
+#include "local_channel.hpp"
+
+#include <utility>
+#include <glog/logging.h>
+
+namespace twisterx {
+namespace net {
+
+LocalCommGroup::LocalCommGroup(int world_size) : world_size(world_size) {}
+
+LocalCommGroup::~LocalCommGroup() {
+  for (auto &mailbox : mailboxes) {
+    delete mailbox.second;
+  }
+}
+
+int LocalCommGroup::GetWorldSize() const {
+  return world_size;
+}
+
+LocalMailbox *LocalCommGroup::AcquireMailbox(int edge, int source, int target) {
+  std::lock_guard<std::mutex> guard(lock);
+  auto key = std::make_tuple(edge, source, target);
+  auto it = mailboxes.find(key);
+  if (it == mailboxes.end()) {
+    it = mailboxes.insert(std::make_pair(key, new LocalMailbox())).first;
+  }
+  it->second->users++;
+  return it->second;
+}
+
+void LocalCommGroup::ReleaseMailbox(int edge, int source, int target) {
+  std::lock_guard<std::mutex> guard(lock);
+  auto it = mailboxes.find(std::make_tuple(edge, source, target));
+  if (it == mailboxes.end()) {
+    return;
+  }
+  if (--it->second->users == 0 && it->second->queue.Empty()) {
+    delete it->second;
+    mailboxes.erase(it);
+  }
+}
+
+void LocalCommGroup::Barrier() {
+  std::unique_lock<std::mutex> guard(lock);
+  int64_t generation = barrier_generation;
+  if (++barrier_count == world_size) {
+    barrier_count = 0;
+    barrier_generation++;
+    barrier_cond.notify_all();
+    return;
+  }
+  barrier_cond.wait(guard, [this, generation] { return barrier_generation != generation; });
+}
+
+LocalConfig::LocalConfig(std::shared_ptr<LocalCommGroup> group, int rank) : group(std::move(group)), rank(rank) {}
+
+const std::shared_ptr<LocalCommGroup> &LocalConfig::GetGroup() const {
+  return group;
+}
+
+int LocalConfig::GetRank() const {
+  return rank;
+}
+
+CommType LocalConfig::Type() {
+  return CommType::LOCAL;
+}
+
+void LocalCommunicator::Init(CommConfig *config) {
+  auto *local_config = static_cast<LocalConfig *>(config);
+  this->group = local_config->GetGroup();
+  this->rank = local_config->GetRank();
+  this->world_size = this->group->GetWorldSize();
+  if (this->rank < 0 || this->rank >= this->world_size) {
+    LOG(FATAL) << "Invalid rank " << this->rank << " for world size " << this->world_size;
+  }
+}
+
+Channel *LocalCommunicator::CreateChannel() {
+  return new LocalChannel(group.get(), this->rank);
+}
+
+int LocalCommunicator::GetRank() {
+  return this->rank;
+}
+int LocalCommunicator::GetWorldSize() {
+  return this->world_size;
+}
+void LocalCommunicator::Finalize() {
+  this->group->Barrier();
+}
+void LocalCommunicator::Barrier() {
+  this->group->Barrier();
+}
+}
+}
@@ -0,0 +1,127 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_NET_LOCAL_LOCAL_COMMUNICATOR_H_
+#define TWISTERX_SRC_TWISTERX_NET_LOCAL_LOCAL_COMMUNICATOR_H_
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include "../comm_config.h"
+#include "../communicator.h"
+#include "spsc_queue.hpp"
+
+// number of messages a mailbox can hold before the sender has to wait
+#define TWISTERX_LOCAL_MAILBOX_SIZE 1024
+
+namespace twisterx {
+namespace net {
+
+struct LocalMessage {
+  int fin{};
+  int header[8]{};
+  int headerLength{};
+  void *buffer{};
+  int length{};
+  // when set the buffer belongs to the sender and is kept alive by this
+  std::shared_ptr<void> owner{};
+};
+
+/**
+ * Messages from a source to a target on an edge
+ */
+struct LocalMailbox {
+  SPSCQueue<LocalMessage> queue{TWISTERX_LOCAL_MAILBOX_SIZE};
+  // the holders of the mailbox, it is removed when the last holder releases it and no message is left for the
+  // receiver, so a sender that releases it before the receiver acquires it doesn't drop its messages
+  int users = 0;
+};
+
+/**
+ * The state shared by the ranks of an in-process group. Create one group and give it to the
+ * LocalConfig of each rank, every rank should run in its own thread.
+ */
+class LocalCommGroup {
+ public:
+  explicit LocalCommGroup(int world_size);
+
+  // the mailboxes with messages nobody received
+  ~LocalCommGroup();
+
+  int GetWorldSize() const;
+
+  /**
+   * Get the mailbox for the messages from the source to the target on the edge, it is created
+   * by the first rank asking for it. Every acquire has to be matched by a release.
+   */
+  LocalMailbox *AcquireMailbox(int edge, int source, int target);
+
+  /**
+   * Release a mailbox acquired by AcquireMailbox
+   */
+  void ReleaseMailbox(int edge, int source, int target);
+
+  /**
+   * Wait until all the ranks of the group call the barrier
+   */
+  void Barrier();
+
+ private:
+  int world_size;
+  std::mutex lock;
+  std::map<std::tuple<int, int, int>, LocalMailbox *> mailboxes;
+  std::condition_variable barrier_cond;
+  int barrier_count = 0;
+  int64_t barrier_generation = 0;
+};
+
+class LocalConfig : public CommConfig {
+ public:
+  /**
+   * @param group the group shared by all the ranks
+   * @param rank rank of the thread using this config
+   */
+  LocalConfig(std::shared_ptr<LocalCommGroup> group, int rank);
+
+  const std::shared_ptr<LocalCommGroup> &GetGroup() const;
+
+  int GetRank() const;
+
+  CommType Type() override;
+
+ private:
+  std::shared_ptr<LocalCommGroup> group;
+  int rank;
+};
+
+/**
+ * A communicator where the ranks are threads of the same process
+ */
+class LocalCommunicator : public Communicator {
+ public:
+  void Init(CommConfig *config) override;
+  Channel *CreateChannel() override;
+  int GetRank() override;
+  int GetWorldSize() override;
+  void Finalize() override;
+  void Barrier() override;
+
+ private:
+  std::shared_ptr<LocalCommGroup> group;
+};
+}
+}
+#endif //TWISTERX_SRC_TWISTERX_NET_LOCAL_LOCAL_COMMUNICATOR_H_
@@ -0,0 +1,83 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SPSC_QUEUE_H
+#define TWISTERX_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace twisterx {
+namespace net {
+
+/**
+ * A bounded lock free queue for a single producer thread and a single consumer thread
+ */
+template<typename T>
+class SPSCQueue {
+ public:
+  explicit SPSCQueue(size_t capacity) : slots(capacity + 1) {}
+
+  /**
+   * Add an item, this should only be called by the producer
+   * @return false if the queue is full
+   */
+  bool Push(T &&item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t next = (t + 1) % slots.size();
+    if (next == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots[t] = std::move(item);
+    tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Remove an item, this should only be called by the consumer
+   * @return false if the queue is empty
+   */
+  bool Pop(T *item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    *item = std::move(slots[h]);
+    // release what the slot holds as soon as it is consumed
+    slots[h] = T();
+    head.store((h + 1) % slots.size(), std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Whether the queue has no items, exact only while neither the producer nor the consumer is using it
+   */
+  bool Empty() const {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+  }
+
+ private:
+  std::vector<T> slots;
+  // head and tail are kept on separate cache lines so the two threads don't share a line
+  char headPad[64]{};
+  std::atomic<size_t> head{0};
+  char tailPad[64]{};
+  std::atomic<size_t> tail{0};
+};
+}
+}
+
+#endif //TWISTERX_SPSC_QUEUE_H
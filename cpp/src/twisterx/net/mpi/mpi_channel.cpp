@@ -15,35 +15,55 @@
 #include "mpi_channel.hpp"
 
 #include <mpi.h>
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include <iostream>
 #include <cstring>
 #include "../TxRequest.h"
+#include "../comm_metrics.hpp"
 
 #include <glog/logging.h>
 
 namespace twisterx {
 
+MPIChannel::MPIChannel(MPI_Comm comm) : comm(comm) {}
+
 void MPIChannel::init(int ed, const std::vector<int> &receives, const std::vector<int> &sendIds,
 					  ChannelReceiveCallback *rcv, ChannelSendCallback *send_fn) {
   edge = ed;
   rcv_fn = rcv;
   send_comp_fn = send_fn;
-  // we need to post the length buffers
+  // we need to post the length buffers, these are persistent as we receive headers all the time
+  receiveRequests.resize(receives.size(), MPI_REQUEST_NULL);
   for (int source : receives) {
 	auto *buf = new PendingReceive();
 	buf->receiveId = source;
+	buf->index = static_cast<int>(receiveSlots.size());
 	pendingReceives.insert(std::pair<int, PendingReceive *>(source, buf));
-	MPI_Irecv(buf->headerBuf, TWISTERX_CHANNEL_HEADER_SIZE, MPI_INT, source, edge, MPI_COMM_WORLD, &buf->request);
+	receiveSlots.push_back(buf);
+	MPI_Recv_init(buf->headerBuf, TWISTERX_CHANNEL_HEADER_SIZE, MPI_INT, source, edge, comm,
+				  &buf->headerRequest);
+	receiveRequests[buf->index] = buf->headerRequest;
+	MPI_Start(&receiveRequests[buf->index]);
 	// set the flag to true so we can identify later which buffers are posted
 	buf->status = RECEIVE_LENGTH_POSTED;
   }
 
+  sendRequests.resize(sendIds.size(), MPI_REQUEST_NULL);
   for (int target : sendIds) {
-	sends[target] = new PendingSend();
+	auto *ps = new PendingSend();
+	ps->index = static_cast<int>(sendSlots.size());
+	sends[target] = ps;
+	sendSlots.push_back(ps);
+	sendTargets.push_back(target);
   }
+
+  size_t max_requests = std::max(receiveRequests.size(), sendRequests.size());
+  completedIndices.resize(max_requests);
+  completedStatuses.resize(max_requests);
   // get the rank
-  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_rank(comm, &rank);
 }
 
 int MPIChannel::send(std::shared_ptr<TxRequest> request) {
@@ -52,6 +72,12 @@ int MPIChannel::send(std::shared_ptr<TxRequest> request) {
 	return -1;
   }
   ps->pendingData.push(request);
+  if (metrics != nullptr) {
+	PeerMetrics &peer = metrics->Peer(request->target);
+	peer.channel_max_queue_depth = std::max(peer.channel_max_queue_depth,
+											static_cast<int64_t>(ps->pendingData.size()));
+  }
+  markReady(request->target);
   return 1;
 }
 
@@ -62,185 +88,282 @@ int MPIChannel::sendFin(std::shared_ptr<TxRequest> request) {
 
   // LOG(INFO) << rank << " Insert FIN " << request->target;
   finishRequests.insert(std::pair<int, std::shared_ptr<TxRequest>>(request->target, request));
+  markReady(request->target);
   return 1;
 }
 
+void MPIChannel::markReady(int target) {
+  PendingSend *ps = sends[target];
+  if (ps->status == SEND_INIT && !ps->ready) {
+	ps->ready = true;
+	readySends.push_back(target);
+  }
+}
+
 void MPIChannel::progressReceives() {
-  MPI_Status status;
-  int count = 0;
-  for (auto x : pendingReceives) {
-	int flag = 0;
-	status = {};
-	if (x.second->status == RECEIVE_LENGTH_POSTED) {
-	  MPI_Test(&(x.second->request), &flag, &status);
-	  if (flag) {
-		x.second->request = {};
-		int count = 0;
-		MPI_Get_count(&status, MPI_INT, &count);
-		// read the length from the header
-		int length = x.second->headerBuf[0];
-		int finFlag = x.second->headerBuf[1];
-		// LOG(INFO) << rank << " ** received " << length << " flag " << finFlag;
-		// check weather we are at the end
-		if (finFlag != TWISTERX_MSG_FIN) {
-		  if (count > 8) {
-			LOG(FATAL) << "Un-expected number of bytes expected: 8 or less " << " received: " << count;
-		  }
-		  // malloc a buffer
-		  x.second->data = new char[length];
-		  x.second->length = length;
-		  MPI_Irecv(x.second->data, length, MPI_BYTE, x.second->receiveId, edge, MPI_COMM_WORLD, &(x.second->request));
-		  // LOG(INFO) << rank << " ** POST RECEIVE " << length << " addr: " << x.second->data;
-		  x.second->status = RECEIVE_POSTED;
-		  // copy the count - 2 to the buffer
-		  int *header = nullptr;
-		  if (count > 2) {
-			header = new int[count - 2];
-			memcpy(header, &(x.second->headerBuf[2]), (count - 2) * sizeof(int));
-		  }
-		  //LOG(INFO) << rank << " Receive header 1 " << count - 2;
-		  // notify the receiver
-		  rcv_fn->receivedHeader(x.first, finFlag, header, count - 2);
-		} else {
-		  if (count != 2) {
-			LOG(FATAL) << "Un-expected number of bytes expected: 2 " << " received: " << count;
-		  }
-		  // we are not expecting to receive any more
-		  x.second->status = RECEIVED_FIN;
-		  // notify the receiver
-		  rcv_fn->receivedHeader(x.first, finFlag, nullptr, 0);
-		}
-	  }
-	} else if (x.second->status == RECEIVE_POSTED) {
-	  MPI_Test(&x.second->request, &flag, &status);
-	  if (flag) {
-		int count = 0;
-		MPI_Get_count(&status, MPI_BYTE, &count);
-		if (count != x.second->length) {
-		  LOG(FATAL) << "Un-expected number of bytes expected:" << x.second->length << " received: " << count;
-		}
-
-		//LOG(INFO) << rank << " ## received from " << x.first
-		//  << " posted length receive to " << x.second->receiveId << " length " << x.second->length;
-
-		x.second->request = {};
-		// clear the array
-		std::fill_n(x.second->headerBuf, TWISTERX_CHANNEL_HEADER_SIZE, 0);
-		// malloc a buffer
-		MPI_Irecv(x.second->headerBuf, TWISTERX_CHANNEL_HEADER_SIZE, MPI_INT,
-				  x.second->receiveId, edge, MPI_COMM_WORLD, &(x.second->request));
-		// LOG(INFO) << rank << " ** POST HEADER " << 8 << " addr: " << x.second->headerBuf;
-		x.second->status = RECEIVE_LENGTH_POSTED;
-		// call the back end
-		rcv_fn->receivedData(x.first, x.second->data, x.second->length);
+  if (receiveRequests.empty()) {
+	return;
+  }
+  std::chrono::steady_clock::time_point start;
+  if (metrics != nullptr) {
+	start = std::chrono::steady_clock::now();
+  }
+  int completed = 0;
+  MPI_Testsome(static_cast<int>(receiveRequests.size()), receiveRequests.data(), &completed,
+			   completedIndices.data(), completedStatuses.data());
+  if (completed != MPI_UNDEFINED) {
+	for (int i = 0; i < completed; i++) {
+	  PendingReceive *pr = receiveSlots[completedIndices[i]];
+	  if (metrics != nullptr) {
+		metrics->Peer(pr->receiveId).channel_messages_received++;
 	  }
-	} else if (x.second->status != RECEIVED_FIN) {
-	  LOG(FATAL) << "At an un-expected state " << x.second->status;
+	  receiveCompleted(pr, &completedStatuses[i]);
 	}
   }
+  if (metrics != nullptr) {
+	metrics->channel_progress_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count();
+  }
 }
 
-void MPIChannel::progressSends() {
-  // lets send values
-  for (auto x : sends) {
-	int flag = 0;
-	MPI_Status status;
-	// if we are in the length posted
-	if (x.second->status == SEND_LENGTH_POSTED) {
-	  MPI_Test(&x.second->request, &flag, &status);
-	  if (flag) {
-		x.second->request = {};
-		// now post the actual send
-		std::shared_ptr<TxRequest> r = x.second->pendingData.front();
-		// LOG(INFO) << rank << " Sent message to " << r->target << " length " << r->length << " addr: " << r->buffer;
-		MPI_Isend(r->buffer, r->length, MPI_BYTE, r->target, edge, MPI_COMM_WORLD, &(x.second->request));
-		x.second->status = SEND_POSTED;
-		x.second->pendingData.pop();
-		// we set to the current send and pop it
-		x.second->currentSend = r;
+void MPIChannel::receiveCompleted(PendingReceive *pr, MPI_Status *status) {
+  if (pr->status == RECEIVE_LENGTH_POSTED) {
+	int count = 0;
+	MPI_Get_count(status, MPI_INT, &count);
+	// read the length from the header
+	int length = pr->headerBuf[0];
+	int finFlag = pr->headerBuf[1];
+	// LOG(INFO) << rank << " ** received " << length << " flag " << finFlag;
+	// check weather we are at the end
+	if (finFlag != TWISTERX_MSG_FIN) {
+	  if (count > TWISTERX_CHANNEL_HEADER_SIZE) {
+		LOG(FATAL) << "Un-expected number of bytes expected: " << TWISTERX_CHANNEL_HEADER_SIZE
+				   << " or less " << " received: " << count;
 	  }
-	} else if (x.second->status == SEND_INIT) {
-	  x.second->request = {};
-	  // now post the actual send
-	  if (!x.second->pendingData.empty()) {
-		sendHeader(x);
-	  } else if (finishRequests.find(x.first) != finishRequests.end()) {
-		// if there are finish requests lets send them
-		sendFinishHeader(x);
+	  // malloc a buffer
+	  pr->data = new char[length];
+	  pr->length = length;
+	  // the slot holds the data receive until it completes, the header request stays with the receive
+	  MPI_Irecv(pr->data, length, MPI_BYTE, pr->receiveId, edge, comm, &receiveRequests[pr->index]);
+	  // LOG(INFO) << rank << " ** POST RECEIVE " << length << " addr: " << pr->data;
+	  pr->status = RECEIVE_POSTED;
+	  // copy the count - 2 to the buffer
+	  int *header = nullptr;
+	  if (count > 2) {
+		header = new int[count - 2];
+		memcpy(header, &(pr->headerBuf[2]), (count - 2) * sizeof(int));
 	  }
-	} else if (x.second->status == SEND_POSTED) {
-	  MPI_Test(&(x.second->request), &flag, &status);
-	  if (flag) {
-		x.second->request = {};
-		// if there are more data to post, post the length buffer now
-		if (!x.second->pendingData.empty()) {
-		  sendHeader(x);
-		  // we need to notify about the send completion
-		  send_comp_fn->sendComplete(x.second->currentSend);
-		  x.second->currentSend = {};
-		} else {
-		  // we need to notify about the send completion
-		  send_comp_fn->sendComplete(x.second->currentSend);
-		  x.second->currentSend = {};
-		  // now check weather finish request is there
-		  if (finishRequests.find(x.first) != finishRequests.end()) {
-			sendFinishHeader(x);
-		  } else {
-			x.second->status = SEND_INIT;
-		  }
-		}
+	  //LOG(INFO) << rank << " Receive header 1 " << count - 2;
+	  // notify the receiver
+	  rcv_fn->receivedHeader(pr->receiveId, finFlag, header, count - 2);
+	} else {
+	  if (count != 2) {
+		LOG(FATAL) << "Un-expected number of bytes expected: 2 " << " received: " << count;
 	  }
-	} else if (x.second->status == SEND_FINISH) {
-	  MPI_Test(&(x.second->request), &flag, &status);
-	  if (flag) {
-		// LOG(INFO) << rank << " FINISHED send " << x.first;
-		// we are going to send complete
-		std::shared_ptr<TxRequest> finReq = finishRequests[x.first];
-		send_comp_fn->sendFinishComplete(finReq);
-		x.second->status = SEND_DONE;
-	  }
-	} else if (x.second->status != SEND_DONE) {
-	  // throw an exception and log
-	  LOG(FATAL) << "At an un-expected state " << x.second->status;
+	  // we are not expecting to receive any more
+	  pr->status = RECEIVED_FIN;
+	  // the persistent request is inactive, we don't start it again
+	  receiveRequests[pr->index] = MPI_REQUEST_NULL;
+	  // notify the receiver
+	  rcv_fn->receivedHeader(pr->receiveId, finFlag, nullptr, 0);
+	}
+  } else if (pr->status == RECEIVE_POSTED) {
+	int count = 0;
+	MPI_Get_count(status, MPI_BYTE, &count);
+	if (count != pr->length) {
+	  LOG(FATAL) << "Un-expected number of bytes expected:" << pr->length << " received: " << count;
+	}
+
+	//LOG(INFO) << rank << " ## received from " << pr->receiveId << " length " << pr->length;
+
+	// clear the array
+	std::fill_n(pr->headerBuf, TWISTERX_CHANNEL_HEADER_SIZE, 0);
+	// restart the persistent header receive
+	receiveRequests[pr->index] = pr->headerRequest;
+	MPI_Start(&receiveRequests[pr->index]);
+	// LOG(INFO) << rank << " ** POST HEADER " << 8 << " addr: " << pr->headerBuf;
+	pr->status = RECEIVE_LENGTH_POSTED;
+	// call the back end
+	rcv_fn->receivedData(pr->receiveId, pr->data, pr->length);
+  } else {
+	LOG(FATAL) << "At an un-expected state " << pr->status;
+  }
+}
+
+void MPIChannel::progressSends() {
+  std::chrono::steady_clock::time_point start;
+  if (metrics != nullptr) {
+	start = std::chrono::steady_clock::now();
+  }
+  progressSendRequests();
+  if (metrics != nullptr) {
+	metrics->channel_progress_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+void MPIChannel::progressSendRequests() {
+  // start the sends of the idle targets that got something to send
+  if (!readySends.empty()) {
+	std::vector<int> ready;
+	ready.swap(readySends);
+	for (int target : ready) {
+	  PendingSend *ps = sends[target];
+	  ps->ready = false;
+	  startSend(target, ps);
 	}
   }
+
+  if (sendRequests.empty()) {
+	return;
+  }
+  int completed = 0;
+  MPI_Testsome(static_cast<int>(sendRequests.size()), sendRequests.data(), &completed,
+			   completedIndices.data(), completedStatuses.data());
+  if (completed == MPI_UNDEFINED) {
+	return;
+  }
+  for (int i = 0; i < completed; i++) {
+	int index = completedIndices[i];
+	sendCompleted(sendTargets[index], sendSlots[index]);
+  }
 }
 
-void MPIChannel::sendHeader(const std::pair<const int, PendingSend *> &x) const {
-  std::shared_ptr<TxRequest> r = x.second->pendingData.front();
+void MPIChannel::startSend(int target, PendingSend *ps) {
+  if (ps->status != SEND_INIT) {
+	return;
+  }
+  if (!ps->pendingData.empty()) {
+	sendHeader(target, ps);
+  } else if (finishRequests.find(target) != finishRequests.end()) {
+	// if there are finish requests lets send them
+	sendFinishHeader(target, ps);
+  }
+}
+
+void MPIChannel::sendCompleted(int target, PendingSend *ps) {
+  if (ps->status == SEND_LENGTH_POSTED) {
+	// now post the actual send
+	std::shared_ptr<TxRequest> r = ps->pendingData.front();
+	// LOG(INFO) << rank << " Sent message to " << r->target << " length " << r->length << " addr: " << r->buffer;
+	MPI_Isend(r->buffer, r->length, MPI_BYTE, r->target, edge, comm, &sendRequests[ps->index]);
+	if (metrics != nullptr) {
+	  metrics->Peer(target).channel_messages_sent++;
+	}
+	ps->status = SEND_POSTED;
+	ps->pendingData.pop();
+	// we set to the current send and pop it
+	ps->currentSend = r;
+  } else if (ps->status == SEND_POSTED) {
+	// we need to notify about the send completion
+	std::shared_ptr<TxRequest> r = ps->currentSend;
+	ps->currentSend = {};
+	ps->status = SEND_INIT;
+	// if there are more data to post, post the length buffer now, otherwise check for the finish
+	startSend(target, ps);
+	send_comp_fn->sendComplete(r);
+  } else if (ps->status == SEND_FINISH) {
+	// LOG(INFO) << rank << " FINISHED send " << target;
+	// we are going to send complete
+	std::shared_ptr<TxRequest> finReq = finishRequests[target];
+	ps->status = SEND_DONE;
+	send_comp_fn->sendFinishComplete(finReq);
+  } else {
+	// throw an exception and log
+	LOG(FATAL) << "At an un-expected state " << ps->status;
+  }
+}
+
+void MPIChannel::sendHeader(int target, PendingSend *ps) {
+  std::shared_ptr<TxRequest> r = ps->pendingData.front();
   // put the length to the buffer
-  x.second->headerBuf[0] = r->length;
-  x.second->headerBuf[1] = 0;
+  ps->headerBuf[0] = r->length;
+  ps->headerBuf[1] = 0;
 
   // copy the memory of the header
   if (r->headerLength > 0) {
-	memcpy(&(x.second->headerBuf[2]), &(r->header[0]), r->headerLength * sizeof(int));
+	memcpy(&(ps->headerBuf[2]), &(r->header[0]), r->headerLength * sizeof(int));
   }
-  // LOG(INFO) << rank << " Sent length to " << r->target << " addr: " << x.second->headerBuf << " len: " << r->headerLength + 2;
+  // LOG(INFO) << rank << " Sent length to " << r->target << " addr: " << ps->headerBuf << " len: " << r->headerLength + 2;
   // we have to add 2 to the header length
-  MPI_Isend(&(x.second->headerBuf[0]), 2 + r->headerLength, MPI_INT,
-			x.first, edge, MPI_COMM_WORLD, &(x.second->request));
-  x.second->status = SEND_LENGTH_POSTED;
+  MPI_Isend(&(ps->headerBuf[0]), 2 + r->headerLength, MPI_INT,
+			target, edge, comm, &sendRequests[ps->index]);
+  if (metrics != nullptr) {
+	metrics->Peer(target).channel_messages_sent++;
+  }
+  ps->status = SEND_LENGTH_POSTED;
 }
 
-void MPIChannel::sendFinishHeader(const std::pair<const int, PendingSend *> &x) const {
+void MPIChannel::sendFinishHeader(int target, PendingSend *ps) {
   // for the last header we always send only the first 2 integers
-  x.second->headerBuf[0] = 0;
-  x.second->headerBuf[1] = TWISTERX_MSG_FIN;
-  // LOG(INFO) << rank << " Sent finish to " << x.first;
-  MPI_Isend(&(x.second->headerBuf[0]), 2, MPI_INT, x.first, edge, MPI_COMM_WORLD, &(x.second->request));
-  x.second->status = SEND_FINISH;
+  ps->headerBuf[0] = 0;
+  ps->headerBuf[1] = TWISTERX_MSG_FIN;
+  // LOG(INFO) << rank << " Sent finish to " << target;
+  MPI_Isend(&(ps->headerBuf[0]), 2, MPI_INT, target, edge, comm, &sendRequests[ps->index]);
+  if (metrics != nullptr) {
+	metrics->Peer(target).channel_messages_sent++;
+  }
+  ps->status = SEND_FINISH;
+}
+
+void MPIChannel::setMetrics(const std::shared_ptr<EdgeMetrics> &m) {
+  metrics = m;
+}
+
+bool MPIChannel::reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send_fn) {
+  for (auto &s : sends) {
+	if (s.second->status != SEND_DONE || !s.second->pendingData.empty()) {
+	  return false;
+	}
+  }
+  for (auto &r : pendingReceives) {
+	if (r.second->status != RECEIVED_FIN) {
+	  return false;
+	}
+  }
+  rcv_fn = rcv;
+  send_comp_fn = send_fn;
+  finishRequests.clear();
+  readySends.clear();
+  for (auto &s : sends) {
+	s.second->status = SEND_INIT;
+	s.second->ready = false;
+  }
+  // the header receives stopped at the finish, so the messages of the next operation were not taken
+  for (auto &r : pendingReceives) {
+	PendingReceive *pr = r.second;
+	std::fill_n(pr->headerBuf, TWISTERX_CHANNEL_HEADER_SIZE, 0);
+	receiveRequests[pr->index] = pr->headerRequest;
+	MPI_Start(&receiveRequests[pr->index]);
+	pr->status = RECEIVE_LENGTH_POSTED;
+  }
+  return true;
 }
 
 void MPIChannel::close() {
   for (auto &pendingReceive : pendingReceives) {
-	delete (pendingReceive.second);
+	PendingReceive *pr = pendingReceive.second;
+	if (pr->status == RECEIVE_LENGTH_POSTED) {
+	  // the header receive is still active, cancel it before freeing
+	  MPI_Cancel(&pr->headerRequest);
+	  MPI_Wait(&pr->headerRequest, MPI_STATUS_IGNORE);
+	}
+	if (pr->headerRequest != MPI_REQUEST_NULL) {
+	  MPI_Request_free(&pr->headerRequest);
+	}
+	delete (pr);
   }
   pendingReceives.clear();
+  receiveSlots.clear();
+  receiveRequests.clear();
 
   for (auto &s : sends) {
 	delete (s.second);
   }
   sends.clear();
+  sendSlots.clear();
+  sendTargets.clear();
+  sendRequests.clear();
+  readySends.clear();
+}
 }
-}
\ No newline at end of file
@@ -23,7 +23,7 @@
 #include <mpi.h>
 #include <glog/logging.h>
 
-#define TWISTERX_CHANNEL_HEADER_SIZE 8
+#define TWISTERX_CHANNEL_HEADER_SIZE 10
 #define TWISTERX_MSG_FIN 1
 
 namespace twisterx {
@@ -46,32 +46,46 @@ enum ReceiveStatus {
  * Keep track about the length buffer to receive the length first
  */
 struct PendingSend {
-  //  we allow upto 8 ints for the header
+  //  we allow upto 10 ints for the header
   int headerBuf[TWISTERX_CHANNEL_HEADER_SIZE]{};
   std::queue<std::shared_ptr<TxRequest>> pendingData;
   SendStatus status = SEND_INIT;
-  MPI_Request request{};
+  // index of the request of this target in the send request array
+  int index{};
+  // the target is in the list of sends to be started
+  bool ready = false;
   // the current send, if it is a actual send
   std::shared_ptr<TxRequest> currentSend{};
 };
 
 struct PendingReceive {
-  // we allow upto 8 integer header
+  // we allow upto 10 integer header
   int headerBuf[TWISTERX_CHANNEL_HEADER_SIZE]{};
   int receiveId{};
   void *data{};
   int length{};
   ReceiveStatus status = RECEIVE_INIT;
-  MPI_Request request{};
+  // index of the request of this source in the receive request array
+  int index{};
+  // persistent request used for receiving the headers
+  MPI_Request headerRequest = MPI_REQUEST_NULL;
 };
 
 /**
  * This class implements a MPI channel, when there is a message to be sent,
  * this channel sends a small message with the size of the next message. This allows the other side
- * to post the network buffer to receive the message
+ * to post the network buffer to receive the message.
+ *
+ * The outstanding requests are kept in contiguous arrays and completed in bulk with MPI_Testsome, so
+ * a progress call only touches the peers with completed requests. Headers are received with persistent requests.
  */
 class MPIChannel : public Channel {
  public:
+  /**
+   * Create a channel over the given communicator, the ranks and the tags are those of the communicator
+   */
+  explicit MPIChannel(MPI_Comm comm = MPI_COMM_WORLD);
+
   /**
    * Initialize the channel
    *
@@ -108,8 +122,22 @@ class MPIChannel : public Channel {
 
   void close() override;
 
+  /**
+   * The header receives are started again, the messages of the next operation wait in MPI until then
+   */
+  bool reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+  /**
+   * Records the messages on the wire, the queue depths and the time spent in the progress calls
+   */
+  void setMetrics(const std::shared_ptr<EdgeMetrics> &metrics) override;
+
  private:
   int edge;
+  // the communicator of the channel
+  MPI_Comm comm;
+  // metrics of the operation using the channel, if recording
+  std::shared_ptr<EdgeMetrics> metrics;
   // keep track of the length buffers for each receiver
   std::unordered_map<int, PendingSend *> sends;
   // keep track of the posted receives
@@ -122,18 +150,59 @@ class MPIChannel : public Channel {
   ChannelSendCallback *send_comp_fn;
   // mpi rank
   int rank;
+  // the outstanding send requests, one for each target
+  std::vector<MPI_Request> sendRequests;
+  // the targets in the order of the send requests
+  std::vector<PendingSend *> sendSlots;
+  std::vector<int> sendTargets;
+  // the outstanding receive requests, one for each source
+  std::vector<MPI_Request> receiveRequests;
+  // the sources in the order of the receive requests
+  std::vector<PendingReceive *> receiveSlots;
+  // the idle targets that have something to send
+  std::vector<int> readySends;
+  // buffers for the indices completed by MPI_Testsome
+  std::vector<int> completedIndices;
+  std::vector<MPI_Status> completedStatuses;
+
+  /**
+   * Start the ready sends and complete the finished send requests
+   */
+  void progressSendRequests();
+
+  /**
+   * Mark the target as having something to send, so that the next progress starts the send
+   */
+  void markReady(int target);
+
+  /**
+   * Start sending the next message or the finish to an idle target
+   */
+  void startSend(int target, PendingSend *ps);
+
+  /**
+   * Drive the state of a target after its send request completed
+   */
+  void sendCompleted(int target, PendingSend *ps);
+
+  /**
+   * Drive the state of a source after its receive request completed
+   */
+  void receiveCompleted(PendingReceive *pr, MPI_Status *status);
 
   /**
    * Send finish request
-   * @param x the target, pendingSend pair
+   * @param target the target
+   * @param ps the pending send of the target
    */
-  void sendFinishHeader(const std::pair<const int, PendingSend *> &x) const;
+  void sendFinishHeader(int target, PendingSend *ps);
 
   /**
    * Send the length
-   * @param x the target, pendingSend pair
+   * @param target the target
+   * @param ps the pending send of the target
    */
-  void sendHeader(const std::pair<const int, PendingSend *> &x) const;
+  void sendHeader(int target, PendingSend *ps);
 };
 }
 
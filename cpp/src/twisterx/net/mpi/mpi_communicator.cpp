@@ -16,6 +16,13 @@
 #include "mpi.h"
 #include "mpi_communicator.h"
 #include "mpi_channel.hpp"
+#include "../shm/shm_channel.hpp"
+#include "../composite_channel.hpp"
+#include "../../util/uuid.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
 namespace twisterx {
 namespace net {
@@ -32,7 +39,10 @@ CommType MPIConfig::Type() {
 }
 
 Channel *MPICommunicator::CreateChannel() {
-  return new MPIChannel();
+  if (shm_enabled) {
+    return new CompositeChannel(new ShmChannel(job_id, this->rank), new MPIChannel(comm), local_ranks);
+  }
+  return new MPIChannel(comm);
 }
 
 int MPICommunicator::GetRank() {
@@ -50,15 +60,155 @@ void MPICommunicator::Init(CommConfig *config) {
     LOG(INFO) << "MPI is already initialized";
   }
 
-  MPI_Comm_rank(MPI_COMM_WORLD, &this->rank);
-  MPI_Comm_size(MPI_COMM_WORLD, &this->world_size);
+  MPI_Comm_rank(comm, &this->rank);
+  MPI_Comm_size(comm, &this->world_size);
+
+  DetectLocalRanks();
+}
+
+void MPICommunicator::DetectLocalRanks() {
+  MPI_Comm node_comm;
+  MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, this->rank, MPI_INFO_NULL, &node_comm);
+  int node_size;
+  MPI_Comm_size(node_comm, &node_size);
+  std::vector<int> node_ranks(node_size);
+  MPI_Allgather(&this->rank, 1, MPI_INT, node_ranks.data(), 1, MPI_INT, node_comm);
+  MPI_Comm_free(&node_comm);
+  local_ranks = std::unordered_set<int>(node_ranks.begin(), node_ranks.end());
+
+  // the shared memory channel can be disabled by setting TWISTERX_SHM=0
+  const char *shm_env = std::getenv("TWISTERX_SHM");
+  bool disabled = shm_env != nullptr && strcmp(shm_env, "0") == 0;
+  shm_enabled = !disabled && node_size > 1;
+
+  // all the ranks need the same job id to find the segments
+  char id_buf[37] = {};
+  if (this->rank == 0) {
+    std::string id = twisterx::util::uuid::generate_uuid_v4();
+    strncpy(id_buf, id.c_str(), sizeof(id_buf) - 1);
+  }
+  MPI_Bcast(id_buf, sizeof(id_buf), MPI_CHAR, 0, comm);
+  job_id = std::string(id_buf);
+  LOG(INFO) << "Rank " << this->rank << " shares the host with " << node_size << " ranks, shared memory "
+            << (shm_enabled ? "enabled" : "disabled");
 }
 void MPICommunicator::Finalize() {
+  if (comm != MPI_COMM_WORLD) {
+    // a sub communicator, MPI is finalized with the world
+    MPI_Comm_free(&comm);
+    return;
+  }
   LOG(INFO) << "Finalizing MPI";
   MPI_Finalize();
 }
 void MPICommunicator::Barrier() {
-  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Barrier(comm);
+}
+
+static MPI_Datatype GetMPIType(Type::type type) {
+  switch (type) {
+    case Type::UINT8:return MPI_UINT8_T;
+    case Type::INT8:return MPI_INT8_T;
+    case Type::UINT16:return MPI_UINT16_T;
+    case Type::INT16:return MPI_INT16_T;
+    case Type::UINT32:return MPI_UINT32_T;
+    case Type::INT32:return MPI_INT32_T;
+    case Type::UINT64:return MPI_UINT64_T;
+    case Type::INT64:return MPI_INT64_T;
+    case Type::FLOAT:return MPI_FLOAT;
+    case Type::DOUBLE:return MPI_DOUBLE;
+    default:LOG(FATAL) << "Un-supported type for reduce " << type;
+      return MPI_DATATYPE_NULL;
+  }
+}
+
+static MPI_Op GetMPIOp(ReduceOp op) {
+  switch (op) {
+    case SUM:return MPI_SUM;
+    case MIN:return MPI_MIN;
+    case MAX:return MPI_MAX;
+    case PROD:return MPI_PROD;
+  }
+  return MPI_OP_NULL;
+}
+
+/**
+ * Compute the displacements of the variable sized buffers
+ */
+static std::vector<int> Displacements(const std::vector<int> &counts, int *total) {
+  std::vector<int> displacements(counts.size(), 0);
+  *total = 0;
+  for (size_t i = 0; i < counts.size(); i++) {
+    displacements[i] = *total;
+    *total += counts[i];
+  }
+  return displacements;
+}
+
+void MPICommunicator::Broadcast(std::vector<uint8_t> *buffer, int root) {
+  int64_t length = buffer->size();
+  MPI_Bcast(&length, 1, MPI_INT64_T, root, comm);
+  buffer->resize(length);
+  MPI_Bcast(buffer->data(), static_cast<int>(length), MPI_BYTE, root, comm);
+}
+
+void MPICommunicator::Gather(const std::vector<uint8_t> &send, int root, std::vector<std::vector<uint8_t>> *recv) {
+  int length = static_cast<int>(send.size());
+  std::vector<int> counts(this->world_size, 0);
+  MPI_Gather(&length, 1, MPI_INT, counts.data(), 1, MPI_INT, root, comm);
+  int total = 0;
+  std::vector<int> displacements = Displacements(counts, &total);
+  std::vector<uint8_t> gathered(this->rank == root ? total : 0);
+  MPI_Gatherv(send.data(), length, MPI_BYTE, gathered.data(), counts.data(), displacements.data(), MPI_BYTE,
+              root, comm);
+  if (this->rank == root) {
+    recv->clear();
+    for (int i = 0; i < this->world_size; i++) {
+      recv->emplace_back(gathered.begin() + displacements[i], gathered.begin() + displacements[i] + counts[i]);
+    }
+  }
+}
+
+void MPICommunicator::AllGather(const std::vector<uint8_t> &send, std::vector<std::vector<uint8_t>> *recv) {
+  int length = static_cast<int>(send.size());
+  std::vector<int> counts(this->world_size, 0);
+  MPI_Allgather(&length, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+  int total = 0;
+  std::vector<int> displacements = Displacements(counts, &total);
+  std::vector<uint8_t> gathered(total);
+  MPI_Allgatherv(send.data(), length, MPI_BYTE, gathered.data(), counts.data(), displacements.data(), MPI_BYTE,
+                 comm);
+  recv->clear();
+  for (int i = 0; i < this->world_size; i++) {
+    recv->emplace_back(gathered.begin() + displacements[i], gathered.begin() + displacements[i] + counts[i]);
+  }
+}
+
+void MPICommunicator::Reduce(const void *send, void *recv, int count, Type::type type, ReduceOp op, int root) {
+  MPI_Reduce(send, recv, count, GetMPIType(type), GetMPIOp(op), root, comm);
+}
+
+void MPICommunicator::AllReduce(const void *send, void *recv, int count, Type::type type, ReduceOp op) {
+  MPI_Allreduce(send, recv, count, GetMPIType(type), GetMPIOp(op), comm);
+}
+Communicator *MPICommunicator::Split(int color, int key) {
+  // the sub communicator takes the node ids from this one
+  GetNodeIds();
+  MPI_Comm sub_comm;
+  MPI_Comm_split(comm, color == TWISTERX_SPLIT_UNDEFINED ? MPI_UNDEFINED : color, key, &sub_comm);
+  if (sub_comm == MPI_COMM_NULL) {
+    return nullptr;
+  }
+  auto sub = new MPICommunicator();
+  sub->comm = sub_comm;
+  MPI_Comm_rank(sub_comm, &sub->rank);
+  MPI_Comm_size(sub_comm, &sub->world_size);
+  std::vector<int> members(sub->world_size);
+  MPI_Allgather(&this->rank, 1, MPI_INT, members.data(), 1, MPI_INT, sub_comm);
+  InheritNodeIds(sub, members);
+  // the shared memory segments are named with the job id, so every sub communicator gets its own
+  sub->DetectLocalRanks();
+  return sub;
+}
 }
 }
-}
\ No newline at end of file
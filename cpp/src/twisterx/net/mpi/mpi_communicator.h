@@ -14,6 +14,9 @@
 
 #ifndef TWISTERX_SRC_TWISTERX_COMM_MPICOMMUNICATOR_H_
 #define TWISTERX_SRC_TWISTERX_COMM_MPICOMMUNICATOR_H_
+#include <string>
+#include <unordered_set>
+#include <mpi.h>
 #include "../comm_config.h"
 #include "../communicator.h"
 namespace twisterx {
@@ -36,6 +39,27 @@ class MPICommunicator : public Communicator {
   int GetWorldSize() override;
   void Finalize() override;
   void Barrier() override;
+  void Broadcast(std::vector<uint8_t> *buffer, int root) override;
+  void Gather(const std::vector<uint8_t> &send, int root, std::vector<std::vector<uint8_t>> *recv) override;
+  void AllGather(const std::vector<uint8_t> &send, std::vector<std::vector<uint8_t>> *recv) override;
+  void Reduce(const void *send, void *recv, int count, Type::type type, ReduceOp op, int root) override;
+  void AllReduce(const void *send, void *recv, int count, Type::type type, ReduceOp op) override;
+  Communicator *Split(int color, int key) override;
+
+ private:
+  // the ranks and the tags of the channels and the collectives belong to this communicator
+  MPI_Comm comm = MPI_COMM_WORLD;
+  // ranks running on the same host as this rank, including this rank
+  std::unordered_set<int> local_ranks;
+  // identifier shared by all the ranks of this job, used to name the shared memory segments
+  std::string job_id;
+  // use the shared memory channel for the local ranks
+  bool shm_enabled = false;
+
+  /**
+   * Find the ranks sharing the host with this rank
+   */
+  void DetectLocalRanks();
 };
 }
 }
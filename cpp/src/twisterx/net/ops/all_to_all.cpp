@@ -13,6 +13,7 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iterator>
 
@@ -20,6 +21,7 @@
 
 #include "all_to_all.hpp"
 #include "../mpi/mpi_channel.hpp"
+#include "hierarchical_all_to_all.hpp"
 
 namespace twisterx {
 AllToAll::AllToAll(twisterx::TwisterXContext *ctx, const std::vector<int> &srcs,
@@ -28,14 +30,27 @@ AllToAll::AllToAll(twisterx::TwisterXContext *ctx, const std::vector<int> &srcs,
   sources = srcs;
   targets = tgts;
   edge = edge_id;
-  channel = ctx->GetCommunicator()->CreateChannel();
-  channel->init(edge_id, srcs, tgts, this, this);
+  pool = ctx->GetChannelPool();
+  channel = pool->Acquire(edge_id, srcs, tgts, this, this);
+  // an operation built on top of us may have opened the metrics of the edge
+  metricsRegistry = ctx->GetMetrics();
+  metrics = metricsRegistry->Current(edge_id);
+  if (metrics == nullptr) {
+	metrics = metricsRegistry->Open(edge_id, "AllToAll");
+	ownsMetrics = metrics != nullptr;
+  }
+  if (ownsMetrics) {
+	metrics->BeginPhase("insert");
+  }
+  channel->setMetrics(metrics);
   callback = rcvCallback;
 
-  // initialize the sends
-  for (int t : tgts) {
-	int tAdjusted = (t + ctx->GetRank()) % targets.size();
-	sends.push_back(new AllToAllSends(tAdjusted));
+  // initialize the sends, each rank starts from a different target to spread the load
+  for (size_t i = 0; i < tgts.size(); i++) {
+	int t = tgts[(i + ctx->GetRank()) % tgts.size()];
+	auto *s = new AllToAllSends(t);
+	sends.push_back(s);
+	sendsByTarget[t] = s;
   }
 
   thisNumTargets = 0;
@@ -49,14 +64,30 @@ AllToAll::AllToAll(twisterx::TwisterXContext *ctx, const std::vector<int> &srcs,
   }
 }
 
+std::shared_ptr<AllToAll> AllToAll::Create(twisterx::TwisterXContext *ctx,
+											const std::vector<int> &srcs,
+											const std::vector<int> &tgts,
+											int edge_id,
+											ReceiveCallback *rcvCallback) {
+  std::string mode = ctx->GetConfig(TWISTERX_ALL_TO_ALL_MODE, TWISTERX_ALL_TO_ALL_FLAT);
+  if (mode == TWISTERX_ALL_TO_ALL_HIERARCHICAL && HierarchicalAllToAll::IsApplicable(ctx, srcs, tgts)) {
+	return std::make_shared<HierarchicalAllToAll>(ctx, srcs, tgts, edge_id, rcvCallback);
+  }
+  return std::make_shared<AllToAll>(ctx, srcs, tgts, edge_id, rcvCallback);
+}
+
 void AllToAll::close() {
-  for (int t : targets) {
-	delete sends[t];
+  for (auto s : sends) {
+	delete s;
   }
   sends.clear();
-  // free the channel
-  channel->close();
-  delete channel;
+  sendsByTarget.clear();
+  channel->setMetrics(nullptr);
+  // the pool keeps the channel for the next operation on the edge, or frees it
+  pool->Release(edge, channel);
+  if (ownsMetrics) {
+	metricsRegistry->Close(metrics);
+  }
 }
 
 int AllToAll::insert(void *buffer, int length, int target) {
@@ -65,7 +96,7 @@ int AllToAll::insert(void *buffer, int length, int target) {
 	return -1;
   }
 
-  AllToAllSends *s = sends[target];
+  AllToAllSends *s = sendsByTarget[target];
   // LOG(INFO) << "Allocating buffer " << length;
   std::shared_ptr<TxRequest> request = std::make_shared<TxRequest>(target, buffer, length);
   s->requestQueue.push(request);
@@ -73,26 +104,47 @@ int AllToAll::insert(void *buffer, int length, int target) {
   return 1;
 }
 
-int AllToAll::insert(void *buffer, int length, int target, int *header, int headerLength) {
+int AllToAll::insert(void *buffer, int length, int target, int *header, int headerLength,
+					 std::shared_ptr<void> owner) {
   if (finishFlag) {
 	// we cannot accept further
 	return -1;
   }
 
-  // we cannot accept headers greater than 6
-  if (headerLength > 6) {
+  // we cannot accept headers greater than 8
+  if (headerLength > 8) {
 	return -1;
   }
 
-  AllToAllSends *s = sends[target];
+  AllToAllSends *s = sendsByTarget[target];
   // LOG(INFO) << "Allocating buffer " << length;
   std::shared_ptr<TxRequest> request = std::make_shared<TxRequest>(target, buffer, length, header, headerLength);
+  request->owner = std::move(owner);
   s->requestQueue.push(request);
   s->messageSizes += length;
+  if (metrics != nullptr) {
+	PeerMetrics &peer = metrics->Peer(target);
+	peer.max_queue_depth = std::max(peer.max_queue_depth, static_cast<int64_t>(s->requestQueue.size()));
+  }
   return 1;
 }
 
 bool AllToAll::isComplete() {
+  if (metrics == nullptr) {
+	return progress();
+  }
+  auto start = std::chrono::steady_clock::now();
+  bool complete = progress();
+  metrics->progress_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+	  std::chrono::steady_clock::now() - start).count();
+  if (complete && !completed && ownsMetrics) {
+	metrics->EndPhase("complete");
+  }
+  completed = complete;
+  return complete;
+}
+
+bool AllToAll::progress() {
   bool allQueuesEmpty = true;
   // if this is a source, send until the operation is finished
   for (auto w : sends) {
@@ -103,10 +155,13 @@ bool AllToAll::isComplete() {
 
 	  std::shared_ptr<TxRequest> request = w->requestQueue.front();
 	  // if the request is accepted to be set, pop
-	  if (channel->send(request)) {
+	  if (channel->send(request) > 0) {
 		w->requestQueue.pop();
 		// we add to the pending queue
 		w->pendingQueue.push(request);
+	  } else {
+		// the channel is full, we try again after progressing it
+		break;
 	  }
 	}
 
@@ -134,19 +189,50 @@ bool AllToAll::isComplete() {
 
 void AllToAll::finish() {
   // here we just set the finish flag to true, the is_complete method will use this flag
+  if (ownsMetrics && !finishFlag) {
+	metrics->EndPhase("insert");
+	metrics->BeginPhase("complete");
+  }
   finishFlag = true;
 }
 
+void AllToAll::recordReceive(int receiveId, int length) {
+  PeerMetrics &peer = metrics->Peer(receiveId);
+  peer.messages_received++;
+  peer.bytes_received += length;
+  if (length == 0) {
+	peer.header_only_received++;
+  }
+}
+
 void AllToAll::receivedData(int receiveId, void *buffer, int length) {
+  if (metrics != nullptr) {
+	recordReceive(receiveId, length);
+  }
   // we just call the callback function of this
   callback->onReceive(receiveId, buffer, length);
 }
 
+void AllToAll::receivedSharedData(int receiveId, void *buffer, int length, const std::shared_ptr<void> &owner) {
+  if (metrics != nullptr) {
+	recordReceive(receiveId, length);
+  }
+  callback->onReceiveShared(receiveId, buffer, length, owner);
+}
+
 void AllToAll::sendComplete(std::shared_ptr<TxRequest> request) {
-  AllToAllSends *s = sends[request->target];
+  AllToAllSends *s = sendsByTarget[request->target];
   s->pendingQueue.pop();
   // we sent this request so we need to reduce memory
   s->messageSizes = s->messageSizes - request->length;
+  if (metrics != nullptr) {
+	PeerMetrics &peer = metrics->Peer(request->target);
+	peer.messages_sent++;
+	peer.bytes_sent += request->length;
+	if (request->length == 0) {
+	  peer.header_only_sent++;
+	}
+  }
   callback->onSendComplete(request->target, request->buffer, request->length);
   // we don't have much to do here, so we delete the request
   // LOG(INFO) << worker_id << " Free buffer " << request->length;
@@ -176,7 +262,7 @@ void AllToAll::receivedHeader(int receiveId, int finished,
 
 void AllToAll::sendFinishComplete(std::shared_ptr<TxRequest> request) {
   finishedTargets.insert(request->target);
-  AllToAllSends *s = sends[request->target];
+  AllToAllSends *s = sendsByTarget[request->target];
   s->sendStatus = ALL_TO_ALL_FINISHED;
   // LOG(INFO) << worker_id << " Free fin buffer " << request->length;
 }
@@ -22,6 +22,13 @@
 #include "../../ctx/twisterx_context.h"
 
 #include "../channel.hpp"
+#include "../channel_pool.hpp"
+#include "../comm_metrics.hpp"
+
+// context config selecting the all to all algorithm
+#define TWISTERX_ALL_TO_ALL_MODE "twisterx.all_to_all.mode"
+#define TWISTERX_ALL_TO_ALL_FLAT "flat"
+#define TWISTERX_ALL_TO_ALL_HIERARCHICAL "hierarchical"
 
 namespace twisterx {
 class ReceiveCallback {
@@ -38,7 +45,7 @@ class ReceiveCallback {
   /**
    * Receive the header, this happens before we receive the actual data
    * @param source the source
-   * @param buffer the header buffer, which can be 6 integers
+   * @param buffer the header buffer, which can be 8 integers
    * @param length the length of the integer array
    * @return true if we accept the header
    */
@@ -52,6 +59,23 @@ class ReceiveCallback {
    * @return
    */
   virtual bool onSendComplete(int target, void *buffer, int length) = 0;
+
+  /**
+   * This function is called when a buffer is received without a copy, the buffer is kept alive by the owner
+   * given to the insert at the sender. By default we copy the buffer and call onReceive
+   * @param source the source
+   * @param buffer the buffer, we don't own it
+   * @param length the length of the buffer
+   * @param owner the owner of the buffer
+   * @return true if we accept this buffer
+   */
+  virtual bool onReceiveShared(int source, void *buffer, int length, const std::shared_ptr<void> &owner) {
+    char *data = new char[length];
+    if (length > 0) {
+      memcpy(data, buffer, length);
+    }
+    return onReceive(source, data, length);
+  }
 };
 
 enum AllToAllSendStatus {
@@ -87,15 +111,29 @@ class AllToAll : public ChannelReceiveCallback, ChannelSendCallback {
 		   int edgeId,
 		   ReceiveCallback *callback);
 
+  /**
+   * Create an all to all using the algorithm configured in the context with TWISTERX_ALL_TO_ALL_MODE,
+   * the flat algorithm is the default
+   */
+  static std::shared_ptr<AllToAll> Create(twisterx::TwisterXContext *ctx,
+										  const std::vector<int> &source,
+										  const std::vector<int> &targets,
+										  int edgeId,
+										  ReceiveCallback *callback);
+
+  virtual ~AllToAll() = default;
+
   /**
    * Insert a buffer to be sent, if the buffer is accepted return true
    *
    * @param buffer the buffer to send
    * @param length the length of the message
    * @param target the target to send the message
+   * @param owner optional owner of the buffer, channels that share memory hand the buffer over without a copy
    * @return true if the buffer is accepted
    */
-  int insert(void *buffer, int length, int target, int *header, int headerLength);
+  virtual int insert(void *buffer, int length, int target, int *header, int headerLength,
+					 std::shared_ptr<void> owner = nullptr);
 
   /**
    * Insert a buffer to be sent, if the buffer is accepted return true
@@ -105,19 +143,19 @@ class AllToAll : public ChannelReceiveCallback, ChannelSendCallback {
    * @param target the target to send the message
    * @return true if the buffer is accepted
    */
-  int insert(void *buffer, int length, int target);
+  virtual int insert(void *buffer, int length, int target);
 
   /**
    * Check weather the operation is complete, this method needs to be called until the operation is complete
    * @return true if the operation is complete
    */
-  bool isComplete();
+  virtual bool isComplete();
 
   /**
    * When this function is called, the operation finishes at both receivers and targets
    * @return
    */
-  void finish();
+  virtual void finish();
 
   /**
    * We implement the receive complete callback from channel
@@ -127,6 +165,11 @@ class AllToAll : public ChannelReceiveCallback, ChannelSendCallback {
    */
   void receivedData(int receiveId, void *buffer, int length) override;
 
+  /**
+   * We implement the shared receive callback from channel
+   */
+  void receivedSharedData(int receiveId, void *buffer, int length, const std::shared_ptr<void> &owner) override;
+
   /**
    * We implement the send callback from channel
    * @param request the original request, we can free it now
@@ -145,20 +188,41 @@ class AllToAll : public ChannelReceiveCallback, ChannelSendCallback {
   /**
    * Close the operation
    */
-  void close();
+  virtual void close();
+ protected:
+  /**
+   * Used by the all to all algorithms built on other all to all operations
+   */
+  AllToAll() = default;
  private:
   void sendFinishComplete(std::shared_ptr<TxRequest> request) override;
 
+  /**
+   * Progress the sends and receives, returns true when the operation is complete
+   */
+  bool progress();
+
+  /**
+   * Count a received message in the metrics
+   */
+  void recordReceive(int receiveId, int length);
+
  private:
   int worker_id;                 // the worker id
   std::vector<int> sources;  // the list of all the workers
   std::vector<int> targets;  // the list of all the workers
   int edge;                  // the edge id we are going to use
   std::vector<AllToAllSends *> sends; // keep track of the sends
+  std::unordered_map<int, AllToAllSends *> sendsByTarget; // the sends of each target
   std::unordered_set<int> finishedSources;  // keep track of  the finished sources
   std::unordered_set<int> finishedTargets;  // keep track of  the finished targets
   bool finishFlag = false;
   Channel *channel;             // the underlying channel
+  ChannelPool *pool;            // gives the channel, and takes it back on close
+  CommMetrics *metricsRegistry = nullptr;  // the metrics of the context
+  std::shared_ptr<EdgeMetrics> metrics; // metrics of this operation, nullptr if not recording
+  bool ownsMetrics = false;     // we opened the metrics, otherwise an operation built on us did
+  bool completed = false;       // we have seen the completion
   ReceiveCallback *callback;    // after we receive a buffer we will call this function
   unsigned long thisNumTargets;            // number of targets in this process, 1 or 0
   int thisNumSources;            // number of sources in this process, 1 or 0
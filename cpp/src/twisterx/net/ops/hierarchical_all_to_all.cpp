@@ -0,0 +1,248 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hierarchical_all_to_all.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <glog/logging.h>
+
+// the edge of the exchange within the node is derived from the edge of the operation
+#define TWISTERX_HIERARCHICAL_EDGE_OFFSET (1 << 18)
+
+namespace twisterx {
+
+HierarchicalStageCallback::HierarchicalStageCallback(HierarchicalAllToAll *parent, bool inter_node)
+    : parent(parent), inter_node(inter_node) {}
+
+bool HierarchicalStageCallback::onReceive(int source, void *buffer, int length) {
+  parent->OnBatch(inter_node, static_cast<const uint8_t *>(buffer), length);
+  delete[] static_cast<char *>(buffer);
+  return true;
+}
+
+bool HierarchicalStageCallback::onReceiveShared(int source, void *buffer, int length,
+                                                const std::shared_ptr<void> &owner) {
+  // the messages are copied out of the batch, so no need to copy the batch itself
+  parent->OnBatch(inter_node, static_cast<const uint8_t *>(buffer), length);
+  return true;
+}
+
+bool HierarchicalStageCallback::onReceiveHeader(int source, int finished, int *buffer, int length) {
+  // batches don't have headers and the finish of the stages are handled by the parent
+  return true;
+}
+
+bool HierarchicalStageCallback::onSendComplete(int target, void *buffer, int length) {
+  // the batch is released with the request
+  return true;
+}
+
+bool HierarchicalAllToAll::IsApplicable(twisterx::TwisterXContext *ctx,
+                                        const std::vector<int> &source,
+                                        const std::vector<int> &targets) {
+  int size = ctx->GetWorldSize();
+  if (size <= 1 || static_cast<int>(source.size()) != size || static_cast<int>(targets.size()) != size) {
+    return false;
+  }
+  std::vector<int> s(source), t(targets);
+  std::sort(s.begin(), s.end());
+  std::sort(t.begin(), t.end());
+  for (int i = 0; i < size; i++) {
+    if (s[i] != i || t[i] != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+HierarchicalAllToAll::HierarchicalAllToAll(twisterx::TwisterXContext *ctx,
+                                           const std::vector<int> &srcs,
+                                           const std::vector<int> &tgts,
+                                           int edge_id,
+                                           ReceiveCallback *rcvCallback)
+    : inter_callback(this, true), intra_callback(this, false) {
+  rank = ctx->GetRank();
+  sources = srcs;
+  callback = rcvCallback;
+  node_ids = ctx->GetCommunicator()->GetNodeIds();
+
+  std::map<int, std::vector<int>> nodes;
+  for (size_t r = 0; r < node_ids.size(); r++) {
+    nodes[node_ids[r]].push_back(static_cast<int>(r));
+  }
+  // the index of a rank within its node
+  std::vector<int> local_index(node_ids.size());
+  for (auto &n : nodes) {
+    for (size_t i = 0; i < n.second.size(); i++) {
+      local_index[n.second[i]] = static_cast<int>(i);
+    }
+  }
+  int my_node = node_ids[rank];
+
+  // we send to the relay of every other node, and receive from the ranks using us as their relay
+  std::vector<int> inter_targets, inter_sources;
+  for (auto &n : nodes) {
+    if (n.first == my_node) {
+      continue;
+    }
+    int relay = n.second[local_index[rank] % n.second.size()];
+    relays[n.first] = relay;
+    inter_targets.push_back(relay);
+    for (int r : n.second) {
+      if (nodes[my_node][local_index[r] % nodes[my_node].size()] == rank) {
+        inter_sources.push_back(r);
+      }
+    }
+  }
+  const std::vector<int> &local_ranks = nodes[my_node];
+
+  inter = std::make_shared<AllToAll>(ctx, inter_sources, inter_targets, edge_id, &inter_callback);
+  intra = std::make_shared<AllToAll>(ctx, local_ranks, local_ranks, edge_id + TWISTERX_HIERARCHICAL_EDGE_OFFSET,
+                                     &intra_callback);
+}
+
+template<typename T>
+static void AppendValue(std::vector<uint8_t> *out, T value) {
+  const auto *p = reinterpret_cast<const uint8_t *>(&value);
+  out->insert(out->end(), p, p + sizeof(T));
+}
+
+void HierarchicalAllToAll::Append(std::unordered_map<int, HierarchicalBatch> *batches, int hop, int source,
+                                  int target, const int *header, int headerLength, const uint8_t *buffer,
+                                  int length) {
+  // a message is [source, target, header length, header..., length, data]
+  HierarchicalBatch &batch = (*batches)[hop];
+  AppendValue<int32_t>(&batch.data, source);
+  AppendValue<int32_t>(&batch.data, target);
+  AppendValue<int32_t>(&batch.data, headerLength);
+  for (int i = 0; i < headerLength; i++) {
+    AppendValue<int32_t>(&batch.data, header[i]);
+  }
+  AppendValue<int32_t>(&batch.data, length);
+  if (length > 0) {
+    batch.data.insert(batch.data.end(), buffer, buffer + length);
+  }
+  batch.messages++;
+}
+
+void HierarchicalAllToAll::Flush(std::unordered_map<int, HierarchicalBatch> *batches, AllToAll *stage) {
+  for (auto &b : *batches) {
+    if (b.second.messages == 0) {
+      continue;
+    }
+    // the request owns the batch until it is sent
+    auto data = std::make_shared<std::vector<uint8_t>>(std::move(b.second.data));
+    stage->insert(data->data(), static_cast<int>(data->size()), b.first, nullptr, 0, data);
+    b.second.data = std::vector<uint8_t>();
+    b.second.messages = 0;
+  }
+}
+
+void HierarchicalAllToAll::OnBatch(bool inter_node, const uint8_t *data, int length) {
+  int pos = 0;
+  int32_t header[8];
+  while (pos < length) {
+    int32_t source, target, header_length, data_length;
+    memcpy(&source, data + pos, sizeof(int32_t));
+    memcpy(&target, data + pos + 4, sizeof(int32_t));
+    memcpy(&header_length, data + pos + 8, sizeof(int32_t));
+    pos += 12;
+    if (header_length > 8) {
+      LOG(FATAL) << "Un-expected header length " << header_length;
+    }
+    memcpy(header, data + pos, header_length * sizeof(int32_t));
+    pos += header_length * sizeof(int32_t);
+    memcpy(&data_length, data + pos, sizeof(int32_t));
+    pos += 4;
+    const uint8_t *message = data + pos;
+    pos += data_length;
+
+    if (target == rank) {
+      callback->onReceiveHeader(source, 0, header_length > 0 ? header : nullptr, header_length);
+      // the receiver owns the buffer
+      char *buf = new char[data_length];
+      if (data_length > 0) {
+        memcpy(buf, message, data_length);
+      }
+      callback->onReceive(source, buf, data_length);
+    } else if (inter_node) {
+      // we are the relay, forward to the target in our node
+      Append(&intra_batches, target, source, target, header, header_length, message, data_length);
+    } else {
+      LOG(FATAL) << "Received a message for " << target << " within the node";
+    }
+  }
+}
+
+int HierarchicalAllToAll::insert(void *buffer, int length, int target, int *header, int headerLength,
+                                 std::shared_ptr<void> owner) {
+  if (finish_flag || headerLength > 8) {
+    return -1;
+  }
+  int node = node_ids[target];
+  if (node == node_ids[rank]) {
+    Append(&intra_batches, target, rank, target, header, headerLength, static_cast<const uint8_t *>(buffer), length);
+  } else {
+    Append(&inter_batches, relays[node], rank, target, header, headerLength,
+           static_cast<const uint8_t *>(buffer), length);
+  }
+  // the buffer is copied to the batch, so we are done with it
+  callback->onSendComplete(target, buffer, length);
+  return 1;
+}
+
+int HierarchicalAllToAll::insert(void *buffer, int length, int target) {
+  return insert(buffer, length, target, nullptr, 0);
+}
+
+bool HierarchicalAllToAll::isComplete() {
+  if (completed) {
+    return true;
+  }
+  Flush(&inter_batches, inter.get());
+  if (finish_flag && !inter_finished) {
+    inter->finish();
+    inter_finished = true;
+  }
+  bool inter_done = inter->isComplete();
+
+  // forward what we got from the other nodes, along with our own messages to this node
+  Flush(&intra_batches, intra.get());
+  if (inter_done && finish_flag && !intra_finished) {
+    // nothing more comes from the other nodes
+    intra->finish();
+    intra_finished = true;
+  }
+  bool intra_done = intra->isComplete();
+
+  if (inter_done && intra_done && intra_finished) {
+    for (int s : sources) {
+      callback->onReceiveHeader(s, 1, nullptr, 0);
+    }
+    completed = true;
+  }
+  return completed;
+}
+
+void HierarchicalAllToAll::finish() {
+  finish_flag = true;
+}
+
+void HierarchicalAllToAll::close() {
+  inter->close();
+  intra->close();
+}
+}
@@ -0,0 +1,122 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_NET_OPS_HIERARCHICAL_ALL_TO_ALL_HPP_
+#define TWISTERX_SRC_TWISTERX_NET_OPS_HIERARCHICAL_ALL_TO_ALL_HPP_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "all_to_all.hpp"
+
+namespace twisterx {
+
+/**
+ * A batch of messages going to the next hop
+ */
+struct HierarchicalBatch {
+  std::vector<uint8_t> data;
+  int messages{};
+};
+
+class HierarchicalAllToAll;
+
+/**
+ * Receives the batches of one of the stages
+ */
+class HierarchicalStageCallback : public ReceiveCallback {
+ public:
+  HierarchicalStageCallback(HierarchicalAllToAll *parent, bool inter_node);
+
+  bool onReceive(int source, void *buffer, int length) override;
+
+  bool onReceiveShared(int source, void *buffer, int length, const std::shared_ptr<void> &owner) override;
+
+  bool onReceiveHeader(int source, int finished, int *buffer, int length) override;
+
+  bool onSendComplete(int target, void *buffer, int length) override;
+
+ private:
+  HierarchicalAllToAll *parent;
+  bool inter_node;
+};
+
+/**
+ * A node aware all to all. Every rank is paired with one rank on each of the other nodes, the relay, which has the
+ * same index within its node. Messages to another node are batched into a single message to the relay on that node,
+ * the relay then forwards them to the targets within its node, again in batches. A rank talks to one rank per node
+ * plus the ranks of its own node, instead of every rank, and exchanges fewer and larger messages between nodes.
+ *
+ * The messages are copied into the batches, so this pays off for large world sizes with small messages.
+ */
+class HierarchicalAllToAll : public AllToAll {
+ public:
+  HierarchicalAllToAll(twisterx::TwisterXContext *ctx,
+                       const std::vector<int> &source,
+                       const std::vector<int> &targets,
+                       int edgeId,
+                       ReceiveCallback *callback);
+
+  /**
+   * We need all the ranks as the sources and the targets
+   */
+  static bool IsApplicable(twisterx::TwisterXContext *ctx,
+                           const std::vector<int> &source,
+                           const std::vector<int> &targets);
+
+  int insert(void *buffer, int length, int target, int *header, int headerLength,
+             std::shared_ptr<void> owner = nullptr) override;
+
+  int insert(void *buffer, int length, int target) override;
+
+  bool isComplete() override;
+
+  void finish() override;
+
+  void close() override;
+
+ private:
+  friend class HierarchicalStageCallback;
+
+  int rank;
+  std::vector<int> sources;
+  ReceiveCallback *callback;
+  // node of every rank
+  std::vector<int> node_ids;
+  // the relay on each node
+  std::unordered_map<int, int> relays;
+  HierarchicalStageCallback inter_callback;
+  HierarchicalStageCallback intra_callback;
+  // exchange between the nodes
+  std::shared_ptr<AllToAll> inter;
+  // exchange within the node
+  std::shared_ptr<AllToAll> intra;
+  // batches waiting to be sent to the next hop
+  std::unordered_map<int, HierarchicalBatch> inter_batches;
+  std::unordered_map<int, HierarchicalBatch> intra_batches;
+  bool finish_flag = false;
+  bool inter_finished = false;
+  bool intra_finished = false;
+  bool completed = false;
+
+  void Append(std::unordered_map<int, HierarchicalBatch> *batches, int hop, int source, int target,
+              const int *header, int headerLength, const uint8_t *buffer, int length);
+
+  void Flush(std::unordered_map<int, HierarchicalBatch> *batches, AllToAll *stage);
+
+  void OnBatch(bool inter_node, const uint8_t *data, int length);
+};
+}
+
+#endif //TWISTERX_SRC_TWISTERX_NET_OPS_HIERARCHICAL_ALL_TO_ALL_HPP_
@@ -0,0 +1,292 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shm_channel.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+#include <glog/logging.h>
+
+namespace twisterx {
+
+/**
+ * Map the named segment, the segment is created if it doesn't exist. A newly created segment is zero filled,
+ * which is an empty ring, so both sides can open it in any order
+ */
+static void OpenSegment(const std::string &name, ShmSegment *segment) {
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    LOG(FATAL) << "Failed to open shared memory segment " << name << " : " << strerror(errno);
+  }
+  size_t size = sizeof(ShmRing) + TWISTERX_SHM_RING_SIZE;
+  if (ftruncate(fd, size) != 0) {
+    LOG(FATAL) << "Failed to size shared memory segment " << name << " : " << strerror(errno);
+  }
+  void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    LOG(FATAL) << "Failed to map shared memory segment " << name << " : " << strerror(errno);
+  }
+  segment->name = name;
+  segment->ring = static_cast<ShmRing *>(addr);
+  segment->data = static_cast<uint8_t *>(addr) + sizeof(ShmRing);
+  segment->mapSize = size;
+}
+
+static void CloseSegment(ShmSegment *segment, bool unlink) {
+  if (segment->ring != nullptr) {
+    munmap(segment->ring, segment->mapSize);
+    segment->ring = nullptr;
+    segment->data = nullptr;
+  }
+  if (unlink) {
+    shm_unlink(segment->name.c_str());
+  }
+}
+
+static size_t RingFree(const ShmSegment &segment) {
+  uint64_t head = segment.ring->head.load(std::memory_order_relaxed);
+  uint64_t tail = segment.ring->tail.load(std::memory_order_acquire);
+  return TWISTERX_SHM_RING_SIZE - (head - tail);
+}
+
+static size_t RingAvailable(const ShmSegment &segment) {
+  uint64_t head = segment.ring->head.load(std::memory_order_acquire);
+  uint64_t tail = segment.ring->tail.load(std::memory_order_relaxed);
+  return head - tail;
+}
+
+/**
+ * Write as much as possible from the buffer to the ring
+ * @return number of bytes written
+ */
+static size_t RingWrite(const ShmSegment &segment, const uint8_t *buf, size_t length) {
+  size_t n = std::min(length, RingFree(segment));
+  if (n == 0) {
+    return 0;
+  }
+  uint64_t head = segment.ring->head.load(std::memory_order_relaxed);
+  size_t pos = head % TWISTERX_SHM_RING_SIZE;
+  size_t first = std::min(n, TWISTERX_SHM_RING_SIZE - pos);
+  memcpy(segment.data + pos, buf, first);
+  memcpy(segment.data, buf + first, n - first);
+  segment.ring->head.store(head + n, std::memory_order_release);
+  return n;
+}
+
+/**
+ * Read as much as possible from the ring to the buffer
+ * @return number of bytes read
+ */
+static size_t RingRead(const ShmSegment &segment, uint8_t *buf, size_t length) {
+  size_t n = std::min(length, RingAvailable(segment));
+  if (n == 0) {
+    return 0;
+  }
+  uint64_t tail = segment.ring->tail.load(std::memory_order_relaxed);
+  size_t pos = tail % TWISTERX_SHM_RING_SIZE;
+  size_t first = std::min(n, TWISTERX_SHM_RING_SIZE - pos);
+  memcpy(buf, segment.data + pos, first);
+  memcpy(buf + first, segment.data, n - first);
+  segment.ring->tail.store(tail + n, std::memory_order_release);
+  return n;
+}
+
+ShmChannel::ShmChannel(std::string job_id, int rank) : job_id(std::move(job_id)), rank(rank) {}
+
+std::string ShmChannel::SegmentName(int source, int target) const {
+  return "/twx_" + job_id + "_" + std::to_string(edge) + "_" + std::to_string(source) + "_" + std::to_string(target);
+}
+
+void ShmChannel::init(int ed, const std::vector<int> &receives, const std::vector<int> &sendIds,
+                      ChannelReceiveCallback *rcv, ChannelSendCallback *send_fn) {
+  edge = ed;
+  rcv_fn = rcv;
+  send_comp_fn = send_fn;
+
+  for (int source : receives) {
+    auto *buf = new ShmPendingReceive();
+    buf->receiveId = source;
+    OpenSegment(SegmentName(source, rank), &buf->segment);
+    pendingReceives.insert(std::pair<int, ShmPendingReceive *>(source, buf));
+  }
+
+  for (int target : sendIds) {
+    auto *ps = new ShmPendingSend();
+    OpenSegment(SegmentName(rank, target), &ps->segment);
+    sends[target] = ps;
+  }
+}
+
+int ShmChannel::send(std::shared_ptr<TxRequest> request) {
+  ShmPendingSend *ps = sends[request->target];
+  if (ps->pendingData.size() > 1000) {
+    return -1;
+  }
+  ps->pendingData.push(request);
+  return 1;
+}
+
+int ShmChannel::sendFin(std::shared_ptr<TxRequest> request) {
+  if (finishRequests.find(request->target) != finishRequests.end()) {
+    return -1;
+  }
+  finishRequests.insert(std::pair<int, std::shared_ptr<TxRequest>>(request->target, request));
+  return 1;
+}
+
+void ShmChannel::progressSend(int target, ShmPendingSend *ps) {
+  while (true) {
+    if (ps->status == SHM_SEND_INIT) {
+      // we only write a header when it fits completely
+      if (RingFree(ps->segment) < sizeof(ShmMessageHeader)) {
+        return;
+      }
+      ShmMessageHeader header{};
+      if (!ps->pendingData.empty()) {
+        std::shared_ptr<TxRequest> r = ps->pendingData.front();
+        header.length = r->length;
+        header.fin = 0;
+        header.headerLength = r->headerLength;
+        if (r->headerLength > 0) {
+          memcpy(&header.header[0], &r->header[0], r->headerLength * sizeof(int));
+        }
+        RingWrite(ps->segment, reinterpret_cast<const uint8_t *>(&header), sizeof(ShmMessageHeader));
+        ps->pendingData.pop();
+        ps->currentSend = r;
+        ps->sentBytes = 0;
+        ps->status = SHM_SEND_POSTED;
+      } else if (finishRequests.find(target) != finishRequests.end()) {
+        header.fin = TWISTERX_SHM_MSG_FIN;
+        RingWrite(ps->segment, reinterpret_cast<const uint8_t *>(&header), sizeof(ShmMessageHeader));
+        ps->status = SHM_SEND_DONE;
+        send_comp_fn->sendFinishComplete(finishRequests[target]);
+        return;
+      } else {
+        return;
+      }
+    } else if (ps->status == SHM_SEND_POSTED) {
+      std::shared_ptr<TxRequest> r = ps->currentSend;
+      const uint8_t *buf = static_cast<const uint8_t *>(r->buffer);
+      ps->sentBytes += RingWrite(ps->segment, buf + ps->sentBytes, r->length - ps->sentBytes);
+      if (ps->sentBytes < r->length) {
+        // the ring is full, we continue in the next call
+        return;
+      }
+      ps->currentSend = {};
+      ps->status = SHM_SEND_INIT;
+      send_comp_fn->sendComplete(r);
+    } else {
+      return;
+    }
+  }
+}
+
+void ShmChannel::progressSends() {
+  for (auto x : sends) {
+    progressSend(x.first, x.second);
+  }
+}
+
+void ShmChannel::progressReceives() {
+  for (auto x : pendingReceives) {
+    ShmPendingReceive *pr = x.second;
+    bool progress = true;
+    while (progress) {
+      progress = false;
+      if (pr->status == SHM_RECEIVE_HEADER) {
+        if (RingAvailable(pr->segment) < sizeof(ShmMessageHeader)) {
+          break;
+        }
+        ShmMessageHeader header{};
+        RingRead(pr->segment, reinterpret_cast<uint8_t *>(&header), sizeof(ShmMessageHeader));
+        if (header.fin == TWISTERX_SHM_MSG_FIN) {
+          // we are not expecting to receive any more
+          pr->status = SHM_RECEIVED_FIN;
+          rcv_fn->receivedHeader(x.first, header.fin, nullptr, 0);
+          break;
+        }
+        if (header.headerLength > TWISTERX_SHM_HEADER_SIZE) {
+          LOG(FATAL) << "Un-expected header length " << header.headerLength;
+        }
+        pr->data = new char[header.length];
+        pr->length = header.length;
+        pr->receivedBytes = 0;
+        pr->status = SHM_RECEIVE_DATA;
+        int *user_header = nullptr;
+        if (header.headerLength > 0) {
+          user_header = new int[header.headerLength];
+          memcpy(user_header, &header.header[0], header.headerLength * sizeof(int));
+        }
+        rcv_fn->receivedHeader(x.first, header.fin, user_header, header.headerLength);
+        progress = true;
+      } else if (pr->status == SHM_RECEIVE_DATA) {
+        pr->receivedBytes += RingRead(pr->segment, reinterpret_cast<uint8_t *>(pr->data) + pr->receivedBytes,
+                                      pr->length - pr->receivedBytes);
+        if (pr->receivedBytes < pr->length) {
+          break;
+        }
+        pr->status = SHM_RECEIVE_HEADER;
+        rcv_fn->receivedData(x.first, pr->data, pr->length);
+        pr->data = nullptr;
+        progress = true;
+      }
+    }
+  }
+}
+
+bool ShmChannel::reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send_fn) {
+  for (auto &s : sends) {
+    if (s.second->status != SHM_SEND_DONE || !s.second->pendingData.empty()) {
+      return false;
+    }
+  }
+  for (auto &r : pendingReceives) {
+    if (r.second->status != SHM_RECEIVED_FIN) {
+      return false;
+    }
+  }
+  rcv_fn = rcv;
+  send_comp_fn = send_fn;
+  finishRequests.clear();
+  for (auto &s : sends) {
+    s.second->status = SHM_SEND_INIT;
+  }
+  for (auto &r : pendingReceives) {
+    r.second->status = SHM_RECEIVE_HEADER;
+  }
+  return true;
+}
+
+void ShmChannel::close() {
+  for (auto &pendingReceive : pendingReceives) {
+    // the receiver owns the segment
+    CloseSegment(&pendingReceive.second->segment, true);
+    delete (pendingReceive.second);
+  }
+  pendingReceives.clear();
+
+  for (auto &s : sends) {
+    CloseSegment(&s.second->segment, false);
+    delete (s.second);
+  }
+  sends.clear();
+}
+}
@@ -0,0 +1,159 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SHM_CHANNEL_H
+#define TWISTERX_SHM_CHANNEL_H
+
+#include "../channel.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <queue>
+
+// size of the ring buffer used for each sender, receiver pair
+#define TWISTERX_SHM_RING_SIZE (1 << 20)
+// maximum number of integers in a user header
+#define TWISTERX_SHM_HEADER_SIZE 8
+#define TWISTERX_SHM_MSG_FIN 1
+
+namespace twisterx {
+
+/**
+ * The control block at the start of a shared memory segment. The producer only writes the head and the
+ * consumer only writes the tail, both are ever increasing byte counts
+ */
+struct ShmRing {
+  std::atomic<uint64_t> head;
+  char headPad[56];
+  std::atomic<uint64_t> tail;
+  char tailPad[56];
+};
+
+/**
+ * Every message written to the ring starts with this header, followed by the data
+ */
+struct ShmMessageHeader {
+  int32_t length;
+  int32_t fin;
+  int32_t headerLength;
+  int32_t header[TWISTERX_SHM_HEADER_SIZE];
+};
+
+/**
+ * A shared memory segment mapped into this process
+ */
+struct ShmSegment {
+  std::string name;
+  ShmRing *ring{};
+  uint8_t *data{};
+  size_t mapSize{};
+};
+
+enum ShmSendStatus {
+  SHM_SEND_INIT = 0,
+  SHM_SEND_POSTED = 1,
+  SHM_SEND_DONE = 2
+};
+
+enum ShmReceiveStatus {
+  SHM_RECEIVE_HEADER = 0,
+  SHM_RECEIVE_DATA = 1,
+  SHM_RECEIVED_FIN = 2
+};
+
+struct ShmPendingSend {
+  ShmSegment segment;
+  std::queue<std::shared_ptr<TxRequest>> pendingData;
+  ShmSendStatus status = SHM_SEND_INIT;
+  // the current send and the number of bytes already written to the ring
+  std::shared_ptr<TxRequest> currentSend{};
+  int sentBytes{};
+};
+
+struct ShmPendingReceive {
+  ShmSegment segment;
+  int receiveId{};
+  char *data{};
+  int length{};
+  int receivedBytes{};
+  ShmReceiveStatus status = SHM_RECEIVE_HEADER;
+};
+
+/**
+ * This class implements a channel for ranks running on the same host. Each sender, receiver pair
+ * uses a single producer single consumer ring buffer in POSIX shared memory. Messages are copied into the
+ * ring by the sender and streamed out by the receiver, so messages larger than the ring are supported.
+ *
+ * The receiver owns the segments and removes them when the channel is closed.
+ */
+class ShmChannel : public Channel {
+ public:
+  /**
+   * Create the channel
+   * @param job_id an identifier unique to this job, shared by all the ranks
+   * @param rank the rank of this process
+   */
+  ShmChannel(std::string job_id, int rank);
+
+  void init(int edge, const std::vector<int> &receives, const std::vector<int> &sendIds,
+            ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+  int send(std::shared_ptr<TxRequest> request) override;
+
+  int sendFin(std::shared_ptr<TxRequest> request) override;
+
+  /**
+   * Write the pending messages to the ring buffers as space permits
+   */
+  void progressSends() override;
+
+  /**
+   * Read the available messages from the ring buffers
+   */
+  void progressReceives() override;
+
+  void close() override;
+
+  /**
+   * The segments stay mapped, the messages of the next operation wait in the rings until then
+   */
+  bool reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+ private:
+  std::string job_id;
+  int rank;
+  int edge{};
+  // keep track of the sends for each target
+  std::unordered_map<int, ShmPendingSend *> sends;
+  // keep track of the receives for each source
+  std::unordered_map<int, ShmPendingReceive *> pendingReceives;
+  // we got finish requests
+  std::unordered_map<int, std::shared_ptr<TxRequest>> finishRequests;
+  // receive callback function
+  ChannelReceiveCallback *rcv_fn{};
+  // send complete callback function
+  ChannelSendCallback *send_comp_fn{};
+
+  std::string SegmentName(int source, int target) const;
+
+  /**
+   * Progress the send to a target until the ring is full or there is nothing to send
+   */
+  void progressSend(int target, ShmPendingSend *ps);
+};
+}
+
+#endif //TWISTERX_SHM_CHANNEL_H
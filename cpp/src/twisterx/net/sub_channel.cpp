@@ -0,0 +1,139 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sub_channel.hpp"
+#include "communicator.h"
+
+#include <glog/logging.h>
+#include <utility>
+
+namespace twisterx {
+
+SubChannel::SubChannel(Channel *channel, std::vector<int> ranks, int split_id)
+    : channel(channel), ranks(std::move(ranks)), split_id(split_id) {
+  for (size_t i = 0; i < this->ranks.size(); i++) {
+    sub_ranks[this->ranks[i]] = static_cast<int>(i);
+  }
+}
+
+int SubChannel::ParentEdge(int edge, int split_id) {
+  int base = 0;
+  if (edge >= TWISTERX_COLLECTIVE_EDGE_BASE) {
+    base = TWISTERX_COLLECTIVE_EDGE_BASE;
+    edge -= TWISTERX_COLLECTIVE_EDGE_BASE;
+  }
+  if (edge >= (1 << TWISTERX_SUB_COMM_EDGE_BITS)) {
+    LOG(FATAL) << "Edge " << edge << " is too large for a sub communicator";
+  }
+  return base + (split_id << TWISTERX_SUB_COMM_EDGE_BITS) + edge;
+}
+
+void SubChannel::init(int edge, const std::vector<int> &receives, const std::vector<int> &sendIds,
+                      ChannelReceiveCallback *rcv, ChannelSendCallback *send) {
+  rcv_fn = rcv;
+  send_fn = send;
+  std::vector<int> parent_receives, parent_sends;
+  for (int r : receives) {
+    parent_receives.push_back(ranks[r]);
+  }
+  for (int s : sendIds) {
+    parent_sends.push_back(ranks[s]);
+  }
+  channel->init(ParentEdge(edge, split_id), parent_receives, parent_sends, this, this);
+}
+
+int SubChannel::Forward(const std::shared_ptr<TxRequest> &request, bool fin) {
+  std::shared_ptr<TxRequest> parent;
+  if (fin) {
+    parent = std::make_shared<TxRequest>(ranks[request->target]);
+  } else {
+    parent = std::make_shared<TxRequest>(ranks[request->target], request->buffer, request->length,
+                                         request->header, request->headerLength);
+    parent->owner = request->owner;
+  }
+  // the parent may complete the request before returning
+  requests[parent.get()] = request;
+  int ret = fin ? channel->sendFin(parent) : channel->send(parent);
+  if (ret <= 0) {
+    requests.erase(parent.get());
+  }
+  return ret;
+}
+
+std::shared_ptr<TxRequest> SubChannel::Original(const std::shared_ptr<TxRequest> &request) {
+  auto it = requests.find(request.get());
+  std::shared_ptr<TxRequest> original = it->second;
+  requests.erase(it);
+  return original;
+}
+
+int SubChannel::send(std::shared_ptr<TxRequest> request) {
+  return Forward(request, false);
+}
+
+int SubChannel::sendFin(std::shared_ptr<TxRequest> request) {
+  return Forward(request, true);
+}
+
+void SubChannel::progressSends() {
+  channel->progressSends();
+}
+
+void SubChannel::progressReceives() {
+  channel->progressReceives();
+}
+
+void SubChannel::close() {
+  channel->close();
+  requests.clear();
+}
+
+bool SubChannel::reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send) {
+  if (!requests.empty()) {
+    return false;
+  }
+  rcv_fn = rcv;
+  send_fn = send;
+  return channel->reuse(this, this);
+}
+
+void SubChannel::setMetrics(const std::shared_ptr<EdgeMetrics> &metrics) {
+  // the metrics are recorded with the ranks of the parent
+  channel->setMetrics(metrics);
+}
+
+SubChannel::~SubChannel() {
+  delete channel;
+}
+
+void SubChannel::receivedData(int receiveId, void *buffer, int length) {
+  rcv_fn->receivedData(sub_ranks[receiveId], buffer, length);
+}
+
+void SubChannel::receivedHeader(int receiveId, int finished, int *header, int headerLength) {
+  rcv_fn->receivedHeader(sub_ranks[receiveId], finished, header, headerLength);
+}
+
+void SubChannel::receivedSharedData(int receiveId, void *buffer, int length, const std::shared_ptr<void> &owner) {
+  rcv_fn->receivedSharedData(sub_ranks[receiveId], buffer, length, owner);
+}
+
+void SubChannel::sendComplete(std::shared_ptr<TxRequest> request) {
+  send_fn->sendComplete(Original(request));
+}
+
+void SubChannel::sendFinishComplete(std::shared_ptr<TxRequest> request) {
+  send_fn->sendFinishComplete(Original(request));
+}
+}
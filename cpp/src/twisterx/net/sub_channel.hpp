@@ -0,0 +1,95 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_NET_SUB_CHANNEL_HPP_
+#define TWISTERX_SRC_TWISTERX_NET_SUB_CHANNEL_HPP_
+
+#include "channel.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+// the low bits of an edge of the parent are the edge in the sub communicator, the next bits the id of the split
+#define TWISTERX_SUB_COMM_EDGE_BITS 20
+#define TWISTERX_SUB_COMM_MAX_SPLITS ((1 << (30 - TWISTERX_SUB_COMM_EDGE_BITS)) - 1)
+
+namespace twisterx {
+
+/**
+ * A channel of a sub communicator built on a channel of the parent communicator. The ranks of the sub communicator
+ * are translated to the ranks of the parent, and the edges are moved to a range reserved for the split, so the
+ * sub communicators don't receive each others messages. The sub channel owns the parent channel.
+ */
+class SubChannel : public Channel, public ChannelReceiveCallback, public ChannelSendCallback {
+ public:
+  /**
+   * Create the channel
+   * @param channel the channel of the parent communicator
+   * @param ranks the rank in the parent communicator of every rank of the sub communicator
+   * @param split_id the id of the split creating the sub communicator
+   */
+  SubChannel(Channel *channel, std::vector<int> ranks, int split_id);
+
+  /**
+   * Map an edge of a sub communicator to an edge of the parent communicator
+   */
+  static int ParentEdge(int edge, int split_id);
+
+  void init(int edge, const std::vector<int> &receives, const std::vector<int> &sendIds,
+            ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+  int send(std::shared_ptr<TxRequest> request) override;
+
+  int sendFin(std::shared_ptr<TxRequest> request) override;
+
+  void progressSends() override;
+
+  void progressReceives() override;
+
+  void close() override;
+
+  bool reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+  void setMetrics(const std::shared_ptr<EdgeMetrics> &metrics) override;
+
+  ~SubChannel() override;
+
+  void receivedData(int receiveId, void *buffer, int length) override;
+
+  void receivedHeader(int receiveId, int finished, int *header, int headerLength) override;
+
+  void receivedSharedData(int receiveId, void *buffer, int length, const std::shared_ptr<void> &owner) override;
+
+  void sendComplete(std::shared_ptr<TxRequest> request) override;
+
+  void sendFinishComplete(std::shared_ptr<TxRequest> request) override;
+
+ private:
+  Channel *channel;
+  std::vector<int> ranks;
+  // rank in the sub communicator of the parent ranks
+  std::unordered_map<int, int> sub_ranks;
+  int split_id;
+  ChannelReceiveCallback *rcv_fn{};
+  ChannelSendCallback *send_fn{};
+  // the requests given to us, keyed by the translated requests given to the parent channel
+  std::unordered_map<TxRequest *, std::shared_ptr<TxRequest>> requests;
+
+  int Forward(const std::shared_ptr<TxRequest> &request, bool fin);
+
+  std::shared_ptr<TxRequest> Original(const std::shared_ptr<TxRequest> &request);
+};
+}
+
+#endif //TWISTERX_SRC_TWISTERX_NET_SUB_CHANNEL_HPP_
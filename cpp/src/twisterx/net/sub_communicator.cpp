@@ -0,0 +1,78 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sub_communicator.h"
+#include "sub_channel.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <glog/logging.h>
+
+namespace twisterx {
+namespace net {
+
+SubCommunicator::SubCommunicator(Communicator *parent, std::vector<int> ranks, int split_id)
+    : parent(parent), ranks(std::move(ranks)), split_id(split_id) {
+  int parent_rank = parent->GetRank();
+  this->rank = static_cast<int>(std::find(this->ranks.begin(), this->ranks.end(), parent_rank) - this->ranks.begin());
+  this->world_size = static_cast<int>(this->ranks.size());
+  // wrap the collective edges within the edge bits of the split, see SubChannel::ParentEdge
+  this->collective_edges = 1 << TWISTERX_SUB_COMM_EDGE_BITS;
+  if (split_id > TWISTERX_SUB_COMM_MAX_SPLITS) {
+    LOG(FATAL) << "Too many sub communicators, the limit is " << TWISTERX_SUB_COMM_MAX_SPLITS;
+  }
+}
+
+void SubCommunicator::Init(CommConfig *config) {
+  // created by the parent
+}
+
+Channel *SubCommunicator::CreateChannel() {
+  return new SubChannel(parent->CreateChannel(), ranks, split_id);
+}
+
+int SubCommunicator::GetRank() {
+  return this->rank;
+}
+
+int SubCommunicator::GetWorldSize() {
+  return this->world_size;
+}
+
+void SubCommunicator::Finalize() {
+  // the parent owns the transport
+}
+
+void SubCommunicator::Barrier() {
+  int32_t send = 0, recv = 0;
+  AllReduce(&send, &recv, 1, Type::INT32, SUM);
+}
+
+Communicator *SubCommunicator::Split(int color, int key) {
+  std::vector<int> members;
+  // the splits of the sub communicators share the edge ranges of the parent, so they share the sequence
+  int id = SplitGroup(color, key, &parent->split_sequence, &members);
+  if (members.empty()) {
+    return nullptr;
+  }
+  std::vector<int> parent_ranks;
+  for (int m : members) {
+    parent_ranks.push_back(ranks[m]);
+  }
+  auto sub = new SubCommunicator(parent, parent_ranks, id);
+  InheritNodeIds(sub, members);
+  return sub;
+}
+}
+}
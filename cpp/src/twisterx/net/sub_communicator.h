@@ -0,0 +1,55 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_NET_SUB_COMMUNICATOR_H_
+#define TWISTERX_SRC_TWISTERX_NET_SUB_COMMUNICATOR_H_
+
+#include <vector>
+#include "communicator.h"
+
+namespace twisterx {
+namespace net {
+
+/**
+ * A sub communicator over the channels of a parent communicator, used by the communicators without a native split.
+ * Channels and collectives run over the parent channels with the ranks and the edges translated, see SubChannel.
+ * The parent must outlive the sub communicator.
+ */
+class SubCommunicator : public Communicator {
+ public:
+  /**
+   * Create the sub communicator
+   * @param parent the communicator with the channels, never a sub communicator
+   * @param ranks the rank in the parent of every rank of the sub communicator
+   * @param split_id the id of the split creating the sub communicator
+   */
+  SubCommunicator(Communicator *parent, std::vector<int> ranks, int split_id);
+
+  void Init(CommConfig *config) override;
+  Channel *CreateChannel() override;
+  int GetRank() override;
+  int GetWorldSize() override;
+  void Finalize() override;
+  void Barrier() override;
+  Communicator *Split(int color, int key) override;
+
+ private:
+  Communicator *parent;
+  std::vector<int> ranks;
+  int split_id;
+};
+}
+}
+
+#endif //TWISTERX_SRC_TWISTERX_NET_SUB_COMMUNICATOR_H_
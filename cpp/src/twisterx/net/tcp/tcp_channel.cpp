@@ -0,0 +1,125 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tcp_channel.hpp"
+
+#include <cstring>
+
+namespace twisterx {
+
+TCPChannel::TCPChannel(net::TCPTransport *transport) : transport(transport) {}
+
+void TCPChannel::init(int ed, const std::vector<int> &receives, const std::vector<int> &sendIds,
+                      ChannelReceiveCallback *rcv, ChannelSendCallback *send_fn) {
+  edge = ed;
+  rcv_fn = rcv;
+  send_comp_fn = send_fn;
+  sources = std::unordered_set<int>(receives.begin(), receives.end());
+  for (int target : sendIds) {
+    pendingSends[target] = 0;
+  }
+  transport->Register(edge, this);
+}
+
+int TCPChannel::send(std::shared_ptr<TxRequest> request) {
+  int &pending = pendingSends[request->target];
+  if (pending > 1000) {
+    return -1;
+  }
+  pending++;
+  transport->Post(request->target, edge, request, false, this);
+  return 1;
+}
+
+int TCPChannel::sendFin(std::shared_ptr<TxRequest> request) {
+  if (finishRequests.find(request->target) != finishRequests.end()) {
+    return -1;
+  }
+  finishRequests.insert(std::pair<int, std::shared_ptr<TxRequest>>(request->target, request));
+  // the frames to a target are written in order, so the finish goes after the data
+  transport->Post(request->target, edge, request, true, this);
+  return 1;
+}
+
+void TCPChannel::progressSends() {
+  transport->Progress();
+}
+
+void TCPChannel::progressReceives() {
+  // deliver the frames that arrived before the channel was reused
+  size_t deferred = deferredFrames.size();
+  for (size_t i = 0; i < deferred; i++) {
+    auto frame = deferredFrames.front();
+    deferredFrames.pop_front();
+    FrameReceived(frame.first, frame.second.first, frame.second.second);
+  }
+  transport->Progress();
+}
+
+void TCPChannel::FrameReceived(int source, const net::TCPFrameHeader &header, char *data) {
+  if (finishedSources.find(source) != finishedSources.end()) {
+    // the source moved on to the next operation on this edge
+    deferredFrames.emplace_back(source, std::make_pair(header, data));
+    return;
+  }
+  if (header.fin == TWISTERX_TCP_MSG_FIN) {
+    finishedSources.insert(source);
+    delete[] data;
+    rcv_fn->receivedHeader(source, header.fin, nullptr, 0);
+    return;
+  }
+  int *user_header = nullptr;
+  if (header.headerLength > 0) {
+    user_header = new int[header.headerLength];
+    memcpy(user_header, header.header, header.headerLength * sizeof(int));
+  }
+  rcv_fn->receivedHeader(source, header.fin, user_header, header.headerLength);
+  rcv_fn->receivedData(source, data, header.length);
+}
+
+void TCPChannel::FrameSent(int target, const std::shared_ptr<TxRequest> &request, bool fin) {
+  if (fin) {
+    finishesSent++;
+    send_comp_fn->sendFinishComplete(request);
+  } else {
+    pendingSends[target]--;
+    send_comp_fn->sendComplete(request);
+  }
+}
+
+bool TCPChannel::reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send_fn) {
+  if (finishesSent != pendingSends.size() || finishedSources.size() != sources.size()) {
+    return false;
+  }
+  for (auto &p : pendingSends) {
+    if (p.second != 0) {
+      return false;
+    }
+  }
+  rcv_fn = rcv;
+  send_comp_fn = send_fn;
+  finishRequests.clear();
+  finishesSent = 0;
+  finishedSources.clear();
+  return true;
+}
+
+void TCPChannel::close() {
+  transport->Unregister(edge);
+  for (auto &frame : deferredFrames) {
+    delete[] frame.second.second;
+  }
+  deferredFrames.clear();
+}
+}
@@ -0,0 +1,81 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_TCP_CHANNEL_H
+#define TWISTERX_TCP_CHANNEL_H
+
+#include "../channel.hpp"
+#include "tcp_transport.hpp"
+
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace twisterx {
+
+/**
+ * A channel over the TCP connections of the TCPCommunicator. It follows the same protocol as the MPIChannel,
+ * a header with the length and the user header is sent before the data and a finish header is sent at the end.
+ * The header and the data are written together with writev.
+ */
+class TCPChannel : public Channel, public net::TCPEdgeHandler {
+ public:
+  explicit TCPChannel(net::TCPTransport *transport);
+
+  void init(int edge, const std::vector<int> &receives, const std::vector<int> &sendIds,
+            ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+  int send(std::shared_ptr<TxRequest> request) override;
+
+  int sendFin(std::shared_ptr<TxRequest> request) override;
+
+  void progressSends() override;
+
+  void progressReceives() override;
+
+  void close() override;
+
+  /**
+   * Frames of the next operation arriving before this call are kept by the channel and delivered after it
+   */
+  bool reuse(ChannelReceiveCallback *rcv, ChannelSendCallback *send) override;
+
+  void FrameReceived(int source, const net::TCPFrameHeader &header, char *data) override;
+
+  void FrameSent(int target, const std::shared_ptr<TxRequest> &request, bool fin) override;
+
+ private:
+  net::TCPTransport *transport;
+  int edge{};
+  // number of sends queued to each target
+  std::unordered_map<int, int> pendingSends;
+  // we got finish requests
+  std::unordered_map<int, std::shared_ptr<TxRequest>> finishRequests;
+  // number of finish frames written
+  size_t finishesSent{};
+  // the ranks we receive from
+  std::unordered_set<int> sources;
+  // sources that sent the finish, what comes after belongs to the next operation on the edge
+  std::unordered_set<int> finishedSources;
+  // frames of the next operation received before the channel is reused
+  std::deque<std::pair<int, std::pair<net::TCPFrameHeader, char *>>> deferredFrames;
+  // receive callback function
+  ChannelReceiveCallback *rcv_fn{};
+  // send complete callback function
+  ChannelSendCallback *send_comp_fn{};
+};
+}
+
+#endif //TWISTERX_TCP_CHANNEL_H
@@ -0,0 +1,211 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tcp_communicator.h"
+#include "tcp_channel.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <glog/logging.h>
+
+namespace twisterx {
+namespace net {
+
+TCPConfig::TCPConfig() {
+  const char *env = std::getenv("TWISTERX_RANK");
+  if (env != nullptr) {
+    rank = std::atoi(env);
+  }
+  env = std::getenv("TWISTERX_WORLD_SIZE");
+  if (env != nullptr) {
+    world_size = std::atoi(env);
+  }
+  env = std::getenv("TWISTERX_PEERS");
+  if (env != nullptr) {
+    std::stringstream ss(env);
+    std::string peer;
+    while (std::getline(ss, peer, ',')) {
+      if (!peer.empty()) {
+        peers.push_back(peer);
+      }
+    }
+  }
+  env = std::getenv("TWISTERX_RENDEZVOUS_DIR");
+  if (env != nullptr) {
+    rendezvous_dir = env;
+  }
+  env = std::getenv("TWISTERX_HOST");
+  if (env != nullptr) {
+    host = env;
+  }
+}
+
+void TCPConfig::SetRank(int r) {
+  this->rank = r;
+}
+void TCPConfig::SetWorldSize(int size) {
+  this->world_size = size;
+}
+void TCPConfig::SetPeers(const std::vector<std::string> &p) {
+  this->peers = p;
+}
+void TCPConfig::SetRendezvousDir(const std::string &dir) {
+  this->rendezvous_dir = dir;
+}
+void TCPConfig::SetHost(const std::string &h) {
+  this->host = h;
+}
+int TCPConfig::GetRank() const {
+  return this->rank;
+}
+int TCPConfig::GetWorldSize() const {
+  return this->world_size;
+}
+const std::vector<std::string> &TCPConfig::GetPeers() const {
+  return this->peers;
+}
+const std::string &TCPConfig::GetRendezvousDir() const {
+  return this->rendezvous_dir;
+}
+const std::string &TCPConfig::GetHost() const {
+  return this->host;
+}
+CommType TCPConfig::Type() {
+  return CommType::TCP;
+}
+
+/**
+ * Create a socket listening on the port, 0 picks a free port
+ * @return the socket
+ */
+static int Listen(int port, int backlog, int *bound_port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    LOG(FATAL) << "Failed to create a socket: " << strerror(errno);
+  }
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+    LOG(FATAL) << "Failed to bind to port " << port << ": " << strerror(errno);
+  }
+  if (listen(fd, backlog) != 0) {
+    LOG(FATAL) << "Failed to listen: " << strerror(errno);
+  }
+  socklen_t len = sizeof(addr);
+  getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len);
+  *bound_port = ntohs(addr.sin_port);
+  return fd;
+}
+
+void TCPCommunicator::Init(CommConfig *config) {
+  auto *tcp_config = static_cast<TCPConfig *>(config);
+  this->rank = tcp_config->GetRank();
+  this->world_size = tcp_config->GetWorldSize();
+  if (this->rank < 0 || this->world_size <= 0 || this->rank >= this->world_size) {
+    LOG(FATAL) << "Invalid rank " << this->rank << " for world size " << this->world_size
+               << ", set TWISTERX_RANK and TWISTERX_WORLD_SIZE";
+  }
+
+  std::vector<std::string> addresses = tcp_config->GetPeers();
+  int port = 0;
+  if (!addresses.empty()) {
+    if (static_cast<int>(addresses.size()) != this->world_size) {
+      LOG(FATAL) << "Expected " << this->world_size << " peers, found " << addresses.size();
+    }
+    const std::string &own = addresses[this->rank];
+    port = std::atoi(own.substr(own.rfind(':') + 1).c_str());
+  } else if (tcp_config->GetRendezvousDir().empty()) {
+    LOG(FATAL) << "Either the peers or the rendezvous directory should be set";
+  }
+
+  int bound_port = 0;
+  int listen_fd = Listen(port, this->world_size, &bound_port);
+  if (addresses.empty()) {
+    addresses = Rendezvous(tcp_config->GetRendezvousDir(),
+                           tcp_config->GetHost() + ":" + std::to_string(bound_port));
+  }
+
+  transport = new TCPTransport(this->rank, this->world_size);
+  transport->Connect(listen_fd, addresses);
+  ::close(listen_fd);
+  LOG(INFO) << "Rank " << this->rank << " connected to " << this->world_size - 1 << " peers";
+}
+
+std::vector<std::string> TCPCommunicator::Rendezvous(const std::string &dir, const std::string &address) {
+  // write to a temporary file and rename, so the others never see a partial file
+  rendezvous_file = dir + "/rank_" + std::to_string(this->rank);
+  std::string tmp = rendezvous_file + ".tmp";
+  {
+    std::ofstream out(tmp);
+    out << address;
+  }
+  if (std::rename(tmp.c_str(), rendezvous_file.c_str()) != 0) {
+    LOG(FATAL) << "Failed to publish the address to " << rendezvous_file << ": " << strerror(errno);
+  }
+
+  std::vector<std::string> addresses(this->world_size);
+  for (int i = 0; i < this->world_size; i++) {
+    std::string file = dir + "/rank_" + std::to_string(i);
+    while (true) {
+      std::ifstream in(file);
+      if (in.good() && std::getline(in, addresses[i]) && !addresses[i].empty()) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+  }
+  return addresses;
+}
+
+Channel *TCPCommunicator::CreateChannel() {
+  return new TCPChannel(transport);
+}
+
+int TCPCommunicator::GetRank() {
+  return this->rank;
+}
+int TCPCommunicator::GetWorldSize() {
+  return this->world_size;
+}
+void TCPCommunicator::Finalize() {
+  LOG(INFO) << "Finalizing TCP";
+  // make sure every rank is done with the connections before closing them
+  transport->Barrier();
+  if (!rendezvous_file.empty()) {
+    std::remove(rendezvous_file.c_str());
+  }
+  transport->Close();
+  delete transport;
+  transport = nullptr;
+}
+void TCPCommunicator::Barrier() {
+  transport->Barrier();
+}
+}
+}
@@ -0,0 +1,84 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_NET_TCP_TCP_COMMUNICATOR_H_
+#define TWISTERX_SRC_TWISTERX_NET_TCP_TCP_COMMUNICATOR_H_
+
+#include <string>
+#include <vector>
+#include "../comm_config.h"
+#include "../communicator.h"
+#include "tcp_transport.hpp"
+
+namespace twisterx {
+namespace net {
+
+/**
+ * Configurations for the TCP communicator. The defaults are read from the environment
+ *
+ * TWISTERX_RANK the rank of this process
+ * TWISTERX_WORLD_SIZE number of processes
+ * TWISTERX_PEERS comma separated host:port of every rank, ordered by the rank
+ * TWISTERX_RENDEZVOUS_DIR a directory shared by the ranks, used when the peers are not given. Each rank
+ *   writes its address to this directory, it should be unique to the job
+ * TWISTERX_HOST the address published to the rendezvous directory, defaults to 127.0.0.1
+ */
+class TCPConfig : public CommConfig {
+ public:
+  TCPConfig();
+
+  void SetRank(int rank);
+  void SetWorldSize(int world_size);
+  void SetPeers(const std::vector<std::string> &peers);
+  void SetRendezvousDir(const std::string &dir);
+  void SetHost(const std::string &host);
+
+  int GetRank() const;
+  int GetWorldSize() const;
+  const std::vector<std::string> &GetPeers() const;
+  const std::string &GetRendezvousDir() const;
+  const std::string &GetHost() const;
+
+  CommType Type() override;
+
+ private:
+  int rank = -1;
+  int world_size = -1;
+  std::vector<std::string> peers;
+  std::string rendezvous_dir;
+  std::string host = "127.0.0.1";
+};
+
+class TCPCommunicator : public Communicator {
+ public:
+  void Init(CommConfig *config) override;
+  Channel *CreateChannel() override;
+  int GetRank() override;
+  int GetWorldSize() override;
+  void Finalize() override;
+  void Barrier() override;
+
+ private:
+  TCPTransport *transport{};
+  // the file we published to the rendezvous directory
+  std::string rendezvous_file;
+
+  /**
+   * Publish our address to the rendezvous directory and wait for the addresses of the other ranks
+   */
+  std::vector<std::string> Rendezvous(const std::string &dir, const std::string &address);
+};
+}
+}
+#endif //TWISTERX_SRC_TWISTERX_NET_TCP_TCP_COMMUNICATOR_H_
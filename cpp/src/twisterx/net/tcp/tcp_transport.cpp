@@ -0,0 +1,419 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tcp_transport.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <glog/logging.h>
+
+namespace twisterx {
+namespace net {
+
+static void SplitAddress(const std::string &address, std::string *host, std::string *port) {
+  size_t pos = address.rfind(':');
+  if (pos == std::string::npos) {
+    LOG(FATAL) << "Invalid address, expected host:port " << address;
+  }
+  *host = address.substr(0, pos);
+  *port = address.substr(pos + 1);
+}
+
+static void ReadFully(int fd, void *buf, size_t length) {
+  auto *p = static_cast<char *>(buf);
+  while (length > 0) {
+    ssize_t n = ::read(fd, p, length);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG(FATAL) << "Failed to read from the socket: " << strerror(errno);
+    }
+    p += n;
+    length -= n;
+  }
+}
+
+static void WriteFully(int fd, const void *buf, size_t length) {
+  auto *p = static_cast<const char *>(buf);
+  while (length > 0) {
+    ssize_t n = ::write(fd, p, length);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG(FATAL) << "Failed to write to the socket: " << strerror(errno);
+    }
+    p += n;
+    length -= n;
+  }
+}
+
+/**
+ * Connect to the address, the peer may not be listening yet so we retry for a while
+ */
+static int ConnectTo(const std::string &address) {
+  std::string host, port;
+  SplitAddress(address, &host, &port);
+  for (int attempt = 0; attempt < 600; attempt++) {
+    struct addrinfo hints{};
+    struct addrinfo *res = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) == 0) {
+      int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+      if (fd >= 0 && ::connect(fd, res->ai_addr, res->ai_addrlen) == 0) {
+        freeaddrinfo(res);
+        return fd;
+      }
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      freeaddrinfo(res);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  LOG(FATAL) << "Failed to connect to " << address;
+  return -1;
+}
+
+TCPTransport::TCPTransport(int rank, int world_size) : rank(rank), world_size(world_size), peers(world_size) {}
+
+void TCPTransport::Connect(int listen_fd, const std::vector<std::string> &addresses) {
+  // connect to the lower ranks and tell them who we are
+  for (int i = 0; i < rank; i++) {
+    int fd = ConnectTo(addresses[i]);
+    int32_t me = rank;
+    WriteFully(fd, &me, sizeof(me));
+    peers[i].fd = fd;
+  }
+  // accept the higher ranks
+  for (int i = rank + 1; i < world_size; i++) {
+    int fd = ::accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      LOG(FATAL) << "Failed to accept a connection: " << strerror(errno);
+    }
+    int32_t remote = -1;
+    ReadFully(fd, &remote, sizeof(remote));
+    if (remote <= rank || remote >= world_size || peers[remote].fd != -1) {
+      LOG(FATAL) << "Un-expected connection from rank " << remote;
+    }
+    peers[remote].fd = fd;
+  }
+
+  epoll_fd = epoll_create1(0);
+  if (epoll_fd < 0) {
+    LOG(FATAL) << "Failed to create epoll: " << strerror(errno);
+  }
+  for (int i = 0; i < world_size; i++) {
+    if (i == rank) {
+      continue;
+    }
+    int fd = peers[i].fd;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = static_cast<uint32_t>(i);
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      LOG(FATAL) << "Failed to register the socket with epoll: " << strerror(errno);
+    }
+  }
+}
+
+void TCPTransport::Register(int edge, TCPEdgeHandler *handler) {
+  handlers[edge] = handler;
+}
+
+void TCPTransport::Unregister(int edge) {
+  handlers.erase(edge);
+}
+
+void TCPTransport::Post(int target, int edge, const std::shared_ptr<TxRequest> &request, bool fin,
+                        TCPEdgeHandler *handler) {
+  auto *frame = new TCPOutFrame();
+  frame->header.edge = edge;
+  frame->header.fin = fin ? TWISTERX_TCP_MSG_FIN : 0;
+  if (!fin && request != nullptr) {
+    frame->header.length = request->length;
+    frame->header.headerLength = request->headerLength;
+    if (request->headerLength > 0) {
+      memcpy(frame->header.header, request->header, request->headerLength * sizeof(int));
+    }
+  }
+  frame->request = request;
+  frame->fin = fin;
+  frame->handler = handler;
+  peers[target].outFrames.push_back(frame);
+}
+
+void TCPTransport::SetWriteInterest(int target, bool enable) {
+  struct epoll_event ev{};
+  ev.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+  ev.data.u32 = static_cast<uint32_t>(target);
+  epoll_ctl(epoll_fd, EPOLL_CTL_MOD, peers[target].fd, &ev);
+  peers[target].writeBlocked = enable;
+}
+
+void TCPTransport::Flush(int target) {
+  TCPPeer &peer = peers[target];
+  if (target == rank) {
+    // messages to ourselves don't go through a socket
+    while (!peer.outFrames.empty()) {
+      TCPOutFrame *frame = peer.outFrames.front();
+      peer.outFrames.pop_front();
+      char *data = new char[frame->header.length];
+      if (frame->header.length > 0) {
+        memcpy(data, frame->request->buffer, frame->header.length);
+      }
+      Dispatch(rank, frame->header, data);
+      if (frame->handler != nullptr) {
+        frame->handler->FrameSent(target, frame->request, frame->fin);
+      }
+      delete frame;
+    }
+    return;
+  }
+
+  while (!peer.outFrames.empty()) {
+    // gather as many frames as possible to a single writev
+    struct iovec iov[TWISTERX_TCP_MAX_IOV];
+    int iov_count = 0;
+    for (size_t f = 0; f < peer.outFrames.size() && iov_count + 2 <= TWISTERX_TCP_MAX_IOV; f++) {
+      TCPOutFrame *frame = peer.outFrames[f];
+      size_t written = frame->written;
+      if (written < sizeof(TCPFrameHeader)) {
+        iov[iov_count].iov_base = reinterpret_cast<char *>(&frame->header) + written;
+        iov[iov_count].iov_len = sizeof(TCPFrameHeader) - written;
+        iov_count++;
+        written = 0;
+      } else {
+        written -= sizeof(TCPFrameHeader);
+      }
+      if (frame->header.length > 0) {
+        iov[iov_count].iov_base = static_cast<char *>(frame->request->buffer) + written;
+        iov[iov_count].iov_len = frame->header.length - written;
+        iov_count++;
+      }
+    }
+
+    ssize_t n = ::writev(peer.fd, iov, iov_count);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // wait for epoll to tell us the socket is writable
+        SetWriteInterest(target, true);
+        return;
+      }
+      LOG(FATAL) << "Failed to write to rank " << target << ": " << strerror(errno);
+    }
+
+    // complete the frames that are fully written
+    auto remaining = static_cast<size_t>(n);
+    while (remaining > 0) {
+      TCPOutFrame *frame = peer.outFrames.front();
+      size_t frame_size = sizeof(TCPFrameHeader) + frame->header.length;
+      size_t left = frame_size - frame->written;
+      if (remaining < left) {
+        frame->written += remaining;
+        break;
+      }
+      remaining -= left;
+      peer.outFrames.pop_front();
+      if (frame->handler != nullptr) {
+        frame->handler->FrameSent(target, frame->request, frame->fin);
+      }
+      delete frame;
+    }
+  }
+  if (peer.writeBlocked) {
+    SetWriteInterest(target, false);
+  }
+}
+
+void TCPTransport::Read(int source) {
+  TCPPeer &peer = peers[source];
+  while (true) {
+    ssize_t n;
+    if (peer.inStatus == TCP_RECEIVE_HEADER) {
+      n = ::read(peer.fd, reinterpret_cast<char *>(&peer.inHeader) + peer.inHeaderBytes,
+                 sizeof(TCPFrameHeader) - peer.inHeaderBytes);
+    } else {
+      n = ::read(peer.fd, peer.inData + peer.inDataBytes, peer.inHeader.length - peer.inDataBytes);
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return;
+      }
+      LOG(FATAL) << "Failed to read from rank " << source << ": " << strerror(errno);
+    }
+    if (n == 0) {
+      if (peer.inStatus == TCP_RECEIVE_HEADER && peer.inHeaderBytes == 0) {
+        // the peer closed after a complete frame, this happens at the finalize
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, peer.fd, nullptr);
+        return;
+      }
+      LOG(FATAL) << "Connection closed by rank " << source << " in the middle of a message";
+    }
+
+    if (peer.inStatus == TCP_RECEIVE_HEADER) {
+      peer.inHeaderBytes += n;
+      if (peer.inHeaderBytes < sizeof(TCPFrameHeader)) {
+        continue;
+      }
+      if (peer.inHeader.headerLength > TWISTERX_TCP_HEADER_SIZE || peer.inHeader.length < 0) {
+        LOG(FATAL) << "Un-expected frame from rank " << source;
+      }
+      peer.inHeaderBytes = 0;
+      peer.inData = new char[peer.inHeader.length];
+      peer.inDataBytes = 0;
+      peer.inStatus = TCP_RECEIVE_DATA;
+    } else {
+      peer.inDataBytes += n;
+    }
+
+    if (peer.inStatus == TCP_RECEIVE_DATA && peer.inDataBytes == static_cast<size_t>(peer.inHeader.length)) {
+      char *data = peer.inData;
+      peer.inData = nullptr;
+      peer.inStatus = TCP_RECEIVE_HEADER;
+      Dispatch(source, peer.inHeader, data);
+    }
+  }
+}
+
+void TCPTransport::Dispatch(int source, const TCPFrameHeader &header, char *data) {
+  if (header.edge == TWISTERX_TCP_BARRIER_EDGE) {
+    peers[source].barriers++;
+    delete[] data;
+    return;
+  }
+  auto handler = handlers.find(header.edge);
+  auto early = early_frames.find(header.edge);
+  // keep the order if there are undelivered frames for this edge
+  if (handler == handlers.end() || early != early_frames.end()) {
+    early_frames[header.edge].push_back(TCPReceivedFrame{source, header, data});
+    return;
+  }
+  handler->second->FrameReceived(source, header, data);
+}
+
+void TCPTransport::DeliverEarlyFrames() {
+  for (auto it = early_frames.begin(); it != early_frames.end();) {
+    auto handler = handlers.find(it->first);
+    if (handler == handlers.end()) {
+      ++it;
+      continue;
+    }
+    std::vector<TCPReceivedFrame> frames = std::move(it->second);
+    it = early_frames.erase(it);
+    for (auto &f : frames) {
+      handler->second->FrameReceived(f.source, f.header, f.data);
+    }
+  }
+}
+
+void TCPTransport::Progress() {
+  if (!early_frames.empty()) {
+    DeliverEarlyFrames();
+  }
+
+  for (int i = 0; i < world_size; i++) {
+    if (!peers[i].outFrames.empty() && !peers[i].writeBlocked) {
+      Flush(i);
+    }
+  }
+
+  if (epoll_fd < 0) {
+    return;
+  }
+  struct epoll_event events[64];
+  int n = epoll_wait(epoll_fd, events, 64, 0);
+  for (int i = 0; i < n; i++) {
+    int peer = static_cast<int>(events[i].data.u32);
+    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+      Read(peer);
+    }
+    if (events[i].events & EPOLLOUT) {
+      Flush(peer);
+    }
+  }
+}
+
+void TCPTransport::Barrier() {
+  barrier_generation++;
+  for (int i = 0; i < world_size; i++) {
+    if (i != rank) {
+      Post(i, TWISTERX_TCP_BARRIER_EDGE, nullptr, false, nullptr);
+    }
+  }
+  bool done = false;
+  while (!done) {
+    Progress();
+    done = true;
+    for (int i = 0; i < world_size; i++) {
+      if (i != rank && (peers[i].barriers < barrier_generation || !peers[i].outFrames.empty())) {
+        done = false;
+        break;
+      }
+    }
+  }
+}
+
+void TCPTransport::Close() {
+  for (auto &peer : peers) {
+    if (peer.fd >= 0) {
+      ::close(peer.fd);
+      peer.fd = -1;
+    }
+    while (!peer.outFrames.empty()) {
+      delete peer.outFrames.front();
+      peer.outFrames.pop_front();
+    }
+    delete[] peer.inData;
+    peer.inData = nullptr;
+  }
+  if (epoll_fd >= 0) {
+    ::close(epoll_fd);
+    epoll_fd = -1;
+  }
+  for (auto &e : early_frames) {
+    for (auto &f : e.second) {
+      delete[] f.data;
+    }
+  }
+  early_frames.clear();
+}
+
+TCPTransport::~TCPTransport() {
+  Close();
+}
+}
+}
@@ -0,0 +1,167 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_TCP_TRANSPORT_H
+#define TWISTERX_TCP_TRANSPORT_H
+
+#include <cstdint>
+#include <memory>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/uio.h>
+
+#include "../TxRequest.h"
+
+// maximum number of integers in a user header
+#define TWISTERX_TCP_HEADER_SIZE 8
+#define TWISTERX_TCP_MSG_FIN 1
+// edge reserved for the barrier messages
+#define TWISTERX_TCP_BARRIER_EDGE (-1)
+// maximum number of io vectors used in a single writev
+#define TWISTERX_TCP_MAX_IOV 64
+
+namespace twisterx {
+namespace net {
+
+/**
+ * Every message on a socket starts with this header, followed by the data. The edge is used to
+ * de-multiplex the messages to the channels sharing the socket, similar to the tag in MPI
+ */
+struct TCPFrameHeader {
+  int32_t edge;
+  int32_t length;
+  int32_t fin;
+  int32_t headerLength;
+  int32_t header[TWISTERX_TCP_HEADER_SIZE];
+};
+
+/**
+ * A channel registers a handler for its edge to get the messages and the send completions
+ */
+class TCPEdgeHandler {
+ public:
+  /**
+   * A message is received
+   * @param source the sender
+   * @param header the frame header
+   * @param data the data allocated with new char[], the handler owns it
+   */
+  virtual void FrameReceived(int source, const TCPFrameHeader &header, char *data) = 0;
+
+  /**
+   * A message is completely written to the socket
+   */
+  virtual void FrameSent(int target, const std::shared_ptr<TxRequest> &request, bool fin) = 0;
+
+  virtual ~TCPEdgeHandler() = default;
+};
+
+struct TCPOutFrame {
+  TCPFrameHeader header{};
+  std::shared_ptr<TxRequest> request;
+  bool fin = false;
+  TCPEdgeHandler *handler{};
+  // bytes of the header and data written so far
+  size_t written{};
+};
+
+struct TCPReceivedFrame {
+  int source;
+  TCPFrameHeader header;
+  char *data;
+};
+
+enum TCPReceiveStatus {
+  TCP_RECEIVE_HEADER = 0,
+  TCP_RECEIVE_DATA = 1
+};
+
+struct TCPPeer {
+  int fd = -1;
+  std::deque<TCPOutFrame *> outFrames;
+  // we are waiting for the socket to be writable
+  bool writeBlocked = false;
+  TCPFrameHeader inHeader{};
+  size_t inHeaderBytes{};
+  char *inData{};
+  size_t inDataBytes{};
+  TCPReceiveStatus inStatus = TCP_RECEIVE_HEADER;
+  // number of barrier messages received from this peer
+  int64_t barriers{};
+};
+
+/**
+ * A full mesh of non-blocking TCP connections between the ranks. The sockets are shared by all the channels,
+ * frames are written with writev and the readable sockets are found with epoll.
+ */
+class TCPTransport {
+ public:
+  TCPTransport(int rank, int world_size);
+
+  /**
+   * Create the connections, lower ranks are connected to and higher ranks are accepted
+   * @param listen_fd the listening socket of this rank
+   * @param addresses host:port of all the ranks
+   */
+  void Connect(int listen_fd, const std::vector<std::string> &addresses);
+
+  void Register(int edge, TCPEdgeHandler *handler);
+
+  void Unregister(int edge);
+
+  /**
+   * Queue a message to the target, the message is sent in the order of posting
+   */
+  void Post(int target, int edge, const std::shared_ptr<TxRequest> &request, bool fin, TCPEdgeHandler *handler);
+
+  /**
+   * Write the queued messages and read the available messages without blocking
+   */
+  void Progress();
+
+  /**
+   * Wait until all the ranks call the barrier
+   */
+  void Barrier();
+
+  void Close();
+
+  ~TCPTransport();
+
+ private:
+  int rank;
+  int world_size;
+  int epoll_fd = -1;
+  std::vector<TCPPeer> peers;
+  std::unordered_map<int, TCPEdgeHandler *> handlers;
+  // frames received before the channel of the edge is created
+  std::unordered_map<int, std::vector<TCPReceivedFrame>> early_frames;
+  int64_t barrier_generation{};
+
+  void Flush(int target);
+
+  void Read(int source);
+
+  void Dispatch(int source, const TCPFrameHeader &header, char *data);
+
+  void DeliverEarlyFrames();
+
+  void SetWriteInterest(int target, bool enable);
+};
+}
+}
+
+#endif //TWISTERX_TCP_TRANSPORT_H
@@ -198,6 +198,71 @@ std::string CxTable::distributed_join(const std::string &table_id, JoinType type
   }
 }
 
+static bool parse_aggregations(const std::vector<int> &aggregate_columns,
+                               const std::vector<std::string> &aggregate_ops,
+                               std::vector<twisterx::groupby::config::Aggregation> *aggregations)
+{
+  if (aggregate_columns.size() != aggregate_ops.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < aggregate_columns.size(); i++)
+  {
+    twisterx::groupby::config::AggregationOp op;
+    if (!twisterx::groupby::config::ParseAggregationOp(aggregate_ops[i], &op))
+    {
+      return false;
+    }
+    aggregations->emplace_back(aggregate_columns[i], op);
+  }
+  return true;
+}
+
+std::string CxTable::group_by(const std::vector<int> &key_columns,
+                              const std::vector<int> &aggregate_columns,
+                              const std::vector<std::string> &aggregate_ops)
+{
+  std::vector<twisterx::groupby::config::Aggregation> aggregations;
+  if (!parse_aggregations(aggregate_columns, aggregate_ops, &aggregations))
+  {
+    return "";
+  }
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  auto ctx_wrap = this->get_new_context();
+  twisterx::Status status = twisterx::GroupBy(ctx_wrap->getInstance(), this->id_, uuid, key_columns, aggregations);
+  if (status.is_ok())
+  {
+    return uuid;
+  }
+  else
+  {
+    return "";
+  }
+}
+
+std::string CxTable::distributed_group_by(const std::vector<int> &key_columns,
+                                          const std::vector<int> &aggregate_columns,
+                                          const std::vector<std::string> &aggregate_ops)
+{
+  std::vector<twisterx::groupby::config::Aggregation> aggregations;
+  if (!parse_aggregations(aggregate_columns, aggregate_ops, &aggregations))
+  {
+    return "";
+  }
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  auto ctx_wrap = this->get_new_context();
+  twisterx::Status status = twisterx::DistributedGroupBy(ctx_wrap->getInstance(), this->id_, uuid, key_columns,
+                                                         aggregations);
+  if (status.is_ok())
+  {
+    return uuid;
+  }
+  else
+  {
+    return "";
+  }
+}
+
 twisterx::python::twisterx_context_wrap *CxTable::get_new_context()
 {
   if (context_map.size() == 0)
@@ -16,6 +16,7 @@
 #define TWISTERX_TABLE_CYTHON_H
 
 #include "string"
+#include <vector>
 #include "../status.hpp"
 #include <arrow/python/serialize.h>
 #include "arrow/api.h"
@@ -77,6 +78,17 @@ class CxTable {
 
   std::string distributed_join(const std::string &table_id, JoinType type, JoinAlgorithm algorithm, int left_column_index, int right_column_index);
 
+  /**
+   * Group by the key columns, the aggregate of aggregate_columns[i] is named by aggregate_ops[i]
+   */
+  std::string group_by(const std::vector<int> &key_columns,
+					   const std::vector<int> &aggregate_columns,
+					   const std::vector<std::string> &aggregate_ops);
+
+  std::string distributed_group_by(const std::vector<int> &key_columns,
+								   const std::vector<int> &aggregate_columns,
+								   const std::vector<std::string> &aggregate_ops);
+
   //unique_ptr<CTable> sort(int sort_column);
 
 };
@@ -14,13 +14,22 @@
 
 #include "row.hpp"
 #include "table_api_extended.hpp"
+#include "util/arrow_utils.hpp"
 
 namespace twisterx {
 
+/**
+ * The chunk of the column with the row, as the table may have more than one chunk. The row is set to the row in the
+ * chunk.
+ */
+static std::shared_ptr<arrow::Array> get_chunk(const std::string &table_id, int64_t col_index, int64_t *row_index) {
+  return util::GetChunk(GetTable(table_id)->column(col_index), row_index);
+}
+
 template<typename ARROW_TYPE>
 auto get_numeric(const std::string &table_id, int64_t col_index, int64_t row_index) {
-  std::shared_ptr<arrow::Table> table = GetTable(table_id);
-  auto numeric_array = std::static_pointer_cast<arrow::NumericArray<ARROW_TYPE>>(table->column(col_index)->chunk(0));
+  auto numeric_array = std::static_pointer_cast<arrow::NumericArray<ARROW_TYPE>>(
+      get_chunk(table_id, col_index, &row_index));
   return numeric_array->Value(row_index);
 }
 
@@ -59,9 +68,9 @@ int64_t Row::RowIndex() {
 }
 
 bool Row::GetBool(int64_t col_index) {
-  std::shared_ptr<arrow::Table> table = GetTable(table_id);
-  auto numeric_array = std::static_pointer_cast<arrow::BooleanArray>(table->column(col_index)->chunk(0));
-  return numeric_array->Value(row_index);
+  int64_t chunk_row = row_index;
+  auto numeric_array = std::static_pointer_cast<arrow::BooleanArray>(get_chunk(table_id, col_index, &chunk_row));
+  return numeric_array->Value(chunk_row);
 }
 float Row::GetHalfFloat(int64_t col_index) {
   return get_numeric<arrow::HalfFloatType>(this->table_id, col_index, this->row_index);
@@ -74,14 +83,15 @@ double Row::GetDouble(int64_t col_index) {
 }
 
 std::string Row::GetString(int64_t col_index) {
-  std::shared_ptr<arrow::Table> table = GetTable(table_id);
-  auto numeric_array = std::static_pointer_cast<arrow::StringArray>(table->column(col_index)->chunk(0));
-  return numeric_array->GetString(row_index);
+  int64_t chunk_row = row_index;
+  auto numeric_array = std::static_pointer_cast<arrow::StringArray>(get_chunk(table_id, col_index, &chunk_row));
+  return numeric_array->GetString(chunk_row);
 }
 const uint8_t *Row::GetFixedBinary(int64_t col_index) {
-  std::shared_ptr<arrow::Table> table = GetTable(table_id);
-  auto numeric_array = std::static_pointer_cast<arrow::FixedSizeBinaryArray>(table->column(col_index)->chunk(0));
-  return numeric_array->GetValue(row_index);
+  int64_t chunk_row = row_index;
+  auto numeric_array = std::static_pointer_cast<arrow::FixedSizeBinaryArray>(
+      get_chunk(table_id, col_index, &chunk_row));
+  return numeric_array->GetValue(chunk_row);
 }
 int32_t Row::GetDate32(int64_t col_index) {
   return get_numeric<arrow::Date32Type>(this->table_id, col_index, this->row_index);
@@ -99,8 +109,8 @@ int64_t Row::Time64(int64_t col_index) {
   return get_numeric<arrow::Time64Type>(this->table_id, col_index, this->row_index);
 }
 const uint8_t * Row::Decimal(int64_t col_index) {
-  std::shared_ptr<arrow::Table> table = GetTable(table_id);
-  auto numeric_array = std::static_pointer_cast<arrow::DecimalArray>(table->column(col_index)->chunk(0));
-  return numeric_array->GetValue(row_index);
+  int64_t chunk_row = row_index;
+  auto numeric_array = std::static_pointer_cast<arrow::DecimalArray>(get_chunk(table_id, col_index, &chunk_row));
+  return numeric_array->GetValue(chunk_row);
 }
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_SORT_SORT_CONFIG_H_
+#define TWISTERX_SRC_TWISTERX_SORT_SORT_CONFIG_H_
+
+namespace twisterx {
+namespace sort {
+namespace config {
+
+enum NullOrder {
+  NULLS_FIRST, NULLS_LAST
+};
+
+/**
+ * A column of a sort, with the order of the values and where the nulls go
+ */
+class SortKey {
+ private:
+  int column_idx;
+  bool ascending;
+  NullOrder null_order;
+
+ public:
+  SortKey() = delete;
+
+  explicit SortKey(int column_idx, bool ascending = true, NullOrder null_order = NULLS_LAST)
+      : column_idx(column_idx), ascending(ascending), null_order(null_order) {}
+
+  static SortKey Ascending(int column_idx, NullOrder null_order = NULLS_LAST) {
+    return SortKey(column_idx, true, null_order);
+  }
+
+  static SortKey Descending(int column_idx, NullOrder null_order = NULLS_LAST) {
+    return SortKey(column_idx, false, null_order);
+  }
+
+  int GetColumnIdx() const {
+    return column_idx;
+  }
+
+  bool IsAscending() const {
+    return ascending;
+  }
+
+  NullOrder GetNullOrder() const {
+    return null_order;
+  }
+
+  bool NullsFirst() const {
+    return null_order == NULLS_FIRST;
+  }
+};
+}
+}
+}
+
+#endif //TWISTERX_SRC_TWISTERX_SORT_SORT_CONFIG_H_
@@ -81,7 +81,8 @@ void Table::Print(int row1, int row2, int col1, int col2) {
 Status Table::Merge(twisterx::TwisterXContext *ctx,
                     const std::vector<std::shared_ptr<twisterx::Table>> &tables,
                     shared_ptr<Table> &tableOut) {
-  std::vector<std::string> table_ids(tables.size());
+  std::vector<std::string> table_ids;
+  table_ids.reserve(tables.size());
   for (auto it = tables.begin(); it < tables.end(); it++) {
     table_ids.push_back((*it)->GetID());
   }
@@ -102,6 +103,44 @@ Status Table::Sort(int sort_column, shared_ptr<Table> &out) {
   return status;
 }
 
+Status Table::Sort(const std::vector<twisterx::sort::config::SortKey> &keys, shared_ptr<Table> &out) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  Status status = twisterx::SortTable(this->ctx, id_, uuid, keys);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, ctx);
+  }
+  return status;
+}
+
+Status Table::DistributedSort(int sort_column, shared_ptr<Table> &out, bool ascending,
+                              twisterx::SortBalance *balance) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  Status status = twisterx::DistributedSort(this->ctx, id_, sort_column, uuid, ascending, balance);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, ctx);
+  }
+  return status;
+}
+
+Status Table::TopK(const std::vector<twisterx::sort::config::SortKey> &keys, int64_t k, shared_ptr<Table> &out) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  Status status = twisterx::TopK(this->ctx, id_, uuid, keys, k);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, ctx);
+  }
+  return status;
+}
+
+Status Table::DistributedTopK(const std::vector<twisterx::sort::config::SortKey> &keys, int64_t k,
+                              shared_ptr<Table> &out) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  Status status = twisterx::DistributedTopK(this->ctx, id_, uuid, keys, k);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, ctx);
+  }
+  return status;
+}
+
 Status Table::HashPartition(const std::vector<int> &hash_columns, int no_of_partitions,
                             std::vector<std::shared_ptr<twisterx::Table>> *out) {
   std::unordered_map<int, std::string> tables;
@@ -118,6 +157,31 @@ Status Table::HashPartition(const std::vector<int> &hash_columns, int no_of_part
   return Status::OK();
 }
 
+Status Table::RangePartition(int column, int no_of_partitions,
+                             std::vector<std::shared_ptr<twisterx::Table>> *out,
+                             bool ascending) {
+  std::unordered_map<int, std::string> tables;
+  Status status = twisterx::RangePartition(ctx, id_, column, no_of_partitions, &tables, ascending);
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  // the partitions are given in the order of the ranges
+  for (int p = 0; p < no_of_partitions; p++) {
+    out->push_back(std::make_shared<Table>(tables[p], this->ctx));
+  }
+  return Status::OK();
+}
+
+Status Table::DistributedRangePartition(int column, std::shared_ptr<Table> &out, bool ascending) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::DistributedRangePartition(ctx, id_, column, uuid, ascending);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
+
 Status Table::Join(const std::shared_ptr<Table> &right,
                    twisterx::join::config::JoinConfig join_config,
                    std::shared_ptr<Table> *out) {
@@ -158,6 +222,14 @@ Status Table::Union(const shared_ptr<Table> &right, std::shared_ptr<Table> &out)
   }
   return status;
 }
+Status Table::UnionAll(const shared_ptr<Table> &right, std::shared_ptr<Table> &out) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::UnionAll(ctx, this->GetID(), right->GetID(), uuid);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
 Status Table::Select(const std::function<bool(twisterx::Row)> &selector, shared_ptr<Table> &out) {
   std::string uuid = twisterx::util::uuid::generate_uuid_v4();
   twisterx::Status status = twisterx::Select(ctx, this->GetID(), selector, uuid);
@@ -176,6 +248,80 @@ Status Table::DistributedUnion(twisterx::TwisterXContext *ctx, const shared_ptr<
   }
   return status;
 }
+Status Table::Intersect(const shared_ptr<Table> &right, std::shared_ptr<Table> &out,
+                        twisterx::SetSemantics semantics) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::Intersect(ctx, this->id_, right->id_, uuid, semantics);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
+Status Table::Subtract(const shared_ptr<Table> &right, std::shared_ptr<Table> &out,
+                       twisterx::SetSemantics semantics) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::Subtract(ctx, this->id_, right->id_, uuid, semantics);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
+Status Table::DistributedIntersect(const shared_ptr<Table> &right, std::shared_ptr<Table> &out,
+                                   twisterx::SetSemantics semantics) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::DistributedIntersect(ctx, this->id_, right->id_, uuid, semantics);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
+Status Table::DistributedSubtract(const shared_ptr<Table> &right, std::shared_ptr<Table> &out,
+                                  twisterx::SetSemantics semantics) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::DistributedSubtract(ctx, this->id_, right->id_, uuid, semantics);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
+Status Table::Distinct(const std::vector<int> &columns, std::shared_ptr<Table> &out,
+                       twisterx::DistinctKeep keep) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::Distinct(ctx, this->id_, uuid, columns, keep);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
+Status Table::DistributedDistinct(const std::vector<int> &columns, std::shared_ptr<Table> &out,
+                                  twisterx::DistinctKeep keep) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::DistributedDistinct(ctx, this->id_, uuid, columns, keep);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
+Status Table::GroupBy(const std::vector<int> &key_columns,
+                      const std::vector<twisterx::groupby::config::Aggregation> &aggregations,
+                      std::shared_ptr<Table> &out) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::GroupBy(ctx, this->id_, uuid, key_columns, aggregations);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
+Status Table::DistributedGroupBy(const std::vector<int> &key_columns,
+                                 const std::vector<twisterx::groupby::config::Aggregation> &aggregations,
+                                 std::shared_ptr<Table> &out) {
+  std::string uuid = twisterx::util::uuid::generate_uuid_v4();
+  twisterx::Status status = twisterx::DistributedGroupBy(ctx, this->id_, uuid, key_columns, aggregations);
+  if (status.is_ok()) {
+    out = std::make_shared<Table>(uuid, this->ctx);
+  }
+  return status;
+}
 void Table::Clear() {
   twisterx::RemoveTable(this->id_);
 }
@@ -30,6 +30,7 @@
 #include "join/join.hpp"
 #include "io/csv_write_config.h"
 #include "row.hpp"
+#include "table_api.hpp"
 
 namespace twisterx {
 
@@ -100,6 +101,28 @@ class Table {
                        int no_of_partitions,
                        std::vector<std::shared_ptr<twisterx::Table>> *out);
 
+  /**
+   * Partition the table into ranges of the order of a column
+   * @param column the column
+   * @param no_of_partitions number of partitions
+   * @param out the partitions in the order of the ranges
+   * @param ascending the order of the ranges
+   * @return the status of the partition
+   */
+  Status RangePartition(int column,
+                        int no_of_partitions,
+                        std::vector<std::shared_ptr<twisterx::Table>> *out,
+                        bool ascending = true);
+
+  /**
+   * Range partition the table across the ranks, rank i gets the i th range of the column
+   * @param column the column
+   * @param out the table of this rank
+   * @param ascending the order of the ranges over the ranks
+   * @return the status of the partition
+   */
+  Status DistributedRangePartition(int column, std::shared_ptr<Table> &out, bool ascending = true);
+
   /**
    * Merge the set of tables to create a single table
    * @param tables
@@ -116,6 +139,44 @@ class Table {
    */
   Status Sort(int sort_column, shared_ptr<Table> &out);
 
+  /**
+   * Sort the table on multiple columns, this is a local sort
+   * @param keys the sort columns with their order and null placement, the first key is the most significant
+   * @param out the sorted table
+   * @return the status of the sort
+   */
+  Status Sort(const std::vector<twisterx::sort::config::SortKey> &keys, shared_ptr<Table> &out);
+
+  /**
+   * Sort the table across the ranks, rank i gets the i th range of the sort column, sorted
+   * @param sort_column the sort column
+   * @param out the sorted table of this rank
+   * @param ascending the order of the sort
+   * @param balance if not null, the balance of the rows over the ranks
+   * @return the status of the sort
+   */
+  Status DistributedSort(int sort_column, shared_ptr<Table> &out, bool ascending = true,
+                         twisterx::SortBalance *balance = nullptr);
+
+  /**
+   * The first k rows of the table in the order of the keys, this is local
+   * @param keys the sort columns with their order and null placement, the first key is the most significant
+   * @param k the number of rows
+   * @param out the k rows, sorted
+   * @return the status of the operation
+   */
+  Status TopK(const std::vector<twisterx::sort::config::SortKey> &keys, int64_t k, shared_ptr<Table> &out);
+
+  /**
+   * The first k rows in the order of the keys over the tables of all the ranks, rank 0 gets the rows
+   * @param keys the sort columns with their order and null placement, the first key is the most significant
+   * @param k the number of rows
+   * @param out the k rows, sorted, at rank 0 and an empty table at the other ranks
+   * @return the status of the operation
+   */
+  Status DistributedTopK(const std::vector<twisterx::sort::config::SortKey> &keys, int64_t k,
+                         shared_ptr<Table> &out);
+
   /**
    * Do the join with the right table
    * @param right the right table
@@ -133,10 +194,87 @@ class Table {
 
   Status Union(const std::shared_ptr<Table> &right, std::shared_ptr<Table> &out);
 
+  /**
+   * Append the rows of the right table, keeping the duplicates. The columns are not copied.
+   * @param right the table with the same schema
+   * @param out the result
+   * @return the status of the operation
+   */
+  Status UnionAll(const std::shared_ptr<Table> &right, std::shared_ptr<Table> &out);
+
   Status DistributedUnion(twisterx::TwisterXContext *ctx,
                           const std::shared_ptr<Table> &right,
                           std::shared_ptr<Table> &out);
 
+  /**
+   * The rows of this table that are in the right table, this is local
+   * @param right the right table, with the same column types
+   * @param out the result
+   * @param semantics SET for distinct rows, BAG to keep the duplicates
+   * @return the status of the operation
+   */
+  Status Intersect(const std::shared_ptr<Table> &right, std::shared_ptr<Table> &out,
+                   twisterx::SetSemantics semantics = twisterx::SET);
+
+  /**
+   * The rows of this table that are not in the right table, this is local
+   * @param right the right table, with the same column types
+   * @param out the result
+   * @param semantics SET for distinct rows, BAG to keep the duplicates
+   * @return the status of the operation
+   */
+  Status Subtract(const std::shared_ptr<Table> &right, std::shared_ptr<Table> &out,
+                  twisterx::SetSemantics semantics = twisterx::SET);
+
+  /**
+   * Remove the rows with duplicate keys, this is local
+   * @param columns the key columns, all the columns if empty
+   * @param out the result
+   * @param keep the row kept out of the rows with equal keys
+   * @return the status of the operation
+   */
+  Status Distinct(const std::vector<int> &columns, std::shared_ptr<Table> &out,
+                  twisterx::DistinctKeep keep = twisterx::KEEP_FIRST);
+
+  /**
+   * Remove the rows with duplicate keys over the tables of all the ranks
+   * @param columns the key columns, all the columns if empty
+   * @param out the result of this rank
+   * @param keep the row kept out of the rows with equal keys
+   * @return the status of the operation
+   */
+  Status DistributedDistinct(const std::vector<int> &columns, std::shared_ptr<Table> &out,
+                             twisterx::DistinctKeep keep = twisterx::KEEP_FIRST);
+
+  /**
+   * Group the rows on the key columns and aggregate the other columns of each group, this is local
+   * @param key_columns the key columns
+   * @param aggregations the aggregates, each of a column
+   * @param out the key columns of the groups followed by a column for each aggregate
+   * @return the status of the operation
+   */
+  Status GroupBy(const std::vector<int> &key_columns,
+                 const std::vector<twisterx::groupby::config::Aggregation> &aggregations,
+                 std::shared_ptr<Table> &out);
+
+  /**
+   * Group the rows of the tables of all the ranks on the key columns and aggregate each group, the ranks shuffle
+   * partial aggregates of their rows unless they hardly reduce the rows
+   * @param key_columns the key columns
+   * @param aggregations the aggregates, each of a column
+   * @param out the groups of this rank, as in GroupBy
+   * @return the status of the operation
+   */
+  Status DistributedGroupBy(const std::vector<int> &key_columns,
+                            const std::vector<twisterx::groupby::config::Aggregation> &aggregations,
+                            std::shared_ptr<Table> &out);
+
+  Status DistributedIntersect(const std::shared_ptr<Table> &right, std::shared_ptr<Table> &out,
+                              twisterx::SetSemantics semantics = twisterx::SET);
+
+  Status DistributedSubtract(const std::shared_ptr<Table> &right, std::shared_ptr<Table> &out,
+                             twisterx::SetSemantics semantics = twisterx::SET);
+
   Status Select(const std::function<bool(twisterx::Row)> &selector, std::shared_ptr<Table> &out);
 
   /**
@@ -26,19 +26,32 @@
 #include <arrow/compute/context.h>
 #include <arrow/compute/api.h>
 #include <future>
+#include <mutex>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <cstring>
+#include <arrow/compute/kernels/take.h>
 #include "util/arrow_utils.hpp"
 #include "arrow/arrow_partition_kernels.hpp"
+#include "arrow/arrow_sort_kernels.hpp"
+#include "arrow/arrow_row_hash_table.hpp"
+#include "arrow/arrow_aggregate_kernels.hpp"
 #include "util/uuid.hpp"
 #include "arrow/arrow_all_to_all.hpp"
+#include "arrow/arrow_collectives.hpp"
+#include "net/comm_metrics.hpp"
 
-#include "arrow/arrow_comparator.h"
 #include "ctx/arrow_memory_pool_utils.h"
 
 namespace twisterx {
 
 std::map<std::string, std::shared_ptr<arrow::Table>> table_map{}; //todo make this un ordered
+// ranks may run as threads of the same process, so the registry is shared between them
+std::mutex table_map_mutex;
 
 std::shared_ptr<arrow::Table> GetTable(const std::string &id) {
+  std::lock_guard<std::mutex> guard(table_map_mutex);
   auto itr = table_map.find(id);
   if (itr != table_map.end()) {
     return itr->second;
@@ -48,17 +61,20 @@ std::shared_ptr<arrow::Table> GetTable(const std::string &id) {
 
 void PutTable(const std::string &id, const std::shared_ptr<arrow::Table> &table) {
   std::pair<std::string, std::shared_ptr<arrow::Table>> pair(id, table);
+  std::lock_guard<std::mutex> guard(table_map_mutex);
   table_map.insert(pair);
 }
 
 std::string PutTable(const std::shared_ptr<arrow::Table> &table) {
   auto id = twisterx::util::uuid::generate_uuid_v4();
   std::pair<std::string, std::shared_ptr<arrow::Table>> pair(id, table);
+  std::lock_guard<std::mutex> guard(table_map_mutex);
   table_map.insert(pair);
   return id;
 }
 
 void RemoveTable(const std::string &id) {
+  std::lock_guard<std::mutex> guard(table_map_mutex);
   table_map.erase(id);
 }
 
@@ -68,14 +84,8 @@ twisterx::Status ReadCSV(twisterx::TwisterXContext *ctx,
                          twisterx::io::config::CSVReadOptions options) {
   arrow::Result<std::shared_ptr<arrow::Table>> result = twisterx::io::read_csv(ctx, path, options);
   if (result.ok()) {
+    // the blocks read are the chunks of the table, the operators combine the columns they need
     std::shared_ptr<arrow::Table> table = *result;
-    LOG(INFO) << "Chunks " << table->column(0)->chunks().size();
-    if (table->column(0)->chunks().size() > 1) {
-      auto status = table->CombineChunks(ToArrowPool(ctx), &table);
-      if (!status.ok()) {
-        return twisterx::Status(Code::IOError, status.message());;
-      }
-    }
     PutTable(id, table);
     return twisterx::Status(Code::OK, result.status().message());
   }
@@ -203,49 +213,109 @@ twisterx::Status PrintToOStream(const std::string &table_id,
   return twisterx::Status(Code::OK);
 }
 
-twisterx::Status Shuffle(twisterx::TwisterXContext *ctx,
-                         const std::string &table_id,
-                         const std::vector<int> &hash_columns,
-                         int edge_id,
-                         std::shared_ptr<arrow::Table> *table_out) {
-  auto table = GetTable(table_id);
+/**
+ * The column as a single array, the chunks are concatenated if there are more than one
+ */
+static twisterx::Status CombineColumn(twisterx::TwisterXContext *ctx,
+                                      const std::shared_ptr<arrow::ChunkedArray> &column,
+                                      std::shared_ptr<arrow::Array> *out) {
+  arrow::Status status = twisterx::util::CombineChunks(column, out, twisterx::ToArrowPool(ctx));
+  return twisterx::Status((int) status.code(), status.message());
+}
 
-  std::unordered_map<int, std::string> partitioned_tables{};
+/**
+ * Take the rows of the table at the int64 indices. The columns with more than one chunk are copied chunk by chunk,
+ * where the take of arrow would combine the chunks first.
+ */
+static arrow::Status TakeTable(twisterx::TwisterXContext *ctx,
+                               const std::shared_ptr<arrow::Table> &table,
+                               const std::shared_ptr<arrow::Array> &indices,
+                               std::shared_ptr<arrow::Table> *out) {
+  arrow::MemoryPool *pool = twisterx::ToArrowPool(ctx);
+  arrow::compute::FunctionContext fn_ctx(pool);
+  bool chunked = false;
+  for (const auto &column : table->columns()) {
+    chunked = chunked || column->num_chunks() > 1;
+  }
+  if (!chunked) {
+    return arrow::compute::Take(&fn_ctx, *table, *indices, arrow::compute::TakeOptions(), out);
+  }
 
-  // partition the tables locally
-  HashPartition(ctx, table_id, hash_columns, ctx->GetWorldSize(), &partitioned_tables);
+  auto int64_indices = std::static_pointer_cast<arrow::Int64Array>(indices);
+  auto rows = std::make_shared<std::vector<int64_t>>(int64_indices->raw_values(),
+                                                     int64_indices->raw_values() + int64_indices->length());
+  std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+  for (const auto &column : table->columns()) {
+    std::shared_ptr<arrow::Array> array;
+    arrow::Status status = twisterx::util::copy_chunked_array_by_indices(rows, column, &array, pool);
+    if (status.IsNotImplemented()) {
+      // the types the copy doesn't support go through the take of arrow
+      std::shared_ptr<arrow::ChunkedArray> taken;
+      status = arrow::compute::Take(&fn_ctx, *column, *indices, arrow::compute::TakeOptions(), &taken);
+      columns.push_back(taken);
+    } else {
+      columns.push_back(std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{array}, column->type()));
+    }
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  *out = arrow::Table::Make(table->schema(), columns);
+  return arrow::Status::OK();
+}
 
+/**
+ * Send the partitions to the ranks and receive the partitions of this rank
+ * @param ctx the context
+ * @param partitioned_tables the partition for each rank
+ * @param schema schema of the tables
+ * @param edge_id the edge of the all to all
+ * @param partition_start when the partitioning started, for the metrics
+ * @param received_tables the partitions received by this rank, including its own
+ * @param metrics the metrics of the exchange, nullptr if the metrics are disabled
+ */
+static twisterx::Status ExchangePartitions(twisterx::TwisterXContext *ctx,
+                                           const std::unordered_map<int, std::shared_ptr<arrow::Table>> &partitioned_tables,
+                                           const std::shared_ptr<arrow::Schema> &schema,
+                                           int edge_id,
+                                           int64_t partition_start,
+                                           std::vector<std::shared_ptr<arrow::Table>> *received_tables,
+                                           std::shared_ptr<EdgeMetrics> *metrics) {
+  int64_t partition_end = EdgeMetrics::Now();
   auto neighbours = ctx->GetNeighbours(true);
 
-  vector<std::shared_ptr<arrow::Table>> received_tables;
-
   // define call back to catch the receiving tables
   class AllToAllListener : public twisterx::ArrowCallback {
 
-    vector<std::shared_ptr<arrow::Table>> *tabs;
+    vector<std::pair<int, std::shared_ptr<arrow::Table>>> *tabs;
     int workerId;
 
    public:
-    explicit AllToAllListener(vector<std::shared_ptr<arrow::Table>> *tabs, int workerId) {
+    explicit AllToAllListener(vector<std::pair<int, std::shared_ptr<arrow::Table>>> *tabs, int workerId) {
       this->tabs = tabs;
       this->workerId = workerId;
     }
 
     bool onReceive(int source, std::shared_ptr<arrow::Table> table) override {
-      this->tabs->push_back(table);
+      this->tabs->emplace_back(source, table);
       return true;
     };
   };
 
   // doing all to all communication to exchange tables
+  std::vector<std::pair<int, std::shared_ptr<arrow::Table>>> sources;
   twisterx::ArrowAllToAll all_to_all(ctx, neighbours, neighbours, edge_id,
-                                     std::make_shared<AllToAllListener>(&received_tables, ctx->GetRank()),
-                                     table->schema(), twisterx::ToArrowPool(ctx));
+                                     std::make_shared<AllToAllListener>(&sources, ctx->GetRank()),
+                                     schema, twisterx::ToArrowPool(ctx));
+  *metrics = all_to_all.GetMetrics();
+  if (*metrics != nullptr) {
+    (*metrics)->AddPhase("partition", partition_start, partition_end);
+  }
   for (auto &partitioned_table : partitioned_tables) {
     if (partitioned_table.first != ctx->GetRank()) {
-      all_to_all.insert(GetTable(partitioned_table.second), partitioned_table.first);
+      all_to_all.insert(partitioned_table.second, partitioned_table.first);
     } else {
-      received_tables.push_back(GetTable(partitioned_table.second));
+      sources.emplace_back(ctx->GetRank(), partitioned_table.second);
     }
   }
 
@@ -254,20 +324,72 @@ twisterx::Status Shuffle(twisterx::TwisterXContext *ctx,
   while (!all_to_all.isComplete()) {}
   all_to_all.close();
 
+  // the tables are ordered by their source rank, so the order of the received rows doesn't depend on the arrival
+  std::stable_sort(sources.begin(), sources.end(),
+                   [](const std::pair<int, std::shared_ptr<arrow::Table>> &a,
+                      const std::pair<int, std::shared_ptr<arrow::Table>> &b) {
+                     return a.first < b.first;
+                   });
+  for (auto &source : sources) {
+    received_tables->push_back(source.second);
+  }
+  return twisterx::Status::OK();
+}
+
+/**
+ * Concatenate the partitions received by this rank into a single table, without copying. The partitions are the
+ * chunks of the table.
+ */
+static twisterx::Status ConcatenatePartitions(twisterx::TwisterXContext *ctx,
+                                              const std::vector<std::shared_ptr<arrow::Table>> &received_tables,
+                                              const std::shared_ptr<EdgeMetrics> &metrics,
+                                              std::shared_ptr<arrow::Table> *table_out) {
   // now we have the final set of tables
   LOG(INFO) << "Concatenating tables, Num of tables :  " << received_tables.size();
+  int64_t concatenate_start = EdgeMetrics::Now();
   arrow::Result<std::shared_ptr<arrow::Table>> concat_tables = arrow::ConcatenateTables(received_tables);
 
   if (concat_tables.ok()) {
-    auto final_table = concat_tables.ValueOrDie();
-    LOG(INFO) << "Done concatenating tables, rows :  " << final_table->num_rows();
-    auto status = final_table->CombineChunks(twisterx::ToArrowPool(ctx), table_out);
-    return twisterx::Status((int) status.code(), status.message());
+    *table_out = concat_tables.ValueOrDie();
+    LOG(INFO) << "Done concatenating tables, rows :  " << (*table_out)->num_rows();
+    if (metrics != nullptr) {
+      metrics->AddPhase("concatenate", concatenate_start, EdgeMetrics::Now());
+    }
+    return twisterx::Status::OK();
   } else {
     return twisterx::Status((int) concat_tables.status().code(), concat_tables.status().message());
   }
 }
 
+twisterx::Status Shuffle(twisterx::TwisterXContext *ctx,
+                         const std::string &table_id,
+                         const std::vector<int> &hash_columns,
+                         int edge_id,
+                         std::shared_ptr<arrow::Table> *table_out) {
+  auto table = GetTable(table_id);
+
+  std::unordered_map<int, std::string> partitioned_tables{};
+
+  // partition the tables locally
+  int64_t partition_start = EdgeMetrics::Now();
+  auto status = HashPartition(ctx, table_id, hash_columns, ctx->GetWorldSize(), &partitioned_tables);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::unordered_map<int, std::shared_ptr<arrow::Table>> partitions;
+  for (const auto &partitioned_table : partitioned_tables) {
+    partitions.insert(std::make_pair(partitioned_table.first, GetTable(partitioned_table.second)));
+    RemoveTable(partitioned_table.second);
+  }
+  std::vector<std::shared_ptr<arrow::Table>> received_tables;
+  std::shared_ptr<EdgeMetrics> metrics;
+  status = ExchangePartitions(ctx, partitions, table->schema(), edge_id, partition_start, &received_tables, &metrics);
+  if (!status.is_ok()) {
+    return status;
+  }
+  return ConcatenatePartitions(ctx, received_tables, metrics, table_out);
+}
+
 twisterx::Status ShuffleTwoTables(twisterx::TwisterXContext *ctx,
                                   const std::string &left_table_id,
                                   const std::vector<int> &left_hash_columns,
@@ -277,10 +399,11 @@ twisterx::Status ShuffleTwoTables(twisterx::TwisterXContext *ctx,
                                   std::shared_ptr<arrow::Table> *right_table_out) {
   LOG(INFO) << "Shuffling two tables with total rows : "
             << GetTable(left_table_id)->num_rows() + GetTable(right_table_id)->num_rows();
-  auto status = Shuffle(ctx, left_table_id, left_hash_columns, ctx->GetNextSequence(), left_table_out);
+  // the shuffles run one after the other, so they reuse the channels of the previous shuffles
+  auto status = Shuffle(ctx, left_table_id, left_hash_columns, ctx->GetReusableEdge(0), left_table_out);
   if (status.is_ok()) {
     LOG(INFO) << "Left table shuffled";
-    return Shuffle(ctx, right_table_id, right_hash_columns, ctx->GetNextSequence(), right_table_out);
+    return Shuffle(ctx, right_table_id, right_hash_columns, ctx->GetReusableEdge(0), right_table_out);
   }
   return status;
 }
@@ -293,6 +416,7 @@ twisterx::Status DistributedJoinTables(twisterx::TwisterXContext *ctx,
   // extract the tables out
   auto left = GetTable(table_left);
   auto right = GetTable(table_right);
+  join_config.SetSortThreads(std::stoi(ctx->GetConfig(TWISTERX_SORT_THREADS, "1")));
 
   // check whether the world size is 1
   if (ctx->GetWorldSize() == 1) {
@@ -349,6 +473,7 @@ twisterx::Status JoinTables(twisterx::TwisterXContext *ctx,
                             const std::string &dest_id) {
   auto left = GetTable(table_left);
   auto right = GetTable(table_right);
+  join_config.SetSortThreads(std::stoi(ctx->GetConfig(TWISTERX_SORT_THREADS, "1")));
 
   if (left == NULLPTR) {
     return twisterx::Status(Code::KeyError, "Couldn't find the left table");
@@ -389,19 +514,41 @@ twisterx::Status Merge(twisterx::TwisterXContext *ctx,
                        const std::string &merged_tab) {
   std::vector<std::shared_ptr<arrow::Table>> tables;
   for (auto it = table_ids.begin(); it < table_ids.end(); it++) {
-    tables.push_back(GetTable(*it));
+    auto table = GetTable(*it);
+    if (table == NULLPTR) {
+      return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + *it);
+    }
+    tables.push_back(table);
   }
   arrow::Result<std::shared_ptr<arrow::Table>> result = arrow::ConcatenateTables(tables);
   if (result.status() == arrow::Status::OK()) {
-    std::shared_ptr<arrow::Table> combined;
-    result.ValueOrDie()->CombineChunks(twisterx::ToArrowPool(ctx), &combined);
-    PutTable(merged_tab, combined);
+    PutTable(merged_tab, result.ValueOrDie());
     return twisterx::Status::OK();
   } else {
     return twisterx::Status((int) result.status().code(), result.status().message());
   }
 }
 
+/**
+ * Sort the rows of the table by a column, the nulls go to the end. The sort is stable in both orders.
+ */
+static twisterx::Status SortTableByColumn(twisterx::TwisterXContext *ctx,
+                                          const std::shared_ptr<arrow::Table> &table,
+                                          int column_index,
+                                          bool ascending,
+                                          std::shared_ptr<arrow::Table> *out) {
+  arrow::MemoryPool *pool = twisterx::ToArrowPool(ctx);
+  std::shared_ptr<arrow::Array> indices;
+  int threads = std::stoi(ctx->GetConfig(TWISTERX_SORT_THREADS, "1"));
+  const std::vector<twisterx::sort::config::SortKey> keys{
+      twisterx::sort::config::SortKey(column_index, ascending, twisterx::sort::config::NULLS_LAST)};
+  arrow::Status status = SortIndicesMultiColumns(pool, table, keys, &indices, threads);
+  if (status.ok()) {
+    status = TakeTable(ctx, table, indices, out);
+  }
+  return twisterx::Status((int) status.code(), status.message());
+}
+
 twisterx::Status SortTable(twisterx::TwisterXContext *ctx,
                            const std::string &id,
                            const std::string &sortedTableId,
@@ -411,30 +558,49 @@ twisterx::Status SortTable(twisterx::TwisterXContext *ctx,
     LOG(FATAL) << "Failed to retrieve table";
     return Status(Code::KeyError, "Couldn't find the right table");
   }
-  auto col = table->column(columnIndex)->chunk(0);
-  std::shared_ptr<arrow::Array> indexSorts;
-  arrow::Status status = SortIndices(twisterx::ToArrowPool(ctx), col, &indexSorts);
+  std::shared_ptr<arrow::Table> sortedTable;
+  twisterx::Status status = SortTableByColumn(ctx, table, columnIndex, true, &sortedTable);
+  if (!status.is_ok()) {
+    return status;
+  }
+  // we need to put this to a new place
+  PutTable(sortedTableId, sortedTable);
+  return Status::OK();
+}
 
-  if (status != arrow::Status::OK()) {
-    LOG(FATAL) << "Failed when sorting table to indices. " << status.ToString();
+twisterx::Status SortTable(twisterx::TwisterXContext *ctx,
+                           const std::string &id,
+                           const std::string &sorted_id,
+                           const std::vector<twisterx::sort::config::SortKey> &keys) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
+  arrow::MemoryPool *pool = twisterx::ToArrowPool(ctx);
+  std::shared_ptr<arrow::Array> indices;
+  int threads = std::stoi(ctx->GetConfig(TWISTERX_SORT_THREADS, "1"));
+  arrow::Status status = SortIndicesMultiColumns(pool, table, keys, &indices, threads);
+  if (!status.ok()) {
+    return twisterx::Status((int) status.code(), status.message());
+  }
+  std::shared_ptr<arrow::Table> sorted;
+  status = TakeTable(ctx, table, indices, &sorted);
+  if (!status.ok()) {
     return twisterx::Status((int) status.code(), status.message());
   }
+  PutTable(sorted_id, sorted);
+  return twisterx::Status::OK();
+}
 
-  std::vector<std::shared_ptr<arrow::Array>> data_arrays;
-  for (auto &column : table->columns()) {
-    std::shared_ptr<arrow::Array> destination_col_array;
-    status = twisterx::util::copy_array_by_indices(nullptr, column->chunk(0),
-                                                   &destination_col_array, twisterx::ToArrowPool(ctx));
-    if (status != arrow::Status::OK()) {
-      LOG(FATAL) << "Failed while copying a column to the final table from left table. " << status.ToString();
-      return twisterx::Status((int) status.code(), status.message());
-    }
-    data_arrays.push_back(destination_col_array);
+/**
+ * The hash algorithm configured in the context
+ */
+static twisterx::Status GetHashAlgorithm(twisterx::TwisterXContext *ctx, util::HashAlgorithm *algorithm) {
+  std::string name = ctx->GetConfig(TWISTERX_HASH_ALGORITHM, "murmur3");
+  if (!util::ParseHashAlgorithm(name, algorithm)) {
+    return twisterx::Status(twisterx::Invalid, "Unknown hash algorithm " + name);
   }
-  // we need to put this to a new place
-  std::shared_ptr<arrow::Table> sortedTable = arrow::Table::Make(table->schema(), data_arrays);
-  PutTable(sortedTableId, sortedTable);
-  return Status::OK();
+  return twisterx::Status::OK();
 }
 
 twisterx::Status HashPartition(twisterx::TwisterXContext *ctx,
@@ -443,22 +609,21 @@ twisterx::Status HashPartition(twisterx::TwisterXContext *ctx,
                                int no_of_partitions,
                                std::unordered_map<int, std::string> *out) {
   std::shared_ptr<arrow::Table> left_tab = GetTable(id);
-  // keep arrays for each target, these arrays are used for creating the table
-  std::unordered_map<int, std::shared_ptr<std::vector<std::shared_ptr<arrow::Array>>>> data_arrays;
   std::vector<int> partitions;
   for (int t = 0; t < no_of_partitions; t++) {
     partitions.push_back(t);
-    data_arrays.insert(
-        std::pair<int, std::shared_ptr<std::vector<std::shared_ptr<arrow::Array>>>>(
-            t, std::make_shared<std::vector<std::shared_ptr<arrow::Array>>>()));
   }
 
   std::vector<std::shared_ptr<arrow::Array>> arrays;
   int64_t length = 0;
   for (auto col_index: hash_columns) {
     auto column = left_tab->column(col_index);
-    std::vector<int64_t> outPartitions;
-    std::shared_ptr<arrow::Array> array = column->chunk(0);
+    // the hashes are computed for the rows of the table, so we need a single array
+    std::shared_ptr<arrow::Array> array;
+    twisterx::Status concat_status = CombineColumn(ctx, column, &array);
+    if (!concat_status.is_ok()) {
+      return concat_status;
+    }
     arrays.push_back(array);
 
     if (!(length == 0 || length == column->length())) {
@@ -467,211 +632,1233 @@ twisterx::Status HashPartition(twisterx::TwisterXContext *ctx,
     length = column->length();
   }
 
+  util::HashAlgorithm algorithm;
+  twisterx::Status status = GetHashAlgorithm(ctx, &algorithm);
+  if (!status.is_ok()) {
+    return status;
+  }
+
   // first we partition the table
-  std::vector<int64_t> outPartitions;
-  twisterx::Status
-      status = HashPartitionArrays(twisterx::ToArrowPool(ctx), arrays, length, partitions, &outPartitions);
+  PartitionIds outPartitions;
+  status = HashPartitionArrays(twisterx::ToArrowPool(ctx), arrays, length, partitions, &outPartitions, algorithm);
   if (!status.is_ok()) {
     LOG(FATAL) << "Failed to create the hash partition";
     return status;
   }
 
-  for (int i = 0; i < left_tab->num_columns(); i++) {
-    std::shared_ptr<arrow::DataType> type = left_tab->column(i)->chunk(0)->type();
-    std::shared_ptr<arrow::Array> array = left_tab->column(i)->chunk(0);
-
-    std::shared_ptr<ArrowArraySplitKernel> splitKernel;
-    status = CreateSplitter(type, twisterx::ToArrowPool(ctx), &splitKernel);
-    if (!status.is_ok()) {
-      LOG(FATAL) << "Failed to create the splitter";
-      return status;
-    }
-
-    // this one outputs arrays for each target as a map
-    std::unordered_map<int, std::shared_ptr<arrow::Array>> splited_arrays;
-    splitKernel->Split(array, outPartitions, partitions, splited_arrays);
-
-    for (const auto &x : splited_arrays) {
-      std::shared_ptr<std::vector<std::shared_ptr<arrow::Array>>> cols = data_arrays[x.first];
-      cols->push_back(x.second);
-    }
+  // then split the columns to the partitions
+  int threads = std::stoi(ctx->GetConfig(TWISTERX_SPLIT_THREADS, "1"));
+  std::unordered_map<int, std::shared_ptr<arrow::Table>> split_tables;
+  status = SplitTable(left_tab, outPartitions, partitions, twisterx::ToArrowPool(ctx), &split_tables, threads);
+  if (!status.is_ok()) {
+    LOG(FATAL) << "Failed to split the table";
+    return status;
   }
-  // now insert these array to
-  for (const auto &x : data_arrays) {
-    std::shared_ptr<arrow::Table> table = arrow::Table::Make(left_tab->schema(), *x.second);
-    out->insert(std::pair<int, std::string>(x.first, PutTable(table)));
+  for (const auto &x : split_tables) {
+    out->insert(std::pair<int, std::string>(x.first, PutTable(x.second)));
   }
   return twisterx::Status::OK();
 }
 
-twisterx::Status Union(twisterx::TwisterXContext *ctx,
-                       const std::string &table_left,
-                       const std::string &table_right,
-                       const std::string &dest_id) {
-  auto ltab = GetTable(table_left);
-  auto rtab = GetTable(table_right);
-
-  std::shared_ptr<arrow::Table> tables[2] = {ltab, rtab};
-
-  // manual field check. todo check why  ltab->schema()->Equals(rtab->schema(), false) doesn't work
-
-  if (ltab->num_columns() != rtab->num_columns()) {
-    return twisterx::Status(twisterx::Invalid, "The no of columns of two tables are not similar. Can't perform union.");
+/**
+ * Choose the splitters of a range partition from the samples of the column of this table, or from the samples
+ * gathered from all the ranks when distributed. The ranks sample in proportion to their rows. A sorted column is
+ * sampled at regular intervals, otherwise at random.
+ */
+static twisterx::Status ChooseSplitters(twisterx::TwisterXContext *ctx,
+                                        const std::shared_ptr<arrow::Field> &field,
+                                        const std::shared_ptr<arrow::Array> &array,
+                                        int no_of_partitions,
+                                        bool distributed,
+                                        bool sorted,
+                                        RangePartitionKernel *kernel) {
+  arrow::MemoryPool *pool = twisterx::ToArrowPool(ctx);
+  int64_t num_samples = std::stoll(ctx->GetConfig(TWISTERX_RANGE_SAMPLES, "100")) * no_of_partitions;
+  distributed = distributed && ctx->GetWorldSize() > 1;
+  if (distributed) {
+    int64_t rows = array->length(), total_rows = 0;
+    ctx->GetCommunicator()->AllReduce(&rows, &total_rows, 1, twisterx::Type::INT64, twisterx::net::SUM);
+    num_samples = total_rows == 0 ? 0 : (num_samples * rows + total_rows - 1) / total_rows;
+  }
+  std::shared_ptr<arrow::Array> samples;
+  twisterx::Status status = sorted ? SampleSortedArray(pool, array, num_samples, &samples)
+                                   : SampleArray(pool, array, num_samples, ctx->GetRank(), &samples);
+  if (!status.is_ok()) {
+    return status;
   }
 
-  for (int fd = 0; fd < ltab->num_columns(); ++fd) {
-    if (!ltab->field(fd)->type()->Equals(rtab->field(fd)->type())) {
-      return twisterx::Status(twisterx::Invalid, "The fields of two tables are not similar. Can't perform union.");
+  // every rank gets the same samples, so they choose the same splitters
+  std::vector<std::shared_ptr<arrow::Array>> all_samples;
+  if (distributed) {
+    auto sample_table = arrow::Table::Make(arrow::schema({field}), {samples});
+    std::vector<std::shared_ptr<arrow::Table>> gathered;
+    arrow::Status gather_status = AllGatherTables(ctx, sample_table, &gathered);
+    if (!gather_status.ok()) {
+      return twisterx::Status((int) gather_status.code(), gather_status.message());
+    }
+    for (const auto &gathered_table : gathered) {
+      for (const auto &chunk : gathered_table->column(0)->chunks()) {
+        all_samples.push_back(chunk);
+      }
     }
+  } else {
+    all_samples.push_back(samples);
   }
+  kernel->SetSplitters(all_samples, no_of_partitions);
+  return twisterx::Status::OK();
+}
 
-  int64_t eq_calls = 0, hash_calls = 0;
-
-  class RowComparator {
-   private:
-    const std::shared_ptr<arrow::Table> *tables;
-    twisterx::TableRowComparator *comparator;
-    twisterx::RowHashingKernel *row_hashing_kernel;
-    int64_t *eq, *hs;
-   public:
-    RowComparator(twisterx::TwisterXContext *ctx,
-                  const std::shared_ptr<arrow::Table> *tables,
-                  int64_t *eq,
-                  int64_t *hs) {
-      this->tables = tables;
-      this->comparator = new twisterx::TableRowComparator(tables[0]->fields());
-      this->row_hashing_kernel =
-          new twisterx::RowHashingKernel(tables[0]->fields(), twisterx::ToArrowPool(ctx));
-      this->eq = eq;
-      this->hs = hs;
-    }
-
-    // equality
-    bool operator()(const std::pair<int8_t, int64_t> &record1, const std::pair<int8_t, int64_t> &record2) const {
-      (*this->eq)++;
-      return this->comparator->compare(
-          this->tables[record1.first],
-          record1.second,
-          this->tables[record2.first],
-          record2.second
-      ) == 0;
-    }
-
-    // hashing
-    size_t operator()(const std::pair<int8_t, int64_t> &record) const {
-      (*this->hs)++;
-      size_t hash = this->row_hashing_kernel->Hash(this->tables[record.first], record.second);
-      return hash;
-    }
-  };
+/**
+ * Range partition the table on a column
+ */
+static twisterx::Status RangePartitionTable(twisterx::TwisterXContext *ctx,
+                                            const std::shared_ptr<arrow::Table> &table,
+                                            int column_index,
+                                            int no_of_partitions,
+                                            bool ascending,
+                                            bool distributed,
+                                            std::unordered_map<int, std::shared_ptr<arrow::Table>> *out) {
+  if (column_index < 0 || column_index >= table->num_columns()) {
+    return twisterx::Status(twisterx::IndexError, "Invalid column " + std::to_string(column_index));
+  }
+  if (no_of_partitions <= 0) {
+    return twisterx::Status(twisterx::Invalid, "The number of partitions should be positive");
+  }
+  std::shared_ptr<arrow::Array> array;
+  twisterx::Status status = CombineColumn(ctx, table->column(column_index), &array);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::shared_ptr<RangePartitionKernel> kernel;
+  status = CreateRangePartitionKernel(array->type(), ascending, &kernel);
+  if (!status.is_ok()) {
+    return status;
+  }
+  status = ChooseSplitters(ctx, table->field(column_index), array, no_of_partitions, distributed, false,
+                           kernel.get());
+  if (!status.is_ok()) {
+    return status;
+  }
 
-  auto row_comp = RowComparator(ctx, tables, &eq_calls, &hash_calls);
+  PartitionIds partitions;
+  kernel->Partition(array, &partitions);
+  std::vector<int> targets;
+  for (int t = 0; t < no_of_partitions; t++) {
+    targets.push_back(t);
+  }
+  int threads = std::stoi(ctx->GetConfig(TWISTERX_SPLIT_THREADS, "1"));
+  return SplitTable(table, partitions, targets, twisterx::ToArrowPool(ctx), out, threads);
+}
 
-  auto buckets_pre_alloc = (ltab->num_rows() + rtab->num_rows());
-  LOG(INFO) << "Buckets : " << buckets_pre_alloc;
-  std::unordered_set<std::pair<int8_t, int64_t>, RowComparator, RowComparator> rows_set(
-      buckets_pre_alloc,
-      row_comp, row_comp
-  );
+twisterx::Status RangePartition(twisterx::TwisterXContext *ctx,
+                                const std::string &id,
+                                int column_index,
+                                int no_of_partitions,
+                                std::unordered_map<int, std::string> *out,
+                                bool ascending) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
+  std::unordered_map<int, std::shared_ptr<arrow::Table>> partitions;
+  twisterx::Status status = RangePartitionTable(ctx, table, column_index, no_of_partitions, ascending, false,
+                                                &partitions);
+  if (!status.is_ok()) {
+    return status;
+  }
+  for (const auto &partition : partitions) {
+    out->insert(std::pair<int, std::string>(partition.first, PutTable(partition.second)));
+  }
+  return twisterx::Status::OK();
+}
 
-  auto t1 = std::chrono::steady_clock::now();
+twisterx::Status DistributedRangePartition(twisterx::TwisterXContext *ctx,
+                                           const std::string &id,
+                                           int column_index,
+                                           const std::string &dest_id,
+                                           bool ascending) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
+  if (ctx->GetWorldSize() == 1) {
+    PutTable(dest_id, table);
+    return twisterx::Status::OK();
+  }
 
-  int64_t max = std::max(ltab->num_rows(), rtab->num_rows());
-  int8_t table0 = 0;
-  int8_t table1 = 1;
-  int64_t print_threshold = max / 10;
-  for (int64_t row = 0; row < max; ++row) {
-    if (row < ltab->num_rows()) {
-      rows_set.insert(std::pair<int8_t, int64_t>(table0, row));
-    }
+  int64_t partition_start = EdgeMetrics::Now();
+  std::unordered_map<int, std::shared_ptr<arrow::Table>> partitions;
+  twisterx::Status status = RangePartitionTable(ctx, table, column_index, ctx->GetWorldSize(), ascending, true,
+                                                &partitions);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::vector<std::shared_ptr<arrow::Table>> received_tables;
+  std::shared_ptr<EdgeMetrics> metrics;
+  status = ExchangePartitions(ctx, partitions, table->schema(), ctx->GetReusableEdge(0), partition_start,
+                              &received_tables, &metrics);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::shared_ptr<arrow::Table> final_table;
+  status = ConcatenatePartitions(ctx, received_tables, metrics, &final_table);
+  if (status.is_ok()) {
+    PutTable(dest_id, final_table);
+  }
+  return status;
+}
 
-    if (row < rtab->num_rows()) {
-      rows_set.insert(std::pair<int8_t, int64_t>(table1, row));
+/**
+ * Partition a table sorted on the partitioned column. The partitions of a sorted table are contiguous, so they are
+ * slices of the table, we only split the table if they are not.
+ */
+static twisterx::Status PartitionSortedTable(twisterx::TwisterXContext *ctx,
+                                             const std::shared_ptr<arrow::Table> &table,
+                                             const PartitionIds &partitions,
+                                             std::unordered_map<int, std::shared_ptr<arrow::Table>> *out) {
+  bool contiguous = true;
+  partitions.Visit([&](const auto *ids) {
+    for (int64_t i = 1; i < partitions.Length() && contiguous; i++) {
+      contiguous = ids[i - 1] <= ids[i];
     }
-
-    if (row % print_threshold == 0) {
-      LOG(INFO) << "Done " << (row + 1) * 100 / max << "%" << " N : " << row << ", Eq : " << eq_calls << ", Hs : "
-                << hash_calls;
+  });
+  if (!contiguous) {
+    std::vector<int> targets;
+    for (uint32_t t = 0; t < partitions.NumPartitions(); t++) {
+      targets.push_back(t);
     }
+    return SplitTable(table, partitions, targets, twisterx::ToArrowPool(ctx), out);
   }
-
-  auto t2 = std::chrono::steady_clock::now();
-
-  LOG(INFO) << "Adding to Set took " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << "ms";
-
-  std::vector<int64_t> indices_from_tabs[2];
-
-  for (auto const &pr:rows_set) {
-    indices_from_tabs[pr.first].push_back(pr.second);
+  int64_t offset = 0;
+  for (uint32_t p = 0; p < partitions.NumPartitions(); p++) {
+    int64_t count = partitions.Counts()[p];
+    out->insert(std::make_pair(p, table->Slice(offset, count)));
+    offset += count;
   }
+  return twisterx::Status::OK();
+}
 
-  std::vector<std::shared_ptr<arrow::ChunkedArray>> final_data_arrays;
+/**
+ * Merge the sorted runs received from the ranks into a single sorted table
+ */
+static twisterx::Status MergeSortedTables(twisterx::TwisterXContext *ctx,
+                                          const std::vector<std::shared_ptr<arrow::Table>> &runs,
+                                          int column_index,
+                                          bool ascending,
+                                          std::shared_ptr<arrow::Table> *out) {
+  std::shared_ptr<arrow::Table> combined;
+  twisterx::Status status = ConcatenatePartitions(ctx, runs, nullptr, &combined);
+  if (!status.is_ok() || runs.size() == 1) {
+    *out = combined;
+    return status;
+  }
 
-  t1 = std::chrono::steady_clock::now();
-  // prepare final arrays
-  for (int32_t c = 0; c < ltab->num_columns(); c++) {
-    arrow::ArrayVector array_vector;
-    for (int tab_idx = 0; tab_idx < 2; tab_idx++) {
-      std::shared_ptr<arrow::Array> destination_col_array;
-      arrow::Status
-          status =
-          twisterx::util::copy_array_by_indices(std::make_shared<std::vector<int64_t>>(indices_from_tabs[tab_idx]),
-                                                tables[tab_idx]->column(c)->chunk(0),
-                                                &destination_col_array,
-                                                twisterx::ToArrowPool(ctx));
-      if (status != arrow::Status::OK()) {
-        LOG(FATAL) << "Failed while copying a column to the final table from tables." << status.ToString();
-        return twisterx::Status((int) status.code(), status.message());
-      }
-      array_vector.push_back(destination_col_array);
+  std::vector<std::shared_ptr<arrow::Array>> keys;
+  for (const auto &run : runs) {
+    std::shared_ptr<arrow::Array> key;
+    status = CombineColumn(ctx, run->column(column_index), &key);
+    if (!status.is_ok()) {
+      return status;
     }
-    final_data_arrays.push_back(std::make_shared<arrow::ChunkedArray>(array_vector));
+    keys.push_back(key);
   }
-  t2 = std::chrono::steady_clock::now();
-
-  LOG(INFO) << "Final array preparation took " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count()
-            << "ms";
-
+  arrow::MemoryPool *pool = twisterx::ToArrowPool(ctx);
+  std::shared_ptr<arrow::Array> indices;
+  arrow::Status arrow_status = MergeSortedRuns(pool, keys, ascending, &indices);
+  if (arrow_status.ok()) {
+    arrow_status = TakeTable(ctx, combined, indices, out);
+  }
+  return twisterx::Status((int) arrow_status.code(), arrow_status.message());
+}
 
-  // create final table
-  std::shared_ptr<arrow::Table> table = arrow::Table::Make(ltab->schema(), final_data_arrays);
-  PutTable(dest_id, table);
-  return twisterx::Status::OK();
+/**
+ * Gather the rows of every rank and compute the balance, rank 0 logs it
+ */
+static void GatherSortBalance(twisterx::TwisterXContext *ctx, int64_t rows, SortBalance *balance) {
+  std::vector<uint8_t> send(sizeof(int64_t));
+  std::memcpy(send.data(), &rows, sizeof(int64_t));
+  std::vector<std::vector<uint8_t>> gathered;
+  ctx->GetCommunicator()->AllGather(send, &gathered);
+
+  SortBalance result;
+  int64_t total = 0;
+  for (const auto &data : gathered) {
+    int64_t rank_rows;
+    std::memcpy(&rank_rows, data.data(), sizeof(int64_t));
+    result.rows.push_back(rank_rows);
+    total += rank_rows;
+  }
+  result.min_rows = *std::min_element(result.rows.begin(), result.rows.end());
+  result.max_rows = *std::max_element(result.rows.begin(), result.rows.end());
+  result.mean_rows = static_cast<double>(total) / result.rows.size();
+  result.imbalance = result.mean_rows > 0 ? result.max_rows / result.mean_rows : 1.0;
+  if (ctx->GetRank() == 0) {
+    LOG(INFO) << "Sort balance, rows min " << result.min_rows << " max " << result.max_rows
+              << " mean " << result.mean_rows << " imbalance " << result.imbalance;
+  }
+  if (balance != nullptr) {
+    *balance = result;
+  }
 }
 
-twisterx::Status DistributedUnion(twisterx::TwisterXContext *ctx,
-                                  const std::string &table_left,
-                                  const std::string &table_right,
-                                  const std::string &dest_id) {
-  // extract the tables out
-  auto left = GetTable(table_left);
-  auto right = GetTable(table_right);
+twisterx::Status DistributedSort(twisterx::TwisterXContext *ctx,
+                                 const std::string &id,
+                                 int column_index,
+                                 const std::string &dest_id,
+                                 bool ascending,
+                                 SortBalance *balance) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
 
+  // sort the rows of this rank
+  int64_t sort_start = EdgeMetrics::Now();
+  std::shared_ptr<arrow::Table> sorted;
+  twisterx::Status status = SortTableByColumn(ctx, table, column_index, ascending, &sorted);
+  if (!status.is_ok()) {
+    return status;
+  }
   if (ctx->GetWorldSize() == 1) {
-    return Union(ctx, table_left, table_right, dest_id);
+    PutTable(dest_id, sorted);
+    GatherSortBalance(ctx, sorted->num_rows(), balance);
+    return twisterx::Status::OK();
   }
 
-  if (left->num_columns() != right->num_columns()) {
-    return twisterx::Status(twisterx::Invalid, "The no of columns of two tables are not similar. Can't perform union.");
+  // choose the splitters from regular samples of the sorted rows of every rank
+  int64_t partition_start = EdgeMetrics::Now();
+  std::shared_ptr<arrow::Array> keys;
+  status = CombineColumn(ctx, sorted->column(column_index), &keys);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::shared_ptr<RangePartitionKernel> kernel;
+  status = CreateRangePartitionKernel(keys->type(), ascending, &kernel);
+  if (!status.is_ok()) {
+    return status;
+  }
+  status = ChooseSplitters(ctx, sorted->field(column_index), keys, ctx->GetWorldSize(), true, true, kernel.get());
+  if (!status.is_ok()) {
+    return status;
+  }
+  PartitionIds partitions;
+  kernel->Partition(keys, &partitions);
+  std::unordered_map<int, std::shared_ptr<arrow::Table>> runs;
+  status = PartitionSortedTable(ctx, sorted, partitions, &runs);
+  if (!status.is_ok()) {
+    return status;
   }
 
-  for (int fd = 0; fd < left->num_columns(); ++fd) {
-    if (!left->field(fd)->type()->Equals(right->field(fd)->type())) {
-      return twisterx::Status(twisterx::Invalid, "The fields of two tables are not similar. Can't perform union.");
-    }
+  // send the runs to the ranks of their ranges, and merge the runs we receive
+  std::vector<std::shared_ptr<arrow::Table>> received_tables;
+  std::shared_ptr<EdgeMetrics> metrics;
+  status = ExchangePartitions(ctx, runs, sorted->schema(), ctx->GetReusableEdge(0), partition_start,
+                              &received_tables, &metrics);
+  if (!status.is_ok()) {
+    return status;
+  }
+  int64_t merge_start = EdgeMetrics::Now();
+  std::shared_ptr<arrow::Table> final_table;
+  status = MergeSortedTables(ctx, received_tables, column_index, ascending, &final_table);
+  if (!status.is_ok()) {
+    return status;
+  }
+  if (metrics != nullptr) {
+    metrics->AddPhase("sort", sort_start, partition_start);
+    metrics->AddPhase("merge", merge_start, EdgeMetrics::Now());
   }
+  PutTable(dest_id, final_table);
+  GatherSortBalance(ctx, final_table->num_rows(), balance);
+  return twisterx::Status::OK();
+}
 
-  std::vector<int32_t> hash_columns;
-  hash_columns.reserve(left->num_columns());
-  for (int kI = 0; kI < left->num_columns(); ++kI) {
-    hash_columns.push_back(kI);
+/**
+ * Take the first k rows of the table in the order of the keys
+ */
+static twisterx::Status TopKTable(twisterx::TwisterXContext *ctx,
+                                  const std::shared_ptr<arrow::Table> &table,
+                                  const std::vector<twisterx::sort::config::SortKey> &keys,
+                                  int64_t k,
+                                  std::shared_ptr<arrow::Table> *out) {
+  arrow::MemoryPool *pool = twisterx::ToArrowPool(ctx);
+  std::shared_ptr<arrow::Array> indices;
+  int threads = std::stoi(ctx->GetConfig(TWISTERX_SORT_THREADS, "1"));
+  arrow::Status status = TopKIndices(pool, table, keys, k, &indices, threads);
+  if (!status.ok()) {
+    return twisterx::Status((int) status.code(), status.message());
   }
+  status = TakeTable(ctx, table, indices, out);
+  return twisterx::Status((int) status.code(), status.message());
+}
 
-  std::shared_ptr<arrow::Table> left_final_table;
-  std::shared_ptr<arrow::Table> right_final_table;
+twisterx::Status TopK(twisterx::TwisterXContext *ctx,
+                      const std::string &id,
+                      const std::string &dest_id,
+                      const std::vector<twisterx::sort::config::SortKey> &keys,
+                      int64_t k) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
+  std::shared_ptr<arrow::Table> top;
+  twisterx::Status status = TopKTable(ctx, table, keys, k, &top);
+  if (!status.is_ok()) {
+    return status;
+  }
+  PutTable(dest_id, top);
+  return twisterx::Status::OK();
+}
 
-  auto shuffle_status = ShuffleTwoTables(ctx,
-                                         table_left,
+twisterx::Status DistributedTopK(twisterx::TwisterXContext *ctx,
+                                 const std::string &id,
+                                 const std::string &dest_id,
+                                 const std::vector<twisterx::sort::config::SortKey> &keys,
+                                 int64_t k) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
+  // the global top k rows are among the top k rows of the ranks
+  std::shared_ptr<arrow::Table> candidates;
+  twisterx::Status status = TopKTable(ctx, table, keys, k, &candidates);
+  if (!status.is_ok()) {
+    return status;
+  }
+  if (ctx->GetWorldSize() == 1) {
+    PutTable(dest_id, candidates);
+    return twisterx::Status::OK();
+  }
+
+  std::vector<std::shared_ptr<arrow::Table>> gathered;
+  arrow::Status arrow_status = GatherTables(ctx, candidates, 0, &gathered);
+  if (!arrow_status.ok()) {
+    return twisterx::Status((int) arrow_status.code(), arrow_status.message());
+  }
+  std::shared_ptr<arrow::Table> top;
+  if (ctx->GetRank() == 0) {
+    // the candidates are in the order of the ranks, so the ties keep the order of the ranks
+    arrow::Result<std::shared_ptr<arrow::Table>> concat = arrow::ConcatenateTables(gathered);
+    if (!concat.ok()) {
+      return twisterx::Status((int) concat.status().code(), concat.status().message());
+    }
+    status = TopKTable(ctx, concat.ValueOrDie(), keys, k, &top);
+    if (!status.is_ok()) {
+      return status;
+    }
+  } else {
+    top = candidates->Slice(0, 0);
+  }
+  PutTable(dest_id, top);
+  return twisterx::Status::OK();
+}
+
+/**
+ * Check that the tables of a set operation have the same column types
+ */
+static twisterx::Status CheckSetOperands(const std::shared_ptr<arrow::Table> &left,
+                                         const std::shared_ptr<arrow::Table> &right,
+                                         const std::string &operation) {
+  // manual field check. todo check why  ltab->schema()->Equals(rtab->schema(), false) doesn't work
+  if (left->num_columns() != right->num_columns()) {
+    return twisterx::Status(twisterx::Invalid,
+                            "The no of columns of two tables are not similar. Can't perform " + operation + ".");
+  }
+  for (int fd = 0; fd < left->num_columns(); ++fd) {
+    if (!left->field(fd)->type()->Equals(right->field(fd)->type())) {
+      return twisterx::Status(twisterx::Invalid,
+                              "The fields of two tables are not similar. Can't perform " + operation + ".");
+    }
+  }
+  return twisterx::Status::OK();
+}
+
+/**
+ * The rows of tables with the same columns, ready to be put in a RowHashTable
+ */
+struct HashedRows {
+  // the tables, only their key columns are combined into single arrays
+  std::vector<std::shared_ptr<arrow::Table>> tables;
+  // the hashes of the rows of each table over the key columns
+  std::vector<std::vector<uint32_t>> hashes;
+  // compares the rows over the key columns
+  std::unique_ptr<twisterx::RowEquality> equality;
+};
+
+/**
+ * Hash the rows of the tables over the key columns, a column at a time with the hash kernels of the partitioner
+ */
+static twisterx::Status HashTableRows(twisterx::TwisterXContext *ctx,
+                                      const std::vector<std::shared_ptr<arrow::Table>> &tables,
+                                      const std::vector<int> &key_columns,
+                                      HashedRows *out) {
+  arrow::MemoryPool *pool = twisterx::ToArrowPool(ctx);
+  util::HashAlgorithm algorithm;
+  twisterx::Status status = GetHashAlgorithm(ctx, &algorithm);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::vector<std::vector<std::shared_ptr<arrow::Array>>> keys(tables.size());
+  out->tables = tables;
+  out->hashes.resize(tables.size());
+  for (size_t t = 0; t < tables.size(); t++) {
+    for (int c : key_columns) {
+      if (c < 0 || c >= tables[t]->num_columns()) {
+        return twisterx::Status(twisterx::IndexError, "Invalid column " + std::to_string(c));
+      }
+      std::shared_ptr<arrow::Array> array;
+      status = CombineColumn(ctx, tables[t]->column(c), &array);
+      if (!status.is_ok()) {
+        return status;
+      }
+      keys[t].push_back(array);
+    }
+    status = twisterx::HashRows(pool, keys[t], tables[t]->num_rows(), &out->hashes[t], algorithm);
+    if (!status.is_ok()) {
+      return status;
+    }
+  }
+  arrow::Status arrow_status = twisterx::RowEquality::Make(keys, &out->equality);
+  return twisterx::Status((int) arrow_status.code(), arrow_status.message());
+}
+
+/**
+ * All the columns of the table
+ */
+static std::vector<int> AllColumns(const std::shared_ptr<arrow::Table> &table) {
+  std::vector<int> columns(table->num_columns());
+  std::iota(columns.begin(), columns.end(), 0);
+  return columns;
+}
+
+/**
+ * Copy the rows of the tables to a new table, the rows taken from each table are a chunk of the new table. The null
+ * values of the rows stay null.
+ * @param indices the rows to take from each table, indices[t] for the table t
+ */
+static twisterx::Status TakeRows(twisterx::TwisterXContext *ctx,
+                                 const HashedRows &rows,
+                                 const std::shared_ptr<arrow::Schema> &schema,
+                                 const std::vector<std::vector<int64_t>> &indices,
+                                 std::shared_ptr<arrow::Table> *out) {
+  std::vector<std::shared_ptr<arrow::ChunkedArray>> final_data_arrays;
+  for (int32_t c = 0; c < schema->num_fields(); c++) {
+    arrow::ArrayVector array_vector;
+    for (size_t tab_idx = 0; tab_idx < indices.size(); tab_idx++) {
+      std::shared_ptr<arrow::Array> destination_col_array;
+      arrow::Status status = twisterx::util::copy_chunked_array_by_indices(
+          std::make_shared<std::vector<int64_t>>(indices[tab_idx]),
+          rows.tables[tab_idx]->column(c),
+          &destination_col_array,
+          twisterx::ToArrowPool(ctx));
+      if (status != arrow::Status::OK()) {
+        LOG(FATAL) << "Failed while copying a column to the final table from tables." << status.ToString();
+        return twisterx::Status((int) status.code(), status.message());
+      }
+      array_vector.push_back(destination_col_array);
+    }
+    final_data_arrays.push_back(std::make_shared<arrow::ChunkedArray>(array_vector, schema->field(c)->type()));
+  }
+  *out = arrow::Table::Make(schema, final_data_arrays);
+  return twisterx::Status::OK();
+}
+
+twisterx::Status Union(twisterx::TwisterXContext *ctx,
+                       const std::string &table_left,
+                       const std::string &table_right,
+                       const std::string &dest_id) {
+  auto ltab = GetTable(table_left);
+  auto rtab = GetTable(table_right);
+  if (ltab == NULLPTR || rtab == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the tables " + table_left + ", " + table_right);
+  }
+  twisterx::Status status = CheckSetOperands(ltab, rtab, "union");
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  HashedRows hashed;
+  status = HashTableRows(ctx, {ltab, rtab}, AllColumns(ltab), &hashed);
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  auto t1 = std::chrono::steady_clock::now();
+  twisterx::RowHashTable rows_set(hashed.equality.get(), ltab->num_rows() + rtab->num_rows());
+  for (int tab_idx = 0; tab_idx < 2; tab_idx++) {
+    const uint32_t *hashes = hashed.hashes[tab_idx].data();
+    const int64_t rows = hashed.hashes[tab_idx].size();
+    for (int64_t row = 0; row < rows; ++row) {
+      rows_set.FindOrInsert(hashes[row], tab_idx, row);
+    }
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  LOG(INFO) << "Adding to Set took " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << "ms";
+
+  // the distinct rows in the order they were added
+  std::vector<std::vector<int64_t>> indices_from_tabs(2);
+  for (int64_t id = 0; id < rows_set.Size(); id++) {
+    indices_from_tabs[rows_set.Table(id)].push_back(rows_set.Row(id));
+  }
+
+  t1 = std::chrono::steady_clock::now();
+  std::shared_ptr<arrow::Table> table;
+  status = TakeRows(ctx, hashed, ltab->schema(), indices_from_tabs, &table);
+  if (!status.is_ok()) {
+    return status;
+  }
+  t2 = std::chrono::steady_clock::now();
+
+  LOG(INFO) << "Final array preparation took " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count()
+            << "ms";
+
+  PutTable(dest_id, table);
+  return twisterx::Status::OK();
+}
+
+twisterx::Status UnionAll(twisterx::TwisterXContext *ctx,
+                          const std::string &table_left,
+                          const std::string &table_right,
+                          const std::string &dest_id) {
+  auto ltab = GetTable(table_left);
+  auto rtab = GetTable(table_right);
+  if (ltab == NULLPTR || rtab == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the tables " + table_left + ", " + table_right);
+  }
+  twisterx::Status status = CheckSetOperands(ltab, rtab, "union all");
+  if (!status.is_ok()) {
+    return status;
+  }
+  // the chunks of the tables are the chunks of the result, nothing is copied
+  arrow::Result<std::shared_ptr<arrow::Table>> result = arrow::ConcatenateTables({ltab, rtab});
+  if (!result.ok()) {
+    return twisterx::Status((int) result.status().code(), result.status().message());
+  }
+  PutTable(dest_id, result.ValueOrDie());
+  return twisterx::Status::OK();
+}
+
+/**
+ * Intersect or subtract the rows of the right table from the left table. The right rows are counted in a
+ * RowHashTable, and the left rows are probed against it, so the result only holds rows of the left table.
+ */
+static twisterx::Status IntersectOrSubtract(twisterx::TwisterXContext *ctx,
+                                            const std::string &table_left,
+                                            const std::string &table_right,
+                                            const std::string &dest_id,
+                                            bool intersect,
+                                            twisterx::SetSemantics semantics) {
+  auto left = GetTable(table_left);
+  auto right = GetTable(table_right);
+  if (left == NULLPTR || right == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the tables " + table_left + ", " + table_right);
+  }
+  twisterx::Status status = CheckSetOperands(left, right, intersect ? "intersect" : "subtract");
+  if (!status.is_ok()) {
+    return status;
+  }
+  HashedRows hashed;
+  status = HashTableRows(ctx, {left, right}, AllColumns(left), &hashed);
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  // the distinct rows of the right table and the number of times each occurs
+  twisterx::RowHashTable rows_set(hashed.equality.get(), left->num_rows() + right->num_rows());
+  std::vector<int64_t> counts;
+  const uint32_t *right_hashes = hashed.hashes[1].data();
+  for (int64_t row = 0; row < right->num_rows(); row++) {
+    int64_t id = rows_set.FindOrInsert(right_hashes[row], 1, row);
+    if (id == static_cast<int64_t>(counts.size())) {
+      counts.push_back(0);
+    }
+    counts[id]++;
+  }
+  const int64_t right_distinct = rows_set.Size();
+
+  std::vector<std::vector<int64_t>> indices(1);
+  std::vector<int64_t> &left_indices = indices[0];
+  const uint32_t *left_hashes = hashed.hashes[0].data();
+  for (int64_t row = 0; row < left->num_rows(); row++) {
+    bool take;
+    if (semantics == twisterx::SET) {
+      // the left rows are added as well, so a row is taken only the first time it is seen
+      bool inserted;
+      int64_t id = rows_set.FindOrInsert(left_hashes[row], 0, row, &inserted);
+      if (intersect) {
+        take = id < right_distinct && counts[id] > 0;
+        if (take) {
+          counts[id] = 0;
+        }
+      } else {
+        take = inserted;
+      }
+    } else {
+      // each right row matches one left row, intersect takes the matched rows and subtract the rest
+      int64_t id = rows_set.Find(left_hashes[row], 0, row);
+      bool matched = id >= 0 && counts[id] > 0;
+      if (matched) {
+        counts[id]--;
+      }
+      take = intersect == matched;
+    }
+    if (take) {
+      left_indices.push_back(row);
+    }
+  }
+
+  std::shared_ptr<arrow::Table> table;
+  status = TakeRows(ctx, hashed, left->schema(), indices, &table);
+  if (!status.is_ok()) {
+    return status;
+  }
+  PutTable(dest_id, table);
+  return twisterx::Status::OK();
+}
+
+twisterx::Status Intersect(twisterx::TwisterXContext *ctx,
+                           const std::string &table_left,
+                           const std::string &table_right,
+                           const std::string &dest_id,
+                           twisterx::SetSemantics semantics) {
+  return IntersectOrSubtract(ctx, table_left, table_right, dest_id, true, semantics);
+}
+
+twisterx::Status Subtract(twisterx::TwisterXContext *ctx,
+                          const std::string &table_left,
+                          const std::string &table_right,
+                          const std::string &dest_id,
+                          twisterx::SetSemantics semantics) {
+  return IntersectOrSubtract(ctx, table_left, table_right, dest_id, false, semantics);
+}
+
+/**
+ * The rows of the table kept by Distinct, in the order of the table
+ */
+static void DistinctRows(const HashedRows &hashed, twisterx::DistinctKeep keep, std::vector<int64_t> *rows) {
+  const std::vector<uint32_t> &hashes = hashed.hashes[0];
+  const int64_t num_rows = hashes.size();
+  twisterx::RowHashTable rows_set(hashed.equality.get(), num_rows);
+  if (keep == twisterx::KEEP_FIRST) {
+    for (int64_t row = 0; row < num_rows; row++) {
+      bool inserted;
+      rows_set.FindOrInsert(hashes[row], 0, row, &inserted);
+      if (inserted) {
+        rows->push_back(row);
+      }
+    }
+    return;
+  }
+
+  std::vector<int64_t> ids(num_rows);
+  for (int64_t row = 0; row < num_rows; row++) {
+    ids[row] = rows_set.FindOrInsert(hashes[row], 0, row);
+  }
+  if (keep == twisterx::KEEP_LAST) {
+    std::vector<int64_t> last(rows_set.Size());
+    for (int64_t row = 0; row < num_rows; row++) {
+      last[ids[row]] = row;
+    }
+    for (int64_t row = 0; row < num_rows; row++) {
+      if (last[ids[row]] == row) {
+        rows->push_back(row);
+      }
+    }
+  } else {
+    std::vector<int64_t> counts(rows_set.Size(), 0);
+    for (int64_t row = 0; row < num_rows; row++) {
+      counts[ids[row]]++;
+    }
+    for (int64_t row = 0; row < num_rows; row++) {
+      if (counts[ids[row]] == 1) {
+        rows->push_back(row);
+      }
+    }
+  }
+}
+
+/**
+ * Remove the duplicates of the key columns from the table
+ * @param hashes if not null, the hashes of the key columns of the rows kept
+ */
+static twisterx::Status DistinctTable(twisterx::TwisterXContext *ctx,
+                                      const std::shared_ptr<arrow::Table> &table,
+                                      const std::vector<int> &key_columns,
+                                      twisterx::DistinctKeep keep,
+                                      std::shared_ptr<arrow::Table> *out,
+                                      std::vector<uint32_t> *hashes) {
+  HashedRows hashed;
+  twisterx::Status status = HashTableRows(ctx, {table}, key_columns, &hashed);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::vector<std::vector<int64_t>> indices(1);
+  DistinctRows(hashed, keep, &indices[0]);
+  if (hashes != nullptr) {
+    hashes->clear();
+    hashes->reserve(indices[0].size());
+    for (int64_t row : indices[0]) {
+      hashes->push_back(hashed.hashes[0][row]);
+    }
+  }
+  return TakeRows(ctx, hashed, table->schema(), indices, out);
+}
+
+twisterx::Status Distinct(twisterx::TwisterXContext *ctx,
+                          const std::string &id,
+                          const std::string &dest_id,
+                          const std::vector<int> &columns,
+                          twisterx::DistinctKeep keep) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
+  std::shared_ptr<arrow::Table> distinct;
+  twisterx::Status status = DistinctTable(ctx, table, columns.empty() ? AllColumns(table) : columns, keep,
+                                          &distinct, nullptr);
+  if (!status.is_ok()) {
+    return status;
+  }
+  PutTable(dest_id, distinct);
+  return twisterx::Status::OK();
+}
+
+twisterx::Status DistributedDistinct(twisterx::TwisterXContext *ctx,
+                                     const std::string &id,
+                                     const std::string &dest_id,
+                                     const std::vector<int> &columns,
+                                     twisterx::DistinctKeep keep) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
+  if (ctx->GetWorldSize() == 1) {
+    return Distinct(ctx, id, dest_id, columns, keep);
+  }
+  const std::vector<int> key_columns = columns.empty() ? AllColumns(table) : columns;
+
+  // remove the duplicates of this rank before the shuffle, the hashes of the rows give their partitions as well
+  int64_t partition_start = EdgeMetrics::Now();
+  std::shared_ptr<arrow::Table> local;
+  std::vector<uint32_t> hashes;
+  twisterx::Status status;
+  if (keep == twisterx::KEEP_NONE) {
+    // a row without duplicates on this rank may have duplicates on another rank, so all the rows are shuffled
+    HashedRows hashed;
+    status = HashTableRows(ctx, {table}, key_columns, &hashed);
+    local = table;
+    hashes = std::move(hashed.hashes[0]);
+  } else {
+    status = DistinctTable(ctx, table, key_columns, keep, &local, &hashes);
+  }
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  std::vector<int> targets(ctx->GetWorldSize());
+  std::iota(targets.begin(), targets.end(), 0);
+  PartitionIds partitions;
+  HashesToPartitions(hashes, targets.size(), &partitions);
+  int threads = std::stoi(ctx->GetConfig(TWISTERX_SPLIT_THREADS, "1"));
+  std::unordered_map<int, std::shared_ptr<arrow::Table>> split_tables;
+  status = SplitTable(local, partitions, targets, twisterx::ToArrowPool(ctx), &split_tables, threads);
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  // the rows with equal keys are on the same rank after the shuffle, in the order of the ranks
+  std::vector<std::shared_ptr<arrow::Table>> received_tables;
+  std::shared_ptr<EdgeMetrics> metrics;
+  status = ExchangePartitions(ctx, split_tables, local->schema(), ctx->GetReusableEdge(0), partition_start,
+                              &received_tables, &metrics);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::shared_ptr<arrow::Table> shuffled;
+  status = ConcatenatePartitions(ctx, received_tables, metrics, &shuffled);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::shared_ptr<arrow::Table> distinct;
+  status = DistinctTable(ctx, shuffled, key_columns, keep, &distinct, nullptr);
+  if (!status.is_ok()) {
+    return status;
+  }
+  PutTable(dest_id, distinct);
+  return twisterx::Status::OK();
+}
+
+static twisterx::Status CheckAggregations(const std::shared_ptr<arrow::Table> &table,
+                                          const std::vector<twisterx::groupby::config::Aggregation> &aggregations) {
+  for (const auto &aggregation : aggregations) {
+    if (aggregation.GetColumnIdx() < 0 || aggregation.GetColumnIdx() >= table->num_columns()) {
+      return twisterx::Status(twisterx::IndexError, "Invalid column " + std::to_string(aggregation.GetColumnIdx()));
+    }
+  }
+  return twisterx::Status::OK();
+}
+
+/**
+ * Put the rows into the hash table of the groups
+ * @param group_ids the group id of each row
+ */
+static void InsertGroupRows(const HashedRows &hashed, int64_t begin, int64_t end,
+                            twisterx::RowHashTable *groups, std::vector<int64_t> *group_ids) {
+  const std::vector<uint32_t> &hashes = hashed.hashes[0];
+  for (int64_t row = begin; row < end; row++) {
+    (*group_ids)[row] = groups->FindOrInsert(hashes[row], 0, row);
+  }
+}
+
+/**
+ * The key columns of the groups, taken from the first rows of the groups. The group of the null keys keeps its null
+ * key, so it stays apart from the group of the zero keys when the keys are grouped again.
+ */
+static twisterx::Status TakeGroupKeys(twisterx::TwisterXContext *ctx,
+                                      const std::shared_ptr<arrow::Table> &table,
+                                      const std::vector<int> &key_columns,
+                                      const twisterx::RowHashTable &groups,
+                                      std::vector<std::shared_ptr<arrow::Field>> *fields,
+                                      std::vector<std::shared_ptr<arrow::Array>> *columns) {
+  auto first_rows = std::make_shared<std::vector<int64_t>>(groups.Size());
+  for (int64_t id = 0; id < groups.Size(); id++) {
+    (*first_rows)[id] = groups.Row(id);
+  }
+  for (int c : key_columns) {
+    std::shared_ptr<arrow::Array> keys;
+    arrow::Status status = twisterx::util::copy_chunked_array_by_indices(first_rows, table->column(c), &keys,
+                                                                         twisterx::ToArrowPool(ctx));
+    if (!status.ok()) {
+      return twisterx::Status((int) status.code(), status.message());
+    }
+    fields->push_back(table->schema()->field(c));
+    columns->push_back(keys);
+  }
+  return twisterx::Status::OK();
+}
+
+/**
+ * The key columns of the groups, taken from their first rows, followed by the aggregates of the groups or by their
+ * partial states
+ * @param partial true for the partial states of the aggregates, to be merged by MergeGroupStates
+ */
+static twisterx::Status AggregateGroups(twisterx::TwisterXContext *ctx,
+                                        const std::shared_ptr<arrow::Table> &table,
+                                        const std::vector<int> &key_columns,
+                                        const std::vector<twisterx::groupby::config::Aggregation> &aggregations,
+                                        const twisterx::RowHashTable &groups,
+                                        const std::vector<int64_t> &group_ids,
+                                        bool partial,
+                                        std::shared_ptr<arrow::Table> *out) {
+  const int64_t num_groups = groups.Size();
+  arrow::MemoryPool *pool = twisterx::ToArrowPool(ctx);
+  std::vector<std::shared_ptr<arrow::Field>> fields;
+  std::vector<std::shared_ptr<arrow::Array>> columns;
+  twisterx::Status status = TakeGroupKeys(ctx, table, key_columns, groups, &fields, &columns);
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  for (const auto &aggregation : aggregations) {
+    const auto &field = table->schema()->field(aggregation.GetColumnIdx());
+    const std::string name = field->name() + "_"
+        + twisterx::groupby::config::AggregationOpName(aggregation.GetOp());
+    std::unique_ptr<twisterx::AggregateKernel> kernel;
+    arrow::Status arrow_status = twisterx::CreateAggregateKernel(field->type(), aggregation.GetOp(), &kernel);
+    if (!arrow_status.ok()) {
+      return twisterx::Status((int) arrow_status.code(), arrow_status.message());
+    }
+    // the chunks are aggregated in place, with the group ids of their rows
+    int64_t offset = 0;
+    for (const auto &chunk : table->column(aggregation.GetColumnIdx())->chunks()) {
+      kernel->Update(*chunk, group_ids.data() + offset, num_groups);
+      offset += chunk->length();
+    }
+    if (partial) {
+      std::vector<std::shared_ptr<arrow::Array>> states;
+      arrow_status = kernel->States(pool, &states);
+      if (!arrow_status.ok()) {
+        return twisterx::Status((int) arrow_status.code(), arrow_status.message());
+      }
+      for (size_t s = 0; s < states.size(); s++) {
+        fields.push_back(arrow::field(name + "_state" + std::to_string(s), states[s]->type()));
+        columns.push_back(states[s]);
+      }
+    } else {
+      std::shared_ptr<arrow::Array> aggregates;
+      arrow_status = kernel->Finish(pool, &aggregates);
+      if (!arrow_status.ok()) {
+        return twisterx::Status((int) arrow_status.code(), arrow_status.message());
+      }
+      fields.push_back(arrow::field(name, kernel->OutputType()));
+      columns.push_back(aggregates);
+    }
+  }
+  *out = arrow::Table::Make(arrow::schema(fields), columns);
+  return twisterx::Status::OK();
+}
+
+/**
+ * Group the rows of the table on the key columns and aggregate each group
+ */
+static twisterx::Status GroupByTable(twisterx::TwisterXContext *ctx,
+                                     const std::shared_ptr<arrow::Table> &table,
+                                     const std::vector<int> &key_columns,
+                                     const std::vector<twisterx::groupby::config::Aggregation> &aggregations,
+                                     std::shared_ptr<arrow::Table> *out) {
+  twisterx::Status status = CheckAggregations(table, aggregations);
+  if (!status.is_ok()) {
+    return status;
+  }
+  HashedRows hashed;
+  status = HashTableRows(ctx, {table}, key_columns, &hashed);
+  if (!status.is_ok()) {
+    return status;
+  }
+  // map the rows to dense group ids, in the order of the first rows of the groups
+  const int64_t num_rows = table->num_rows();
+  twisterx::RowHashTable groups(hashed.equality.get(), num_rows);
+  std::vector<int64_t> group_ids(num_rows);
+  InsertGroupRows(hashed, 0, num_rows, &groups, &group_ids);
+  return AggregateGroups(ctx, table, key_columns, aggregations, groups, group_ids, false, out);
+}
+
+/**
+ * Merge the partial states of a table made by AggregateGroups, the states of equal keys may come from many ranks.
+ * The null keys of the states are null, so the null key groups of the ranks merge only with each other.
+ * @param schema the schema of the table aggregated into the partial states
+ * @param num_keys the number of key columns, the first columns of the partial states
+ */
+static twisterx::Status MergeGroupStates(twisterx::TwisterXContext *ctx,
+                                         const std::shared_ptr<arrow::Table> &states,
+                                         const std::shared_ptr<arrow::Schema> &schema,
+                                         int num_keys,
+                                         const std::vector<twisterx::groupby::config::Aggregation> &aggregations,
+                                         std::shared_ptr<arrow::Table> *out) {
+  std::vector<int> key_columns(num_keys);
+  std::iota(key_columns.begin(), key_columns.end(), 0);
+  HashedRows hashed;
+  twisterx::Status status = HashTableRows(ctx, {states}, key_columns, &hashed);
+  if (!status.is_ok()) {
+    return status;
+  }
+  const int64_t num_rows = states->num_rows();
+  twisterx::RowHashTable groups(hashed.equality.get(), num_rows);
+  std::vector<int64_t> group_ids(num_rows);
+  InsertGroupRows(hashed, 0, num_rows, &groups, &group_ids);
+  const int64_t num_groups = groups.Size();
+  arrow::MemoryPool *pool = twisterx::ToArrowPool(ctx);
+  std::vector<std::shared_ptr<arrow::Field>> fields;
+  std::vector<std::shared_ptr<arrow::Array>> columns;
+  status = TakeGroupKeys(ctx, states, key_columns, groups, &fields, &columns);
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  int state_column = num_keys;
+  for (const auto &aggregation : aggregations) {
+    const auto &field = schema->field(aggregation.GetColumnIdx());
+    std::unique_ptr<twisterx::AggregateKernel> kernel;
+    arrow::Status arrow_status = twisterx::CreateAggregateKernel(field->type(), aggregation.GetOp(), &kernel);
+    if (!arrow_status.ok()) {
+      return twisterx::Status((int) arrow_status.code(), arrow_status.message());
+    }
+    // the states are small next to the rows, so they are combined rather than merged a chunk at a time
+    std::vector<std::shared_ptr<arrow::Array>> kernel_states;
+    for (int s = 0; s < kernel->NumStates(); s++) {
+      std::shared_ptr<arrow::Array> state;
+      status = CombineColumn(ctx, states->column(state_column++), &state);
+      if (!status.is_ok()) {
+        return status;
+      }
+      kernel_states.push_back(state);
+    }
+    kernel->Merge(kernel_states, group_ids.data(), num_groups);
+    std::shared_ptr<arrow::Array> aggregates;
+    arrow_status = kernel->Finish(pool, &aggregates);
+    if (!arrow_status.ok()) {
+      return twisterx::Status((int) arrow_status.code(), arrow_status.message());
+    }
+    fields.push_back(arrow::field(
+        field->name() + "_" + twisterx::groupby::config::AggregationOpName(aggregation.GetOp()),
+        kernel->OutputType()));
+    columns.push_back(aggregates);
+  }
+  *out = arrow::Table::Make(arrow::schema(fields), columns);
+  return twisterx::Status::OK();
+}
+
+twisterx::Status GroupBy(twisterx::TwisterXContext *ctx,
+                         const std::string &id,
+                         const std::string &dest_id,
+                         const std::vector<int> &key_columns,
+                         const std::vector<twisterx::groupby::config::Aggregation> &aggregations) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
+  std::shared_ptr<arrow::Table> grouped;
+  twisterx::Status status = GroupByTable(ctx, table, key_columns, aggregations, &grouped);
+  if (!status.is_ok()) {
+    return status;
+  }
+  PutTable(dest_id, grouped);
+  return twisterx::Status::OK();
+}
+
+twisterx::Status DistributedGroupBy(twisterx::TwisterXContext *ctx,
+                                    const std::string &id,
+                                    const std::string &dest_id,
+                                    const std::vector<int> &key_columns,
+                                    const std::vector<twisterx::groupby::config::Aggregation> &aggregations) {
+  auto table = GetTable(id);
+  if (table == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the table " + id);
+  }
+  if (ctx->GetWorldSize() == 1) {
+    return GroupBy(ctx, id, dest_id, key_columns, aggregations);
+  }
+  twisterx::Status status = CheckAggregations(table, aggregations);
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  int64_t partition_start = EdgeMetrics::Now();
+  HashedRows hashed;
+  status = HashTableRows(ctx, {table}, key_columns, &hashed);
+  if (!status.is_ok()) {
+    return status;
+  }
+  const int64_t num_rows = table->num_rows();
+  twisterx::RowHashTable groups(hashed.equality.get(), num_rows);
+  std::vector<int64_t> group_ids(num_rows);
+
+  // group the first rows of each rank, and choose for all the ranks whether the partial states are worth computing
+  int64_t sample_rows = std::min(num_rows, static_cast<int64_t>(
+      std::stoll(ctx->GetConfig(TWISTERX_GROUPBY_PARTIAL_SAMPLE, "100000"))));
+  InsertGroupRows(hashed, 0, sample_rows, &groups, &group_ids);
+  int64_t sampled[2] = {sample_rows, groups.Size()};
+  int64_t total_sampled[2];
+  ctx->GetCommunicator()->AllReduce(sampled, total_sampled, 2, twisterx::Type::INT64, twisterx::net::SUM);
+  double max_ratio = std::stod(ctx->GetConfig(TWISTERX_GROUPBY_PARTIAL_RATIO, "0.9"));
+  double ratio = total_sampled[0] > 0 ? static_cast<double>(total_sampled[1]) / total_sampled[0] : 0;
+  bool partial = ratio <= max_ratio;
+  if (ctx->GetRank() == 0) {
+    LOG(INFO) << "Group by sampled " << total_sampled[0] << " rows into " << total_sampled[1] << " groups, "
+              << (partial ? "aggregating" : "not aggregating") << " before the shuffle";
+  }
+
+  std::shared_ptr<arrow::Table> local;
+  std::vector<uint32_t> hashes;
+  std::vector<int> shuffled_keys(key_columns.size());
+  std::iota(shuffled_keys.begin(), shuffled_keys.end(), 0);
+  std::vector<twisterx::groupby::config::Aggregation> shuffled_aggregations;
+  if (partial) {
+    // the keys of the groups followed by the partial states, the hash of a group is the hash of its first row
+    InsertGroupRows(hashed, sample_rows, num_rows, &groups, &group_ids);
+    status = AggregateGroups(ctx, table, key_columns, aggregations, groups, group_ids, true, &local);
+    if (!status.is_ok()) {
+      return status;
+    }
+    hashes.resize(groups.Size());
+    for (int64_t group = 0; group < groups.Size(); group++) {
+      hashes[group] = hashed.hashes[0][groups.Row(group)];
+    }
+  } else {
+    // the key columns followed by the aggregated columns of the rows, without copying them
+    std::vector<int> columns = key_columns;
+    for (const auto &aggregation : aggregations) {
+      auto it = std::find(columns.begin() + key_columns.size(), columns.end(), aggregation.GetColumnIdx());
+      shuffled_aggregations.emplace_back(static_cast<int>(it - columns.begin()), aggregation.GetOp());
+      if (it == columns.end()) {
+        columns.push_back(aggregation.GetColumnIdx());
+      }
+    }
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    std::vector<std::shared_ptr<arrow::ChunkedArray>> arrays;
+    for (int c : columns) {
+      fields.push_back(table->schema()->field(c));
+      arrays.push_back(table->column(c));
+    }
+    local = arrow::Table::Make(arrow::schema(fields), arrays);
+    hashes = std::move(hashed.hashes[0]);
+  }
+
+  std::vector<int> targets(ctx->GetWorldSize());
+  std::iota(targets.begin(), targets.end(), 0);
+  PartitionIds partitions;
+  HashesToPartitions(hashes, targets.size(), &partitions);
+  int threads = std::stoi(ctx->GetConfig(TWISTERX_SPLIT_THREADS, "1"));
+  std::unordered_map<int, std::shared_ptr<arrow::Table>> split_tables;
+  status = SplitTable(local, partitions, targets, twisterx::ToArrowPool(ctx), &split_tables, threads);
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  // the states or the rows of equal keys are on the same rank after the shuffle
+  std::vector<std::shared_ptr<arrow::Table>> received_tables;
+  std::shared_ptr<EdgeMetrics> metrics;
+  status = ExchangePartitions(ctx, split_tables, local->schema(), ctx->GetReusableEdge(0), partition_start,
+                              &received_tables, &metrics);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::shared_ptr<arrow::Table> shuffled;
+  status = ConcatenatePartitions(ctx, received_tables, metrics, &shuffled);
+  if (!status.is_ok()) {
+    return status;
+  }
+  std::shared_ptr<arrow::Table> grouped;
+  if (partial) {
+    status = MergeGroupStates(ctx, shuffled, table->schema(), key_columns.size(), aggregations, &grouped);
+  } else {
+    status = GroupByTable(ctx, shuffled, shuffled_keys, shuffled_aggregations, &grouped);
+  }
+  if (!status.is_ok()) {
+    return status;
+  }
+  PutTable(dest_id, grouped);
+  return twisterx::Status::OK();
+}
+
+/**
+ * Shuffle the tables on the hashes of all their columns, so the equal rows of both tables are on the same rank,
+ * and apply the local set operation to the tables received by this rank
+ * @param local the set operation on the ids of the left and right tables of this rank
+ */
+static twisterx::Status DistributedSetOperation(
+    twisterx::TwisterXContext *ctx,
+    const std::string &table_left,
+    const std::string &table_right,
+    const std::string &operation,
+    const std::function<twisterx::Status(const std::string &, const std::string &)> &local) {
+  // extract the tables out
+  auto left = GetTable(table_left);
+  auto right = GetTable(table_right);
+  if (left == NULLPTR || right == NULLPTR) {
+    return twisterx::Status(twisterx::KeyError, "Couldn't find the tables " + table_left + ", " + table_right);
+  }
+
+  if (ctx->GetWorldSize() == 1) {
+    return local(table_left, table_right);
+  }
+
+  twisterx::Status status = CheckSetOperands(left, right, operation);
+  if (!status.is_ok()) {
+    return status;
+  }
+
+  std::vector<int32_t> hash_columns;
+  hash_columns.reserve(left->num_columns());
+  for (int kI = 0; kI < left->num_columns(); ++kI) {
+    hash_columns.push_back(kI);
+  }
+
+  std::shared_ptr<arrow::Table> left_final_table;
+  std::shared_ptr<arrow::Table> right_final_table;
+
+  auto shuffle_status = ShuffleTwoTables(ctx,
+                                         table_left,
                                          hash_columns,
                                          table_right,
                                          hash_columns,
@@ -682,9 +1869,8 @@ twisterx::Status DistributedUnion(twisterx::TwisterXContext *ctx,
     auto ltab_id = PutTable(left_final_table);
     auto rtab_id = PutTable(right_final_table);
 
-    // now do the local union
-    std::shared_ptr<arrow::Table> table;
-    auto status = Union(ctx, ltab_id, rtab_id, dest_id);
+    // now do the local operation
+    status = local(ltab_id, rtab_id);
 
     RemoveTable(ltab_id);
     RemoveTable(rtab_id);
@@ -693,7 +1879,38 @@ twisterx::Status DistributedUnion(twisterx::TwisterXContext *ctx,
   } else {
     return shuffle_status;
   }
+}
+
+twisterx::Status DistributedUnion(twisterx::TwisterXContext *ctx,
+                                  const std::string &table_left,
+                                  const std::string &table_right,
+                                  const std::string &dest_id) {
+  return DistributedSetOperation(ctx, table_left, table_right, "union",
+                                 [&](const std::string &left_id, const std::string &right_id) {
+                                   return Union(ctx, left_id, right_id, dest_id);
+                                 });
+}
+
+twisterx::Status DistributedIntersect(twisterx::TwisterXContext *ctx,
+                                      const std::string &table_left,
+                                      const std::string &table_right,
+                                      const std::string &dest_id,
+                                      twisterx::SetSemantics semantics) {
+  return DistributedSetOperation(ctx, table_left, table_right, "intersect",
+                                 [&](const std::string &left_id, const std::string &right_id) {
+                                   return Intersect(ctx, left_id, right_id, dest_id, semantics);
+                                 });
+}
 
+twisterx::Status DistributedSubtract(twisterx::TwisterXContext *ctx,
+                                     const std::string &table_left,
+                                     const std::string &table_right,
+                                     const std::string &dest_id,
+                                     twisterx::SetSemantics semantics) {
+  return DistributedSetOperation(ctx, table_left, table_right, "subtract",
+                                 [&](const std::string &left_id, const std::string &right_id) {
+                                   return Subtract(ctx, left_id, right_id, dest_id, semantics);
+                                 });
 }
 
 Status Select(twisterx::TwisterXContext *ctx,
@@ -20,6 +20,8 @@
 #include <functional>
 #include "status.hpp"
 #include "join/join_config.h"
+#include "sort/sort_config.h"
+#include "groupby/groupby_config.h"
 #include "io/csv_read_config.h"
 #include "io/csv_write_config.h"
 #include "ctx/twisterx_context.h"
@@ -72,6 +74,157 @@ twisterx::Status DistributedUnion(
     const std::string &dest_id
 );
 
+/**
+ * Append the rows of the right table to the rows of the left table, keeping the duplicates. The columns are not
+ * copied, the result has the chunks of both tables. The operators combine only the columns they need as single
+ * arrays, so the result can be used as it is.
+ * @param table_left the left table id
+ * @param table_right the right table id, with the same schema
+ * @param dest_id the id of the result
+ * @return the status of the operation
+ */
+twisterx::Status UnionAll(twisterx::TwisterXContext *ctx,
+                          const std::string &table_left,
+                          const std::string &table_right,
+                          const std::string &dest_id);
+
+/**
+ * The duplicate rows in the result of a set operation
+ */
+enum SetSemantics {
+  // the rows of the result are distinct
+  SET,
+  // the duplicates are kept, as in INTERSECT ALL and EXCEPT ALL
+  BAG
+};
+
+/**
+ * The rows of the left table that are in the right table. With bag semantics a row occurring m times in the left
+ * table and n times in the right table occurs min(m, n) times in the result.
+ * @param table_left the id of the left table
+ * @param table_right the id of the right table, with the same column types
+ * @param dest_id the id of the result
+ * @param semantics set or bag semantics
+ * @return the status of the operation
+ */
+twisterx::Status Intersect(twisterx::TwisterXContext *ctx,
+                           const std::string &table_left,
+                           const std::string &table_right,
+                           const std::string &dest_id,
+                           twisterx::SetSemantics semantics = twisterx::SET);
+
+/**
+ * The rows of the left table that are not in the right table. With bag semantics a row occurring m times in the left
+ * table and n times in the right table occurs max(m - n, 0) times in the result.
+ * @param table_left the id of the left table
+ * @param table_right the id of the right table, with the same column types
+ * @param dest_id the id of the result
+ * @param semantics set or bag semantics
+ * @return the status of the operation
+ */
+twisterx::Status Subtract(twisterx::TwisterXContext *ctx,
+                          const std::string &table_left,
+                          const std::string &table_right,
+                          const std::string &dest_id,
+                          twisterx::SetSemantics semantics = twisterx::SET);
+
+/**
+ * The row kept by Distinct out of the rows with equal keys
+ */
+enum DistinctKeep {
+  // the first row
+  KEEP_FIRST,
+  // the last row
+  KEEP_LAST,
+  // none of the rows, only the rows without duplicates are kept
+  KEEP_NONE
+};
+
+/**
+ * Remove the rows with duplicate keys, the rows kept are in the order of the table
+ * @param id the table id
+ * @param dest_id the id of the result
+ * @param columns the key columns, all the columns if empty
+ * @param keep the row kept out of the rows with equal keys
+ * @return the status of the operation
+ */
+twisterx::Status Distinct(twisterx::TwisterXContext *ctx,
+                          const std::string &id,
+                          const std::string &dest_id,
+                          const std::vector<int> &columns,
+                          twisterx::DistinctKeep keep = twisterx::KEEP_FIRST);
+
+/**
+ * Remove the rows with duplicate keys over the tables of all the ranks. Each rank removes its own duplicates first,
+ * then the rows are shuffled on the hashes of the key columns, so a duplicate crosses the network at most once per
+ * rank. The first and the last rows are in the order of the ranks and then of the rows. KEEP_NONE shuffles all
+ * the rows, as a row may only have duplicates on other ranks.
+ * @param id the table id
+ * @param dest_id the id of the result of this rank
+ * @param columns the key columns, all the columns if empty
+ * @param keep the row kept out of the rows with equal keys
+ * @return the status of the operation
+ */
+twisterx::Status DistributedDistinct(twisterx::TwisterXContext *ctx,
+                                     const std::string &id,
+                                     const std::string &dest_id,
+                                     const std::vector<int> &columns,
+                                     twisterx::DistinctKeep keep = twisterx::KEEP_FIRST);
+
+/**
+ * Group the rows on the key columns and aggregate the other columns of each group. The rows are mapped to dense
+ * group ids with a hash table, and each aggregate keeps its state in typed arrays indexed by the group id, updated a
+ * column at a time. The result has the key columns, with the groups in the order of their first rows, followed by a
+ * column for each aggregate named after the column and the aggregate, such as price_sum. Null keys form a group, null
+ * and NaN values are skipped, and the aggregates of groups without values are null.
+ * @param id the table id
+ * @param dest_id the id of the result
+ * @param key_columns the key columns
+ * @param aggregations the aggregates, each of a column
+ * @return the status of the operation
+ */
+twisterx::Status GroupBy(twisterx::TwisterXContext *ctx,
+                         const std::string &id,
+                         const std::string &dest_id,
+                         const std::vector<int> &key_columns,
+                         const std::vector<twisterx::groupby::config::Aggregation> &aggregations);
+
+/**
+ * Group the rows of the tables of all the ranks on the key columns and aggregate each group. Each rank aggregates its
+ * own rows into partial states, the states are shuffled on the hashes of the keys and the states of each group are
+ * merged on one rank. The partial aggregation is skipped, and the key and aggregated columns of the rows are shuffled
+ * instead, if the groups of the first rows of the ranks are more than TWISTERX_GROUPBY_PARTIAL_RATIO (0.9) of the
+ * rows, as the states would be about as large as the rows.
+ * @param id the table id
+ * @param dest_id the id of the groups of this rank, as in GroupBy
+ * @param key_columns the key columns
+ * @param aggregations the aggregates, each of a column
+ * @return the status of the operation
+ */
+twisterx::Status DistributedGroupBy(twisterx::TwisterXContext *ctx,
+                                    const std::string &id,
+                                    const std::string &dest_id,
+                                    const std::vector<int> &key_columns,
+                                    const std::vector<twisterx::groupby::config::Aggregation> &aggregations);
+
+/**
+ * Intersect the tables of all the ranks, the rows are shuffled on their hashes as in DistributedUnion
+ */
+twisterx::Status DistributedIntersect(twisterx::TwisterXContext *ctx,
+                                      const std::string &table_left,
+                                      const std::string &table_right,
+                                      const std::string &dest_id,
+                                      twisterx::SetSemantics semantics = twisterx::SET);
+
+/**
+ * Subtract the tables of all the ranks, the rows are shuffled on their hashes as in DistributedUnion
+ */
+twisterx::Status DistributedSubtract(twisterx::TwisterXContext *ctx,
+                                     const std::string &table_left,
+                                     const std::string &table_right,
+                                     const std::string &dest_id,
+                                     twisterx::SetSemantics semantics = twisterx::SET);
+
 int ColumnCount(const std::string &id);
 
 int64_t RowCount(const std::string &id);
@@ -98,7 +251,8 @@ twisterx::Status PrintToOStream(const std::string &table_id,
                                 const std::vector<std::string> &headers = {});
 
 /**
- * Merge the set of tables into a single table, each table should have the same schema
+ * Merge the set of tables into a single table, each table should have the same schema. The tables are concatenated
+ * without copying, the chunks of the tables are the chunks of the result.
  *
  * @param table_ids ids of the tables
  * @param merged_tab id of the merged table
@@ -119,6 +273,79 @@ twisterx::Status SortTable(twisterx::TwisterXContext *ctx,
                            const std::string &sortTableId,
                            int columnIndex);
 
+/**
+ * Sort the table on multiple columns, each with its own order and null placement. The sort is stable.
+ * @param id table id
+ * @param sorted_id id of the sorted table
+ * @param keys the sort columns, the first key is the most significant
+ * @return the status of the sort
+ */
+twisterx::Status SortTable(twisterx::TwisterXContext *ctx,
+                           const std::string &id,
+                           const std::string &sorted_id,
+                           const std::vector<twisterx::sort::config::SortKey> &keys);
+
+/**
+ * The balance of the rows over the ranks after a distributed sort
+ */
+struct SortBalance {
+  // the rows of each rank
+  std::vector<int64_t> rows;
+  int64_t min_rows = 0;
+  int64_t max_rows = 0;
+  double mean_rows = 0;
+  // the maximum rows over the mean, 1 when the rows are balanced
+  double imbalance = 1.0;
+};
+
+/**
+ * Sort the table across the ranks with a sample sort. Each rank sorts its rows, the splitters are chosen from
+ * regular samples of the sorted rows of all the ranks, the sorted runs are range partitioned to the ranks, and each
+ * rank merges the runs it receives. Rank i gets the i th range, sorted, and the nulls go to the last rank.
+ * @param id the table id
+ * @param column_index the sorting column index
+ * @param dest_id the id of the sorted table of this rank
+ * @param ascending the order of the sort
+ * @param balance if not null, the balance of the rows over the ranks
+ * @return the status of the sort
+ */
+twisterx::Status DistributedSort(twisterx::TwisterXContext *ctx,
+                                 const std::string &id,
+                                 int column_index,
+                                 const std::string &dest_id,
+                                 bool ascending = true,
+                                 SortBalance *balance = nullptr);
+
+/**
+ * Take the first k rows of the table in the order of the keys, without sorting the other rows
+ * @param id the table id
+ * @param dest_id the id of the table of the k rows
+ * @param keys the sort columns, the first key is the most significant
+ * @param k the number of rows, the table is sorted if it has at most k rows
+ * @return the status of the operation
+ */
+twisterx::Status TopK(twisterx::TwisterXContext *ctx,
+                      const std::string &id,
+                      const std::string &dest_id,
+                      const std::vector<twisterx::sort::config::SortKey> &keys,
+                      int64_t k);
+
+/**
+ * Take the first k rows in the order of the keys over the tables of all the ranks. Each rank selects its own top k
+ * rows and rank 0 gathers them, so at most k rows move from a rank. Rank 0 gets the k rows, the other ranks get an
+ * empty table. The ties keep the order of the ranks.
+ * @param id the table id
+ * @param dest_id the id of the table of the k rows
+ * @param keys the sort columns, the first key is the most significant
+ * @param k the number of rows
+ * @return the status of the operation
+ */
+twisterx::Status DistributedTopK(twisterx::TwisterXContext *ctx,
+                                 const std::string &id,
+                                 const std::string &dest_id,
+                                 const std::vector<twisterx::sort::config::SortKey> &keys,
+                                 int64_t k);
+
 /**
  * Partition the table into multiple tables using a hash function, hash will be applied to the bytes of the data
  * @param id the table id
@@ -134,6 +361,38 @@ twisterx::Status HashPartition(twisterx::TwisterXContext *ctx,
                                int no_of_partitions,
                                std::unordered_map<int, std::string> *out);
 
+/**
+ * Partition the table into ranges of the order of a column, the ranges are bounded by splitters chosen from a
+ * sample of the column. The number of samples for each partition is set with TWISTERX_RANGE_SAMPLES.
+ * @param id the table id
+ * @param column_index the column
+ * @param no_of_partitions number of partitions to output
+ * @param out the tables of the partitions, partition 0 has the smallest values when ascending
+ * @param ascending the order of the partitions
+ * @return the status of the partition operation
+ */
+twisterx::Status RangePartition(twisterx::TwisterXContext *ctx,
+                                const std::string &id,
+                                int column_index,
+                                int no_of_partitions,
+                                std::unordered_map<int, std::string> *out,
+                                bool ascending = true);
+
+/**
+ * Range partition the table across the ranks, the splitters are chosen from samples gathered from all the ranks.
+ * Rank i gets the i th range, the rows within a rank are not sorted.
+ * @param id the table id
+ * @param column_index the column
+ * @param dest_id the id of the table of this rank
+ * @param ascending the order of the ranges over the ranks
+ * @return the status of the partition operation
+ */
+twisterx::Status DistributedRangePartition(twisterx::TwisterXContext *ctx,
+                                           const std::string &id,
+                                           int column_index,
+                                           const std::string &dest_id,
+                                           bool ascending = true);
+
 /**
  * Select a set of rows based on the selector condition
  *
@@ -14,6 +14,7 @@
 
 #include <arrow/compute/api.h>
 #include <arrow/api.h>
+#include <arrow/array/concatenate.h>
 #include <glog/logging.h>
 #include "arrow_utils.hpp"
 
@@ -135,14 +136,14 @@ arrow::Status sort_column(const std::shared_ptr<arrow::Array> &data_column,
 arrow::Status sort_table(std::shared_ptr<arrow::Table> tab, int64_t sort_column_index,
                          std::shared_ptr<arrow::Table> *sorted_table,
                          arrow::MemoryPool *memory_pool) {
-  std::shared_ptr<arrow::Table> tab_to_process;
-  // combine chunks if multiple chunks are available
-  if (tab->column(sort_column_index)->num_chunks() > 1) {
-    arrow::Status left_combine_stat = tab->CombineChunks(memory_pool, &tab);
-  } else {
-    tab_to_process = tab;
+  std::shared_ptr<arrow::Table> tab_to_process = tab;
+  // combine the chunks of the sort column if multiple chunks are available, the other columns are copied by chunk
+  std::shared_ptr<arrow::Array> column_to_sort;
+  arrow::Status combine_status = CombineChunks(tab->column(sort_column_index), &column_to_sort, memory_pool);
+  if (combine_status != arrow::Status::OK()) {
+    LOG(FATAL) << "Failed to combine the chunks of the sort column" << combine_status.ToString();
+    return combine_status;
   }
-  auto column_to_sort = tab_to_process->column(sort_column_index)->chunk(0);
 
   // sort to indices
   std::shared_ptr<arrow::Array> sorted_column_index;
@@ -159,10 +160,19 @@ arrow::Status sort_table(std::shared_ptr<arrow::Table> tab, int64_t sort_column_
   // now sort everything based on sorted index
   std::vector<std::shared_ptr<arrow::Array>> sorted_columns;
   int64_t no_of_columns = tab_to_process->num_columns();
+  std::shared_ptr<std::vector<int64_t>> indices;
   for (int64_t col_index = 0; col_index < no_of_columns; ++col_index) {
     std::shared_ptr<arrow::Array> sorted_array;
-    status = sort_column(tab_to_process->column(col_index)->chunk(0),
-                         index_lookup, &sorted_array, memory_pool);
+    const std::shared_ptr<arrow::ChunkedArray> &column = tab_to_process->column(col_index);
+    if (column->num_chunks() == 1) {
+      status = sort_column(column->chunk(0), index_lookup, &sorted_array, memory_pool);
+    } else {
+      if (indices == nullptr) {
+        indices = std::make_shared<std::vector<int64_t>>(index_lookup->raw_values(),
+                                                         index_lookup->raw_values() + index_lookup->length());
+      }
+      status = copy_chunked_array_by_indices(indices, column, &sorted_array, memory_pool);
+    }
     if (status != arrow::Status::OK()) {
       LOG(FATAL) << "Failed to sort column based on indices. " << status.ToString();
       return status;
@@ -173,6 +183,28 @@ arrow::Status sort_table(std::shared_ptr<arrow::Table> tab, int64_t sort_column_
   return arrow::Status::OK();
 }
 
+std::shared_ptr<arrow::Array> GetChunk(const std::shared_ptr<arrow::ChunkedArray> &column, int64_t *row) {
+  for (const auto &chunk : column->chunks()) {
+    if (*row < chunk->length()) {
+      return chunk;
+    }
+    *row -= chunk->length();
+  }
+  return nullptr;
+}
+
+arrow::Status CombineChunks(const std::shared_ptr<arrow::ChunkedArray> &column,
+                            std::shared_ptr<arrow::Array> *out,
+                            arrow::MemoryPool *memory_pool) {
+  if (column->num_chunks() == 1) {
+    *out = column->chunk(0);
+    return arrow::Status::OK();
+  } else if (column->num_chunks() == 0) {
+    return arrow::MakeArrayOfNull(column->type(), 0, out);
+  }
+  return arrow::Concatenate(column->chunks(), memory_pool, out);
+}
+
 arrow::Status free_table(const std::shared_ptr<arrow::Table> &table) {
   const int ncolumns = table->num_columns();
   for (int i = 0; i < ncolumns; ++i) {
@@ -31,6 +31,31 @@ arrow::Status copy_array_by_indices(std::shared_ptr<std::vector<int64_t>> indice
                                     std::shared_ptr<arrow::Array> *copied_array,
                                     arrow::MemoryPool *memory_pool = arrow::default_memory_pool());
 
+/**
+ * Copy the values of a chunked array at the indices into a single array, without combining the chunks first. The
+ * indices are rows of the chunked array, a -1 index gives a null.
+ */
+arrow::Status copy_chunked_array_by_indices(const std::shared_ptr<std::vector<int64_t>> &indices,
+                                            const std::shared_ptr<arrow::ChunkedArray> &source_array,
+                                            std::shared_ptr<arrow::Array> *copied_array,
+                                            arrow::MemoryPool *memory_pool = arrow::default_memory_pool());
+
+/**
+ * The chunk of a chunked array with the row
+ * @param column the chunked array
+ * @param row the row of the chunked array, set to the row in the chunk
+ * @return the chunk, nullptr if the row is past the end
+ */
+std::shared_ptr<arrow::Array> GetChunk(const std::shared_ptr<arrow::ChunkedArray> &column, int64_t *row);
+
+/**
+ * The chunks of a chunked array as a single array. A single chunk is returned without copying, no chunks give an
+ * empty array and more chunks are concatenated.
+ */
+arrow::Status CombineChunks(const std::shared_ptr<arrow::ChunkedArray> &column,
+                            std::shared_ptr<arrow::Array> *out,
+                            arrow::MemoryPool *memory_pool = arrow::default_memory_pool());
+
 /**
  * Free the buffers of a arrow table, after this, the table is no-longer valid
  * @param table the table pointer
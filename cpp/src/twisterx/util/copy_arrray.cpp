@@ -15,52 +15,141 @@
 #include <arrow/compute/api.h>
 #include <arrow/api.h>
 #include <glog/logging.h>
+#include <algorithm>
 #include "arrow_utils.hpp"
 
 namespace twisterx {
 namespace util {
 
+/**
+ * Finds the chunk of a row of a chunked array. The chunk of the last row is kept, so rows close together don't
+ * search the chunks.
+ */
+template<typename ARRAY_TYPE>
+class ChunkResolver {
+ public:
+  explicit ChunkResolver(const std::vector<std::shared_ptr<arrow::Array>> &chunks) {
+    int64_t offset = 0;
+    for (const auto &chunk : chunks) {
+      chunks_.push_back(static_cast<const ARRAY_TYPE *>(chunk.get()));
+      offsets_.push_back(offset);
+      offset += chunk->length();
+    }
+    offsets_.push_back(offset);
+  }
+
+  int64_t length() const {
+    return offsets_.back();
+  }
+
+  /**
+   * The chunk of a row less than the length, the row is set to the row in the chunk
+   */
+  inline const ARRAY_TYPE &Resolve(int64_t *row) {
+    if (*row < offsets_[current_] || *row >= offsets_[current_ + 1]) {
+      current_ = std::upper_bound(offsets_.begin(), offsets_.end(), *row) - offsets_.begin() - 1;
+    }
+    *row -= offsets_[current_];
+    return *chunks_[current_];
+  }
+
+ private:
+  std::vector<const ARRAY_TYPE *> chunks_;
+  std::vector<int64_t> offsets_;
+  size_t current_ = 0;
+};
+
 template<typename TYPE>
 arrow::Status do_copy_numeric_array(const std::shared_ptr<std::vector<int64_t>> &indices,
-                                    std::shared_ptr<arrow::Array> data_array,
+                                    const std::shared_ptr<arrow::DataType> &type,
+                                    const std::vector<std::shared_ptr<arrow::Array>> &data_chunks,
                                     std::shared_ptr<arrow::Array> *copied_array,
                                     arrow::MemoryPool *memory_pool) {
-  arrow::NumericBuilder<TYPE> array_builder(memory_pool);
+  // the builder takes the type of the array, the date and time types have parameters
+  arrow::NumericBuilder<TYPE> array_builder(type, memory_pool);
   arrow::Status status = array_builder.Reserve(indices->size());
   if (status != arrow::Status::OK()) {
     LOG(FATAL) << "Failed to reserve memory when re arranging the array based on indices. " << status.ToString();
     return status;
   }
 
-  auto casted_array = std::static_pointer_cast<arrow::NumericArray<TYPE>>(data_array);
-  for (auto &index : *indices) {
+  ChunkResolver<arrow::NumericArray<TYPE>> chunks(data_chunks);
+  for (int64_t index : *indices) {
     // handle -1 index : comes in left, right joins
     if (index == -1) {
       array_builder.UnsafeAppendNull();
       continue;
     }
 
-    if (casted_array->length() <= index) {
-      LOG(FATAL) << "INVALID INDEX " << index << " LENGTH " << casted_array->length();
+    if (chunks.length() <= index) {
+      LOG(FATAL) << "INVALID INDEX " << index << " LENGTH " << chunks.length();
+    }
+    const arrow::NumericArray<TYPE> &chunk = chunks.Resolve(&index);
+    if (chunk.IsNull(index)) {
+      array_builder.UnsafeAppendNull();
+    } else {
+      array_builder.UnsafeAppend(chunk.Value(index));
+    }
+  }
+  return array_builder.Finish(copied_array);
+}
+
+arrow::Status do_copy_boolean_array(const std::shared_ptr<std::vector<int64_t>> &indices,
+                                    const std::vector<std::shared_ptr<arrow::Array>> &data_chunks,
+                                    std::shared_ptr<arrow::Array> *copied_array,
+                                    arrow::MemoryPool *memory_pool) {
+  arrow::BooleanBuilder array_builder(memory_pool);
+  arrow::Status status = array_builder.Reserve(indices->size());
+  if (status != arrow::Status::OK()) {
+    LOG(FATAL) << "Failed to reserve memory when re arranging the array based on indices. " << status.ToString();
+    return status;
+  }
+
+  ChunkResolver<arrow::BooleanArray> chunks(data_chunks);
+  for (int64_t index : *indices) {
+    if (index == -1) {
+      array_builder.UnsafeAppendNull();
+      continue;
+    }
+    const arrow::BooleanArray &chunk = chunks.Resolve(&index);
+    if (chunk.IsNull(index)) {
+      array_builder.UnsafeAppendNull();
+    } else {
+      array_builder.UnsafeAppend(chunk.Value(index));
     }
-    array_builder.UnsafeAppend(casted_array->Value(index));
   }
   return array_builder.Finish(copied_array);
 }
 
-arrow::Status do_copy_binary_array(std::shared_ptr<std::vector<int64_t>> indices,
-                                   std::shared_ptr<arrow::Array> data_array,
+template<typename TYPE>
+arrow::Status do_copy_binary_array(const std::shared_ptr<std::vector<int64_t>> &indices,
+                                   const std::vector<std::shared_ptr<arrow::Array>> &data_chunks,
                                    std::shared_ptr<arrow::Array> *copied_array,
                                    arrow::MemoryPool *memory_pool) {
-  arrow::BinaryBuilder binary_builder(memory_pool);
-  auto casted_array = std::static_pointer_cast<arrow::BinaryArray>(data_array);
-  for (auto &index : *indices) {
-    if (casted_array->length() <= index) {
-      LOG(FATAL) << "INVALID INDEX " << index << " LENGTH " << casted_array->length();
+  using ARRAY_TYPE = typename arrow::TypeTraits<TYPE>::ArrayType;
+  typename arrow::TypeTraits<TYPE>::BuilderType binary_builder(memory_pool);
+  arrow::Status status = binary_builder.Reserve(indices->size());
+  if (status != arrow::Status::OK()) {
+    LOG(FATAL) << "Failed to reserve memory when re arranging the array based on indices. " << status.ToString();
+    return status;
+  }
+  ChunkResolver<ARRAY_TYPE> chunks(data_chunks);
+  for (int64_t index : *indices) {
+    if (index == -1) {
+      binary_builder.UnsafeAppendNull();
+      continue;
+    }
+    if (chunks.length() <= index) {
+      LOG(FATAL) << "INVALID INDEX " << index << " LENGTH " << chunks.length();
+    }
+    const ARRAY_TYPE &chunk = chunks.Resolve(&index);
+    if (chunk.IsNull(index)) {
+      binary_builder.UnsafeAppendNull();
+      continue;
     }
-    int32_t out;
-    const uint8_t *data = casted_array->GetValue(index, &out);
-    arrow::Status status = binary_builder.Reserve(out);
+    typename TYPE::offset_type out;
+    const uint8_t *data = chunk.GetValue(index, &out);
+    status = binary_builder.ReserveData(out);
     if (status != arrow::Status::OK()) {
       LOG(FATAL) << "Failed to append rearranged data points to the array builder. " << status.ToString();
       return status;
@@ -70,18 +159,24 @@ arrow::Status do_copy_binary_array(std::shared_ptr<std::vector<int64_t>> indices
   return binary_builder.Finish(copied_array);
 }
 
-arrow::Status do_copy_fixed_binary_array(std::shared_ptr<std::vector<int64_t>> indices,
-                                         std::shared_ptr<arrow::Array> data_array,
+arrow::Status do_copy_fixed_binary_array(const std::shared_ptr<std::vector<int64_t>> &indices,
+                                         const std::shared_ptr<arrow::DataType> &type,
+                                         const std::vector<std::shared_ptr<arrow::Array>> &data_chunks,
                                          std::shared_ptr<arrow::Array> *copied_array,
                                          arrow::MemoryPool *memory_pool) {
-  arrow::FixedSizeBinaryBuilder binary_builder(data_array->type(), memory_pool);
-  auto casted_array = std::static_pointer_cast<arrow::FixedSizeBinaryArray>(data_array);
-  for (auto &index : *indices) {
-    if (casted_array->length() <= index) {
-      LOG(FATAL) << "INVALID INDEX " << index << " LENGTH " << casted_array->length();
+  arrow::FixedSizeBinaryBuilder binary_builder(type, memory_pool);
+  ChunkResolver<arrow::FixedSizeBinaryArray> chunks(data_chunks);
+  for (int64_t index : *indices) {
+    arrow::Status status;
+    if (index == -1) {
+      status = binary_builder.AppendNull();
+    } else {
+      if (chunks.length() <= index) {
+        LOG(FATAL) << "INVALID INDEX " << index << " LENGTH " << chunks.length();
+      }
+      const arrow::FixedSizeBinaryArray &chunk = chunks.Resolve(&index);
+      status = chunk.IsNull(index) ? binary_builder.AppendNull() : binary_builder.Append(chunk.GetValue(index));
     }
-    const uint8_t *data = casted_array->GetValue(index);
-    arrow::Status status = binary_builder.Append(data);
     if (status != arrow::Status::OK()) {
       LOG(FATAL) << "Failed to append rearranged data points to the array builder. " << status.ToString();
       return status;
@@ -91,22 +186,27 @@ arrow::Status do_copy_fixed_binary_array(std::shared_ptr<std::vector<int64_t>> i
 }
 
 template<typename TYPE>
-arrow::Status do_copy_numeric_list(std::shared_ptr<std::vector<int64_t>> indices,
-                                   std::shared_ptr<arrow::Array> data_array,
+arrow::Status do_copy_numeric_list(const std::shared_ptr<std::vector<int64_t>> &indices,
+                                   const std::vector<std::shared_ptr<arrow::Array>> &data_chunks,
                                    std::shared_ptr<arrow::Array> *copied_array,
                                    arrow::MemoryPool *memory_pool) {
 
   arrow::ListBuilder list_builder(memory_pool, std::make_shared<arrow::NumericBuilder<TYPE>>(memory_pool));
   arrow::NumericBuilder<TYPE> &value_builder =
       *(static_cast<arrow::NumericBuilder<TYPE> *>(list_builder.value_builder()));
-  auto casted_array = std::static_pointer_cast<arrow::ListArray>(data_array);
-  for (auto &index : *indices) {
-    arrow::Status status = list_builder.Append();
+  ChunkResolver<arrow::ListArray> chunks(data_chunks);
+  for (int64_t index : *indices) {
+    const arrow::ListArray *chunk = index == -1 ? nullptr : &chunks.Resolve(&index);
+    const bool is_null = chunk == nullptr || chunk->IsNull(index);
+    arrow::Status status = is_null ? list_builder.AppendNull() : list_builder.Append();
     if (status != arrow::Status::OK()) {
       LOG(FATAL) << "Failed to append rearranged data points to the array builder. " << status.ToString();
       return status;
     }
-    auto numericArray = std::static_pointer_cast<arrow::NumericArray<TYPE>>(casted_array->Slice(index));
+    if (is_null) {
+      continue;
+    }
+    auto numericArray = std::static_pointer_cast<arrow::NumericArray<TYPE>>(chunk->Slice(index));
 
     for (int n = 0; n < numericArray->length(); n++) {
       status = value_builder.Append(numericArray->Value(n));
@@ -119,140 +219,82 @@ arrow::Status do_copy_numeric_list(std::shared_ptr<std::vector<int64_t>> indices
   return list_builder.Finish(copied_array);
 }
 
-arrow::Status copy_array_by_indices(std::shared_ptr<std::vector<int64_t>> indices,
-                                    std::shared_ptr<arrow::Array> data_array,
-                                    std::shared_ptr<arrow::Array> *copied_array,
-                                    arrow::MemoryPool *memory_pool) {
-  switch (data_array->type()->id()) {
+/**
+ * Copy the values of the chunks of a column at the indices into a single array, a -1 index gives a null
+ */
+static arrow::Status copy_chunks_by_indices(const std::shared_ptr<std::vector<int64_t>> &indices,
+                                            const std::shared_ptr<arrow::DataType> &type,
+                                            const std::vector<std::shared_ptr<arrow::Array>> &data_chunks,
+                                            std::shared_ptr<arrow::Array> *copied_array,
+                                            arrow::MemoryPool *memory_pool) {
+  switch (type->id()) {
     case arrow::Type::NA:break;
-    case arrow::Type::BOOL:break;
+    case arrow::Type::BOOL:return do_copy_boolean_array(indices, data_chunks, copied_array, memory_pool);
     case arrow::Type::UINT8:
-      return do_copy_numeric_array<arrow::UInt8Type>(indices,
-                                                     data_array,
-                                                     copied_array,
-                                                     memory_pool);
+      return do_copy_numeric_array<arrow::UInt8Type>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::INT8:
-      return do_copy_numeric_array<arrow::Int8Type>(indices,
-                                                    data_array,
-                                                    copied_array,
-                                                    memory_pool);
+      return do_copy_numeric_array<arrow::Int8Type>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::UINT16:
-      return do_copy_numeric_array<arrow::Int16Type>(indices,
-                                                     data_array,
-                                                     copied_array,
-                                                     memory_pool);
+      return do_copy_numeric_array<arrow::UInt16Type>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::INT16:
-      return do_copy_numeric_array<arrow::Int16Type>(indices,
-                                                     data_array,
-                                                     copied_array,
-                                                     memory_pool);
+      return do_copy_numeric_array<arrow::Int16Type>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::UINT32:
-      return do_copy_numeric_array<arrow::UInt32Type>(indices,
-                                                      data_array,
-                                                      copied_array,
-                                                      memory_pool);
+      return do_copy_numeric_array<arrow::UInt32Type>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::INT32:
-      return do_copy_numeric_array<arrow::Int32Type>(indices,
-                                                     data_array,
-                                                     copied_array,
-                                                     memory_pool);
+      return do_copy_numeric_array<arrow::Int32Type>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::UINT64:
-      return do_copy_numeric_array<arrow::UInt64Type>(indices,
-                                                      data_array,
-                                                      copied_array,
-                                                      memory_pool);
+      return do_copy_numeric_array<arrow::UInt64Type>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::INT64:
-      return do_copy_numeric_array<arrow::Int64Type>(indices,
-                                                     data_array,
-                                                     copied_array,
-                                                     memory_pool);
+      return do_copy_numeric_array<arrow::Int64Type>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::HALF_FLOAT:
-      return do_copy_numeric_array<arrow::HalfFloatType>(indices,
-                                                         data_array,
-                                                         copied_array,
-                                                         memory_pool);
+      return do_copy_numeric_array<arrow::HalfFloatType>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::FLOAT:
-      return do_copy_numeric_array<arrow::FloatType>(indices,
-                                                     data_array,
-                                                     copied_array,
-                                                     memory_pool);
+      return do_copy_numeric_array<arrow::FloatType>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::DOUBLE:
-      return do_copy_numeric_array<arrow::DoubleType>(indices,
-                                                      data_array,
-                                                      copied_array,
-                                                      memory_pool);
-    case arrow::Type::STRING:break;
-    case arrow::Type::BINARY:return do_copy_binary_array(indices, data_array, copied_array, memory_pool);
+      return do_copy_numeric_array<arrow::DoubleType>(indices, type, data_chunks, copied_array, memory_pool);
+    case arrow::Type::STRING:
+      return do_copy_binary_array<arrow::StringType>(indices, data_chunks, copied_array, memory_pool);
+    case arrow::Type::BINARY:
+      return do_copy_binary_array<arrow::BinaryType>(indices, data_chunks, copied_array, memory_pool);
     case arrow::Type::FIXED_SIZE_BINARY:
-      return do_copy_fixed_binary_array(indices,
-                                        data_array,
-                                        copied_array,
-                                        memory_pool);
-    case arrow::Type::DATE32:break;
-    case arrow::Type::DATE64:break;
-    case arrow::Type::TIMESTAMP:break;
-    case arrow::Type::TIME32:break;
-    case arrow::Type::TIME64:break;
+    case arrow::Type::DECIMAL:
+      return do_copy_fixed_binary_array(indices, type, data_chunks, copied_array, memory_pool);
+    case arrow::Type::DATE32:
+      return do_copy_numeric_array<arrow::Date32Type>(indices, type, data_chunks, copied_array, memory_pool);
+    case arrow::Type::DATE64:
+      return do_copy_numeric_array<arrow::Date64Type>(indices, type, data_chunks, copied_array, memory_pool);
+    case arrow::Type::TIMESTAMP:
+      return do_copy_numeric_array<arrow::TimestampType>(indices, type, data_chunks, copied_array, memory_pool);
+    case arrow::Type::TIME32:
+      return do_copy_numeric_array<arrow::Time32Type>(indices, type, data_chunks, copied_array, memory_pool);
+    case arrow::Type::TIME64:
+      return do_copy_numeric_array<arrow::Time64Type>(indices, type, data_chunks, copied_array, memory_pool);
     case arrow::Type::INTERVAL:break;
-    case arrow::Type::DECIMAL:break;
     case arrow::Type::LIST: {
-      auto t_value = std::static_pointer_cast<arrow::ListType>(data_array->type());
+      auto t_value = std::static_pointer_cast<arrow::ListType>(type);
       switch (t_value->value_type()->id()) {
         case arrow::Type::UINT8:
-          return do_copy_numeric_list<arrow::UInt8Type>(indices,
-                                                        data_array,
-                                                        copied_array,
-                                                        memory_pool);
+          return do_copy_numeric_list<arrow::UInt8Type>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::INT8:
-          return do_copy_numeric_list<arrow::Int8Type>(indices,
-                                                       data_array,
-                                                       copied_array,
-                                                       memory_pool);
+          return do_copy_numeric_list<arrow::Int8Type>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::UINT16:
-          return do_copy_numeric_list<arrow::Int16Type>(indices,
-                                                        data_array,
-                                                        copied_array,
-                                                        memory_pool);
+          return do_copy_numeric_list<arrow::Int16Type>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::INT16:
-          return do_copy_numeric_list<arrow::Int16Type>(indices,
-                                                        data_array,
-                                                        copied_array,
-                                                        memory_pool);
+          return do_copy_numeric_list<arrow::Int16Type>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::UINT32:
-          return do_copy_numeric_list<arrow::UInt32Type>(indices,
-                                                         data_array,
-                                                         copied_array,
-                                                         memory_pool);
+          return do_copy_numeric_list<arrow::UInt32Type>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::INT32:
-          return do_copy_numeric_list<arrow::Int32Type>(indices,
-                                                        data_array,
-                                                        copied_array,
-                                                        memory_pool);
+          return do_copy_numeric_list<arrow::Int32Type>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::UINT64:
-          return do_copy_numeric_list<arrow::UInt64Type>(indices,
-                                                         data_array,
-                                                         copied_array,
-                                                         memory_pool);
+          return do_copy_numeric_list<arrow::UInt64Type>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::INT64:
-          return do_copy_numeric_list<arrow::Int64Type>(indices,
-                                                        data_array,
-                                                        copied_array,
-                                                        memory_pool);
+          return do_copy_numeric_list<arrow::Int64Type>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::HALF_FLOAT:
-          return do_copy_numeric_list<arrow::HalfFloatType>(indices,
-                                                            data_array,
-                                                            copied_array,
-                                                            memory_pool);
+          return do_copy_numeric_list<arrow::HalfFloatType>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::FLOAT:
-          return do_copy_numeric_list<arrow::FloatType>(indices,
-                                                        data_array,
-                                                        copied_array,
-                                                        memory_pool);
+          return do_copy_numeric_list<arrow::FloatType>(indices, data_chunks, copied_array, memory_pool);
         case arrow::Type::DOUBLE:
-          return do_copy_numeric_list<arrow::DoubleType>(indices,
-                                                         data_array,
-                                                         copied_array,
-                                                         memory_pool);
+          return do_copy_numeric_list<arrow::DoubleType>(indices, data_chunks, copied_array, memory_pool);
       }
       break;
     }
@@ -263,10 +305,27 @@ arrow::Status copy_array_by_indices(std::shared_ptr<std::vector<int64_t>> indice
     case arrow::Type::EXTENSION:break;
     case arrow::Type::FIXED_SIZE_LIST:break;
     case arrow::Type::DURATION:break;
-    case arrow::Type::LARGE_STRING:break;
-    case arrow::Type::LARGE_BINARY:break;
+    case arrow::Type::LARGE_STRING:
+      return do_copy_binary_array<arrow::LargeStringType>(indices, data_chunks, copied_array, memory_pool);
+    case arrow::Type::LARGE_BINARY:
+      return do_copy_binary_array<arrow::LargeBinaryType>(indices, data_chunks, copied_array, memory_pool);
     case arrow::Type::LARGE_LIST:break;
   }
+  return arrow::Status::NotImplemented("Copying arrays of type " + type->ToString());
+}
+
+arrow::Status copy_array_by_indices(std::shared_ptr<std::vector<int64_t>> indices,
+                                    std::shared_ptr<arrow::Array> data_array,
+                                    std::shared_ptr<arrow::Array> *copied_array,
+                                    arrow::MemoryPool *memory_pool) {
+  return copy_chunks_by_indices(indices, data_array->type(), {data_array}, copied_array, memory_pool);
+}
+
+arrow::Status copy_chunked_array_by_indices(const std::shared_ptr<std::vector<int64_t>> &indices,
+                                            const std::shared_ptr<arrow::ChunkedArray> &data_array,
+                                            std::shared_ptr<arrow::Array> *copied_array,
+                                            arrow::MemoryPool *memory_pool) {
+  return copy_chunks_by_indices(indices, data_array->type(), data_array->chunks(), copied_array, memory_pool);
 }
 
 }
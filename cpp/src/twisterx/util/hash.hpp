@@ -0,0 +1,210 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TWISTERX_SRC_TWISTERX_UTIL_HASH_HPP_
+#define TWISTERX_SRC_TWISTERX_UTIL_HASH_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#include "murmur3.hpp"
+
+namespace twisterx {
+namespace util {
+
+/**
+ * The hash functions used for partitioning and hashing rows. Every rank of an operation has to use the same one.
+ */
+enum HashAlgorithm {
+  MURMUR3_HASH = 0,
+  XXHASH = 1,
+  // crc32c, uses the SSE4.2 instructions when built with them, otherwise a table
+  CRC32_HASH = 2
+};
+
+/**
+ * Get the algorithm from its name, murmur3, xxhash or crc32
+ * @return false if the name is not known
+ */
+bool ParseHashAlgorithm(const std::string &name, HashAlgorithm *algorithm);
+
+uint32_t XXHash32(const void *key, int64_t len, uint32_t seed);
+
+uint32_t Crc32Hash(const void *key, int64_t len, uint32_t seed);
+
+// the crc32c table used when the SSE4.2 instructions are not available
+extern const uint32_t kCrc32cTable[256];
+
+inline uint32_t Rotl32(uint32_t x, int8_t r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+inline uint32_t FMix32(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+/**
+ * Combine the hash of a column value into the hash of the row
+ */
+inline uint32_t CombineHash(uint32_t row_hash, uint32_t value_hash) {
+  return 31 * row_hash + value_hash;
+}
+
+/**
+ * The hashers hash a value of a known width with Hash<LEN>, the width is a constant so the compiler can unroll the
+ * hash and vectorize the loops over an array. Values of any width are hashed with Hash(data, len).
+ */
+struct Murmur3Hasher {
+  // gives the same hash as MurmurHash3_x86_32
+  template<int LEN>
+  static inline uint32_t Hash(const uint8_t *data) {
+    const uint32_t c1 = 0xcc9e2d51;
+    const uint32_t c2 = 0x1b873593;
+    uint32_t h1 = 0;
+    for (int i = 0; i < LEN / 4; i++) {
+      uint32_t k1;
+      std::memcpy(&k1, data + i * 4, sizeof(k1));
+      k1 *= c1;
+      k1 = Rotl32(k1, 15);
+      k1 *= c2;
+      h1 ^= k1;
+      h1 = Rotl32(h1, 13);
+      h1 = h1 * 5 + 0xe6546b64;
+    }
+    const uint8_t *tail = data + (LEN / 4) * 4;
+    uint32_t k1 = 0;
+    switch (LEN & 3) {
+      case 3:k1 ^= tail[2] << 16;
+        // fall through
+      case 2:k1 ^= tail[1] << 8;
+        // fall through
+      case 1:k1 ^= tail[0];
+        k1 *= c1;
+        k1 = Rotl32(k1, 15);
+        k1 *= c2;
+        h1 ^= k1;
+      default:break;
+    }
+    h1 ^= LEN;
+    return FMix32(h1);
+  }
+
+  static inline uint32_t Hash(const uint8_t *data, int64_t len) {
+    uint32_t hash = 0;
+    MurmurHash3_x86_32(data, static_cast<int>(len), 0, &hash);
+    return hash;
+  }
+};
+
+struct XXHasher {
+  static const uint32_t PRIME1 = 2654435761U;
+  static const uint32_t PRIME2 = 2246822519U;
+  static const uint32_t PRIME3 = 3266489917U;
+  static const uint32_t PRIME4 = 668265263U;
+  static const uint32_t PRIME5 = 374761393U;
+
+  // gives the same hash as XXHash32, the values wider than 16 bytes use it
+  template<int LEN>
+  static inline uint32_t Hash(const uint8_t *data) {
+    if (LEN >= 16) {
+      return XXHash32(data, LEN, 0);
+    }
+    uint32_t h = PRIME5 + LEN;
+    int i = 0;
+    for (; i + 4 <= LEN; i += 4) {
+      uint32_t lane;
+      std::memcpy(&lane, data + i, sizeof(lane));
+      h += lane * PRIME3;
+      h = Rotl32(h, 17) * PRIME4;
+    }
+    for (; i < LEN; i++) {
+      h += data[i] * PRIME5;
+      h = Rotl32(h, 11) * PRIME1;
+    }
+    h ^= h >> 15;
+    h *= PRIME2;
+    h ^= h >> 13;
+    h *= PRIME3;
+    h ^= h >> 16;
+    return h;
+  }
+
+  static inline uint32_t Hash(const uint8_t *data, int64_t len) {
+    return XXHash32(data, len, 0);
+  }
+};
+
+struct Crc32Hasher {
+  // the crc is mixed at the end, as its low bits alone don't spread well over the partitions
+  template<int LEN>
+  static inline uint32_t Hash(const uint8_t *data) {
+    uint32_t crc = 0xFFFFFFFF;
+    int i = 0;
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    for (; i + 8 <= LEN; i += 8) {
+      uint64_t block;
+      std::memcpy(&block, data + i, sizeof(block));
+      crc = static_cast<uint32_t>(_mm_crc32_u64(crc, block));
+    }
+#endif
+#if defined(__SSE4_2__)
+    for (; i + 4 <= LEN; i += 4) {
+      uint32_t block;
+      std::memcpy(&block, data + i, sizeof(block));
+      crc = _mm_crc32_u32(crc, block);
+    }
+    for (; i < LEN; i++) {
+      crc = _mm_crc32_u8(crc, data[i]);
+    }
+#else
+    for (; i < LEN; i++) {
+      crc = kCrc32cTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+#endif
+    return FMix32(~crc);
+  }
+
+  static inline uint32_t Hash(const uint8_t *data, int64_t len) {
+    return Crc32Hash(data, len, 0);
+  }
+};
+
+/**
+ * Call the function with the hasher of the algorithm, the function takes the hasher as an argument so it can be
+ * a generic lambda
+ */
+template<typename FUNCTION>
+inline void WithHasher(HashAlgorithm algorithm, FUNCTION &&fn) {
+  switch (algorithm) {
+    case XXHASH:fn(XXHasher());
+      break;
+    case CRC32_HASH:fn(Crc32Hasher());
+      break;
+    default:fn(Murmur3Hasher());
+  }
+}
+}
+}
+
+#endif //TWISTERX_SRC_TWISTERX_UTIL_HASH_HPP_
@@ -14,10 +14,10 @@
 
 #include "uuid.hpp"
 
-static std::random_device rd;
-static std::mt19937 gen(rd());
-static std::uniform_int_distribution<> dis(0, 15);
-static std::uniform_int_distribution<> dis2(8, 11);
+// the generator is per thread, as ranks may run as threads of the same process
+static thread_local std::mt19937 gen(std::random_device{}());
+static thread_local std::uniform_int_distribution<> dis(0, 15);
+static thread_local std::uniform_int_distribution<> dis2(8, 11);
 
 std::string twisterx::util::uuid::generate_uuid_v4() {
   std::stringstream ss;
@@ -0,0 +1,177 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/test_header.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+#include <arrow/api.h>
+
+#include "twisterx/arrow/arrow_aggregate_kernels.hpp"
+
+using twisterx::groupby::config::AggregationOp;
+
+// the last group has a single value, and the group after it only nulls
+static const int64_t kGroups = 12;
+
+/**
+ * Values of groups with large means and small variances, where a sum of squares loses the variance. Some values are
+ * null or NaN, which the aggregates skip.
+ */
+struct GroupedValues {
+  std::vector<double> values;
+  std::vector<bool> valid;
+  std::vector<int64_t> groups;
+
+  explicit GroupedValues(int64_t length) {
+    std::mt19937_64 generator(3);
+    std::normal_distribution<double> normal(0, 1);
+    for (int64_t i = 0; i < length; i++) {
+      int64_t group = static_cast<int64_t>(generator() % (kGroups - 2));
+      double value = 1e9 * static_cast<double>(group + 1) + normal(generator) * static_cast<double>(group + 1);
+      if (i % 17 == 0) {
+        value = std::numeric_limits<double>::quiet_NaN();
+      }
+      Add(value, i % 13 != 0, group);
+    }
+    Add(5.0, true, kGroups - 2);
+    Add(0.0, false, kGroups - 1);
+  }
+
+  void Add(double value, bool is_valid, int64_t group) {
+    values.push_back(value);
+    valid.push_back(is_valid);
+    groups.push_back(group);
+  }
+
+  std::shared_ptr<arrow::Array> Array(size_t begin, size_t end) const {
+    arrow::DoubleBuilder builder;
+    REQUIRE(builder.AppendValues(values.data() + begin, end - begin,
+                                 std::vector<bool>(valid.begin() + begin, valid.begin() + end)).ok());
+    std::shared_ptr<arrow::Array> array;
+    REQUIRE(builder.Finish(&array).ok());
+    return array;
+  }
+
+  /**
+   * The mean and the sample variance of each group with two passes over the values in long double
+   */
+  void Moments(std::vector<long double> *means, std::vector<long double> *variances,
+               std::vector<int64_t> *counts) const {
+    means->assign(kGroups, 0);
+    variances->assign(kGroups, 0);
+    counts->assign(kGroups, 0);
+    for (size_t i = 0; i < values.size(); i++) {
+      if (valid[i] && !std::isnan(values[i])) {
+        (*means)[groups[i]] += values[i];
+        (*counts)[groups[i]]++;
+      }
+    }
+    for (int64_t g = 0; g < kGroups; g++) {
+      if ((*counts)[g] > 0) {
+        (*means)[g] /= (*counts)[g];
+      }
+    }
+    for (size_t i = 0; i < values.size(); i++) {
+      if (valid[i] && !std::isnan(values[i])) {
+        long double d = values[i] - (*means)[groups[i]];
+        (*variances)[groups[i]] += d * d;
+      }
+    }
+    for (int64_t g = 0; g < kGroups; g++) {
+      if ((*counts)[g] > 1) {
+        (*variances)[g] /= (*counts)[g] - 1;
+      }
+    }
+  }
+};
+
+static std::unique_ptr<twisterx::AggregateKernel> CreateKernel(AggregationOp op) {
+  std::unique_ptr<twisterx::AggregateKernel> kernel;
+  REQUIRE(twisterx::CreateAggregateKernel(arrow::float64(), op, &kernel).ok());
+  return kernel;
+}
+
+static std::shared_ptr<arrow::DoubleArray> Finish(twisterx::AggregateKernel *kernel) {
+  std::shared_ptr<arrow::Array> out;
+  REQUIRE(kernel->Finish(arrow::default_memory_pool(), &out).ok());
+  REQUIRE(out->length() == kGroups);
+  return std::static_pointer_cast<arrow::DoubleArray>(out);
+}
+
+/**
+ * Check the aggregates against the two pass moments, the groups without enough values are null
+ */
+static void CheckMoments(const GroupedValues &data, AggregationOp op, const arrow::DoubleArray &result) {
+  std::vector<long double> means, variances;
+  std::vector<int64_t> counts;
+  data.Moments(&means, &variances, &counts);
+  const int64_t min_count = op == twisterx::groupby::config::VAR ? 2 : 1;
+  for (int64_t g = 0; g < kGroups; g++) {
+    REQUIRE(result.IsNull(g) == (counts[g] < min_count));
+    if (result.IsValid(g)) {
+      double expected = static_cast<double>(op == twisterx::groupby::config::VAR ? variances[g] : means[g]);
+      REQUIRE(result.Value(g) == Approx(expected).epsilon(1e-6));
+    }
+  }
+}
+
+TEST_CASE("The variance kernel keeps the precision of groups with large means", "[groupby]") {
+  GroupedValues data(100000);
+  for (AggregationOp op : {twisterx::groupby::config::MEAN, twisterx::groupby::config::VAR}) {
+    auto kernel = CreateKernel(op);
+    // update a chunk at a time
+    const size_t chunk = 30000;
+    for (size_t begin = 0; begin < data.values.size(); begin += chunk) {
+      size_t end = std::min(data.values.size(), begin + chunk);
+      kernel->Update(*data.Array(begin, end), data.groups.data() + begin, kGroups);
+    }
+    CheckMoments(data, op, *Finish(kernel.get()));
+  }
+}
+
+TEST_CASE("Merged partial variances equal the variance of all the values", "[groupby]") {
+  GroupedValues data(100000);
+  for (AggregationOp op : {twisterx::groupby::config::MEAN, twisterx::groupby::config::VAR}) {
+    auto merged = CreateKernel(op);
+    // three ranks with uneven shares of the rows, the last numbers the groups in reverse as its own group ids
+    const size_t size = data.values.size();
+    const std::vector<size_t> bounds{0, size / 10, size / 2, size};
+    for (size_t part = 0; part + 1 < bounds.size(); part++) {
+      const bool reversed = part == 2;
+      std::vector<int64_t> local_groups(data.groups.begin() + bounds[part], data.groups.begin() + bounds[part + 1]);
+      if (reversed) {
+        for (auto &g : local_groups) {
+          g = kGroups - 1 - g;
+        }
+      }
+      auto partial = CreateKernel(op);
+      partial->Update(*data.Array(bounds[part], bounds[part + 1]), local_groups.data(), kGroups);
+
+      std::vector<std::shared_ptr<arrow::Array>> states;
+      REQUIRE(partial->States(arrow::default_memory_pool(), &states).ok());
+      REQUIRE(static_cast<int>(states.size()) == partial->NumStates());
+      std::vector<int64_t> group_ids(kGroups);
+      for (int64_t g = 0; g < kGroups; g++) {
+        group_ids[g] = reversed ? kGroups - 1 - g : g;
+      }
+      merged->Merge(states, group_ids.data(), kGroups);
+    }
+    CheckMoments(data, op, *Finish(merged.get()));
+  }
+}
@@ -0,0 +1,95 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/test_header.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <arrow/api.h>
+
+#include "twisterx/net/mpi/mpi_communicator.h"
+#include "twisterx/table_api.hpp"
+#include "twisterx/table_api_extended.hpp"
+
+using twisterx::groupby::config::Aggregation;
+
+static std::shared_ptr<arrow::Array> MakeInt64Array(const std::vector<int64_t> &values,
+                                                    const std::vector<bool> &valid) {
+  arrow::Int64Builder builder;
+  REQUIRE(builder.AppendValues(values.data(), values.size(), valid).ok());
+  std::shared_ptr<arrow::Array> array;
+  REQUIRE(builder.Finish(&array).ok());
+  return array;
+}
+
+/**
+ * Group the rows of all the ranks and check the groups of this rank. Every rank has a null key group, a 0 key group
+ * and a group of its own, in two chunks
+ *
+ * k    0  null  0  null  rank + 1
+ * v    1  10    1  10    100
+ *
+ * @return the number of groups of this rank, the null key groups and the 0 key groups
+ */
+static std::vector<int64_t> CheckGroups(twisterx::TwisterXContext *ctx) {
+  const int64_t world_size = ctx->GetWorldSize();
+  auto keys = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeInt64Array({0, 0, 0}, {true, false, true}), MakeInt64Array({0, ctx->GetRank() + 1}, {false, true})});
+  auto values = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeInt64Array({1, 10, 1}, {true, true, true}), MakeInt64Array({10, 100}, {true, true})});
+  twisterx::PutTable("input", arrow::Table::Make(
+      arrow::schema({arrow::field("k", arrow::int64()), arrow::field("v", arrow::int64())}), {keys, values}));
+
+  REQUIRE(twisterx::DistributedGroupBy(ctx, "input", "grouped", {0}, {Aggregation::Sum(1)}).is_ok());
+  std::shared_ptr<arrow::Table> grouped;
+  REQUIRE(twisterx::GetTable("grouped")->CombineChunks(arrow::default_memory_pool(), &grouped).ok());
+
+  std::vector<int64_t> counts(3, 0);
+  if (grouped->num_rows() == 0) {
+    return counts;
+  }
+  const auto &k = static_cast<const arrow::Int64Array &>(*grouped->column(0)->chunk(0));
+  const auto &sums = static_cast<const arrow::Int64Array &>(*grouped->column(1)->chunk(0));
+  for (int64_t row = 0; row < grouped->num_rows(); row++) {
+    counts[0]++;
+    if (k.IsNull(row)) {
+      counts[1]++;
+      REQUIRE(sums.Value(row) == 20 * world_size);
+    } else if (k.Value(row) == 0) {
+      counts[2]++;
+      REQUIRE(sums.Value(row) == 2 * world_size);
+    } else {
+      REQUIRE(sums.Value(row) == 100);
+    }
+  }
+  return counts;
+}
+
+TEST_CASE("DistributedGroupBy keeps the null key group apart from the 0 key group", "[groupby]") {
+  auto mpi_config = new twisterx::net::MPIConfig();
+  auto ctx = twisterx::TwisterXContext::InitDistributed(mpi_config);
+
+  // the groups are always fewer than the rows, so a ratio of 1 shuffles the partial states and 0 the rows
+  for (const std::string &ratio : {"1", "0"}) {
+    ctx->AddConfig(TWISTERX_GROUPBY_PARTIAL_RATIO, ratio);
+    std::vector<int64_t> counts = CheckGroups(ctx);
+    std::vector<int64_t> total_counts(counts.size());
+    ctx->GetCommunicator()->AllReduce(counts.data(), total_counts.data(), counts.size(), twisterx::Type::INT64,
+                                      twisterx::net::SUM);
+    REQUIRE(total_counts == std::vector<int64_t>{ctx->GetWorldSize() + 2, 1, 1});
+  }
+
+  ctx->Finalize();
+}
@@ -0,0 +1,230 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/test_header.hpp"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <arrow/api.h>
+
+#include "twisterx/arrow/arrow_partition_kernels.hpp"
+
+using twisterx::util::HashAlgorithm;
+
+static const std::vector<HashAlgorithm> kAlgorithms{twisterx::util::MURMUR3_HASH, twisterx::util::XXHASH,
+                                                    twisterx::util::CRC32_HASH};
+
+/**
+ * The hash of the bytes of a value with the streaming hash of the algorithm
+ */
+static uint32_t HashBytes(HashAlgorithm algorithm, const void *data, int64_t length) {
+  uint32_t hash = 0;
+  twisterx::util::WithHasher(algorithm, [&](auto hasher) {
+    hash = decltype(hasher)::Hash(reinterpret_cast<const uint8_t *>(data), length);
+  });
+  return hash;
+}
+
+template<typename TYPE>
+static std::shared_ptr<arrow::Array> MakeArray(const std::vector<typename TYPE::c_type> &values,
+                                               const std::vector<bool> &valid) {
+  typename arrow::TypeTraits<TYPE>::BuilderType builder;
+  REQUIRE(builder.AppendValues(values.data(), values.size(), valid).ok());
+  std::shared_ptr<arrow::Array> array;
+  REQUIRE(builder.Finish(&array).ok());
+  return array;
+}
+
+static std::shared_ptr<arrow::Array> MakeStringArray(const std::vector<std::string> &values) {
+  arrow::StringBuilder builder;
+  REQUIRE(builder.AppendValues(values).ok());
+  std::shared_ptr<arrow::Array> array;
+  REQUIRE(builder.Finish(&array).ok());
+  return array;
+}
+
+/**
+ * The hashes of the array are the hashes of the bytes of the values at their exact width, and 0 for the nulls
+ */
+template<typename TYPE>
+static void CheckHashArray(const std::vector<typename TYPE::c_type> &values) {
+  using T = typename TYPE::c_type;
+  std::vector<bool> valid(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    valid[i] = i % 5 != 0;
+  }
+  auto array = MakeArray<TYPE>(values, valid);
+  for (HashAlgorithm algorithm : kAlgorithms) {
+    std::unique_ptr<twisterx::ArrowPartitionKernel> kernel(
+        twisterx::GetPartitionKernel(arrow::default_memory_pool(), array, algorithm));
+    REQUIRE(kernel != nullptr);
+    std::vector<uint32_t> hashes(values.size());
+    kernel->HashArray(array, hashes.data());
+    for (size_t i = 0; i < values.size(); i++) {
+      uint32_t expected = valid[i] ? HashBytes(algorithm, &values[i], sizeof(T)) : 0;
+      REQUIRE(hashes[i] == expected);
+      REQUIRE(kernel->ToHash(array, i) == expected);
+    }
+  }
+}
+
+template<typename TYPE>
+static void CheckHashArray() {
+  using T = typename TYPE::c_type;
+  std::mt19937_64 generator(sizeof(T));
+  std::vector<T> values(1000);
+  for (auto &value : values) {
+    value = static_cast<T>(generator());
+  }
+  CheckHashArray<TYPE>(values);
+}
+
+TEST_CASE("Hash kernels hash the values at their exact width", "[hash]") {
+  CheckHashArray<arrow::Int8Type>();
+  CheckHashArray<arrow::UInt8Type>();
+  CheckHashArray<arrow::Int16Type>();
+  CheckHashArray<arrow::UInt16Type>();
+  CheckHashArray<arrow::Int32Type>();
+  CheckHashArray<arrow::UInt32Type>();
+  CheckHashArray<arrow::Int64Type>();
+  CheckHashArray<arrow::UInt64Type>();
+  CheckHashArray<arrow::FloatType>({0.0f, 1.5f, -1.5f, 3.25e10f, 1.5f, -7.0f, 1e-30f});
+  CheckHashArray<arrow::DoubleType>({0.0, 1.5, -1.5, 3.25e100, 1.5, -7.0, 1e-300});
+}
+
+TEST_CASE("HashRows combines the column hashes and equal rows hash equally", "[hash]") {
+  const int64_t length = 5000;
+  std::mt19937_64 generator(11);
+  std::vector<int64_t> ints(length);
+  std::vector<double> doubles(length);
+  std::vector<bool> valid(length);
+  std::vector<std::string> strings(length);
+  for (int64_t i = 0; i < length; i++) {
+    // few distinct rows, so many rows are equal
+    ints[i] = static_cast<int64_t>(generator() % 4);
+    doubles[i] = static_cast<double>(generator() % 3) / 2;
+    valid[i] = generator() % 4 != 0;
+    strings[i] = std::string(generator() % 3, 'a');
+  }
+  const std::vector<std::shared_ptr<arrow::Array>> columns{MakeArray<arrow::Int64Type>(ints, valid),
+                                                           MakeArray<arrow::DoubleType>(doubles, valid),
+                                                           MakeStringArray(strings)};
+
+  for (HashAlgorithm algorithm : kAlgorithms) {
+    std::vector<uint32_t> hashes;
+    REQUIRE(twisterx::HashRows(arrow::default_memory_pool(), columns, length, &hashes, algorithm).is_ok());
+    REQUIRE(hashes.size() == static_cast<size_t>(length));
+
+    std::unordered_map<std::string, uint32_t> row_hashes;
+    for (int64_t i = 0; i < length; i++) {
+      uint32_t expected = 1;
+      expected = twisterx::util::CombineHash(expected, valid[i] ? HashBytes(algorithm, &ints[i], 8) : 0);
+      expected = twisterx::util::CombineHash(expected, valid[i] ? HashBytes(algorithm, &doubles[i], 8) : 0);
+      expected = twisterx::util::CombineHash(expected, HashBytes(algorithm, strings[i].data(), strings[i].size()));
+      REQUIRE(hashes[i] == expected);
+
+      std::string row = valid[i] ? std::to_string(ints[i]) + "," + std::to_string(doubles[i]) : "null";
+      row += "," + strings[i];
+      auto it = row_hashes.emplace(row, hashes[i]).first;
+      REQUIRE(it->second == hashes[i]);
+    }
+  }
+}
+
+TEST_CASE("RowHashingKernel hashes chunked tables like single rows", "[hash]") {
+  std::vector<int32_t> first{1, 2, 3, 4}, second{5, 6, 7};
+  std::vector<bool> first_valid{true, false, true, true}, second_valid{true, true, false};
+  auto ints = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeArray<arrow::Int32Type>(first, first_valid), MakeArray<arrow::Int32Type>(second, second_valid)});
+  // the second column is chunked differently
+  auto strings = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeStringArray({"a", "b"}), MakeStringArray({"c", "d", "e", "f", "g"})});
+  auto schema = arrow::schema({arrow::field("i", arrow::int32()), arrow::field("s", arrow::utf8())});
+  auto table = arrow::Table::Make(schema, {ints, strings});
+
+  for (HashAlgorithm algorithm : kAlgorithms) {
+    twisterx::RowHashingKernel kernel(schema->fields(), arrow::default_memory_pool(), algorithm);
+    std::vector<uint32_t> hashes;
+    kernel.Hash(table, &hashes);
+    REQUIRE(hashes.size() == 7);
+    for (int64_t row = 0; row < 7; row++) {
+      REQUIRE(hashes[row] == static_cast<uint32_t>(kernel.Hash(table, row)));
+    }
+  }
+}
+
+TEST_CASE("SplitTable scatters the rows to their hash partitions in order", "[hash]") {
+  const int64_t length = 10000;
+  std::vector<int64_t> keys(length);
+  std::vector<double> values(length);
+  std::vector<bool> valid(length);
+  std::vector<std::string> strings(length);
+  for (int64_t i = 0; i < length; i++) {
+    keys[i] = i % 97;
+    values[i] = static_cast<double>(i);
+    valid[i] = i % 7 != 0;
+    strings[i] = std::to_string(i);
+  }
+  auto key_array = MakeArray<arrow::Int64Type>(keys, valid);
+  auto table = arrow::Table::Make(
+      arrow::schema({arrow::field("k", arrow::int64()), arrow::field("v", arrow::float64()),
+                     arrow::field("s", arrow::utf8())}),
+      {key_array, MakeArray<arrow::DoubleType>(values, std::vector<bool>(length, true)), MakeStringArray(strings)});
+
+  const std::vector<int32_t> targets{0, 1, 2, 3, 4};
+  twisterx::PartitionIds partitions;
+  REQUIRE(twisterx::HashPartitionArrays(arrow::default_memory_pool(), {key_array}, length, targets, &partitions)
+              .is_ok());
+  std::vector<uint32_t> hashes;
+  REQUIRE(twisterx::HashRows(arrow::default_memory_pool(), {key_array}, length, &hashes).is_ok());
+
+  std::vector<std::vector<int64_t>> expected(targets.size());
+  for (int64_t i = 0; i < length; i++) {
+    REQUIRE(partitions.Get(i) == hashes[i] % targets.size());
+    expected[partitions.Get(i)].push_back(i);
+  }
+  for (size_t p = 0; p < targets.size(); p++) {
+    REQUIRE(partitions.Counts()[p] == static_cast<int64_t>(expected[p].size()));
+  }
+
+  for (int threads : {1, 3}) {
+    std::unordered_map<int, std::shared_ptr<arrow::Table>> split;
+    REQUIRE(twisterx::SplitTable(table, partitions, targets, arrow::default_memory_pool(), &split, threads).is_ok());
+    REQUIRE(split.size() == targets.size());
+    for (int32_t target : targets) {
+      const auto &rows = expected[target];
+      auto part = split[target];
+      REQUIRE(part->num_rows() == static_cast<int64_t>(rows.size()));
+      if (rows.empty()) {
+        continue;
+      }
+      std::shared_ptr<arrow::Table> combined;
+      REQUIRE(part->CombineChunks(arrow::default_memory_pool(), &combined).ok());
+      const auto &k = static_cast<const arrow::Int64Array &>(*combined->column(0)->chunk(0));
+      const auto &v = static_cast<const arrow::DoubleArray &>(*combined->column(1)->chunk(0));
+      const auto &s = static_cast<const arrow::StringArray &>(*combined->column(2)->chunk(0));
+      for (size_t r = 0; r < rows.size(); r++) {
+        REQUIRE(k.IsValid(r) == valid[rows[r]]);
+        if (valid[rows[r]]) {
+          REQUIRE(k.Value(r) == keys[rows[r]]);
+        }
+        REQUIRE(v.Value(r) == values[rows[r]]);
+        REQUIRE(s.GetString(r) == strings[rows[r]]);
+      }
+    }
+  }
+}
@@ -0,0 +1,134 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/test_header.hpp"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <arrow/api.h>
+
+#include "twisterx/arrow/arrow_row_hash_table.hpp"
+
+/**
+ * The columns of a table of (int64, string) rows with repeated rows, row i is (i % distinct, "s" + i % distinct)
+ */
+static std::vector<std::shared_ptr<arrow::Array>> MakeColumns(int64_t length, int64_t distinct) {
+  arrow::Int64Builder ints;
+  arrow::StringBuilder strings;
+  for (int64_t i = 0; i < length; i++) {
+    REQUIRE(ints.Append(i % distinct).ok());
+    REQUIRE(strings.Append("s" + std::to_string(i % distinct)).ok());
+  }
+  std::vector<std::shared_ptr<arrow::Array>> columns(2);
+  REQUIRE(ints.Finish(&columns[0]).ok());
+  REQUIRE(strings.Finish(&columns[1]).ok());
+  return columns;
+}
+
+/**
+ * Insert the rows of the tables and check the ids against a map of the rows. The ids are dense in the order of the
+ * first rows, and the table and the row of an id are those of its first row.
+ */
+static void CheckRowHashTable(const std::vector<std::vector<std::shared_ptr<arrow::Array>>> &tables,
+                              const std::function<uint32_t(int64_t)> &hash) {
+  std::unique_ptr<twisterx::RowEquality> equality;
+  REQUIRE(twisterx::RowEquality::Make(tables, &equality).ok());
+  // start small so the table grows many times
+  twisterx::RowHashTable table(equality.get(), 1);
+
+  std::map<int64_t, int64_t> ids;
+  std::vector<std::pair<int32_t, int64_t>> first_rows;
+  for (int32_t t = 0; t < static_cast<int32_t>(tables.size()); t++) {
+    const auto &keys = static_cast<const arrow::Int64Array &>(*tables[t][0]);
+    for (int64_t row = 0; row < keys.length(); row++) {
+      bool inserted = false;
+      int64_t id = table.FindOrInsert(hash(keys.Value(row)), t, row, &inserted);
+      auto it = ids.find(keys.Value(row));
+      if (it == ids.end()) {
+        REQUIRE(inserted);
+        REQUIRE(id == static_cast<int64_t>(ids.size()));
+        ids[keys.Value(row)] = id;
+        first_rows.emplace_back(t, row);
+      } else {
+        REQUIRE(!inserted);
+        REQUIRE(id == it->second);
+      }
+    }
+  }
+
+  REQUIRE(table.Size() == static_cast<int64_t>(ids.size()));
+  for (int32_t t = 0; t < static_cast<int32_t>(tables.size()); t++) {
+    const auto &keys = static_cast<const arrow::Int64Array &>(*tables[t][0]);
+    for (int64_t row = 0; row < keys.length(); row++) {
+      REQUIRE(table.Find(hash(keys.Value(row)), t, row) == ids[keys.Value(row)]);
+    }
+  }
+  for (int64_t id = 0; id < table.Size(); id++) {
+    REQUIRE(table.Table(id) == first_rows[id].first);
+    REQUIRE(table.Row(id) == first_rows[id].second);
+  }
+}
+
+TEST_CASE("RowHashTable keeps the ids of the rows as it grows", "[hash_table]") {
+  auto columns = MakeColumns(200000, 50000);
+  CheckRowHashTable({columns}, [](int64_t key) {
+    return static_cast<uint32_t>(key * 2654435761u);
+  });
+}
+
+TEST_CASE("RowHashTable tells apart rows with equal hashes", "[hash_table]") {
+  auto columns = MakeColumns(6000, 2000);
+  SECTION("all the hashes are equal") {
+    CheckRowHashTable({columns}, [](int64_t) {
+      return 42u;
+    });
+  }
+  SECTION("the hashes are a few values") {
+    CheckRowHashTable({columns}, [](int64_t key) {
+      return static_cast<uint32_t>(key % 3);
+    });
+  }
+}
+
+TEST_CASE("RowHashTable spreads hashes with equal low bits", "[hash_table]") {
+  // the rows of one rank after a hash shuffle over 64 ranks
+  auto columns = MakeColumns(100000, 100000);
+  CheckRowHashTable({columns}, [](int64_t key) {
+    return static_cast<uint32_t>(key) << 6;
+  });
+}
+
+TEST_CASE("RowHashTable finds the rows of one table in another", "[hash_table]") {
+  auto left = MakeColumns(3000, 1000);
+  auto right = MakeColumns(5000, 2500);
+  CheckRowHashTable({left, right}, [](int64_t key) {
+    return static_cast<uint32_t>(key % 257);
+  });
+
+  std::unique_ptr<twisterx::RowEquality> equality;
+  REQUIRE(twisterx::RowEquality::Make({left, right}, &equality).ok());
+  twisterx::RowHashTable table(equality.get(), 1000);
+  for (int64_t row = 0; row < 1000; row++) {
+    table.FindOrInsert(static_cast<uint32_t>(row), 0, row);
+  }
+  for (int64_t row = 0; row < 2500; row++) {
+    // the rows with keys from 1000 are not in the left table
+    REQUIRE(table.Find(static_cast<uint32_t>(row), 1, row) == (row < 1000 ? row : -1));
+  }
+  REQUIRE(table.Size() == 1000);
+}
@@ -0,0 +1,256 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/test_header.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <arrow/api.h>
+
+#include "twisterx/arrow/arrow_sort_kernels.hpp"
+
+using twisterx::sort::config::SortKey;
+using twisterx::sort::config::NULLS_FIRST;
+using twisterx::sort::config::NULLS_LAST;
+
+// the comparison sort, the radix sort on one thread and the radix sort on the threads
+static const std::vector<int64_t> kLengths{100, 5000, 1 << 18};
+
+/**
+ * The indices of the values sorted with std::stable_sort
+ */
+template<typename T>
+static std::vector<int64_t> StableSortIndices(const std::vector<T> &values) {
+  std::vector<int64_t> indices(values.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  std::stable_sort(indices.begin(), indices.end(), [&values](int64_t a, int64_t b) {
+    return twisterx::ValueLess(values[a], values[b]);
+  });
+  return indices;
+}
+
+template<typename T>
+static void CheckSortValueIndices(const std::vector<T> &values) {
+  const std::vector<int64_t> expected = StableSortIndices(values);
+  for (int threads : {1, 4}) {
+    std::vector<int64_t> indices(values.size());
+    twisterx::SortValueIndices<T>(values.data(), values.size(), indices.data(), threads);
+    REQUIRE(indices == expected);
+  }
+}
+
+/**
+ * Random integers over the whole range of the type, or a narrow range around zero which has many equal values and
+ * takes fewer radix passes
+ */
+template<typename T>
+static std::vector<T> RandomIntegers(int64_t length, bool narrow, uint64_t seed) {
+  std::mt19937_64 generator(seed);
+  std::vector<T> values(length);
+  for (auto &value : values) {
+    uint64_t bits = generator();
+    value = narrow ? static_cast<T>(static_cast<int64_t>(bits % 100) - (std::is_signed<T>::value ? 50 : 0))
+                   : static_cast<T>(bits);
+  }
+  return values;
+}
+
+template<typename T>
+static void CheckIntegers() {
+  for (int64_t length : kLengths) {
+    for (bool narrow : {false, true}) {
+      CheckSortValueIndices(RandomIntegers<T>(length, narrow, length + narrow));
+    }
+  }
+}
+
+/**
+ * Random floating point values with NaNs, signed zeros, infinities and repeated values
+ */
+template<typename T>
+static std::vector<T> RandomFloats(int64_t length, uint64_t seed) {
+  const T specials[] = {std::numeric_limits<T>::quiet_NaN(), -std::numeric_limits<T>::quiet_NaN(),
+                        static_cast<T>(0.0), static_cast<T>(-0.0),
+                        std::numeric_limits<T>::infinity(), -std::numeric_limits<T>::infinity(),
+                        std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max(),
+                        std::numeric_limits<T>::denorm_min(), static_cast<T>(1.5), static_cast<T>(-1.5)};
+  std::mt19937_64 generator(seed);
+  std::uniform_int_distribution<int> pick(0, 2 * static_cast<int>(sizeof(specials) / sizeof(T)) - 1);
+  std::normal_distribution<double> normal(0, 1000);
+  std::vector<T> values(length);
+  for (auto &value : values) {
+    int p = pick(generator);
+    value = p < static_cast<int>(sizeof(specials) / sizeof(T)) ? specials[p] : static_cast<T>(normal(generator));
+  }
+  return values;
+}
+
+TEST_CASE("SortValueIndices matches std::stable_sort for integers", "[sort]") {
+  SECTION("8 bit") {
+    CheckIntegers<int8_t>();
+    CheckIntegers<uint8_t>();
+  }
+  SECTION("16 bit") {
+    CheckIntegers<int16_t>();
+    CheckIntegers<uint16_t>();
+  }
+  SECTION("32 bit") {
+    CheckIntegers<int32_t>();
+    CheckIntegers<uint32_t>();
+  }
+  SECTION("64 bit") {
+    CheckIntegers<int64_t>();
+    CheckIntegers<uint64_t>();
+  }
+}
+
+TEST_CASE("SortValueIndices orders NaN last and keeps signed zeros stable", "[sort]") {
+  for (int64_t length : kLengths) {
+    CheckSortValueIndices(RandomFloats<float>(length, length));
+    CheckSortValueIndices(RandomFloats<double>(length, length + 1));
+  }
+
+  const std::vector<double> values{std::numeric_limits<double>::quiet_NaN(), 0.0, -0.0, -1.0, 0.0,
+                                   -std::numeric_limits<double>::quiet_NaN(), 1.0};
+  std::vector<int64_t> indices(values.size());
+  twisterx::SortValueIndices<double>(values.data(), values.size(), indices.data());
+  REQUIRE(indices == std::vector<int64_t>{3, 1, 2, 4, 6, 0, 5});
+}
+
+static std::shared_ptr<arrow::Array> MakeInt32Array(const std::vector<int32_t> &values,
+                                                    const std::vector<bool> &valid) {
+  arrow::Int32Builder builder;
+  REQUIRE(builder.AppendValues(values.data(), values.size(), valid).ok());
+  std::shared_ptr<arrow::Array> array;
+  REQUIRE(builder.Finish(&array).ok());
+  return array;
+}
+
+static std::shared_ptr<arrow::Array> MakeDoubleArray(const std::vector<double> &values,
+                                                     const std::vector<bool> &valid) {
+  arrow::DoubleBuilder builder;
+  REQUIRE(builder.AppendValues(values.data(), values.size(), valid).ok());
+  std::shared_ptr<arrow::Array> array;
+  REQUIRE(builder.Finish(&array).ok());
+  return array;
+}
+
+static std::shared_ptr<arrow::Array> MakeStringArray(const std::vector<std::string> &values) {
+  arrow::StringBuilder builder;
+  REQUIRE(builder.AppendValues(values).ok());
+  std::shared_ptr<arrow::Array> array;
+  REQUIRE(builder.Finish(&array).ok());
+  return array;
+}
+
+static std::vector<int64_t> IndicesOf(const std::shared_ptr<arrow::Array> &array) {
+  const auto &indices = static_cast<const arrow::Int64Array &>(*array);
+  return std::vector<int64_t>(indices.raw_values(), indices.raw_values() + indices.length());
+}
+
+/**
+ * The order of two rows by a key, with the nulls placed by the key and the values compared with ValueLess
+ */
+template<typename T>
+static int CompareKey(const std::vector<T> &values, const std::vector<bool> &valid, const SortKey &key,
+                      int64_t a, int64_t b) {
+  if (!valid[a] || !valid[b]) {
+    if (valid[a] == valid[b]) {
+      return 0;
+    }
+    return !valid[a] == key.NullsFirst() ? -1 : 1;
+  }
+  int c = twisterx::ValueLess(values[a], values[b]) ? -1 : (twisterx::ValueLess(values[b], values[a]) ? 1 : 0);
+  return key.IsAscending() ? c : -c;
+}
+
+TEST_CASE("SortIndicesMultiColumns places the nulls and breaks ties on the next columns", "[sort]") {
+  const int64_t length = 20000;
+  std::mt19937_64 generator(7);
+  std::vector<int32_t> ints(length);
+  std::vector<double> doubles(length);
+  std::vector<bool> ints_valid(length), doubles_valid(length);
+  std::vector<std::string> strings(length);
+  for (int64_t i = 0; i < length; i++) {
+    ints[i] = static_cast<int32_t>(generator() % 8) - 4;
+    ints_valid[i] = generator() % 5 != 0;
+    doubles[i] = generator() % 7 == 0 ? std::numeric_limits<double>::quiet_NaN()
+                                      : static_cast<double>(generator() % 4) - 2;
+    doubles_valid[i] = generator() % 6 != 0;
+    strings[i] = std::string(generator() % 3, 'x') + std::to_string(generator() % 10);
+  }
+  auto table = arrow::Table::Make(
+      arrow::schema({arrow::field("i", arrow::int32()), arrow::field("d", arrow::float64()),
+                     arrow::field("s", arrow::utf8())}),
+      {MakeInt32Array(ints, ints_valid), MakeDoubleArray(doubles, doubles_valid), MakeStringArray(strings)});
+
+  for (auto null_order : {NULLS_FIRST, NULLS_LAST}) {
+    for (bool ascending : {true, false}) {
+      const std::vector<SortKey> keys{SortKey(0, ascending, null_order), SortKey(1, !ascending, null_order),
+                                      SortKey(2, ascending)};
+      std::vector<int64_t> expected(length);
+      std::iota(expected.begin(), expected.end(), 0);
+      std::stable_sort(expected.begin(), expected.end(), [&](int64_t a, int64_t b) {
+        int c = CompareKey(ints, ints_valid, keys[0], a, b);
+        if (c == 0) {
+          c = CompareKey(doubles, doubles_valid, keys[1], a, b);
+        }
+        if (c == 0) {
+          c = (ascending ? 1 : -1) * strings[a].compare(strings[b]);
+        }
+        return c < 0;
+      });
+
+      for (int threads : {1, 4}) {
+        std::shared_ptr<arrow::Array> indices;
+        REQUIRE(twisterx::SortIndicesMultiColumns(arrow::default_memory_pool(), table, keys, &indices, threads).ok());
+        REQUIRE(IndicesOf(indices) == expected);
+      }
+    }
+  }
+}
+
+TEST_CASE("SortBinaryIndices sorts strings with equal 8 byte prefixes in byte order", "[sort]") {
+  // the bytes include 0, which the prefixes are padded with, and bytes above 127
+  const std::string alphabet("\0\x01" "ab\x7f\x80\xff", 7);
+  const std::vector<std::string> prefixes{"", "abcdefgh", "abcdefghabcdefgh", "abcdefg"};
+  for (int64_t length : kLengths) {
+    std::mt19937_64 generator(length);
+    std::vector<std::string> strings(length);
+    for (auto &s : strings) {
+      s = prefixes[generator() % prefixes.size()];
+      size_t suffix = generator() % 12;
+      for (size_t c = 0; c < suffix; c++) {
+        s.push_back(alphabet[generator() % alphabet.size()]);
+      }
+    }
+    auto array = MakeStringArray(strings);
+    std::vector<int64_t> expected(length);
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(), [&strings](int64_t a, int64_t b) {
+      return strings[a] < strings[b];
+    });
+
+    for (int threads : {1, 4}) {
+      std::vector<int64_t> indices(length);
+      REQUIRE(twisterx::SortBinaryIndices(array, indices.data(), threads).ok());
+      REQUIRE(indices == expected);
+    }
+  }
+}
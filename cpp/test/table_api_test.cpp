@@ -0,0 +1,197 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/test_header.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <arrow/api.h>
+
+#include "twisterx/table_api.hpp"
+#include "twisterx/table_api_extended.hpp"
+
+using twisterx::sort::config::SortKey;
+using twisterx::sort::config::NULLS_FIRST;
+using twisterx::sort::config::NULLS_LAST;
+
+static std::shared_ptr<arrow::Array> MakeInt64Array(const std::vector<int64_t> &values,
+                                                    const std::vector<bool> &valid) {
+  arrow::Int64Builder builder;
+  REQUIRE(builder.AppendValues(values.data(), values.size(), valid).ok());
+  std::shared_ptr<arrow::Array> array;
+  REQUIRE(builder.Finish(&array).ok());
+  return array;
+}
+
+static std::shared_ptr<arrow::Array> MakeStringArray(const std::vector<std::string> &values,
+                                                     const std::vector<bool> &valid) {
+  arrow::StringBuilder builder;
+  for (size_t i = 0; i < values.size(); i++) {
+    REQUIRE((valid[i] ? builder.Append(values[i]) : builder.AppendNull()).ok());
+  }
+  std::shared_ptr<arrow::Array> array;
+  REQUIRE(builder.Finish(&array).ok());
+  return array;
+}
+
+/**
+ * The values of an int64 column over all its chunks, "null" for the nulls
+ */
+static std::vector<std::string> Int64Values(const std::shared_ptr<arrow::Table> &table, int column) {
+  std::vector<std::string> values;
+  for (const auto &chunk : table->column(column)->chunks()) {
+    const auto &array = static_cast<const arrow::Int64Array &>(*chunk);
+    for (int64_t i = 0; i < array.length(); i++) {
+      values.push_back(array.IsNull(i) ? "null" : std::to_string(array.Value(i)));
+    }
+  }
+  return values;
+}
+
+static std::vector<std::string> StringValues(const std::shared_ptr<arrow::Table> &table, int column) {
+  std::vector<std::string> values;
+  for (const auto &chunk : table->column(column)->chunks()) {
+    const auto &array = static_cast<const arrow::StringArray &>(*chunk);
+    for (int64_t i = 0; i < array.length(); i++) {
+      values.push_back(array.IsNull(i) ? "null" : array.GetString(i));
+    }
+  }
+  return values;
+}
+
+/**
+ * The rows of a table of an int64 and a string column as "k,s", in the order of the table
+ */
+static std::vector<std::string> RowValues(const std::shared_ptr<arrow::Table> &table) {
+  std::vector<std::string> keys = Int64Values(table, 0);
+  std::vector<std::string> strings = StringValues(table, 1);
+  std::vector<std::string> rows;
+  for (size_t i = 0; i < keys.size(); i++) {
+    rows.push_back(keys[i] + "," + strings[i]);
+  }
+  return rows;
+}
+
+static std::vector<std::string> SortedRowValues(const std::shared_ptr<arrow::Table> &table) {
+  std::vector<std::string> rows = RowValues(table);
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+/**
+ * A table of an int64 key and a string value, with nulls in both, in two chunks
+ *
+ * row  0    1     2  3     4     5
+ * k    3    null  1  null  2     0
+ * s    a    b     c  d     null  f
+ */
+static std::shared_ptr<arrow::Table> ChunkedTableWithNulls() {
+  auto keys = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeInt64Array({3, 0, 1}, {true, false, true}), MakeInt64Array({0, 2, 0}, {false, true, true})});
+  auto strings = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeStringArray({"a", "b", "c"}, {true, true, true}), MakeStringArray({"d", "", "f"}, {true, false, true})});
+  return arrow::Table::Make(arrow::schema({arrow::field("k", arrow::int64()), arrow::field("s", arrow::utf8())}),
+                            {keys, strings});
+}
+
+TEST_CASE("SortTable and TopK keep the nulls of chunked tables", "[table]") {
+  auto ctx = twisterx::TwisterXContext::Init();
+  twisterx::PutTable("chunked", ChunkedTableWithNulls());
+  REQUIRE(twisterx::GetTable("chunked")->column(0)->num_chunks() == 2);
+
+  SECTION("sort") {
+    REQUIRE(twisterx::SortTable(ctx, "chunked", "sorted", {SortKey(0, true, NULLS_LAST)}).is_ok());
+    auto sorted = twisterx::GetTable("sorted");
+    REQUIRE(Int64Values(sorted, 0) == std::vector<std::string>{"0", "1", "2", "3", "null", "null"});
+    REQUIRE(StringValues(sorted, 1) == std::vector<std::string>{"f", "c", "null", "a", "b", "d"});
+
+    REQUIRE(twisterx::SortTable(ctx, "chunked", "sorted_by_column", 0).is_ok());
+    auto sorted_by_column = twisterx::GetTable("sorted_by_column");
+    REQUIRE(Int64Values(sorted_by_column, 0) == Int64Values(sorted, 0));
+    REQUIRE(StringValues(sorted_by_column, 1) == StringValues(sorted, 1));
+  }
+
+  SECTION("top k") {
+    REQUIRE(twisterx::TopK(ctx, "chunked", "top", {SortKey(0, false, NULLS_LAST)}, 3).is_ok());
+    auto top = twisterx::GetTable("top");
+    REQUIRE(Int64Values(top, 0) == std::vector<std::string>{"3", "2", "1"});
+    REQUIRE(StringValues(top, 1) == std::vector<std::string>{"a", "null", "c"});
+
+    // the two null keys are the top rows
+    REQUIRE(twisterx::TopK(ctx, "chunked", "top_nulls", {SortKey(0, true, NULLS_FIRST)}, 3).is_ok());
+    auto top_nulls = twisterx::GetTable("top_nulls");
+    REQUIRE(Int64Values(top_nulls, 0) == std::vector<std::string>{"null", "null", "0"});
+    auto strings = StringValues(top_nulls, 1);
+    std::sort(strings.begin(), strings.begin() + 2);
+    REQUIRE(strings == std::vector<std::string>{"b", "d", "f"});
+  }
+
+  ctx->Finalize();
+}
+
+TEST_CASE("GroupBy keeps the null key of the group of the null keys", "[table]") {
+  auto ctx = twisterx::TwisterXContext::Init();
+  // the null keys and the zero keys are separate groups, over both chunks
+  auto keys = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeInt64Array({0, 0, 0}, {true, false, true}), MakeInt64Array({0, 1}, {false, true})});
+  auto values = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeInt64Array({1, 2, 3}, {true, true, true}), MakeInt64Array({4, 5}, {true, true})});
+  twisterx::PutTable("grouped_input", arrow::Table::Make(
+      arrow::schema({arrow::field("k", arrow::int64()), arrow::field("v", arrow::int64())}), {keys, values}));
+
+  REQUIRE(twisterx::GroupBy(ctx, "grouped_input", "grouped", {0},
+                            {twisterx::groupby::config::Aggregation::Sum(1)}).is_ok());
+  auto grouped = twisterx::GetTable("grouped");
+  REQUIRE(Int64Values(grouped, 0) == std::vector<std::string>{"0", "null", "1"});
+  REQUIRE(Int64Values(grouped, 1) == std::vector<std::string>{"4", "6", "5"});
+
+  ctx->Finalize();
+}
+
+TEST_CASE("Set operations and Distinct keep the null values of the rows", "[table]") {
+  auto ctx = twisterx::TwisterXContext::Init();
+  auto schema = arrow::schema({arrow::field("k", arrow::int64()), arrow::field("s", arrow::utf8())});
+  // the rows 1,a null,b null,b 2,null in two chunks
+  auto left_keys = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeInt64Array({1, 0}, {true, false}), MakeInt64Array({0, 2}, {false, true})});
+  auto left_strings = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{
+      MakeStringArray({"a", "b"}, {true, true}), MakeStringArray({"b", ""}, {true, false})});
+  twisterx::PutTable("left", arrow::Table::Make(schema, {left_keys, left_strings}));
+  // the rows null,b 3,c 2,null
+  twisterx::PutTable("right", arrow::Table::Make(schema, {MakeInt64Array({0, 3, 2}, {false, true, true}),
+                                                          MakeStringArray({"b", "c", ""}, {true, true, false})}));
+
+  REQUIRE(twisterx::Union(ctx, "left", "right", "union").is_ok());
+  REQUIRE(SortedRowValues(twisterx::GetTable("union"))
+              == std::vector<std::string>{"1,a", "2,null", "3,c", "null,b"});
+
+  REQUIRE(twisterx::Intersect(ctx, "left", "right", "intersect").is_ok());
+  REQUIRE(SortedRowValues(twisterx::GetTable("intersect")) == std::vector<std::string>{"2,null", "null,b"});
+
+  REQUIRE(twisterx::Subtract(ctx, "left", "right", "subtract").is_ok());
+  REQUIRE(SortedRowValues(twisterx::GetTable("subtract")) == std::vector<std::string>{"1,a"});
+  // one of the two null,b rows of the left table is not in the right table
+  REQUIRE(twisterx::Subtract(ctx, "left", "right", "subtract_bag", twisterx::BAG).is_ok());
+  REQUIRE(SortedRowValues(twisterx::GetTable("subtract_bag")) == std::vector<std::string>{"1,a", "null,b"});
+
+  REQUIRE(twisterx::Distinct(ctx, "left", "distinct", {}).is_ok());
+  REQUIRE(RowValues(twisterx::GetTable("distinct")) == std::vector<std::string>{"1,a", "null,b", "2,null"});
+  // the null keys are equal, so only the rows of the keys 1 and 2 have no duplicates
+  REQUIRE(twisterx::Distinct(ctx, "left", "distinct_none", {0}, twisterx::KEEP_NONE).is_ok());
+  REQUIRE(RowValues(twisterx::GetTable("distinct_none")) == std::vector<std::string>{"1,a", "2,null"});
+
+  ctx->Finalize();
+}
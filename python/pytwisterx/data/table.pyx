@@ -13,6 +13,7 @@
  ##
 
 from libcpp.string cimport string
+from libcpp.vector cimport vector
 from pytwisterx.common.status cimport _Status
 from pytwisterx.common.status import Status
 import uuid
@@ -52,6 +53,10 @@ cdef extern from "../../../cpp/src/twisterx/python/table_cython.h" namespace "tw
 							   CJoinAlgorithm algorithm,
 							   int left_column_index,
 							   int right_column_index);
+        string group_by(const vector[int] &key_columns, const vector[int] &aggregate_columns,
+                        const vector[string] &aggregate_ops)
+        string distributed_group_by(const vector[int] &key_columns, const vector[int] &aggregate_columns,
+                                    const vector[string] &aggregate_ops)
 
 cdef extern from "../../../cpp/src/twisterx/python/table_cython.h" namespace "twisterx::python::table::CxTable":
     cdef extern _Status from_csv(const string, const char, const string)
@@ -216,6 +221,45 @@ cdef class Table:
         return Table(table_out_id)
 
 
+    def groupby(self, ctx: TwisterxContext, key_columns: list, aggregations: list) -> Table:
+        '''
+        Groups the rows of a PyTwisterX table on the key columns and aggregates each group
+        :param key_columns: the key columns as a list of int
+        :param aggregations: the aggregates as a list of (column, aggregate) tuples, the aggregate as str
+        ["count", "sum", "min", "max", "mean", "var"]
+        :return: PyTwisterX table with the key columns followed by a column for each aggregate
+        '''
+        cdef vector[int] c_key_columns = key_columns
+        cdef vector[int] c_aggregate_columns
+        cdef vector[string] c_aggregate_ops
+        for column, op in aggregations:
+            c_aggregate_columns.push_back(column)
+            c_aggregate_ops.push_back(op.encode())
+        cdef string table_out_id = self.thisPtr.group_by(c_key_columns, c_aggregate_columns, c_aggregate_ops)
+        if table_out_id.size() == 0:
+            raise Exception("Group By Failed !!!")
+        return Table(table_out_id)
+
+    def distributed_groupby(self, ctx: TwisterxContext, key_columns: list, aggregations: list) -> Table:
+        '''
+        Groups the rows of the PyTwisterX tables of all the processes on the key columns and aggregates each group
+        :param key_columns: the key columns as a list of int
+        :param aggregations: the aggregates as a list of (column, aggregate) tuples, the aggregate as str
+        ["count", "sum", "min", "max", "mean", "var"]
+        :return: PyTwisterX table with the groups of this process
+        '''
+        cdef vector[int] c_key_columns = key_columns
+        cdef vector[int] c_aggregate_columns
+        cdef vector[string] c_aggregate_ops
+        for column, op in aggregations:
+            c_aggregate_columns.push_back(column)
+            c_aggregate_ops.push_back(op.encode())
+        cdef string table_out_id = self.thisPtr.distributed_group_by(c_key_columns, c_aggregate_columns,
+                                                                     c_aggregate_ops)
+        if table_out_id.size() == 0:
+            raise Exception("Distributed Group By Failed !!!")
+        return Table(table_out_id)
+
     @staticmethod
     def from_arrow(obj) -> Table:       
         '''
@@ -21,4 +21,5 @@ cdef extern from "../../../cpp/src/twisterx/net/comm_type.h" namespace "twisterx
     cdef enum _CommType 'twisterx::net::CommType':
         _MPI 'twisterx::net::CommType::MPI'
         _TCP 'twisterx::net::CommType::TCP'
-        _UCX 'twisterx::net::CommType::UCX'
\ No newline at end of file
+        _UCX 'twisterx::net::CommType::UCX'
+        _LOCAL 'twisterx::net::CommType::LOCAL'
\ No newline at end of file
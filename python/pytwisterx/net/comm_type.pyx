@@ -21,4 +21,5 @@ from pytwisterx.net.comm_type cimport _CommType
 cpdef enum CommType:
     MPI = _CommType._MPI
     TCP = _CommType._TCP
-    UCX = _CommType._UCX
\ No newline at end of file
+    UCX = _CommType._UCX
+    LOCAL = _CommType._LOCAL
\ No newline at end of file
@@ -23,7 +23,7 @@ cdef extern from "../../../cpp/src/twisterx/net/TxRequest.h" namespace "twisterx
         void *buffer;
         int length;
         int target;
-        int header[6];
+        int header[8];
         int headerLength;
         CTxRequest(int)
         CTxRequest(int, void *, int)